@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+#include <atomic>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#include "Real.hpp"
+
+#define MEMORY_ALIGNMENT 64 // выравнивание буферов (размер кэш-линии и регистра AVX-512)
+#define HUGE_PAGE_SIZE (2 << 20) // размер большой страницы
+#define HUGE_PAGE_THRESHOLD (4 << 20) // минимальный размер буфера для больших страниц
+
+// настройки выделения памяти
+class MemoryConfig {
+	static bool hugePages; // использовать ли прозрачные большие страницы для крупных буферов
+	static std::atomic<size_t> allocations; // количество выделений памяти под значения
+
+public:
+	static void SetHugePages(bool enable); // включение/выключение больших страниц
+	static bool HugePages(); // используются ли большие страницы
+
+	static void CountAllocation(); // учёт очередного выделения памяти
+	static size_t Allocations(); // количество выделений памяти с начала работы
+};
+
+#ifdef USE_HUGE_PAGES
+bool MemoryConfig::hugePages = true;
+#else
+bool MemoryConfig::hugePages = false;
+#endif
+
+std::atomic<size_t> MemoryConfig::allocations(0);
+
+// включение/выключение больших страниц
+void MemoryConfig::SetHugePages(bool enable) {
+	hugePages = enable;
+}
+
+// используются ли большие страницы
+bool MemoryConfig::HugePages() {
+	return hugePages;
+}
+
+// учёт очередного выделения памяти
+void MemoryConfig::CountAllocation() {
+	allocations++;
+}
+
+// количество выделений памяти с начала работы (позволяет проверить, что шаг обучения не выделяет память)
+size_t MemoryConfig::Allocations() {
+	return allocations;
+}
+
+// аллокатор, выравнивающий память по MEMORY_ALIGNMENT байт и помечающий крупные буферы для больших страниц
+template <typename T>
+class AlignedAllocator {
+public:
+	typedef T value_type;
+
+	AlignedAllocator() {}
+
+	template <typename U>
+	AlignedAllocator(const AlignedAllocator<U> &allocator) {}
+
+	T* allocate(size_t n); // выделение памяти под n элементов
+	void deallocate(T *p, size_t n); // освобождение памяти
+
+	template <typename U>
+	bool operator==(const AlignedAllocator<U> &allocator) const { return true; }
+
+	template <typename U>
+	bool operator!=(const AlignedAllocator<U> &allocator) const { return false; }
+};
+
+// выделение памяти под n элементов
+template <typename T>
+T* AlignedAllocator<T>::allocate(size_t n) {
+	if (n == 0)
+		return nullptr;
+
+	size_t bytes = n * sizeof(T);
+	size_t alignment = MEMORY_ALIGNMENT;
+	bool huge = MemoryConfig::HugePages() && bytes >= HUGE_PAGE_THRESHOLD;
+
+	if (huge)
+		alignment = HUGE_PAGE_SIZE;
+
+	bytes = (bytes + alignment - 1) / alignment * alignment; // aligned_alloc требует размер, кратный выравниванию
+	void *p = aligned_alloc(alignment, bytes);
+
+	if (p == nullptr)
+		throw std::bad_alloc();
+
+	MemoryConfig::CountAllocation();
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+	if (huge)
+		madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+
+	return static_cast<T*>(p);
+}
+
+// освобождение памяти
+template <typename T>
+void AlignedAllocator<T>::deallocate(T *p, size_t n) {
+	free(p);
+}
+
+typedef std::vector<real, AlignedAllocator<real>> AlignedVector; // выровненный буфер значений
+typedef std::vector<int8_t, AlignedAllocator<int8_t>> AlignedInt8Vector; // выровненный буфер квантованных весов
+typedef std::vector<uint8_t, AlignedAllocator<uint8_t>> AlignedUInt8Vector; // выровненный буфер квантованных входов
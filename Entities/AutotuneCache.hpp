@@ -0,0 +1,127 @@
+#pragma once
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "Real.hpp"
+
+#define AUTOTUNE_CACHE_PATH "autotune_cache.txt" // файл кэша автонастройки по умолчанию
+
+// подпись процессора: модель, наборы инструкций, под которые собрана программа, количество потоков и тип чисел
+// результаты замеров зависят от всего этого, поэтому записи с другой подписью не используются
+std::string GetCPUSignature() {
+	std::string model = "unknown";
+	std::ifstream f("/proc/cpuinfo");
+	std::string line;
+
+	while (std::getline(f, line)) {
+		if (line.find("model name") == 0 && line.find(':') != std::string::npos) {
+			model = line.substr(line.find(':') + 1);
+			break;
+		}
+	}
+
+	std::string isa = "";
+
+#ifdef __AVX512F__
+	isa += "+avx512f";
+#endif
+#ifdef __AVX2__
+	isa += "+avx2";
+#endif
+#ifdef __FMA__
+	isa += "+fma";
+#endif
+
+	std::string signature = model + " isa:" + (isa == "" ? "generic" : isa.substr(1));
+
+#ifdef _OPENMP
+	signature += " threads:" + std::to_string(omp_get_max_threads());
+#else
+	signature += " threads:1";
+#endif
+
+	signature += " real:" + std::to_string(sizeof(real) * 8);
+
+	// в файле подпись - одно слово
+	signature.erase(0, signature.find_first_not_of(' '));
+	std::replace(signature.begin(), signature.end(), ' ', '_');
+	std::replace(signature.begin(), signature.end(), '\t', '_');
+
+	return signature;
+}
+
+// кэш автонастройки: лучший найденный вариант для каждого ключа (формы слоя) на текущем процессоре
+// файл хранит строки "подпись ключ значение", записи других процессоров сохраняются, но не читаются
+class AutotuneCache {
+	std::string path; // путь к файлу кэша
+	std::string signature; // подпись текущего процессора
+	std::map<std::string, std::string> entries; // записи всех процессоров по "подпись ключ"
+	bool changed; // есть ли несохранённые записи
+
+public:
+	AutotuneCache(const std::string &path);
+
+	bool Find(const std::string &key, std::string &value) const; // поиск записи текущего процессора
+	void Set(const std::string &key, const std::string &value); // добавление записи текущего процессора
+	void Save(); // сохранение кэша в файл, если есть новые записи
+
+	size_t Size() const; // количество записей
+};
+
+AutotuneCache::AutotuneCache(const std::string &path) {
+	this->path = path;
+	this->signature = GetCPUSignature();
+	this->changed = false;
+
+	std::ifstream f(path.c_str());
+	std::string entrySignature, key, value;
+
+	while (f >> entrySignature >> key >> value)
+		entries[entrySignature + " " + key] = value;
+}
+
+// поиск записи текущего процессора
+bool AutotuneCache::Find(const std::string &key, std::string &value) const {
+	std::map<std::string, std::string>::const_iterator entry = entries.find(signature + " " + key);
+
+	if (entry == entries.end())
+		return false;
+
+	value = entry->second;
+	return true;
+}
+
+// добавление записи текущего процессора
+void AutotuneCache::Set(const std::string &key, const std::string &value) {
+	entries[signature + " " + key] = value;
+	changed = true;
+}
+
+// сохранение кэша в файл, если есть новые записи
+void AutotuneCache::Save() {
+	if (!changed)
+		return;
+
+	std::ofstream f(path.c_str());
+
+	if (!f)
+		throw std::runtime_error("Unable to write autotune cache to '" + path + "'");
+
+	for (std::map<std::string, std::string>::const_iterator entry = entries.begin(); entry != entries.end(); entry++)
+		f << entry->first << " " << entry->second << std::endl;
+
+	changed = false;
+}
+
+// количество записей
+size_t AutotuneCache::Size() const {
+	return entries.size();
+}
@@ -7,6 +7,7 @@
 #include <string>
 
 #include "Volume.hpp"
+#include "Tensor.hpp"
 #include "../Network.hpp"
 
 class DataLoader {
@@ -15,6 +16,9 @@ public:
 	std::vector<Volume> trainOutputData; // обучающая выходная выборка
 
 private:
+	Tensor trainInputs; // память обучающей входной выборки
+	Tensor trainOutputs; // память обучающей выходной выборки
+
 	std::vector<std::string> labels; // метки классов
 	std::vector<int> statistics; // статистика обучающей выборки
 	VolumeSize inputSize; // размер входа
@@ -27,6 +31,7 @@ private:
 
 	Volume GetVolume(const std::vector<std::string> &args, int start = 1);
 	void ReadTrain(const std::string &trainPath, size_t maxTrainData);
+	void PackTrain(); // размещение обучающей выборки в непрерывной памяти
 	void ReadLabels(const std::string& path); // считывание меток классов
 
 public:
@@ -162,6 +167,28 @@ void DataLoader::ReadTrain(const std::string &trainPath, size_t maxTrainData) {
 
 	f.close();
 	std::cout << "Succesfully loaded " << trainInputData.size() << " train samples" << std::endl;
+
+	PackTrain();
+}
+
+// размещение обучающей выборки в непрерывной памяти
+void DataLoader::PackTrain() {
+	if (trainInputData.size() == 0)
+		return;
+
+	trainInputs = Tensor(trainInputData);
+	trainOutputs = Tensor(trainOutputData);
+
+	std::vector<Volume> inputs;
+	std::vector<Volume> outputs;
+
+	for (size_t i = 0; i < trainInputs.size(); i++) {
+		inputs.emplace_back(trainInputs.GetSize(), trainInputs[i].Data());
+		outputs.emplace_back(trainOutputs.GetSize(), trainOutputs[i].Data());
+	}
+
+	trainInputData = std::move(inputs);
+	trainOutputData = std::move(outputs);
 }
 
 // считывание меток классов
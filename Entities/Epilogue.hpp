@@ -0,0 +1,120 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cmath>
+
+#include "Real.hpp"
+#include "Tensor.hpp"
+#include "Layout.hpp"
+
+// активация, которую слой может применить к своему выходу сам
+enum class EpilogueActivation {
+	None,
+	ReLU,
+	LeakyReLU,
+	Sigmoid
+};
+
+// эпилог слоя при выводе: активация, затем поканальное преобразование scale * x + shift
+// применяется одним проходом по выходу вместо отдельных слоёв активации и нормализации
+struct Epilogue {
+	EpilogueActivation activation; // активация
+	real alpha; // наклон leaky relu
+	std::vector<real> scale; // множители каналов (пусто, если преобразования нет)
+	std::vector<real> shift; // сдвиги каналов
+
+	Epilogue();
+
+	bool Empty() const; // нет ни активации, ни преобразования
+	void AddScaleShift(const std::vector<real> &scale, const std::vector<real> &shift); // добавление преобразования после текущего
+	real Apply(real value, int channel) const; // применение к значению канала
+};
+
+Epilogue::Epilogue() {
+	activation = EpilogueActivation::None;
+	alpha = 0;
+}
+
+// нет ни активации, ни преобразования
+bool Epilogue::Empty() const {
+	return activation == EpilogueActivation::None && scale.empty();
+}
+
+// добавление преобразования после текущего: s2 * (s1 * x + b1) + b2 = (s2 * s1) * x + (s2 * b1 + b2)
+void Epilogue::AddScaleShift(const std::vector<real> &scale, const std::vector<real> &shift) {
+	if (this->scale.empty()) {
+		this->scale = scale;
+		this->shift = shift;
+		return;
+	}
+
+	for (size_t i = 0; i < scale.size(); i++) {
+		this->scale[i] *= scale[i];
+		this->shift[i] = this->shift[i] * scale[i] + shift[i];
+	}
+}
+
+// применение к значению канала
+inline real Epilogue::Apply(real value, int channel) const {
+	if (activation == EpilogueActivation::ReLU)
+		value = value > 0 ? value : 0;
+	else if (activation == EpilogueActivation::LeakyReLU)
+		value = value > 0 ? value : alpha * value;
+	else if (activation == EpilogueActivation::Sigmoid)
+		value = 1.0 / (1 + exp(-value));
+
+	if (!scale.empty())
+		value = value * scale[channel] + shift[channel];
+
+	return value;
+}
+
+// применение эпилога ко всему выходу в канальном или блочном расположении
+void ApplyEpilogue(const Epilogue &epilogue, Tensor &output, Layout layout) {
+	VolumeSize size = output.GetSize();
+	int area = size.height * size.width;
+
+	if (layout != Layout::Blocked) {
+		#pragma omp parallel for collapse(2)
+		for (size_t n = 0; n < output.size(); n++) {
+			for (int i = 0; i < area; i++) {
+				real *y = output[n].Data() + i * size.deep;
+
+				for (int d = 0; d < size.deep; d++)
+					y[d] = epilogue.Apply(y[d], d);
+			}
+		}
+
+		return;
+	}
+
+	#pragma omp parallel for collapse(2)
+	for (size_t n = 0; n < output.size(); n++) {
+		for (int start = 0; start < size.deep; start += LAYOUT_BLOCK_SIZE) {
+			int blockSize = std::min(LAYOUT_BLOCK_SIZE, size.deep - start);
+			real *block = output[n].Data() + start * area;
+
+			for (int i = 0; i < area; i++)
+				for (int d = 0; d < blockSize; d++)
+					block[i * blockSize + d] = epilogue.Apply(block[i * blockSize + d], start + d);
+		}
+	}
+}
+
+// описание эпилога для вывода конфигурации
+std::string EpilogueToString(const Epilogue &epilogue) {
+	std::string result = "";
+
+	if (epilogue.activation == EpilogueActivation::ReLU)
+		result = "relu";
+	else if (epilogue.activation == EpilogueActivation::LeakyReLU)
+		result = "leaky relu";
+	else if (epilogue.activation == EpilogueActivation::Sigmoid)
+		result = "sigmoid";
+
+	if (!epilogue.scale.empty())
+		result += result == "" ? "scale" : " + scale";
+
+	return result;
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+#include "Real.hpp"
+#include "AlignedAllocator.hpp"
+
+class NetworkLayer;
+
+// план размещения активаций при выводе: по времени жизни выходов слоёв им назначаются общие буферы
+// значение -1 обозначает вход сети, который плану не принадлежит
+class InferencePlan {
+	std::vector<NetworkLayer*> layers; // слои в порядке вычисления
+	std::vector<int> outputs; // значения, в которые слои записывают выходы
+
+	std::vector<int> sizes; // количество чисел одного примера в значении
+	std::vector<int> lastUses; // последний шаг, на котором значение читается
+	std::vector<int> valueBuffers; // буферы, назначенные значениям
+
+	std::vector<AlignedVector> buffers; // общие буферы
+
+	int ChooseBuffer(const std::vector<int> &free, const std::vector<int> &bufferSizes, int size) const; // выбор свободного буфера под значение
+
+public:
+	int AddLayer(NetworkLayer *layer, const std::vector<int> &inputs, int size); // добавление шага, возвращает значение с выходом слоя
+	void Build(size_t batchSize, int output); // назначение буферов значениям и выделение памяти
+	void Clear(); // очистка плана
+
+	size_t StepsCount() const; // количество шагов плана
+	NetworkLayer* GetLayer(size_t step) const; // слой, вычисляемый на шаге
+	real* GetOutput(size_t step); // буфер для выхода слоя на шаге
+
+	size_t BuffersCount() const; // количество общих буферов
+	size_t GetMemory() const; // количество чисел во всех общих буферах
+};
+
+// выбор свободного буфера: наименьший из вмещающих значение, иначе наибольший (он будет увеличен)
+int InferencePlan::ChooseBuffer(const std::vector<int> &free, const std::vector<int> &bufferSizes, int size) const {
+	int best = -1;
+
+	for (size_t i = 0; i < free.size(); i++) {
+		int buffer = free[i];
+
+		if (best == -1) {
+			best = buffer;
+		}
+		else if (bufferSizes[best] < size) {
+			if (bufferSizes[buffer] > bufferSizes[best])
+				best = buffer;
+		}
+		else if (bufferSizes[buffer] >= size && bufferSizes[buffer] < bufferSizes[best]) {
+			best = buffer;
+		}
+	}
+
+	return best;
+}
+
+// добавление шага: слой читает значения inputs и записывает выход размера size в новое значение
+int InferencePlan::AddLayer(NetworkLayer *layer, const std::vector<int> &inputs, int size) {
+	int step = layers.size();
+
+	for (size_t i = 0; i < inputs.size(); i++)
+		if (inputs[i] >= 0)
+			lastUses[inputs[i]] = std::max(lastUses[inputs[i]], step);
+
+	layers.push_back(layer);
+	outputs.push_back(sizes.size());
+
+	sizes.push_back(size);
+	lastUses.push_back(step);
+
+	return outputs[step];
+}
+
+// назначение буферов значениям (выход сети output живёт до конца вывода) и выделение памяти
+void InferencePlan::Build(size_t batchSize, int output) {
+	if (output >= 0)
+		lastUses[output] = layers.size();
+
+	std::vector<int> free; // буферы, значения в которых больше не нужны
+	std::vector<int> bufferSizes;
+
+	valueBuffers.assign(sizes.size(), -1);
+
+	for (size_t step = 0; step < layers.size(); step++) {
+		int value = outputs[step];
+		int buffer = ChooseBuffer(free, bufferSizes, sizes[value]);
+
+		if (buffer == -1) {
+			buffer = bufferSizes.size();
+			bufferSizes.push_back(sizes[value]);
+		}
+		else {
+			free.erase(std::find(free.begin(), free.end(), buffer));
+			bufferSizes[buffer] = std::max(bufferSizes[buffer], sizes[value]);
+		}
+
+		valueBuffers[value] = buffer;
+
+		// входы шага уже прочитаны, поэтому их буферы освобождаются только после назначения выхода
+		for (size_t i = 0; i < sizes.size(); i++)
+			if (lastUses[i] == (int) step && valueBuffers[i] >= 0)
+				free.push_back(valueBuffers[i]);
+	}
+
+	buffers.resize(bufferSizes.size());
+
+	for (size_t i = 0; i < buffers.size(); i++)
+		if (buffers[i].size() != bufferSizes[i] * batchSize)
+			buffers[i] = AlignedVector(bufferSizes[i] * batchSize, 0);
+}
+
+// очистка плана
+void InferencePlan::Clear() {
+	layers.clear();
+	outputs.clear();
+	sizes.clear();
+	lastUses.clear();
+	valueBuffers.clear();
+	buffers.clear();
+}
+
+// количество шагов плана
+size_t InferencePlan::StepsCount() const {
+	return layers.size();
+}
+
+// слой, вычисляемый на шаге
+NetworkLayer* InferencePlan::GetLayer(size_t step) const {
+	return layers[step];
+}
+
+// буфер для выхода слоя на шаге
+real* InferencePlan::GetOutput(size_t step) {
+	return buffers[valueBuffers[outputs[step]]].data();
+}
+
+// количество общих буферов
+size_t InferencePlan::BuffersCount() const {
+	return buffers.size();
+}
+
+// количество чисел во всех общих буферах
+size_t InferencePlan::GetMemory() const {
+	size_t memory = 0;
+
+	for (size_t i = 0; i < buffers.size(); i++)
+		memory += buffers[i].size();
+
+	return memory;
+}
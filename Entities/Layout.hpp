@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <algorithm>
+
+#include "Real.hpp"
+#include "Volume.hpp"
+
+#define LAYOUT_BLOCK_SIZE 8 // количество каналов в блоке
+
+// расположение значений объёма в памяти
+enum class Layout {
+	Any, // слою безразлично расположение (поэлементные слои)
+	Channels, // каналы меняются быстрее всего: (i * width + j) * deep + d
+	Blocked // каналы разбиты на блоки по LAYOUT_BLOCK_SIZE: [d / b][i][j][d % b]
+};
+
+// получение названия расположения
+std::string LayoutToString(Layout layout) {
+	if (layout == Layout::Channels)
+		return "channels";
+
+	if (layout == Layout::Blocked)
+		return "blocked";
+
+	return "any";
+}
+
+// получение расположения по названию
+Layout StringToLayout(const std::string &layout) {
+	if (layout == "channels" || layout == "nhwc")
+		return Layout::Channels;
+
+	if (layout == "blocked" || layout == "nchwc")
+		return Layout::Blocked;
+
+	throw std::runtime_error("Invalid layout '" + layout + "'");
+}
+
+// индекс значения (d, i, j) в блочном расположении (последний блок может быть неполным, поэтому дополнение не требуется)
+inline int BlockedIndex(const VolumeSize &size, int d, int i, int j) {
+	int block = d / LAYOUT_BLOCK_SIZE;
+	int start = block * LAYOUT_BLOCK_SIZE;
+	int blockSize = std::min(LAYOUT_BLOCK_SIZE, size.deep - start);
+
+	return start * size.height * size.width + (i * size.width + j) * blockSize + d - start;
+}
+
+// перевод значений из канального расположения в блочное
+void ChannelsToBlocked(const real *src, real *dst, const VolumeSize &size) {
+	for (int start = 0; start < size.deep; start += LAYOUT_BLOCK_SIZE) {
+		int blockSize = std::min(LAYOUT_BLOCK_SIZE, size.deep - start);
+		real *block = dst + start * size.height * size.width;
+
+		for (int i = 0; i < size.height * size.width; i++)
+			for (int d = 0; d < blockSize; d++)
+				block[i * blockSize + d] = src[i * size.deep + start + d];
+	}
+}
+
+// перевод значений из блочного расположения в канальное
+void BlockedToChannels(const real *src, real *dst, const VolumeSize &size) {
+	for (int start = 0; start < size.deep; start += LAYOUT_BLOCK_SIZE) {
+		int blockSize = std::min(LAYOUT_BLOCK_SIZE, size.deep - start);
+		const real *block = src + start * size.height * size.width;
+
+		for (int i = 0; i < size.height * size.width; i++)
+			for (int d = 0; d < blockSize; d++)
+				dst[i * size.deep + start + d] = block[i * blockSize + d];
+	}
+}
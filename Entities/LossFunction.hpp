@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Volume.hpp"
+#include "Tensor.hpp"
 
 class LossFunction {
 protected:
@@ -31,8 +32,8 @@ public:
 	virtual double CalculateLoss(const Volume &y, const Volume &t, Volume &deltas) const; // вычисление значений функции ошибки и её производных
 	virtual double CalculateLoss(const Volume &y, const Volume &t) const; // вычисление значений функции ошибки
 	
-	double CalculateLoss(const std::vector<Volume> &y, const std::vector<Volume> &t, std::vector<Volume> &deltas) const; // вычисление значений функции ошибки и её производных для батча
-	double CalculateLoss(const std::vector<Volume> &y, const std::vector<Volume> &t) const; // вычисление значений функции ошибки для батча
+	double CalculateLoss(const Tensor &y, const Tensor &t, Tensor &deltas) const; // вычисление значений функции ошибки и её производных для батча
+	double CalculateLoss(const Tensor &y, const Tensor &t) const; // вычисление значений функции ошибки для батча
 
 	std::string GetName() const; // получение названия функции
 };
@@ -138,7 +139,7 @@ double LossFunction::CalculateLoss(const Volume &y, const Volume &t) const {
 	}
 	else if (type == LossType::CrossEntropy) {
 		for (int i = 0; i < total; i++) {
-			double yi = std::max(1e-7, std::min(1 - 1e-7, y[i]));
+			double yi = std::max(1e-7, std::min(1 - 1e-7, (double) y[i]));
 			double ti = t[i];
 
 			loss -= ti * log(yi);
@@ -167,7 +168,7 @@ double LossFunction::CalculateLoss(const Volume &y, const Volume &t) const {
 }
 
 // вычисление значений функции ошибки и её производных для батча
-double LossFunction::CalculateLoss(const std::vector<Volume> &y, const std::vector<Volume> &t, std::vector<Volume> &deltas) const {
+double LossFunction::CalculateLoss(const Tensor &y, const Tensor &t, Tensor &deltas) const {
 	double loss = 0;
 
 	for (size_t i = 0; i < deltas.size(); i++)
@@ -177,7 +178,7 @@ double LossFunction::CalculateLoss(const std::vector<Volume> &y, const std::vect
 }
 
 // вычисление значений функции ошибки для батча
-double LossFunction::CalculateLoss(const std::vector<Volume> &y, const std::vector<Volume> &t) const {
+double LossFunction::CalculateLoss(const Tensor &y, const Tensor &t) const {
 	double loss = 0;
 
 	for (size_t i = 0; i < y.size(); i++)
@@ -4,16 +4,27 @@
 #include <iomanip>
 #include <vector>
 
+#include "Real.hpp"
+#include "AlignedAllocator.hpp"
+
+// матрица в одном выровненном буфере по строкам: элемент (i, j) лежит в values[i * m + j],
+// поэтому матрицу целиком можно передавать в Gemm с шагами строк m и столбцов 1
 class Matrix {
 	int n; // число строк
 	int m; // число столбцов
-	std::vector<std::vector<double>> values; // значения
+	AlignedVector values; // значения
 
 public:
 	Matrix(int n, int m); // конструктор из заданных размеров
 
-	double& operator()(int i, int j); // индексация
-	double operator()(int i, int j) const; // индексация
+	int Rows() const; // число строк
+	int Cols() const; // число столбцов
+
+	real& operator()(int i, int j); // индексация
+	real operator()(int i, int j) const; // индексация
+
+	real* Data(); // указатель на значения
+	const real* Data() const; // указатель на значения
 
 	friend std::ostream& operator<<(std::ostream& os, const Matrix &matrix);
 };
@@ -23,23 +34,43 @@ Matrix::Matrix(int n, int m) {
 	this->n = n;
 	this->m = m;
 
-	values = std::vector<std::vector<double>>(n, std::vector<double>(m, 0));
+	values = AlignedVector((size_t) n * m, 0);
+}
+
+// число строк
+int Matrix::Rows() const {
+	return n;
+}
+
+// число столбцов
+int Matrix::Cols() const {
+	return m;
 }
 
 // индексация
-double& Matrix::operator()(int i, int j) {
-	return values[i][j];
+inline real& Matrix::operator()(int i, int j) {
+	return values[(size_t) i * m + j];
 }
 
 // индексация
-double Matrix::operator()(int i, int j) const {
-	return values[i][j];
+inline real Matrix::operator()(int i, int j) const {
+	return values[(size_t) i * m + j];
+}
+
+// указатель на значения
+real* Matrix::Data() {
+	return values.data();
+}
+
+// указатель на значения
+const real* Matrix::Data() const {
+	return values.data();
 }
 
 std::ostream& operator<<(std::ostream& os, const Matrix &matrix) {
 	for (int i = 0; i < matrix.n; i++) {
 		for (int j = 0; j < matrix.m; j++)
-			os << std::setw(5) << matrix.values[i][j] << " ";
+			os << std::setw(5) << matrix(i, j) << " ";
 
 		os << std::endl;
 	}
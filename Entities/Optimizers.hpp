@@ -3,6 +3,7 @@
 #include <cmath>
 #include <algorithm>
 #include "ArgParser.hpp"
+#include "Real.hpp"
 
 #define OPTIMIZER_PARAMS_COUNT 3
 
@@ -31,17 +32,17 @@ class Optimizer {
 	double param4; // четвёртый параметр оптимизатора
 	int epoch; // номер эпохи
 
-	void UpdateSGD(double grad, double &dw, double &dw2, double &dw3, double &w) const; // обновление веса для стохастического градиентного спуска
-	void UpdateSGDm(double grad, double &dw, double &dw2, double &dw3, double &w) const; // обновление веса для стохастического градиентного спуска с моментом
-	void UpdateAdagrad(double grad, double &dw, double &dw2, double &dw3, double &w) const; // обновление веса для адаптивного градиента
-	void UpdateRMSprop(double grad, double &dw, double &dw2, double &dw3, double &w) const; // обновление веса для RMSprop
-	void UpdateAdadelta(double grad, double &dw, double &dw2, double &dw3, double &w) const; // обновление веса для адаптивного градиента со скользящим средним
-	void UpdateNAG(double grad, double &dw, double &dw2, double &dw3, double &w) const; // обновление веса для ускоренного градиента Нестерова
-	void UpdateAdam(double grad, double &dw, double &dw2, double &dw3, double &w) const; // обновление веса для адаптивного момента
-	void UpdateAdaMax(double grad, double &dw, double &dw2, double &dw3, double &w) const; // обновление веса для AdaMax
-	void UpdateNadam(double grad, double &dw, double &dw2, double &dw3, double &w) const; // обновление веса для Nadam
-	void UpdateAMSgrad(double grad, double &dw, double &dw2, double &dw3, double &w) const; // обновление веса для AMSgrad
-	void UpdateAdaBound(double grad, double &dw, double &dw2, double &dw3, double &w) const; // обновление веса для AdaBound
+	void UpdateSGD(real grad, real &dw, real &dw2, real &dw3, real &w) const; // обновление веса для стохастического градиентного спуска
+	void UpdateSGDm(real grad, real &dw, real &dw2, real &dw3, real &w) const; // обновление веса для стохастического градиентного спуска с моментом
+	void UpdateAdagrad(real grad, real &dw, real &dw2, real &dw3, real &w) const; // обновление веса для адаптивного градиента
+	void UpdateRMSprop(real grad, real &dw, real &dw2, real &dw3, real &w) const; // обновление веса для RMSprop
+	void UpdateAdadelta(real grad, real &dw, real &dw2, real &dw3, real &w) const; // обновление веса для адаптивного градиента со скользящим средним
+	void UpdateNAG(real grad, real &dw, real &dw2, real &dw3, real &w) const; // обновление веса для ускоренного градиента Нестерова
+	void UpdateAdam(real grad, real &dw, real &dw2, real &dw3, real &w) const; // обновление веса для адаптивного момента
+	void UpdateAdaMax(real grad, real &dw, real &dw2, real &dw3, real &w) const; // обновление веса для AdaMax
+	void UpdateNadam(real grad, real &dw, real &dw2, real &dw3, real &w) const; // обновление веса для Nadam
+	void UpdateAMSgrad(real grad, real &dw, real &dw2, real &dw3, real &w) const; // обновление веса для AMSgrad
+	void UpdateAdaBound(real grad, real &dw, real &dw2, real &dw3, real &w) const; // обновление веса для AdaBound
 
 	Optimizer(OptimizerType type, double learningRate, double weightDecay, double beta1 = 0, double beta2 = 0, double param3 = 0, double param4 = 0);
 
@@ -60,7 +61,7 @@ public:
 	static Optimizer AMSgrad(double learningRate = 0.002, double weightDecay = 0, double beta1 = 0.9, double beta2 = 0.999); // AMSgrad
 	static Optimizer AdaBound(double learningRate = 0.001, double weightDecay = 0, double beta1 = 0.9, double beta2 = 0.999, double finalLearningRate = 0.1, double gamma = 1e-3); // AdaBound
 
-	void Update(double grad, double &dw, double &dw2, double &dw3, double &w) const; // обновление весовых коэффициентов
+	void Update(real grad, real &dw, real &dw2, real &dw3, real &w) const; // обновление весовых коэффициентов
 	void Print() const; // вывод информации об алгоритме
 
 	void SetEpoch(int epoch); // задание текущей эпохи
@@ -281,30 +282,30 @@ Optimizer Optimizer::AdaBound(double learningRate, double weightDecay, double be
 }
 
 // обновление веса для стохастического градиентного спуска
-void Optimizer::UpdateSGD(double grad, double &dw, double &dw2, double &dw3, double &w) const {
+void Optimizer::UpdateSGD(real grad, real &dw, real &dw2, real &dw3, real &w) const {
 	w -= learningRate * grad;
 }
 
 // обновление веса для стохастического градиентного спуска с моментом
-void Optimizer::UpdateSGDm(double grad, double &m, double &dw2, double &dw3, double &w) const {
+void Optimizer::UpdateSGDm(real grad, real &m, real &dw2, real &dw3, real &w) const {
 	m = beta1 * m + learningRate * grad;
 	w -= m;
 }
 
 // обновление веса для адаптивного градиента
-void Optimizer::UpdateAdagrad(double grad, double &G, double &dw2, double &dw3, double &w) const {
+void Optimizer::UpdateAdagrad(real grad, real &G, real &dw2, real &dw3, real &w) const {
 	G += grad * grad;
 	w -= learningRate * grad / sqrt(G + 1e-6);
 }
 
 // обновление веса для RMSprop
-void Optimizer::UpdateRMSprop(double grad, double &dw, double &dw2, double &dw3, double &w) const {
+void Optimizer::UpdateRMSprop(real grad, real &dw, real &dw2, real &dw3, real &w) const {
 	dw = dw * beta1 + (1 - beta1) * grad * grad;
 	w -= learningRate * grad / sqrt(dw + 1e-6);
 }
 
 // обновление веса для адаптивного градиента со скользящим средним
-void Optimizer::UpdateAdadelta(double grad, double &Eg, double &Ex, double &dw3, double &w) const {
+void Optimizer::UpdateAdadelta(real grad, real &Eg, real &Ex, real &dw3, real &w) const {
 	Eg = beta1 * Eg + (1 - beta1) * grad * grad;
 	double dw = -(sqrt(Ex + 1e-6)) / sqrt(Eg + 1e-6) * grad;
 	Ex = beta1 * Ex + (1 - beta1) * dw * dw;
@@ -312,14 +313,14 @@ void Optimizer::UpdateAdadelta(double grad, double &Eg, double &Ex, double &dw3,
 }
 
 // обновление веса для ускоренного градиента Нестерова
-void Optimizer::UpdateNAG(double grad, double &v, double &dw2, double &dw3, double &w) const {
+void Optimizer::UpdateNAG(real grad, real &v, real &dw2, real &dw3, real &w) const {
 	double prev = v;
 	v = beta1 * v - learningRate * grad;
 	w += beta1 * (v - prev) + v;
 }
 
 // обновление веса для адаптивного момента
-void Optimizer::UpdateAdam(double grad, double &m, double &v, double &dw3, double &w) const {
+void Optimizer::UpdateAdam(real grad, real &m, real &v, real &dw3, real &w) const {
 	m = beta1 * m + (1 - beta1) * grad;
 	v = beta2 * v + (1 - beta2) * grad * grad;
 
@@ -330,9 +331,9 @@ void Optimizer::UpdateAdam(double grad, double &m, double &v, double &dw3, doubl
 }
 
 // обновление веса для AdaMax
-void Optimizer::UpdateAdaMax(double grad, double &m, double &v, double &dw3, double &w) const {
+void Optimizer::UpdateAdaMax(real grad, real &m, real &v, real &dw3, real &w) const {
 	m = beta1 * m + (1 - beta1) * grad;
-	v = std::max(beta2 * v, fabs(grad));
+	v = std::max<real>(beta2 * v, fabs(grad));
 
 	double mt = m / (1 - pow(beta1, epoch));
 
@@ -340,7 +341,7 @@ void Optimizer::UpdateAdaMax(double grad, double &m, double &v, double &dw3, dou
 }
 
 // обновление веса для Nadam
-void Optimizer::UpdateNadam(double grad, double &m, double &v, double &dw3, double &w) const {
+void Optimizer::UpdateNadam(real grad, real &m, real &v, real &dw3, real &w) const {
 	double mt1 = m / (1 - pow(beta1, epoch));
 
 	m = beta1 * m + (1 - beta1) * grad;
@@ -353,7 +354,7 @@ void Optimizer::UpdateNadam(double grad, double &m, double &v, double &dw3, doub
 }
 
 // обновление веса для AMSgrad
-void Optimizer::UpdateAMSgrad(double grad, double &m, double &v, double &vt, double &w) const {
+void Optimizer::UpdateAMSgrad(real grad, real &m, real &v, real &vt, real &w) const {
 	m = beta1 * m + (1 - beta1) * grad;
 	v = beta2 * v + (1 - beta2) * grad * grad;
 
@@ -363,7 +364,7 @@ void Optimizer::UpdateAMSgrad(double grad, double &m, double &v, double &vt, dou
 }
 
 // обновление веса для AdaBound
-void Optimizer::UpdateAdaBound(double grad, double &m, double &v, double &dw3, double &w) const {
+void Optimizer::UpdateAdaBound(real grad, real &m, real &v, real &dw3, real &w) const {
 	m = beta1 * m + (1 - beta1) * grad;
 	v = beta2 * v + (1 - beta2) * grad * grad;
 	double mt = m / (1 - pow(beta1, epoch));
@@ -384,7 +385,7 @@ void Optimizer::UpdateAdaBound(double grad, double &m, double &v, double &dw3, d
 }
 
 // обновление весовых коэффициентов
-void Optimizer::Update(double grad, double &dw, double &dw2, double &dw3, double &w) const {
+void Optimizer::Update(real grad, real &dw, real &dw2, real &dw3, real &w) const {
 	w -= learningRate * weightDecay * w;
 
 	switch (type) {
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+#include "Real.hpp"
+
+#define QUANTIZED_INPUT_MAX 127 // наибольшее квантованное значение входа (7 бит: попарные суммы произведений на int8 веса не переполняют int16)
+#define QUANTIZED_WEIGHT_MAX 127 // наибольший модуль квантованного веса
+
+// параметры квантования входа слоя: x ≈ scale * (q - zeroPoint), q из [0, QUANTIZED_INPUT_MAX]
+struct QuantizationParams {
+	real scale; // шаг квантования
+	int zeroPoint; // квантованное значение нуля
+};
+
+// параметры квантования по найденному калибровкой диапазону значений
+// диапазон расширяется до нуля, чтобы нулевое дополнение свёртки представлялось точно
+QuantizationParams GetQuantizationParams(real min, real max) {
+	min = std::min(min, (real) 0);
+	max = std::max(max, (real) 0);
+
+	QuantizationParams params;
+	params.scale = max > min ? (max - min) / QUANTIZED_INPUT_MAX : 1;
+	params.zeroPoint = std::min(QUANTIZED_INPUT_MAX, std::max(0, (int) std::floor(-min / params.scale + 0.5)));
+
+	return params;
+}
+
+// квантование size значений x в беззнаковые байты q
+void QuantizeInputs(const real *x, int size, const QuantizationParams &params, uint8_t *q) {
+	real inv = 1 / params.scale;
+	int zeroPoint = params.zeroPoint;
+
+	#pragma omp simd
+	for (int i = 0; i < size; i++) {
+		int value = (int) std::floor(x[i] * inv + (real) 0.5) + zeroPoint;
+		q[i] = (uint8_t) std::min(QUANTIZED_INPUT_MAX, std::max(0, value));
+	}
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+// тип вещественных значений (сборка с -DUSE_FLOAT переводит библиотеку на одинарную точность)
+#ifdef USE_FLOAT
+typedef float real;
+#else
+typedef double real;
+#endif
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+
+#include "Real.hpp"
+#include "AlignedAllocator.hpp"
+
+// разреженная матрица rows x cols в формате CSR: ненулевые значения строки i лежат в values[offsets[i]], ..., values[offsets[i + 1] - 1],
+// а их столбцы (по возрастанию) - в columns по тем же индексам
+struct SparseMatrix {
+	int rows; // число строк
+	int cols; // число столбцов
+	std::vector<int> offsets; // начала строк (rows + 1 значение)
+	std::vector<int> columns; // столбцы ненулевых значений
+	AlignedVector values; // ненулевые значения по строкам
+
+	int NonZeros() const; // количество ненулевых значений
+};
+
+// количество ненулевых значений
+int SparseMatrix::NonZeros() const {
+	return values.size();
+}
+
+// транспонирование структуры матрицы: T (cols x rows) получает значения A, k-е значение T равно A.values[order[k]]
+// при изменении значений A (но не структуры) T обновляется копированием по order без повторного транспонирования
+void TransposeSparse(const SparseMatrix &A, SparseMatrix &T, std::vector<int> &order) {
+	T.rows = A.cols;
+	T.cols = A.rows;
+	T.offsets.assign(A.cols + 1, 0);
+	T.columns.resize(A.NonZeros());
+	T.values.resize(A.NonZeros());
+	order.resize(A.NonZeros());
+
+	for (int k = 0; k < A.NonZeros(); k++)
+		T.offsets[A.columns[k] + 1]++;
+
+	for (int j = 0; j < A.cols; j++)
+		T.offsets[j + 1] += T.offsets[j];
+
+	std::vector<int> positions(T.offsets.begin(), T.offsets.end() - 1);
+
+	for (int i = 0; i < A.rows; i++) {
+		for (int k = A.offsets[i]; k < A.offsets[i + 1]; k++) {
+			int position = positions[A.columns[k]]++;
+
+			T.columns[position] = i;
+			T.values[position] = A.values[k];
+			order[position] = k;
+		}
+	}
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <initializer_list>
+
+#include "Volume.hpp"
+
+// батч объёмов одинакового размера, хранящийся в одном непрерывном блоке памяти (N x H x W x C)
+// тензор может ссылаться на значения другого тензора (Alias), тогда он не владеет памятью
+class Tensor {
+	VolumeSize volumeSize; // размер одного примера
+	int total; // количество значений в одном примере
+
+	AlignedVector values; // значения всех примеров подряд
+	real *data; // начало батча (values или значения другого тензора)
+	bool alias; // ссылается ли тензор на значения другого тензора
+	std::vector<Volume> volumes; // примеры батча, ссылающиеся на data
+
+	void Init(size_t batchSize, VolumeSize size);
+	void InitVolumes(size_t batchSize); // создание представлений примеров
+
+public:
+	Tensor();
+	Tensor(size_t batchSize, VolumeSize size);
+	Tensor(size_t batchSize, int width, int height, int deep);
+	Tensor(const std::vector<Volume> &volumes); // упаковка набора объёмов в непрерывную память
+	Tensor(std::initializer_list<Volume> volumes);
+
+	Tensor(const Tensor &tensor);
+	Tensor(Tensor &&tensor) = default;
+
+	Tensor& operator=(const Tensor &tensor);
+	Tensor& operator=(Tensor &&tensor) = default;
+
+	void Resize(size_t batchSize, VolumeSize size); // изменение размера тензора без перевыделения памяти в пределах ёмкости
+	void Alias(const Tensor &tensor); // использование значений другого тензора без копирования
+	void Alias(const Tensor &tensor, VolumeSize size); // использование значений другого тензора с другим размером примера
+	void Alias(real *data, size_t batchSize, VolumeSize size); // использование внешней памяти без копирования
+	void Detach(); // возврат к собственным значениям
+	bool IsAlias() const; // ссылается ли тензор на значения другого тензора
+
+	size_t size() const; // количество примеров в батче
+	size_t Capacity() const; // количество примеров, помещающихся в выделенную память
+	VolumeSize GetSize() const; // размер одного примера
+	int Total() const; // количество значений в одном примере
+
+	Volume& operator[](size_t index); // получение примера
+	const Volume& operator[](size_t index) const; // получение примера
+
+	real* Data(); // указатель на начало батча
+	const real* Data() const; // указатель на начало батча
+};
+
+void Tensor::Init(size_t batchSize, VolumeSize size) {
+	this->volumeSize = size;
+	this->total = size.width * size.height * size.deep;
+
+	values = AlignedVector(batchSize * total, 0);
+	data = values.data();
+	alias = false;
+
+	InitVolumes(batchSize);
+}
+
+// создание представлений примеров
+void Tensor::InitVolumes(size_t batchSize) {
+	volumes.clear();
+	volumes.reserve(batchSize);
+
+	for (size_t i = 0; i < batchSize; i++)
+		volumes.emplace_back(volumeSize, data + i * total);
+}
+
+Tensor::Tensor() {
+	volumeSize.width = 0;
+	volumeSize.height = 0;
+	volumeSize.deep = 0;
+	total = 0;
+	data = nullptr;
+	alias = false;
+}
+
+Tensor::Tensor(size_t batchSize, VolumeSize size) {
+	Init(batchSize, size);
+}
+
+Tensor::Tensor(size_t batchSize, int width, int height, int deep) {
+	VolumeSize size;
+	size.width = width;
+	size.height = height;
+	size.deep = deep;
+
+	Init(batchSize, size);
+}
+
+// упаковка набора объёмов в непрерывную память
+Tensor::Tensor(const std::vector<Volume> &volumes) : Tensor() {
+	if (volumes.size() == 0)
+		return;
+
+	Init(volumes.size(), volumes[0].GetSize());
+
+	for (size_t i = 0; i < volumes.size(); i++)
+		this->volumes[i] = volumes[i];
+}
+
+Tensor::Tensor(std::initializer_list<Volume> volumes) : Tensor(std::vector<Volume>(volumes)) {
+
+}
+
+Tensor::Tensor(const Tensor &tensor) : volumeSize(tensor.volumeSize), total(tensor.total), values(tensor.data, tensor.data + tensor.volumes.size() * tensor.total), alias(false) {
+	data = values.data();
+	InitVolumes(tensor.volumes.size());
+}
+
+Tensor& Tensor::operator=(const Tensor &tensor) {
+	if (this == &tensor)
+		return *this;
+
+	volumeSize = tensor.volumeSize;
+	total = tensor.total;
+	values.assign(tensor.data, tensor.data + tensor.volumes.size() * tensor.total);
+	data = values.data();
+	alias = false;
+
+	InitVolumes(tensor.volumes.size());
+
+	return *this;
+}
+
+// изменение размера тензора (память выделяется только при превышении наибольшего ранее выделенного объёма, значения не обнуляются)
+void Tensor::Resize(size_t batchSize, VolumeSize size) {
+	if (!alias && volumes.size() == batchSize && volumeSize == size)
+		return;
+
+	volumeSize = size;
+	total = size.width * size.height * size.deep;
+
+	if (values.size() < batchSize * total)
+		values = AlignedVector(batchSize * total, 0);
+
+	data = values.data();
+	alias = false;
+
+	InitVolumes(batchSize);
+}
+
+// использование значений другого тензора без копирования
+void Tensor::Alias(const Tensor &tensor) {
+	Alias(tensor, tensor.volumeSize);
+}
+
+// использование значений другого тензора с другим размером примера (значения не копируются и не выделяются)
+void Tensor::Alias(const Tensor &tensor, VolumeSize size) {
+	if (size.width * size.height * size.deep != tensor.total)
+		throw std::runtime_error("Unable to alias tensor: different sizes");
+
+	Alias(const_cast<real*>(tensor.data), tensor.volumes.size(), size);
+}
+
+// использование внешней памяти без копирования (память должна вмещать batchSize примеров и жить дольше тензора)
+void Tensor::Alias(real *data, size_t batchSize, VolumeSize size) {
+	if (alias && this->data == data && volumes.size() == batchSize && volumeSize == size)
+		return; // представления уже построены
+
+	volumeSize = size;
+	total = size.width * size.height * size.deep;
+	this->data = data;
+	alias = true;
+
+	InitVolumes(batchSize);
+}
+
+// возврат к собственным значениям с текущим количеством примеров
+void Tensor::Detach() {
+	if (!alias)
+		return;
+
+	size_t batchSize = volumes.size();
+
+	if (values.size() < batchSize * total)
+		values = AlignedVector(batchSize * total, 0);
+
+	data = values.data();
+	alias = false;
+
+	InitVolumes(batchSize);
+}
+
+// ссылается ли тензор на значения другого тензора
+bool Tensor::IsAlias() const {
+	return alias;
+}
+
+// количество примеров в батче
+size_t Tensor::size() const {
+	return volumes.size();
+}
+
+// количество примеров, помещающихся в выделенную память
+size_t Tensor::Capacity() const {
+	return total == 0 ? 0 : values.size() / total;
+}
+
+// размер одного примера
+VolumeSize Tensor::GetSize() const {
+	return volumeSize;
+}
+
+// количество значений в одном примере
+int Tensor::Total() const {
+	return total;
+}
+
+// получение примера
+Volume& Tensor::operator[](size_t index) {
+	return volumes[index];
+}
+
+// получение примера
+const Volume& Tensor::operator[](size_t index) const {
+	return volumes[index];
+}
+
+// указатель на начало батча
+real* Tensor::Data() {
+	return data;
+}
+
+// указатель на начало батча
+const real* Tensor::Data() const {
+	return data;
+}
@@ -3,7 +3,11 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <algorithm>
+#include <stdexcept>
 
+#include "Real.hpp"
+#include "AlignedAllocator.hpp"
 #include "Bitmap.hpp"
 
 // размерность объёма
@@ -36,7 +40,9 @@ struct VolumeSize {
 // объём
 class Volume {
 	VolumeSize size; // размерность объёма
-	std::vector<double> values; // значения объёма
+	AlignedVector values; // значения объёма (пусты, если объём ссылается на внешнюю память)
+	real *data; // указатель на значения объёма
+	bool isView; // ссылается ли объём на внешнюю память
 
 	int whd;
 	int dh;
@@ -47,24 +53,36 @@ class Volume {
 public:
 	Volume(int width, int height, int deep); // создание из размеров
 	Volume(VolumeSize size);
+	Volume(VolumeSize size, real *data); // создание объёма поверх внешней памяти без копирования
 
-	double& At(int d, int i, int j); // индексация
-	double At(int d, int i, int j) const; // индексация
+	Volume(const Volume &volume);
+	Volume(Volume &&volume);
 
-	double& operator()(int d, int i, int j); // индексация
-	double operator()(int d, int i, int j) const; // индексация
+	Volume& operator=(const Volume &volume);
+	Volume& operator=(Volume &&volume);
 
-	double& operator[](int i); // индексация
-	double operator[](int i) const; // индексация
+	real& At(int d, int i, int j); // индексация
+	real At(int d, int i, int j) const; // индексация
+
+	real& operator()(int d, int i, int j); // индексация
+	real operator()(int d, int i, int j) const; // индексация
+
+	real& operator[](int i); // индексация
+	real operator[](int i) const; // индексация
 
 	int Deep() const; // получение глубины
 	int Height() const; // получение высоты
 	int Width() const; // получение ширины
+	int Total() const; // получение общего количества значений
+
+	real* Data(); // получение указателя на значения
+	const real* Data() const; // получение указателя на значения
+	bool IsView() const; // ссылается ли объём на внешнюю память
 
-	double Min() const; // минимальное значение
-	double Max() const; // максимальное значение
-	double Mean() const; // среднее значение
-	double StdDev() const; // среднеквадратичное отклонение
+	real Min() const; // минимальное значение
+	real Max() const; // максимальное значение
+	real Mean() const; // среднее значение
+	real StdDev() const; // среднеквадратичное отклонение
 
 	VolumeSize GetSize() const; // получение размера
 	Volume Resize(int newWidth, int newHeight); // билинейное масштабирование
@@ -86,7 +104,9 @@ void Volume::Init(int width, int height, int deep) {
 	dh = deep * height;
 	dw = deep * width;
 
-	values = std::vector<double>(deep * height * width, 0);
+	values = AlignedVector(deep * height * width, 0);
+	data = values.data();
+	isView = false;
 }
 
 // создание из размеров
@@ -99,34 +119,105 @@ Volume::Volume(VolumeSize size) {
 	Init(size.width, size.height, size.deep);
 }
 
+// создание объёма поверх внешней памяти без копирования
+Volume::Volume(VolumeSize size, real *data) {
+	this->size = size;
+	this->data = data;
+
+	whd = size.width * size.height * size.deep;
+	dh = size.deep * size.height;
+	dw = size.deep * size.width;
+
+	isView = true;
+}
+
+// копирование всегда создаёт собственные значения
+Volume::Volume(const Volume &volume) : size(volume.size), values(volume.data, volume.data + volume.whd) {
+	data = values.data();
+	isView = false;
+
+	whd = volume.whd;
+	dh = volume.dh;
+	dw = volume.dw;
+}
+
+// перемещение сохраняет ссылку на внешнюю память у объёмов-представлений
+Volume::Volume(Volume &&volume) : size(volume.size), values(std::move(volume.values)) {
+	data = volume.isView ? volume.data : values.data();
+	isView = volume.isView;
+
+	whd = volume.whd;
+	dh = volume.dh;
+	dw = volume.dw;
+}
+
+// присваивание в объём-представление копирует значения в его память
+Volume& Volume::operator=(const Volume &volume) {
+	if (this == &volume)
+		return *this;
+
+	if (isView) {
+		if (whd != volume.whd)
+			throw std::runtime_error("Unable to assign volume: different sizes");
+
+		std::copy(volume.data, volume.data + volume.whd, data);
+	}
+	else {
+		values.assign(volume.data, volume.data + volume.whd);
+		data = values.data();
+	}
+
+	size = volume.size;
+	whd = volume.whd;
+	dh = volume.dh;
+	dw = volume.dw;
+
+	return *this;
+}
+
+Volume& Volume::operator=(Volume &&volume) {
+	if (isView || volume.isView)
+		return *this = volume;
+
+	values = std::move(volume.values);
+	data = values.data();
+
+	size = volume.size;
+	whd = volume.whd;
+	dh = volume.dh;
+	dw = volume.dw;
+
+	return *this;
+}
+
 // индексация
-double& Volume::At(int d, int i, int j) {
-	return values[i * dw + j * size.deep + d];
+real& Volume::At(int d, int i, int j) {
+	return data[i * dw + j * size.deep + d];
 }
 
 // индексация
-double Volume::At(int d, int i, int j) const {
-	return values[i * dw + j * size.deep + d];
+real Volume::At(int d, int i, int j) const {
+	return data[i * dw + j * size.deep + d];
 }
 
 // индексация
-double& Volume::operator()(int d, int i, int j) {
-	return values[i * dw + j * size.deep + d];
+real& Volume::operator()(int d, int i, int j) {
+	return data[i * dw + j * size.deep + d];
 }
 
 // индексация
-double Volume::operator()(int d, int i, int j) const {
-	return values[i * dw + j * size.deep + d];
+real Volume::operator()(int d, int i, int j) const {
+	return data[i * dw + j * size.deep + d];
 }
 
 // индексация
-double& Volume::operator[](int i) {
-	return values[i];
+real& Volume::operator[](int i) {
+	return data[i];
 }
 
 // индексация
-double Volume::operator[](int i) const {
-	return values[i];
+real Volume::operator[](int i) const {
+	return data[i];
 }
 
 // получение глубины
@@ -144,47 +235,67 @@ int Volume::Width() const {
 	return size.width;
 }
 
+// получение общего количества значений
+int Volume::Total() const {
+	return whd;
+}
+
+// получение указателя на значения
+real* Volume::Data() {
+	return data;
+}
+
+// получение указателя на значения
+const real* Volume::Data() const {
+	return data;
+}
+
+// ссылается ли объём на внешнюю память
+bool Volume::IsView() const {
+	return isView;
+}
+
 // минимальное значение
-double Volume::Min() const {
-	double min = values[0];
+real Volume::Min() const {
+	real min = data[0];
 
-	for (size_t i = 1; i < values.size(); i++)
-		if (values[i] < min)
-			min = values[i];
+	for (size_t i = 1; i < whd; i++)
+		if (data[i] < min)
+			min = data[i];
 
 	return min;
 }
 
 // максимальное значение
-double Volume::Max() const {
-	double max = values[0];
+real Volume::Max() const {
+	real max = data[0];
 
-	for (size_t i = 1; i < values.size(); i++)
-		if (values[i] > max)
-			max = values[i];
+	for (size_t i = 1; i < whd; i++)
+		if (data[i] > max)
+			max = data[i];
 
 	return max;
 }
 
 // среднее значение
-double Volume::Mean() const {
-	double sum = 0;
+real Volume::Mean() const {
+	real sum = 0;
 
-	for (size_t i = 0; i < values.size(); i++)
-		sum += values[i];
+	for (size_t i = 0; i < whd; i++)
+		sum += data[i];
 
-	return sum / values.size();
+	return sum / whd;
 }
 
 // среднеквадратичное отклонение
-double Volume::StdDev() const {
-	double avg = Mean();
-	double stddev = 0;
+real Volume::StdDev() const {
+	real avg = Mean();
+	real stddev = 0;
 
-	for (size_t i = 0; i < values.size(); i++)
-		stddev += (values[i] - avg) * (values[i] - avg);
+	for (size_t i = 0; i < whd; i++)
+		stddev += (data[i] - avg) * (data[i] - avg);
 
-	return stddev / values.size();
+	return stddev / whd;
 }
 
 // получение размера
@@ -196,24 +307,24 @@ VolumeSize Volume::GetSize() const {
 Volume Volume::Resize(int newWidth, int newHeight) {
 	Volume result(newWidth, newHeight, size.deep);
 
-	double wscale = (newWidth - 1.0) / (size.width - 1.0);
-	double hscale = (newHeight - 1.0) / (size.height - 1.0);
+	real wscale = (newWidth - 1.0) / (size.width - 1.0);
+	real hscale = (newHeight - 1.0) / (size.height - 1.0);
 
 	for (int i = 0; i < newHeight; i++) {
 		int y = std::min(int(i / hscale), size.height - 2);
-		double dy = (i / hscale) - y;
+		real dy = (i / hscale) - y;
 
 		for (int j = 0; j < newWidth; j++) {
 			int x = std::min(int(j / wscale), size.width - 2);
-			double dx = (j / wscale) - x;
+			real dx = (j / wscale) - x;
 
-			double b0 = (1 - dx) * (1 - dy);
-			double b1 = dx * (1 - dy);
-			double b2 = (1 - dx) * dy;
-			double b3 = dx * dy;
+			real b0 = (1 - dx) * (1 - dy);
+			real b1 = dx * (1 - dy);
+			real b2 = (1 - dx) * dy;
+			real b3 = dx * dy;
 
 			for (int d = 0; d < size.deep; d++) {
-				double sum = 0;
+				real sum = 0;
 
 				sum += b0 * At(d, y, x);
 				sum += b1 * At(d, y, x + 1);
@@ -232,18 +343,18 @@ Volume Volume::Resize(int newWidth, int newHeight) {
 Volume Volume::ResizeBicubic(int newWidth, int newHeight) {
 	Volume result(newWidth, newHeight, size.deep);
 
-	double wscale = (newWidth - 1.0) / (size.width - 1.0);
-	double hscale = (newHeight - 1.0) / (size.height - 1.0);
+	real wscale = (newWidth - 1.0) / (size.width - 1.0);
+	real hscale = (newHeight - 1.0) / (size.height - 1.0);
 
 	for (int i = 0; i < newHeight; i++) {
 		int y = std::max(1, std::min(int(i / hscale), size.height - 3));
-		double dy = (i / hscale) - y;
+		real dy = (i / hscale) - y;
 
 		for (int j = 0; j < newWidth; j++) {
 			int x = std::max(1, std::min(int(j / wscale), size.width - 3));
-			double dx = (j / wscale) - x;
+			real dx = (j / wscale) - x;
 
-			double b[16];
+			real b[16];
 			b[0] = 1.0 / 4 * (dx - 1) * (dx - 2) * (dx + 1) * (dy - 1) * (dy - 2) * (dy + 1);
 			b[1] = -1.0 / 4 * dx * (dx + 1) * (dx - 2) * (dy - 1) * (dy - 2) * (dy + 1);
 			b[2] = -1.0 / 4 * dy * (dx - 1) * (dx - 2) * (dx + 1) * (dy + 1) * (dy - 2);
@@ -262,7 +373,7 @@ Volume Volume::ResizeBicubic(int newWidth, int newHeight) {
 			b[15] = 1.0 / 36 * dx * dy * (dx - 1) * (dx + 1) * (dy - 1) * (dy + 1);
 
 			for (int d = 0; d < size.deep; d++) {
-				double sum = 0;
+				real sum = 0;
 
 				sum += b[0] * At(d, y, x);
 				sum += b[1] * At(d, y, x + 1);
@@ -298,7 +409,7 @@ void Volume::Save(const std::string &path, int blockSize) const {
 		BitmapImage image(blockSize, size.deep * blockSize);
 
 		for (int d = 0; d < size.deep; d++) {
-			int value = std::min(255.0, std::max(0.0, values[d]));
+			int value = std::min(real(255), std::max(real(0), data[d]));
 
 			for (int i = 0; i < blockSize; i++)
 				for (int j = 0; j < blockSize; j++)
@@ -312,9 +423,9 @@ void Volume::Save(const std::string &path, int blockSize) const {
 
 		for (int y = 0; y < size.height; y++) {
 			for (int x = 0; x < size.width; x++) {
-				int r = std::min(255.0, std::max(0.0, At(0, y, x)));
-				int g = std::min(255.0, std::max(0.0, At(1, y, x)));
-				int b = std::min(255.0, std::max(0.0, At(2, y, x)));
+				int r = std::min(real(255), std::max(real(0), At(0, y, x)));
+				int g = std::min(real(255), std::max(real(0), At(1, y, x)));
+				int b = std::min(real(255), std::max(real(0), At(2, y, x)));
 
 				for (int i = 0; i < blockSize; i++)
 					for (int j = 0; j < blockSize; j++)
@@ -330,7 +441,7 @@ void Volume::Save(const std::string &path, int blockSize) const {
 
 			for (int y = 0; y < size.height; y++) {
 				for (int x = 0; x < size.width; x++) {
-					int br = std::min(255.0, std::max(0.0, At(d, y, x)));
+					int br = std::min(real(255), std::max(real(0), At(d, y, x)));
 					
 					for (int i = 0; i < blockSize; i++)
 						for (int j = 0; j < blockSize; j++)
@@ -375,7 +486,7 @@ std::ostream& operator<<(std::ostream& os, const Volume &volume) {
 	for (int d = 0; d < volume.size.deep; d++) {
 		for (int i = 0; i < volume.size.height; i++) {
 			for (int j = 0; j < volume.size.width; j++)
-				os << volume.values[i * volume.dw + j * volume.size.deep + d] << " ";
+				os << volume.data[i * volume.dw + j * volume.size.deep + d] << " ";
 			
 			os << std::endl;
 		}
@@ -9,18 +9,20 @@
 
 class ELULayer : public NetworkLayer {
 	int total;
-	double alpha;
+	real alpha;
 
 public:
-	ELULayer(VolumeSize size, double alpha);
+	ELULayer(VolumeSize size, real alpha);
 
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	void ForwardOutput(const Tensor &X); // прямое распространение без вычисления производных
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
+	Layout GetLayout() const; // расположение входа и выхода слоя
 
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
 };
 
-ELULayer::ELULayer(VolumeSize size, double alpha) : NetworkLayer(size) {
+ELULayer::ELULayer(VolumeSize size, real alpha) : NetworkLayer(size) {
 	this->alpha = alpha;
 	total = size.width * size.height * size.deep;
 
@@ -28,8 +30,19 @@ ELULayer::ELULayer(VolumeSize size, double alpha) : NetworkLayer(size) {
 	info = "alpha: " + std::to_string(alpha);
 }
 
+// прямое распространение без вычисления производных (при выводе градиенты не нужны)
+void ELULayer::ForwardOutput(const Tensor &X) {
+	#pragma omp parallel for collapse(2)
+	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
+		for (int i = 0; i < total; i++) {
+			real value = X[batchIndex][i];
+			output[batchIndex][i] = value > 0 ? value : alpha * (exp(value) - 1);
+		}
+	}
+}
+
 // прямое распространение
-void ELULayer::Forward(const std::vector<Volume> &X) {
+void ELULayer::Forward(const Tensor &X) {
 	#pragma omp parallel for collapse(2)
 	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
 		for (int i = 0; i < total; i++) {
@@ -46,7 +59,7 @@ void ELULayer::Forward(const std::vector<Volume> &X) {
 }
 
 // обратное распространение
-void ELULayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
+void ELULayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
 	if (!calc_dX)
 		return;
 
@@ -56,6 +69,11 @@ void ELULayer::Backward(const std::vector<Volume> &dout, const std::vector<Volum
 			dX[batchIndex][i] *= dout[batchIndex][i];
 }
 
+// расположение входа и выхода слоя (поэлементный слой работает с любым)
+Layout ELULayer::GetLayout() const {
+	return Layout::Any;
+}
+
 // сохранение слоя в файл
 void ELULayer::Save(std::ofstream &f) const {
 	f << "elu " << inputSize << " " << alpha << std::endl;
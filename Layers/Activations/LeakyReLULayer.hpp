@@ -9,18 +9,21 @@
 
 class LeakyReLULayer : public NetworkLayer {
 	int total;
-	double alpha;
+	real alpha;
 
 public:
-	LeakyReLULayer(VolumeSize size, double alpha);
+	LeakyReLULayer(VolumeSize size, real alpha);
 
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	void ForwardOutput(const Tensor &X); // прямое распространение без вычисления производных
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
+	Layout GetLayout() const; // расположение входа и выхода слоя
+	bool GetActivation(EpilogueActivation &activation, real &alpha) const; // активация для эпилога предыдущего слоя
 
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
 };
 
-LeakyReLULayer::LeakyReLULayer(VolumeSize size, double alpha) : NetworkLayer(size) {
+LeakyReLULayer::LeakyReLULayer(VolumeSize size, real alpha) : NetworkLayer(size) {
 	total = size.width * size.height * size.deep;
 	this->alpha = alpha;
 
@@ -28,8 +31,19 @@ LeakyReLULayer::LeakyReLULayer(VolumeSize size, double alpha) : NetworkLayer(siz
 	info = "alpha: " + std::to_string(alpha);
 }
 
+// прямое распространение без вычисления производных (при выводе градиенты не нужны)
+void LeakyReLULayer::ForwardOutput(const Tensor &X) {
+	#pragma omp parallel for collapse(2)
+	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
+		for (int i = 0; i < total; i++) {
+			real value = X[batchIndex][i];
+			output[batchIndex][i] = value > 0 ? value : alpha * value;
+		}
+	}
+}
+
 // прямое распространение
-void LeakyReLULayer::Forward(const std::vector<Volume> &X) {
+void LeakyReLULayer::Forward(const Tensor &X) {
 	#pragma omp parallel for collapse(2)
 	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
 		for (int i = 0; i < total; i++) {
@@ -46,7 +60,7 @@ void LeakyReLULayer::Forward(const std::vector<Volume> &X) {
 }
 
 // обратное распространение
-void LeakyReLULayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
+void LeakyReLULayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
 	if (!calc_dX)
 		return;
 
@@ -56,6 +70,18 @@ void LeakyReLULayer::Backward(const std::vector<Volume> &dout, const std::vector
 			dX[batchIndex][i] *= dout[batchIndex][i];
 }
 
+// расположение входа и выхода слоя (поэлементный слой работает с любым)
+Layout LeakyReLULayer::GetLayout() const {
+	return Layout::Any;
+}
+
+// активация для эпилога предыдущего слоя
+bool LeakyReLULayer::GetActivation(EpilogueActivation &activation, real &alpha) const {
+	activation = EpilogueActivation::LeakyReLU;
+	alpha = this->alpha;
+	return true;
+}
+
 // сохранение слоя в файл
 void LeakyReLULayer::Save(std::ofstream &f) const {
 	f << "leakyrelu " << inputSize << " " << alpha << std::endl;
@@ -13,8 +13,10 @@ class LogSigmoidLayer : public NetworkLayer {
 public:
 	LogSigmoidLayer(VolumeSize size);
 
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	void ForwardOutput(const Tensor &X); // прямое распространение без вычисления производных
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
+	Layout GetLayout() const; // расположение входа и выхода слоя
 
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
 };
@@ -26,8 +28,18 @@ LogSigmoidLayer::LogSigmoidLayer(VolumeSize size) : NetworkLayer(size) {
 	info = "";
 }
 
+// прямое распространение без вычисления производных (при выводе градиенты не нужны)
+void LogSigmoidLayer::ForwardOutput(const Tensor &X) {
+	#pragma omp parallel for collapse(2)
+	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
+		for (int i = 0; i < total; i++) {
+			output[batchIndex][i] = log(1.0 / (1 + exp(-X[batchIndex][i])));
+		}
+	}
+}
+
 // прямое распространение
-void LogSigmoidLayer::Forward(const std::vector<Volume> &X) {
+void LogSigmoidLayer::Forward(const Tensor &X) {
 	#pragma omp parallel for collapse(2)
 	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
 		for (int i = 0; i < total; i++) {
@@ -38,7 +50,7 @@ void LogSigmoidLayer::Forward(const std::vector<Volume> &X) {
 }
 
 // обратное распространение
-void LogSigmoidLayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
+void LogSigmoidLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
 	if (!calc_dX)
 		return;
 
@@ -48,6 +60,11 @@ void LogSigmoidLayer::Backward(const std::vector<Volume> &dout, const std::vecto
 			dX[batchIndex][i] *= dout[batchIndex][i];
 }
 
+// расположение входа и выхода слоя (поэлементный слой работает с любым)
+Layout LogSigmoidLayer::GetLayout() const {
+	return Layout::Any;
+}
+
 // сохранение слоя в файл
 void LogSigmoidLayer::Save(std::ofstream &f) const {
 	f << "logsigmoid " << inputSize << std::endl;
@@ -10,7 +10,7 @@
 
 class ParametricReLULayer : public NetworkLayer {
 	std::default_random_engine generator;
-	std::normal_distribution<double> distribution;
+	std::normal_distribution<real> distribution;
 
 	int total;
 	Volume alpha;
@@ -27,16 +27,17 @@ public:
 
 	int GetTrainableParams() const; // получение количества обучаемых параметров
 
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	void ForwardOutput(const Tensor &X); // прямое распространение без вычисления производных
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
 	void UpdateWeights(const Optimizer &optimizer, bool trainable); // обновление весовых коэффициентов
 
 	void ResetCache(); // сброс параметров
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
 
-	void SetParam(int index, double weight); // установка веса по индексу
-	double GetParam(int index) const; // получение веса по индексу
-	double GetGradient(int index) const; // получение градиента веса по индексу
+	void SetParam(int index, real weight); // установка веса по индексу
+	real GetParam(int index) const; // получение веса по индексу
+	real GetGradient(int index) const; // получение градиента веса по индексу
 	void ZeroGradient(int index); // обнуление градиента веса по индексу
 };
 
@@ -83,8 +84,19 @@ int ParametricReLULayer::GetTrainableParams() const {
 	return total;
 }
 
+// прямое распространение без вычисления производных (при выводе градиенты не нужны)
+void ParametricReLULayer::ForwardOutput(const Tensor &X) {
+	#pragma omp parallel for collapse(2)
+	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
+		for (int i = 0; i < total; i++) {
+			real value = X[batchIndex][i];
+			output[batchIndex][i] = value > 0 ? value : alpha[i] * value;
+		}
+	}
+}
+
 // прямое распространение
-void ParametricReLULayer::Forward(const std::vector<Volume> &X) {
+void ParametricReLULayer::Forward(const Tensor &X) {
 	#pragma omp parallel for collapse(2)
 	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
 		for (int i = 0; i < total; i++) {
@@ -101,7 +113,7 @@ void ParametricReLULayer::Forward(const std::vector<Volume> &X) {
 }
 
 // обратное распространение
-void ParametricReLULayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
+void ParametricReLULayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
 	for (size_t batchIndex = 0; batchIndex < dout.size(); batchIndex++)
 		for (int i = 0; i < total; i++)
 			if (X[batchIndex][i] <= 0)
@@ -146,17 +158,17 @@ void ParametricReLULayer::Save(std::ofstream &f) const {
 }
 
 // установка веса по индексу
-void ParametricReLULayer::SetParam(int index, double weight) {
+void ParametricReLULayer::SetParam(int index, real weight) {
 	alpha[index] = weight;
 }
 
 // получение веса по индексу
-double ParametricReLULayer::GetParam(int index) const {
+real ParametricReLULayer::GetParam(int index) const {
 	return alpha[index];
 }
 
 // получение градиента веса по индексу
-double ParametricReLULayer::GetGradient(int index) const {
+real ParametricReLULayer::GetGradient(int index) const {
 	return dalpha[index];
 }
 
@@ -13,8 +13,11 @@ class ReLULayer : public NetworkLayer {
 public:
 	ReLULayer(VolumeSize size);
 
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	void ForwardOutput(const Tensor &X); // прямое распространение без вычисления производных
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
+	Layout GetLayout() const; // расположение входа и выхода слоя
+	bool GetActivation(EpilogueActivation &activation, real &alpha) const; // активация для эпилога предыдущего слоя
 
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
 };
@@ -26,8 +29,19 @@ ReLULayer::ReLULayer(VolumeSize size) : NetworkLayer(size) {
 	info = "";
 }
 
+// прямое распространение без вычисления производных (при выводе градиенты не нужны)
+void ReLULayer::ForwardOutput(const Tensor &X) {
+	#pragma omp parallel for collapse(2)
+	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
+		for (int i = 0; i < total; i++) {
+			real value = X[batchIndex][i];
+			output[batchIndex][i] = value > 0 ? value : 0;
+		}
+	}
+}
+
 // прямое распространение
-void ReLULayer::Forward(const std::vector<Volume> &X) {
+void ReLULayer::Forward(const Tensor &X) {
 	#pragma omp parallel for collapse(2)
 	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
 		for (int i = 0; i < total; i++) {
@@ -44,7 +58,7 @@ void ReLULayer::Forward(const std::vector<Volume> &X) {
 }
 
 // обратное распространение
-void ReLULayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
+void ReLULayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
 	if (!calc_dX)
 		return;
 
@@ -54,6 +68,18 @@ void ReLULayer::Backward(const std::vector<Volume> &dout, const std::vector<Volu
 			dX[batchIndex][i] *= dout[batchIndex][i];
 }
 
+// расположение входа и выхода слоя (поэлементный слой работает с любым)
+Layout ReLULayer::GetLayout() const {
+	return Layout::Any;
+}
+
+// активация для эпилога предыдущего слоя
+bool ReLULayer::GetActivation(EpilogueActivation &activation, real &alpha) const {
+	activation = EpilogueActivation::ReLU;
+	alpha = 0;
+	return true;
+}
+
 // сохранение слоя в файл
 void ReLULayer::Save(std::ofstream &f) const {
 	f << "relu " << inputSize << std::endl;
@@ -13,8 +13,11 @@ class SigmoidLayer : public NetworkLayer {
 public:
 	SigmoidLayer(VolumeSize size);
 
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	void ForwardOutput(const Tensor &X); // прямое распространение без вычисления производных
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
+	Layout GetLayout() const; // расположение входа и выхода слоя
+	bool GetActivation(EpilogueActivation &activation, real &alpha) const; // активация для эпилога предыдущего слоя
 
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
 };
@@ -26,12 +29,22 @@ SigmoidLayer::SigmoidLayer(VolumeSize size) : NetworkLayer(size) {
 	info = "";
 }
 
+// прямое распространение без вычисления производных (при выводе градиенты не нужны)
+void SigmoidLayer::ForwardOutput(const Tensor &X) {
+	#pragma omp parallel for collapse(2)
+	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
+		for (int i = 0; i < total; i++) {
+			output[batchIndex][i] = 1.0 / (1 + exp(-X[batchIndex][i]));
+		}
+	}
+}
+
 // прямое распространение
-void SigmoidLayer::Forward(const std::vector<Volume> &X) {
+void SigmoidLayer::Forward(const Tensor &X) {
 	#pragma omp parallel for collapse(2)
 	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
 		for (int i = 0; i < total; i++) {
-			double value = 1.0 / (1 + exp(-X[batchIndex][i]));
+			real value = 1.0 / (1 + exp(-X[batchIndex][i]));
 
 			output[batchIndex][i] = value;
 			dX[batchIndex][i] = value * (1 - value);
@@ -40,7 +53,7 @@ void SigmoidLayer::Forward(const std::vector<Volume> &X) {
 }
 
 // обратное распространение
-void SigmoidLayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
+void SigmoidLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
 	if (!calc_dX)
 		return;
 
@@ -50,6 +63,18 @@ void SigmoidLayer::Backward(const std::vector<Volume> &dout, const std::vector<V
 			dX[batchIndex][i] *= dout[batchIndex][i];
 }
 
+// расположение входа и выхода слоя (поэлементный слой работает с любым)
+Layout SigmoidLayer::GetLayout() const {
+	return Layout::Any;
+}
+
+// активация для эпилога предыдущего слоя
+bool SigmoidLayer::GetActivation(EpilogueActivation &activation, real &alpha) const {
+	activation = EpilogueActivation::Sigmoid;
+	alpha = 0;
+	return true;
+}
+
 // сохранение слоя в файл
 void SigmoidLayer::Save(std::ofstream &f) const {
 	f << "sigmoid " << inputSize << std::endl;
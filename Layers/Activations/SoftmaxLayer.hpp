@@ -13,8 +13,9 @@ class SoftmaxLayer : public NetworkLayer {
 public:
 	SoftmaxLayer(VolumeSize size);
 
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
+	Layout GetLayout() const; // расположение входа и выхода слоя
 
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
 };
@@ -27,10 +28,10 @@ SoftmaxLayer::SoftmaxLayer(VolumeSize size) : NetworkLayer(size) {
 }
 
 // прямое распространение
-void SoftmaxLayer::Forward(const std::vector<Volume> &X) {
+void SoftmaxLayer::Forward(const Tensor &X) {
 	#pragma omp parallel for
 	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
-		double sum = 0;
+		real sum = 0;
 
 		for (int i = 0; i < total; i++) {
 			output[batchIndex][i] = exp(X[batchIndex][i]);
@@ -43,14 +44,14 @@ void SoftmaxLayer::Forward(const std::vector<Volume> &X) {
 }
 
 // обратное распространение
-void SoftmaxLayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
+void SoftmaxLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
 	if (!calc_dX)
 		return;
 
 	#pragma omp parallel for collapse(2)
 	for (size_t batchIndex = 0; batchIndex < dout.size(); batchIndex++) {
 		for (int i = 0; i < total; i++) {
-			double sum = 0;
+			real sum = 0;
 
 			for (int j = 0; j < total; j++)
 				sum += dout[batchIndex][j] * output[batchIndex][i] * ((i == j) - output[batchIndex][j]);
@@ -60,6 +61,11 @@ void SoftmaxLayer::Backward(const std::vector<Volume> &dout, const std::vector<V
 	}
 }
 
+// расположение входа и выхода слоя (softmax по всему объёму не зависит от порядка значений)
+Layout SoftmaxLayer::GetLayout() const {
+	return Layout::Any;
+}
+
 // сохранение слоя в файл
 void SoftmaxLayer::Save(std::ofstream &f) const {
 	f << "softmax " << inputSize << std::endl;
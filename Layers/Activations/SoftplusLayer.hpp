@@ -13,8 +13,10 @@ class SoftplusLayer : public NetworkLayer {
 public:
 	SoftplusLayer(VolumeSize size);
 
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	void ForwardOutput(const Tensor &X); // прямое распространение без вычисления производных
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
+	Layout GetLayout() const; // расположение входа и выхода слоя
 
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
 };
@@ -26,8 +28,18 @@ SoftplusLayer::SoftplusLayer(VolumeSize size) : NetworkLayer(size) {
 	info = "";
 }
 
+// прямое распространение без вычисления производных (при выводе градиенты не нужны)
+void SoftplusLayer::ForwardOutput(const Tensor &X) {
+	#pragma omp parallel for collapse(2)
+	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
+		for (int i = 0; i < total; i++) {
+			output[batchIndex][i] = log(1 + exp(X[batchIndex][i]));
+		}
+	}
+}
+
 // прямое распространение
-void SoftplusLayer::Forward(const std::vector<Volume> &X) {
+void SoftplusLayer::Forward(const Tensor &X) {
 	#pragma omp parallel for collapse(2)
 	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
 		for (int i = 0; i < total; i++) {
@@ -38,7 +50,7 @@ void SoftplusLayer::Forward(const std::vector<Volume> &X) {
 }
 
 // обратное распространение
-void SoftplusLayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
+void SoftplusLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
 	if (!calc_dX)
 		return;
 
@@ -48,6 +60,11 @@ void SoftplusLayer::Backward(const std::vector<Volume> &dout, const std::vector<
 			dX[batchIndex][i] *= dout[batchIndex][i];
 }
 
+// расположение входа и выхода слоя (поэлементный слой работает с любым)
+Layout SoftplusLayer::GetLayout() const {
+	return Layout::Any;
+}
+
 // сохранение слоя в файл
 void SoftplusLayer::Save(std::ofstream &f) const {
 	f << "softplus " << inputSize << std::endl;
@@ -13,8 +13,10 @@ class SwishLayer : public NetworkLayer {
 public:
 	SwishLayer(VolumeSize size);
 
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	void ForwardOutput(const Tensor &X); // прямое распространение без вычисления производных
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
+	Layout GetLayout() const; // расположение входа и выхода слоя
 
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
 };
@@ -26,13 +28,23 @@ SwishLayer::SwishLayer(VolumeSize size) : NetworkLayer(size) {
 	info = "";
 }
 
+// прямое распространение без вычисления производных (при выводе градиенты не нужны)
+void SwishLayer::ForwardOutput(const Tensor &X) {
+	#pragma omp parallel for collapse(2)
+	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
+		for (int i = 0; i < total; i++) {
+			output[batchIndex][i] = X[batchIndex][i] / (1 + exp(-X[batchIndex][i]));
+		}
+	}
+}
+
 // прямое распространение
-void SwishLayer::Forward(const std::vector<Volume> &X) {
+void SwishLayer::Forward(const Tensor &X) {
 	#pragma omp parallel for collapse(2)
 	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
 		for (int i = 0; i < total; i++) {
-			double sigmoid = 1.0 / (1 + exp(-X[batchIndex][i]));
-			double value = X[batchIndex][i] * sigmoid;
+			real sigmoid = 1.0 / (1 + exp(-X[batchIndex][i]));
+			real value = X[batchIndex][i] * sigmoid;
 
 			output[batchIndex][i] = value;
 			dX[batchIndex][i] = value + sigmoid * (1 - value);
@@ -41,7 +53,7 @@ void SwishLayer::Forward(const std::vector<Volume> &X) {
 }
 
 // обратное распространение
-void SwishLayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
+void SwishLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
 	if (!calc_dX)
 		return;
 
@@ -51,6 +63,11 @@ void SwishLayer::Backward(const std::vector<Volume> &dout, const std::vector<Vol
 			dX[batchIndex][i] *= dout[batchIndex][i];
 }
 
+// расположение входа и выхода слоя (поэлементный слой работает с любым)
+Layout SwishLayer::GetLayout() const {
+	return Layout::Any;
+}
+
 // сохранение слоя в файл
 void SwishLayer::Save(std::ofstream &f) const {
 	f << "swish " << inputSize << std::endl;
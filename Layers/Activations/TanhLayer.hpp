@@ -13,8 +13,10 @@ class TanhLayer : public NetworkLayer {
 public:
 	TanhLayer(VolumeSize size);
 
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	void ForwardOutput(const Tensor &X); // прямое распространение без вычисления производных
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
+	Layout GetLayout() const; // расположение входа и выхода слоя
 
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
 };
@@ -26,12 +28,22 @@ TanhLayer::TanhLayer(VolumeSize size) : NetworkLayer(size) {
 	info = "";
 }
 
+// прямое распространение без вычисления производных (при выводе градиенты не нужны)
+void TanhLayer::ForwardOutput(const Tensor &X) {
+	#pragma omp parallel for collapse(2)
+	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
+		for (int i = 0; i < total; i++) {
+			output[batchIndex][i] = tanh(X[batchIndex][i]);
+		}
+	}
+}
+
 // прямое распространение
-void TanhLayer::Forward(const std::vector<Volume> &X) {
+void TanhLayer::Forward(const Tensor &X) {
 	#pragma omp parallel for collapse(2)
 	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
 		for (int i = 0; i < total; i++) {
-			double value = tanh(X[batchIndex][i]);
+			real value = tanh(X[batchIndex][i]);
 
 			output[batchIndex][i] = value;
 			dX[batchIndex][i] = 1 - value * value;
@@ -40,7 +52,7 @@ void TanhLayer::Forward(const std::vector<Volume> &X) {
 }
 
 // обратное распространение
-void TanhLayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
+void TanhLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
 	if (!calc_dX)
 		return;
 
@@ -50,6 +62,11 @@ void TanhLayer::Backward(const std::vector<Volume> &dout, const std::vector<Volu
 			dX[batchIndex][i] *= dout[batchIndex][i];
 }
 
+// расположение входа и выхода слоя (поэлементный слой работает с любым)
+Layout TanhLayer::GetLayout() const {
+	return Layout::Any;
+}
+
 // сохранение слоя в файл
 void TanhLayer::Save(std::ofstream &f) const {
 	f << "tanh " << inputSize << std::endl;
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+
+#include "NetworkLayer.hpp"
+#include "Kernels/ConvAlgorithm.hpp"
+
+#define AUTOTUNE_REPEATS 3 // замеров каждого варианта после прогревочного прохода (берётся наименьшее время)
+
+// алгоритмы свёртки, перебираемые при автонастройке (прямой проход - эталон и заведомо медленнее остальных)
+std::vector<ConvAlgorithm> GetAutotuneConvAlgorithms() {
+	return { ConvAlgorithm::Specialized, ConvAlgorithm::Gemm, ConvAlgorithm::Pointwise, ConvAlgorithm::Winograd2, ConvAlgorithm::Winograd4, ConvAlgorithm::FFT };
+}
+
+// ключ формы свёртки в кэше автонастройки: тип слоя, размер входа, фильтры, дополнение, шаг, разрежение, батч и режим
+std::string ConvAutotuneKey(const std::string &type, VolumeSize inputSize, int fc, int fs, int P, int S, int D, int batchSize, bool training) {
+	std::string key = type + ":" + std::to_string(inputSize.width) + "x" + std::to_string(inputSize.height) + "x" + std::to_string(inputSize.deep);
+	key += ":fc" + std::to_string(fc) + ":fs" + std::to_string(fs) + ":P" + std::to_string(P) + ":S" + std::to_string(S) + ":D" + std::to_string(D);
+	key += ":N" + std::to_string(batchSize) + (training ? ":train" : ":inference");
+
+	return key;
+}
+
+// наименьшее из AUTOTUNE_REPEATS времён (в секундах) прохода слоя по батчу из batchSize примеров после прогревочного
+// при обучении проход - прямое и обратное распространение и обновление с нулевой скоростью обучения: оно не меняет веса,
+// но обнуляет накопленные при замере градиенты и, как настоящий шаг обучения, заставляет заново преобразовать фильтры
+double MeasureLayerPass(NetworkLayer &layer, int batchSize, bool training) {
+	VolumeSize inputSize = layer.GetInputSize();
+	VolumeSize outputSize = layer.GetOutputSize();
+
+	Tensor X(batchSize, inputSize);
+	Tensor dout(batchSize, outputSize);
+
+	for (int i = 0; i < batchSize * X.Total(); i++)
+		X.Data()[i] = sin(i * 0.37);
+
+	for (int i = 0; i < batchSize * dout.Total(); i++)
+		dout.Data()[i] = cos(i * 0.53);
+
+	layer.SetBatchSize(batchSize);
+
+	Optimizer optimizer = Optimizer::SGD(0);
+	double best = INFINITY;
+
+	for (int repeat = 0; repeat <= AUTOTUNE_REPEATS; repeat++) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		if (training) {
+			layer.Forward(X);
+			layer.Backward(dout, X, true);
+			layer.UpdateWeights(optimizer, true);
+		}
+		else {
+			layer.ForwardOutput(X);
+		}
+
+		double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		if (repeat > 0 && time < best)
+			best = time;
+	}
+
+	return best;
+}
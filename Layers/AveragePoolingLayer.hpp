@@ -16,8 +16,8 @@ class AveragePoolingLayer : public NetworkLayer {
 public:
 	AveragePoolingLayer(VolumeSize size, int scale = 2);
 
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
 
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
 };
@@ -42,13 +42,13 @@ AveragePoolingLayer::AveragePoolingLayer(VolumeSize size, int scale) : NetworkLa
 }
 
 // прямое распространение
-void AveragePoolingLayer::Forward(const std::vector<Volume> &X) {
+void AveragePoolingLayer::Forward(const Tensor &X) {
 	#pragma omp parallel for collapse(4)
 	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
 		for (int d = 0; d < inputSize.deep; d++) {
 			for (int i = 0; i < inputSize.height; i += scale) {
 				for (int j = 0; j < inputSize.width; j += scale) {
-					double sum = 0;
+					real sum = 0;
 
 					for (int y = i; y < i + scale; y++)
 						for (int x = j; x < j + scale; x++)
@@ -62,7 +62,7 @@ void AveragePoolingLayer::Forward(const std::vector<Volume> &X) {
 }
 
 // обратное распространение
-void AveragePoolingLayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
+void AveragePoolingLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
 	if (!calc_dX)
 		return;
 
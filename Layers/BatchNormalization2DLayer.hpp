@@ -9,7 +9,7 @@
 
 class BatchNormalization2DLayer : public NetworkLayer {
 	int wh;
-	double momentum;
+	real momentum;
 
 	Volume gamma;
 	Volume dgamma;
@@ -19,40 +19,44 @@ class BatchNormalization2DLayer : public NetworkLayer {
 	Volume dbeta;
 	std::vector<Volume> paramsbeta;
 
-	std::vector<Volume> X_norm;
-	std::vector<Volume> dX_norm;
+	Tensor X_norm;
+	Tensor dX_norm;
 
 	Volume mu, var;
 	Volume running_mu, running_var;
+	Volume d1, d2; // суммы градиентов для обратного распространения
+	std::vector<real> scale, shift; // множители и сдвиги каналов при выводе
 
 	void InitParams(); // инициализация параметров для обучения
 	void InitWeights(); // инициализация весовых коэффициентов
 	void LoadWeights(std::ifstream &f); // считывание весовых коэффициентов из файла
 
 public:
-	BatchNormalization2DLayer(VolumeSize size, double momentum);
-	BatchNormalization2DLayer(VolumeSize size, double momentum, std::ifstream &f);
+	BatchNormalization2DLayer(VolumeSize size, real momentum);
+	BatchNormalization2DLayer(VolumeSize size, real momentum, std::ifstream &f);
 
 	int GetTrainableParams() const; // получение количества обучаемых параметров
 
-	void ForwardOutput(const std::vector<Volume> &X); // прямое распространение
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	void ForwardOutput(const Tensor &X); // прямое распространение
+	bool GetScaleShift(std::vector<real> &scale, std::vector<real> &shift) const; // нормализация при выводе - поканальное преобразование
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
 	void UpdateWeights(const Optimizer &optimizer, bool trainable); // обновление весовых коэффициентов
 
 	void ResetCache(); // сброс параметров
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
 	void SetBatchSize(int batchSize); // установка размера батча
+	void SetInferenceBatchSize(int batchSize); // установка размера батча для вывода без градиентов
 
-	void SetParam(int index, double weight); // установка веса по индексу
-	double GetParam(int index) const; // получение веса по индексу
-	double GetGradient(int index) const; // получение градиента веса по индексу
+	void SetParam(int index, real weight); // установка веса по индексу
+	real GetParam(int index) const; // получение веса по индексу
+	real GetGradient(int index) const; // получение градиента веса по индексу
 	void ZeroGradient(int index); // обнуление градиента веса по индексу
 };
 
-BatchNormalization2DLayer::BatchNormalization2DLayer(VolumeSize size, double momentum) : NetworkLayer(size),
+BatchNormalization2DLayer::BatchNormalization2DLayer(VolumeSize size, real momentum) : NetworkLayer(size),
 	gamma(1, 1, size.deep), dgamma(1, 1, size.deep), beta(1, 1, size.deep), dbeta(1, 1, size.deep), 
-	mu(1, 1, size.deep), var(1, 1, size.deep), running_mu(1, 1, size.deep), running_var(1, 1, size.deep) {
+	mu(1, 1, size.deep), var(1, 1, size.deep), running_mu(1, 1, size.deep), running_var(1, 1, size.deep), d1(1, 1, size.deep), d2(1, 1, size.deep) {
 
 	this->momentum = momentum;
 	wh = size.width * size.height;
@@ -64,9 +68,9 @@ BatchNormalization2DLayer::BatchNormalization2DLayer(VolumeSize size, double mom
 	InitWeights();
 }
 
-BatchNormalization2DLayer::BatchNormalization2DLayer(VolumeSize size, double momentum, std::ifstream &f) : NetworkLayer(size),
+BatchNormalization2DLayer::BatchNormalization2DLayer(VolumeSize size, real momentum, std::ifstream &f) : NetworkLayer(size),
 	gamma(1, 1, size.deep), dgamma(1, 1, size.deep), beta(1, 1, size.deep), dbeta(1, 1, size.deep), 
-	mu(1, 1, size.deep), var(1, 1, size.deep), running_mu(1, 1, size.deep), running_var(1, 1, size.deep) {
+	mu(1, 1, size.deep), var(1, 1, size.deep), running_mu(1, 1, size.deep), running_var(1, 1, size.deep), d1(1, 1, size.deep), d2(1, 1, size.deep) {
 
 	this->momentum = momentum;
 	wh = size.width * size.height;
@@ -117,21 +121,40 @@ int BatchNormalization2DLayer::GetTrainableParams() const {
 	return 2 * outputSize.deep;
 }
 
-// прямое распространение
-void BatchNormalization2DLayer::ForwardOutput(const std::vector<Volume> &X) {
-	#pragma omp parallel for collapse(4)
-	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++)
-		for (int d = 0; d < outputSize.deep; d++)
-			for (int i = 0; i < outputSize.height; i++)
-				for (int j = 0; j < outputSize.width; j++)
-					output[batchIndex](d, i, j) = gamma[d] * (X[batchIndex](d, i, j) - running_mu[d]) / sqrt(running_var[d] + 1e-8) + beta[d];	
+// прямое распространение (корни считаются один раз на канал, а не на каждое значение)
+void BatchNormalization2DLayer::ForwardOutput(const Tensor &X) {
+	GetScaleShift(scale, shift);
+
+	#pragma omp parallel for collapse(2)
+	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
+		for (int i = 0; i < wh; i++) {
+			const real *x = X[batchIndex].Data() + i * outputSize.deep;
+			real *y = output[batchIndex].Data() + i * outputSize.deep;
+
+			for (int d = 0; d < outputSize.deep; d++)
+				y[d] = x[d] * scale[d] + shift[d];
+		}
+	}
+}
+
+// нормализация при выводе - поканальное преобразование: gamma * (x - mu) / sqrt(var + eps) + beta = scale * x + shift
+bool BatchNormalization2DLayer::GetScaleShift(std::vector<real> &scale, std::vector<real> &shift) const {
+	scale.resize(outputSize.deep);
+	shift.resize(outputSize.deep);
+
+	for (int d = 0; d < outputSize.deep; d++) {
+		scale[d] = gamma[d] / sqrt(running_var[d] + 1e-8);
+		shift[d] = beta[d] - running_mu[d] * scale[d];
+	}
+
+	return true;
 }
 
 // прямое распространение
-void BatchNormalization2DLayer::Forward(const std::vector<Volume> &X) {
+void BatchNormalization2DLayer::Forward(const Tensor &X) {
 	#pragma omp parallel for
 	for (int d = 0; d < outputSize.deep; d++) {
-		double sum = 0;
+		real sum = 0;
 
 		for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++)
 			for (int i = 0; i < outputSize.height; i++)
@@ -163,12 +186,12 @@ void BatchNormalization2DLayer::Forward(const std::vector<Volume> &X) {
 }
 
 // обратное распространение
-void BatchNormalization2DLayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
+void BatchNormalization2DLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
 	for (size_t batchIndex = 0; batchIndex < dout.size(); batchIndex++) {
 		for (int d = 0; d < outputSize.deep; d++) {
 			for (int i = 0; i < outputSize.height; i++) {
 				for (int j = 0; j < outputSize.width; j++) {
-					double delta = dout[batchIndex](d, i, j);
+					real delta = dout[batchIndex](d, i, j);
 
 					dgamma[d] += delta * X_norm[batchIndex](d, i, j);
 					dbeta[d] += delta;
@@ -180,8 +203,10 @@ void BatchNormalization2DLayer::Backward(const std::vector<Volume> &dout, const
 	if (calc_dX) {
 		size_t N = dout.size();
 
-		Volume d1(1, 1, outputSize.deep);
-		Volume d2(1, 1, outputSize.deep);
+		for (int i = 0; i < outputSize.deep; i++) {
+			d1[i] = 0;
+			d2[i] = 0;
+		}
 
 		for (size_t batchIndex = 0; batchIndex < N; batchIndex++) {
 			for (int d = 0; d < outputSize.deep; d++) {
@@ -259,15 +284,23 @@ void BatchNormalization2DLayer::Save(std::ofstream &f) const {
 
 // установка размера батча
 void BatchNormalization2DLayer::SetBatchSize(int batchSize) {
-	output = std::vector<Volume>(batchSize, Volume(outputSize));
-	dX = std::vector<Volume>(batchSize, Volume(inputSize));
+	output.Resize(batchSize, outputSize);
+	dX.Resize(batchSize, inputSize);
+
+	X_norm.Resize(batchSize, inputSize);
+	dX_norm.Resize(batchSize, inputSize);
+}
+
+// установка размера батча для вывода без градиентов (при выводе используются накопленные статистики)
+void BatchNormalization2DLayer::SetInferenceBatchSize(int batchSize) {
+	dX = Tensor();
 
-	X_norm = std::vector<Volume>(batchSize, Volume(inputSize));
-	dX_norm = std::vector<Volume>(batchSize, Volume(inputSize));
+	X_norm = Tensor();
+	dX_norm = Tensor();
 }
 
 // установка веса по индексу
-void BatchNormalization2DLayer::SetParam(int index, double weight) {
+void BatchNormalization2DLayer::SetParam(int index, real weight) {
 	if (index / outputSize.deep == 0) {
 		gamma[index] = weight;
 	}
@@ -277,7 +310,7 @@ void BatchNormalization2DLayer::SetParam(int index, double weight) {
 }
 
 // получение веса по индексу
-double BatchNormalization2DLayer::GetParam(int index) const {
+real BatchNormalization2DLayer::GetParam(int index) const {
 	if (index / outputSize.deep == 0) {
 		return gamma[index];
 	}
@@ -287,7 +320,7 @@ double BatchNormalization2DLayer::GetParam(int index) const {
 }
 
 // получение градиента веса по индексу
-double BatchNormalization2DLayer::GetGradient(int index) const {
+real BatchNormalization2DLayer::GetGradient(int index) const {
 	if (index / outputSize.deep == 0) {
 		return dgamma[index];
 	}
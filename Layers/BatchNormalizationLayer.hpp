@@ -9,7 +9,7 @@
 
 class BatchNormalizationLayer : public NetworkLayer {
 	int total;
-	double momentum;
+	real momentum;
 
 	Volume gamma;
 	Volume dgamma;
@@ -19,39 +19,43 @@ class BatchNormalizationLayer : public NetworkLayer {
 	Volume dbeta;
 	std::vector<Volume> paramsbeta;
 
-	std::vector<Volume> X_norm;
-	std::vector<Volume> dX_norm;
+	Tensor X_norm;
+	Tensor dX_norm;
 
 	Volume mu, var;
 	Volume running_mu, running_var;
+	Volume d1, d2; // суммы градиентов для обратного распространения
+	std::vector<real> scale, shift; // множители и сдвиги при выводе
 
 	void InitParams(); // инициализация параметров для обучения
 	void InitWeights(); // инициализация весовых коэффициентов
 	void LoadWeights(std::ifstream &f); // считывание весовых коэффициентов из файла
 
 public:
-	BatchNormalizationLayer(VolumeSize size, double momentum);
-	BatchNormalizationLayer(VolumeSize size, double momentum, std::ifstream &f);
+	BatchNormalizationLayer(VolumeSize size, real momentum);
+	BatchNormalizationLayer(VolumeSize size, real momentum, std::ifstream &f);
 
 	int GetTrainableParams() const; // получение количества обучаемых параметров
 
-	void ForwardOutput(const std::vector<Volume> &X); // прямое распространение
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	void ForwardOutput(const Tensor &X); // прямое распространение
+	bool GetScaleShift(std::vector<real> &scale, std::vector<real> &shift) const; // нормализация при выводе - поэлементное преобразование
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
 	void UpdateWeights(const Optimizer &optimizer, bool trainable); // обновление весовых коэффициентов
 
 	void ResetCache(); // сброс параметров
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
 	void SetBatchSize(int batchSize); // установка размера батча
+	void SetInferenceBatchSize(int batchSize); // установка размера батча для вывода без градиентов
 
-	void SetParam(int index, double weight); // установка веса по индексу
-	double GetParam(int index) const; // получение веса по индексу
-	double GetGradient(int index) const; // получение градиента веса по индексу
+	void SetParam(int index, real weight); // установка веса по индексу
+	real GetParam(int index) const; // получение веса по индексу
+	real GetGradient(int index) const; // получение градиента веса по индексу
 	void ZeroGradient(int index); // обнуление градиента веса по индексу
 };
 
-BatchNormalizationLayer::BatchNormalizationLayer(VolumeSize size, double momentum) : NetworkLayer(size),
-	gamma(size), dgamma(size), beta(size), dbeta(size), mu(size), var(size), running_mu(size), running_var(size) {
+BatchNormalizationLayer::BatchNormalizationLayer(VolumeSize size, real momentum) : NetworkLayer(size),
+	gamma(size), dgamma(size), beta(size), dbeta(size), mu(size), var(size), running_mu(size), running_var(size), d1(size), d2(size) {
 
 	this->momentum = momentum;
 	total = size.width * size.height * size.deep;
@@ -63,8 +67,8 @@ BatchNormalizationLayer::BatchNormalizationLayer(VolumeSize size, double momentu
 	InitWeights();
 }
 
-BatchNormalizationLayer::BatchNormalizationLayer(VolumeSize size, double momentum, std::ifstream &f) : NetworkLayer(size),
-	gamma(size), dgamma(size), beta(size), dbeta(size), mu(size), var(size), running_mu(size), running_var(size) {
+BatchNormalizationLayer::BatchNormalizationLayer(VolumeSize size, real momentum, std::ifstream &f) : NetworkLayer(size),
+	gamma(size), dgamma(size), beta(size), dbeta(size), mu(size), var(size), running_mu(size), running_var(size), d1(size), d2(size) {
 
 	this->momentum = momentum;
 	total = size.width * size.height * size.deep;
@@ -115,19 +119,34 @@ int BatchNormalizationLayer::GetTrainableParams() const {
 	return 2 * total;
 }
 
-// прямое распространение
-void BatchNormalizationLayer::ForwardOutput(const std::vector<Volume> &X) {
+// прямое распространение (корни считаются один раз на значение, а не на каждый пример)
+void BatchNormalizationLayer::ForwardOutput(const Tensor &X) {
+	GetScaleShift(scale, shift);
+
 	#pragma omp parallel for collapse(2)
 	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++)
 		for (int i = 0; i < total; i++)
-			output[batchIndex][i] = gamma[i] * (X[batchIndex][i] - running_mu[i]) / sqrt(running_var[i] + 1e-8) + beta[i];
+			output[batchIndex][i] = X[batchIndex][i] * scale[i] + shift[i];
+}
+
+// нормализация при выводе - поэлементное преобразование (совпадает с поканальным, если выход - вектор 1x1xN): gamma * (x - mu) / sqrt(var + eps) + beta = scale * x + shift
+bool BatchNormalizationLayer::GetScaleShift(std::vector<real> &scale, std::vector<real> &shift) const {
+	scale.resize(total);
+	shift.resize(total);
+
+	for (int i = 0; i < total; i++) {
+		scale[i] = gamma[i] / sqrt(running_var[i] + 1e-8);
+		shift[i] = beta[i] - running_mu[i] * scale[i];
+	}
+
+	return true;
 }
 
 // прямое распространение
-void BatchNormalizationLayer::Forward(const std::vector<Volume> &X) {
+void BatchNormalizationLayer::Forward(const Tensor &X) {
 	#pragma omp parallel for
 	for (int i = 0; i < total; i++) {
-		double sum = 0;
+		real sum = 0;
 
 		for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++)
 			sum += X[batchIndex][i];
@@ -151,10 +170,10 @@ void BatchNormalizationLayer::Forward(const std::vector<Volume> &X) {
 }
 
 // обратное распространение
-void BatchNormalizationLayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
+void BatchNormalizationLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
 	for (size_t batchIndex = 0; batchIndex < dout.size(); batchIndex++) {
 		for (int i = 0; i < total; i++) {
-			double delta = dout[batchIndex][i];
+			real delta = dout[batchIndex][i];
 
 			dgamma[i] += delta * X_norm[batchIndex][i];
 			dbeta[i] += delta;
@@ -164,8 +183,10 @@ void BatchNormalizationLayer::Backward(const std::vector<Volume> &dout, const st
 	if (calc_dX) {
 		size_t N = dout.size();
 
-		Volume d1(outputSize);
-		Volume d2(outputSize);
+		for (int i = 0; i < total; i++) {
+			d1[i] = 0;
+			d2[i] = 0;
+		}
 
 		for (size_t batchIndex = 0; batchIndex < N; batchIndex++) {
 			for (int i = 0; i < total; i++) {
@@ -237,15 +258,23 @@ void BatchNormalizationLayer::Save(std::ofstream &f) const {
 
 // установка размера батча
 void BatchNormalizationLayer::SetBatchSize(int batchSize) {
-	output = std::vector<Volume>(batchSize, Volume(outputSize));
-	dX = std::vector<Volume>(batchSize, Volume(inputSize));
+	output.Resize(batchSize, outputSize);
+	dX.Resize(batchSize, inputSize);
+
+	X_norm.Resize(batchSize, inputSize);
+	dX_norm.Resize(batchSize, inputSize);
+}
+
+// установка размера батча для вывода без градиентов (при выводе используются накопленные статистики)
+void BatchNormalizationLayer::SetInferenceBatchSize(int batchSize) {
+	dX = Tensor();
 
-	X_norm = std::vector<Volume>(batchSize, Volume(inputSize));
-	dX_norm = std::vector<Volume>(batchSize, Volume(inputSize));
+	X_norm = Tensor();
+	dX_norm = Tensor();
 }
 
 // установка веса по индексу
-void BatchNormalizationLayer::SetParam(int index, double weight) {
+void BatchNormalizationLayer::SetParam(int index, real weight) {
 	if (index / total == 0) {
 		gamma[index] = weight;
 	}
@@ -255,7 +284,7 @@ void BatchNormalizationLayer::SetParam(int index, double weight) {
 }
 
 // получение веса по индексу
-double BatchNormalizationLayer::GetParam(int index) const {
+real BatchNormalizationLayer::GetParam(int index) const {
 	if (index / total == 0) {
 		return gamma[index];
 	}
@@ -265,7 +294,7 @@ double BatchNormalizationLayer::GetParam(int index) const {
 }
 
 // получение градиента веса по индексу
-double BatchNormalizationLayer::GetGradient(int index) const {
+real BatchNormalizationLayer::GetGradient(int index) const {
 	if (index / total == 0) {
 		return dgamma[index];
 	}
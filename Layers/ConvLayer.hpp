@@ -7,63 +7,108 @@
 #include <random>
 
 #include "NetworkLayer.hpp"
+#include "Autotune.hpp"
+#include "QuantizedConvLayer.hpp"
+#include "Kernels/BlockedConv.hpp"
+#include "Kernels/GemmConv.hpp"
+#include "Kernels/ConvKernel.hpp"
+#include "Kernels/PointwiseConv.hpp"
+#include "Kernels/PhaseConv.hpp"
+#include "Kernels/FFTConv.hpp"
+#include "Kernels/ConvAlgorithm.hpp"
 
 class ConvLayer : public NetworkLayer {
 	std::default_random_engine generator;
-	std::normal_distribution<double> distribution;
+	std::normal_distribution<real> distribution;
 
 	std::vector<Volume> W; // фильтры
 	std::vector<Volume> dW; // градиенты фильтров
 	std::vector<std::vector<Volume>> paramsW; // параметры фильтров
 
-	std::vector<double> b; // смещения
-	std::vector<double> db; // градиенты смещений
-	std::vector<std::vector<double>> paramsb; // параметры смещений
+	std::vector<real> b; // смещения
+	std::vector<real> db; // градиенты смещений
+	std::vector<std::vector<real>> paramsb; // параметры смещений
 
 	int P; // дополнение нулями
 	int S; // шаг свёртки
+	int D; // разрежение фильтра (расстояние между соседними ядрами во входе)
 
 	int fc; // количество фильтров
 	int fs; // размер фильтров
 	int fd; // глубина фильтров
 
+	Layout layout; // расположение входа и выхода
+	ConvAlgorithm algorithm; // алгоритм свёртки в канальном расположении
+	AlignedVector packedW; // фильтры, упакованные для блочной свёртки, GEMM или специализированного ядра
+	AlignedVector packedWT; // фильтры, упакованные для градиентов входа
+	bool packed; // соответствуют ли упакованные фильтры текущим весам
+	bool packedT; // соответствуют ли упакованные для градиентов входа фильтры текущим весам
+	ConvKernelFunction kernel; // ядро, специализированное под размер фильтра и шаг (nullptr, если его нет)
+
+	FFTSpectra fftW; // спектры фильтров
+	FFTSpectra fftWT; // спектры повёрнутых фильтров для градиентов входа (только при шаге 1)
+	bool transformed; // соответствуют ли спектры текущим весам
+
+	Epilogue epilogue; // слитые со свёрткой при выводе активация и нормализация
+
 	void InitParams(); // инициализация параметров для обучения
 	void InitWeights(); // инициализация весовых коэффициентов
 	void LoadWeights(std::ifstream &f); // считывание весовых коэффициентов из файла
+	void UpdateInfo(); // обновление информации о слое
+	void TransformFilters(); // вычисление спектров фильтров для свёртки через FFT
+	void PackFilters(); // упаковка фильтров для прямого распространения
+	void PackTransposedFilters(); // упаковка фильтров для градиентов входа
 
 public:
-	ConvLayer(VolumeSize size, int fc, int fs, int P, int S);
-	ConvLayer(VolumeSize size, int fc, int fs, int P, int S, std::ifstream &f);
+	ConvLayer(VolumeSize size, int fc, int fs, int P, int S, int D);
+	ConvLayer(VolumeSize size, int fc, int fs, int P, int S, int D, std::ifstream &f);
 
 	int GetTrainableParams() const; // получение количества обучаемых параметров
-
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	Layout GetLayout() const; // расположение входа и выхода слоя
+	void SetLayout(Layout layout); // установка расположения входа и выхода
+	ConvAlgorithm GetAlgorithm() const; // алгоритм свёртки
+	void SetAlgorithm(ConvAlgorithm algorithm); // установка алгоритма свёртки
+	void ChooseAlgorithm(); // выбор алгоритма свёртки по оценке количества операций
+	int Autotune(AutotuneCache &cache, int batchSize, bool training); // выбор самого быстрого алгоритма свёртки замерами
+
+	void ForwardOutput(const Tensor &X); // прямое распространение при выводе
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
 	void UpdateWeights(const Optimizer &optimizer, bool trainable); // обновление весовых коэффициентов
 
+	bool FuseScaleShift(const std::vector<real> &scale, const std::vector<real> &shift); // встраивание поканального преобразования выхода
+	bool FuseActivation(EpilogueActivation activation, real alpha); // встраивание активации выхода
+	NetworkLayer* Quantize(const QuantizationParams &input) const; // квантованная копия свёртки для вывода
+
 	void ResetCache(); // сброс параметров
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
-	void SetBatchSize(int batchSize); // установка размера батча
 
-	void SetWeight(int index, int i, int j, int k, double weight);
-	void SetBias(int index, double bias);
+	void SetWeight(int index, int i, int j, int k, real weight);
+	void SetBias(int index, real bias);
 
-	void SetParam(int index, double weight); // установка веса по индексу
-	double GetParam(int index) const; // получение веса по индексу
-	double GetGradient(int index) const; // получение градиента веса по индексу
+	void SetParam(int index, real weight); // установка веса по индексу
+	real GetParam(int index) const; // получение веса по индексу
+	real GetGradient(int index) const; // получение градиента веса по индексу
 	void ZeroGradient(int index); // обнуление градиента веса по индексу
 };
 
-ConvLayer::ConvLayer(VolumeSize size, int fc, int fs, int P, int S) : NetworkLayer(size, (size.width - fs + 2 * P) / S + 1, (size.height - fs + 2 * P) / S + 1, fc), distribution(0.0, sqrt(2.0 / (fs*fs*size.deep))) {
+ConvLayer::ConvLayer(VolumeSize size, int fc, int fs, int P, int S, int D) : NetworkLayer(size, (size.width - D * (fs - 1) - 1 + 2 * P) / S + 1, (size.height - D * (fs - 1) - 1 + 2 * P) / S + 1, fc), distribution(0.0, sqrt(2.0 / (fs*fs*size.deep))) {
 	this->P = P;
 	this->S = S;
+	this->D = D;
 
 	this->fc = fc;
 	this->fs = fs;
 	this->fd = size.deep;
+	this->layout = Layout::Channels;
+	this->algorithm = ConvAlgorithm::Gemm;
+	this->kernel = D == 1 ? GetConvKernel(fs, S) : nullptr;
+	this->transformed = false;
+	this->packed = false;
+	this->packedT = false;
 
 	name = "conv";
-	info = std::to_string(fc) + " filters [" + std::to_string(fs) + "x" + std::to_string(fs) + "x" + std::to_string(fd) + "] P:" + std::to_string(P) + " S:" + std::to_string(S);
+	UpdateInfo();
 
 	for (int i = 0; i < fc; i++) {
 		W.push_back(Volume(fs, fs, fd));
@@ -77,16 +122,23 @@ ConvLayer::ConvLayer(VolumeSize size, int fc, int fs, int P, int S) : NetworkLay
 	InitWeights();
 }
 
-ConvLayer::ConvLayer(VolumeSize size, int fc, int fs, int P, int S, std::ifstream &f) : NetworkLayer(size, (size.width - fs + 2 * P) / S + 1, (size.height - fs + 2 * P) / S + 1, fc), distribution(0.0, sqrt(2.0 / (fs*fs*size.deep))) {
+ConvLayer::ConvLayer(VolumeSize size, int fc, int fs, int P, int S, int D, std::ifstream &f) : NetworkLayer(size, (size.width - D * (fs - 1) - 1 + 2 * P) / S + 1, (size.height - D * (fs - 1) - 1 + 2 * P) / S + 1, fc), distribution(0.0, sqrt(2.0 / (fs*fs*size.deep))) {
 	this->P = P;
 	this->S = S;
+	this->D = D;
 
 	this->fc = fc;
 	this->fs = fs;
 	this->fd = size.deep;
+	this->layout = Layout::Channels;
+	this->algorithm = ConvAlgorithm::Gemm;
+	this->kernel = D == 1 ? GetConvKernel(fs, S) : nullptr;
+	this->transformed = false;
+	this->packed = false;
+	this->packedT = false;
 
 	name = "conv";
-	info = std::to_string(fc) + " filters [" + std::to_string(fs) + "x" + std::to_string(fs) + "x" + std::to_string(fd) + "] P:" + std::to_string(P) + " S:" + std::to_string(S);
+	UpdateInfo();
 
 	for (int i = 0; i < fc; i++) {
 		W.push_back(Volume(fs, fs, fd));
@@ -104,7 +156,7 @@ ConvLayer::ConvLayer(VolumeSize size, int fc, int fs, int P, int S, std::ifstrea
 void ConvLayer::InitParams() {
 	for (int i = 0; i < OPTIMIZER_PARAMS_COUNT; i++) {
 		paramsW.push_back(std::vector<Volume>(fc, Volume(fs, fs, fd)));
-		paramsb.push_back(std::vector<double>(fc, 0));
+		paramsb.push_back(std::vector<real>(fc, 0));
 	}
 }
 
@@ -137,23 +189,224 @@ int ConvLayer::GetTrainableParams() const {
 	return fc * (fs * fs * fd + 1);
 }
 
+// расположение входа и выхода слоя
+Layout ConvLayer::GetLayout() const {
+	return layout;
+}
+
+// установка расположения входа и выхода
+void ConvLayer::SetLayout(Layout layout) {
+	if (layout == Layout::Any)
+		throw std::runtime_error("Invalid conv layout");
+
+	this->layout = layout;
+	this->packed = false;
+	UpdateInfo();
+}
+
+// алгоритм свёртки
+ConvAlgorithm ConvLayer::GetAlgorithm() const {
+	return algorithm;
+}
+
+// установка алгоритма свёртки (используется только в канальном расположении)
+void ConvLayer::SetAlgorithm(ConvAlgorithm algorithm) {
+	if (IsWinograd(algorithm))
+		throw std::runtime_error("Winograd convolution requires stride 1");
+
+	if (algorithm == ConvAlgorithm::Specialized && D > 1)
+		throw std::runtime_error("Specialized convolution does not support dilation");
+
+	if (algorithm == ConvAlgorithm::Specialized && !kernel)
+		throw std::runtime_error("No specialized conv kernel for filter size " + std::to_string(fs) + " and stride " + std::to_string(S));
+
+	if (algorithm == ConvAlgorithm::Pointwise && fs != 1)
+		throw std::runtime_error("Pointwise convolution requires 1x1 filters");
+
+	this->algorithm = algorithm;
+	this->transformed = false;
+	this->packed = false;
+	this->packedT = false;
+
+	if (algorithm == ConvAlgorithm::FFT) {
+		fftW.size = ChooseFFTSize(inputSize, outputSize, D * (fs - 1) + 1, S);
+		fftWT.size = ChooseFFTSize(outputSize, inputSize, D * (fs - 1) + 1, 1);
+	}
+
+	UpdateInfo();
+}
+
+// выбор алгоритма свёртки по оценке количества операций
+void ConvLayer::ChooseAlgorithm() {
+	SetAlgorithm(ChooseConvAlgorithm(inputSize, outputSize, fs, S, D));
+}
+
+// выбор самого быстрого алгоритма свёртки замерами всех подходящих слою алгоритмов на батче batchSize
+// результат запоминается в кэше по форме слоя, и при повторной настройке алгоритм берётся из кэша без замеров
+int ConvLayer::Autotune(AutotuneCache &cache, int batchSize, bool training) {
+	if (layout == Layout::Blocked)
+		return 0; // в блочном расположении алгоритм один
+
+	std::string key = ConvAutotuneKey("conv", inputSize, fc, fs, P, S, D, batchSize, training);
+	std::string value;
+
+	if (cache.Find(key, value)) {
+		SetAlgorithm(StringToConvAlgorithm(value));
+		return 0;
+	}
+
+	std::vector<ConvAlgorithm> algorithms = GetAutotuneConvAlgorithms();
+	ConvAlgorithm best = algorithm;
+	double bestTime = INFINITY;
+
+	for (size_t i = 0; i < algorithms.size(); i++) {
+		try {
+			SetAlgorithm(algorithms[i]);
+		}
+		catch (const std::runtime_error &) {
+			continue; // алгоритм не поддерживает форму слоя
+		}
+
+		double time = MeasureLayerPass(*this, batchSize, training);
+
+		if (time < bestTime) {
+			best = algorithms[i];
+			bestTime = time;
+		}
+	}
+
+	SetAlgorithm(best);
+	cache.Set(key, ConvAlgorithmToString(best));
+	return 1;
+}
+
+// обновление информации о слое
+void ConvLayer::UpdateInfo() {
+	info = std::to_string(fc) + " filters [" + std::to_string(fs) + "x" + std::to_string(fs) + "x" + std::to_string(fd) + "] P:" + std::to_string(P) + " S:" + std::to_string(S);
+
+	if (D > 1)
+		info += " D:" + std::to_string(D);
+
+	if (layout == Layout::Blocked)
+		info += " layout: blocked";
+	else if (algorithm != ConvAlgorithm::Gemm)
+		info += " algorithm: " + ConvAlgorithmToString(algorithm);
+
+	if (!epilogue.Empty())
+		info += " epilogue: " + EpilogueToString(epilogue);
+}
+
+// вычисление спектров фильтров для свёртки через FFT (выполняется только после изменения весов)
+void ConvLayer::TransformFilters() {
+	if (transformed)
+		return;
+
+	FFTTransformFilters(W, fs, D, false, fftW);
+
+	if (S == 1)
+		FFTTransformFilters(W, fs, D, true, fftWT);
+
+	transformed = true;
+}
+
+// упаковка фильтров для прямого распространения (выполняется только после изменения весов, алгоритма или расположения)
+void ConvLayer::PackFilters() {
+	if (packed)
+		return;
+
+	if (layout == Layout::Blocked) {
+		PackBlockedFilters(W, fs, fd, packedW);
+	}
+	else if (algorithm == ConvAlgorithm::Specialized || (algorithm == ConvAlgorithm::Pointwise && kernel)) {
+		PackKernelFilters(W, false, packedW);
+	}
+	else {
+		PackGemmFilters(W, packedW);
+	}
+
+	packed = true;
+}
+
+// упаковка фильтров для градиентов входа (выполняется только после изменения весов или алгоритма)
+void ConvLayer::PackTransposedFilters() {
+	if (packedT)
+		return;
+
+	if (algorithm == ConvAlgorithm::Specialized && S == 1) {
+		PackKernelFilters(W, true, packedWT);
+	}
+	else if (algorithm == ConvAlgorithm::Direct && D == 1) {
+		PackPhaseFilters(W, S, false, packedWT);
+	}
+	else {
+		PackGemmFilters(W, packedWT);
+	}
+
+	packedT = true;
+}
+
+// прямое распространение при выводе: свёртка, затем слитые с ней активация и нормализация одним проходом по выходу
+void ConvLayer::ForwardOutput(const Tensor &X) {
+	Forward(X);
+
+	if (!epilogue.Empty())
+		ApplyEpilogue(epilogue, output, layout);
+}
+
 // прямое распространение
-void ConvLayer::Forward(const std::vector<Volume> &X) {
+void ConvLayer::Forward(const Tensor &X) {
+	if (layout == Layout::Blocked) {
+		PackFilters();
+		BlockedConvForward(X, packedW, b, output, fs, P, S, D);
+		return;
+	}
+
+	if (algorithm == ConvAlgorithm::Gemm) {
+		PackFilters();
+		GemmConvForward(X, packedW, b, output, fs, P, S, D);
+		return;
+	}
+
+	// произведение матриц свёртки 1x1 быстрее считает ядро 1x1, читающее вход без упаковки (оно есть для шагов 1 и 2)
+	if (algorithm == ConvAlgorithm::Pointwise && kernel) {
+		PackFilters();
+		kernel(X, packedW, b.data(), output, P);
+		return;
+	}
+
+	if (algorithm == ConvAlgorithm::Pointwise) {
+		PackFilters();
+		PointwiseConvForward(X, packedW, b, output, P, S);
+		return;
+	}
+
+	if (algorithm == ConvAlgorithm::Specialized) {
+		PackFilters();
+		kernel(X, packedW, b.data(), output, P);
+		return;
+	}
+
+	if (algorithm == ConvAlgorithm::FFT) {
+		TransformFilters();
+		FFTConvForward(X, fftW, b.data(), output, D * (fs - 1) + 1, P, S);
+		return;
+	}
+
 	#pragma omp parallel for collapse(4)
 	for (size_t n = 0; n < X.size(); n++) {
 		for (int f = 0; f < fc; f++) {
 			for (int i = 0; i < outputSize.height; i++) {
 				for (int j = 0; j < outputSize.width; j++) {
-					double sum = b[f];
+					real sum = b[f];
 
 					for (int k = 0; k < fs; k++) {
-						int i0 = S * i + k - P;
+						int i0 = S * i + D * k - P;
 
 						if (i0 < 0 || i0 >= inputSize.height)
 							continue;
 
 						for (int l = 0; l < fs; l++) {
-							int j0 = S * j + l - P;
+							int j0 = S * j + D * l - P;
 
 							if (j0 < 0 || j0 >= inputSize.width)
 								continue;
@@ -171,85 +424,136 @@ void ConvLayer::Forward(const std::vector<Volume> &X) {
 }
 
 // обратное распространение
-void ConvLayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
-	VolumeSize size;
+void ConvLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
+	if (layout == Layout::Blocked) {
+		BlockedConvBackwardWeights(dout, X, dW, db, fs, P, S, D);
+
+		if (calc_dX)
+			BlockedConvBackwardInput(dout, W, dX, fs, P, S, D);
 
-	size.height = S * (outputSize.height - 1) + 1;
-	size.width = S * (outputSize.width - 1) + 1;
-	size.deep = outputSize.deep;
+		return;
+	}
 
-	std::vector<Volume> deltas(dout.size(), Volume(size));
+	if (algorithm == ConvAlgorithm::Gemm) {
+		GemmConvBackwardWeights(dout, X, dW, db, fs, P, S, D);
+
+		if (calc_dX) {
+			PackFilters(); // упаковка для GEMM та же, что и при прямом распространении
+			GemmConvBackwardInput(dout, packedW, dX, fs, P, S, D);
+		}
 
-	for (size_t n = 0; n < dout.size(); n++) {
-		for (int d = 0; d < size.deep; d++)
-			for (int i = 0; i < outputSize.height; i++)
-				for (int j = 0; j < outputSize.width; j++)
-					deltas[n](d, i * S, j * S) = dout[n](d, i, j);
+		return;
 	}
 
-	#pragma omp parallel for
-	for (int f = 0; f < fc; f++) {
-		for (size_t n = 0; n < dout.size(); n++) {
-			for (int k = 0; k < size.height; k++) {
-				for (int l = 0; l < size.width; l++) {
-					double delta = deltas[n](f, k, l); // значение фильтра
+	if (algorithm == ConvAlgorithm::Pointwise) {
+		PointwiseConvBackwardWeights(dout, X, dW, db, P, S);
 
-					for (int i = 0; i < fs; i++) {
-						int i0 = i + k - P;
+		if (calc_dX) {
+			PackTransposedFilters();
+			PointwiseConvBackwardInput(dout, packedWT, dX, P, S);
+		}
 
-						if (i0 < 0 || i0 >= inputSize.height)
-							continue;
+		return;
+	}
 
-						for (int j = 0; j < fs; j++) {
-							int j0 = j + l - P;
+	// градиенты фильтров считаются через GEMM, градиенты входа при шаге 1 - тем же ядром с повёрнутыми фильтрами
+	if (algorithm == ConvAlgorithm::Specialized) {
+		GemmConvBackwardWeights(dout, X, dW, db, fs, P, S, D);
 
-							if (j0 < 0 || j0 >= inputSize.width)
-								continue;
+		if (calc_dX && S == 1) {
+			PackTransposedFilters();
+			kernel(dout, packedWT, nullptr, dX, fs - 1 - P);
+		}
+		else if (calc_dX) {
+			PackTransposedFilters();
+			GemmConvBackwardInput(dout, packedWT, dX, fs, P, S, D);
+		}
 
-							for (int c = 0; c < fd; c++)
-								dW[f](c, i, j) += delta * X[n](c, i0, j0);
-						}
-					}
+		return;
+	}
 
-					db[f] += delta;
-				}
-			}
+	// градиенты фильтров считаются через GEMM, градиенты входа при шаге 1 - свёрткой через FFT с повёрнутыми фильтрами
+	if (algorithm == ConvAlgorithm::FFT) {
+		GemmConvBackwardWeights(dout, X, dW, db, fs, P, S, D);
+
+		if (calc_dX && S == 1) {
+			TransformFilters();
+			FFTConvForward(dout, fftWT, nullptr, dX, D * (fs - 1) + 1, D * (fs - 1) - P, 1);
 		}
+		else if (calc_dX) {
+			PackTransposedFilters();
+			GemmConvBackwardInput(dout, packedWT, dX, fs, P, S, D);
+		}
+
+		return;
 	}
 
-	if (calc_dX) {
-		int pad = fs - 1 - P;
+	int total = fs * fs * fd;
+	GradientTiles tiles = GetGradientTiles(dout.size(), outputSize.height);
+	size_t count = fc * total + fc; // градиенты фильтров, затем смещений
+	real *partials = GradientPartials(tiles.parts, count);
+
+	// участки батча (полосы строк выхода) накапливаются потоками в частичные суммы, которые затем складываются деревом
+	#pragma omp parallel for
+	for (int part = 0; part < tiles.parts; part++) {
+		real *gradients = partials + part * count;
+		std::fill(gradients, gradients + count, 0);
+
+		for (int unit = part * tiles.units / tiles.parts; unit < (part + 1) * tiles.units / tiles.parts; unit++) {
+			int n = unit / tiles.bands;
+			int begin = unit % tiles.bands * tiles.bandRows;
+			int end = std::min(outputSize.height, begin + tiles.bandRows);
+
+			for (int f = 0; f < fc; f++) {
+				real *dw = gradients + f * total;
 
-		#pragma omp parallel for collapse(3)
-		for (size_t n = 0; n < dout.size(); n++) {
-			for (int i = 0; i < inputSize.height; i++) {
-				for (int j = 0; j < inputSize.width; j++) {
-					for (int c = 0; c < fd; c++) {
-						double sum = 0;
+				for (int k = begin; k < end; k++) {
+					for (int l = 0; l < outputSize.width; l++) {
+						real delta = dout[n](f, k, l); // значение градиента выхода
 
-						for (int k = 0; k < fs; k++) {
-							int i0 = i+k-pad;
+						for (int i = 0; i < fs; i++) {
+							int i0 = S * k + D * i - P;
 
-							if (i0 < 0 || i0 >= size.height)
+							if (i0 < 0 || i0 >= inputSize.height)
 								continue;
 
-							for (int l = 0; l < fs; l++) {
-								int j0 = j+l-pad;
+							for (int j = 0; j < fs; j++) {
+								int j0 = S * l + D * j - P;
 
-								if (j0 < 0 || j0 >= size.width)
+								if (j0 < 0 || j0 >= inputSize.width)
 									continue;
 
-								for (int f = 0; f < fc; f++)
-									sum += W[f](c, fs - 1 - k, fs - 1 - l) * deltas[n](f, i0, j0);
+								for (int c = 0; c < fd; c++)
+									dw[(i * fs + j) * fd + c] += delta * X[n](c, i0, j0);
 							}
 						}
 
-						dX[n](c, i, j) = sum;
+						gradients[fc * total + f] += delta;
 					}
 				}
 			}
 		}
 	}
+
+	ReduceGradientPartials(partials, tiles.parts, count);
+
+	#pragma omp parallel for
+	for (int f = 0; f < fc; f++) {
+		for (int i = 0; i < total; i++)
+			dW[f][i] += partials[f * total + i];
+
+		db[f] += partials[fc * total + f];
+	}
+
+	// градиенты входа собираются по фазам шага без разреженных нулями градиентов выхода (фазы разреженного фильтра не совпадают с фазами шага, поэтому для него - через GEMM)
+	if (calc_dX && D == 1) {
+		PackTransposedFilters();
+		PhaseConv(dout, packedWT, nullptr, dX, fs, P, S);
+	}
+	else if (calc_dX) {
+		PackTransposedFilters();
+		GemmConvBackwardInput(dout, packedWT, dX, fs, P, S, D);
+	}
 }
 
 // обновление весовых коэффициентов
@@ -271,6 +575,55 @@ void ConvLayer::UpdateWeights(const Optimizer &optimizer, bool trainable) {
 
 		db[index] = 0;
 	}
+
+	transformed = transformed && !trainable;
+	packed = packed && !trainable;
+	packedT = packedT && !trainable;
+}
+
+// встраивание поканального преобразования выхода: пока эпилог пуст, оно переносится в фильтры и смещения, иначе добавляется в эпилог
+bool ConvLayer::FuseScaleShift(const std::vector<real> &scale, const std::vector<real> &shift) {
+	if ((int) scale.size() != fc)
+		return false;
+
+	if (!epilogue.Empty()) {
+		epilogue.AddScaleShift(scale, shift);
+		UpdateInfo();
+		return true;
+	}
+
+	int total = fs * fs * fd;
+
+	for (int f = 0; f < fc; f++) {
+		for (int i = 0; i < total; i++)
+			W[f][i] *= scale[f];
+
+		b[f] = b[f] * scale[f] + shift[f];
+	}
+
+	transformed = false;
+	packed = false;
+	packedT = false;
+	return true;
+}
+
+// встраивание активации выхода (только в пустой эпилог, иначе нарушится порядок операций)
+bool ConvLayer::FuseActivation(EpilogueActivation activation, real alpha) {
+	if (!epilogue.Empty())
+		return false;
+
+	epilogue.activation = activation;
+	epilogue.alpha = alpha;
+	UpdateInfo();
+	return true;
+}
+
+// квантованная копия свёртки вместе с эпилогом (в блочном расположении свёртка не квантуется)
+NetworkLayer* ConvLayer::Quantize(const QuantizationParams &input) const {
+	if (layout == Layout::Blocked)
+		return nullptr;
+
+	return new QuantizedConvLayer(inputSize, outputSize, W, b, P, S, D, epilogue, input);
 }
 
 // сброс параметров
@@ -289,8 +642,22 @@ void ConvLayer::ResetCache() {
 
 // сохранение слоя в файл
 void ConvLayer::Save(std::ofstream &f) const {
-	f << "conv " << inputSize << " ";
-	f << fs << " " << fc << " " << P << " " << S << std::endl;
+	if (D > 1) {
+		f << "dilatedconv " << inputSize << " ";
+		f << fs << " " << fc << " " << P << " " << S << " " << D;
+	}
+	else {
+		f << "conv " << inputSize << " ";
+		f << fs << " " << fc << " " << P << " " << S;
+	}
+
+	// расположение и алгоритм, выбранный не по оценке количества операций, дописываются необязательными полями
+	if (layout == Layout::Blocked)
+		f << " layout=" << LayoutToString(layout);
+	else if (algorithm != ChooseConvAlgorithm(inputSize, outputSize, fs, S, D))
+		f << " algorithm=" << ConvAlgorithmToString(algorithm);
+
+	f << std::endl;
 
 	for (int index = 0; index < fc; index++) {
 		for (int d = 0; d < fd; d++)
@@ -302,22 +669,19 @@ void ConvLayer::Save(std::ofstream &f) const {
 	}
 }
 
-// установка размера батча
-void ConvLayer::SetBatchSize(int batchSize) {
-	output = std::vector<Volume>(batchSize, Volume(outputSize));
-	dX = std::vector<Volume>(batchSize, Volume(inputSize));
-}
-
-void ConvLayer::SetWeight(int index, int i, int j, int k, double weight) {
+void ConvLayer::SetWeight(int index, int i, int j, int k, real weight) {
 	W[index](i, j, k) = weight;
+	transformed = false;
+	packed = false;
+	packedT = false;
 }
 
-void ConvLayer::SetBias(int index, double bias) {
+void ConvLayer::SetBias(int index, real bias) {
 	b[index] = bias;
 }
 
 // установка веса по индексу
-void ConvLayer::SetParam(int index, double weight) {
+void ConvLayer::SetParam(int index, real weight) {
 	int params = fs * fs * fd + 1;
 	int findex = index / params;
 	int windex = index % params;
@@ -327,11 +691,14 @@ void ConvLayer::SetParam(int index, double weight) {
 	}
 	else {
 		W[findex][windex] = weight;
+		transformed = false;
+		packed = false;
+		packedT = false;
 	}
 }
 
 // получение веса по индексу
-double ConvLayer::GetParam(int index) const {
+real ConvLayer::GetParam(int index) const {
 	int params = fs * fs * fd + 1;
 	int findex = index / params;
 	int windex = index % params;
@@ -343,7 +710,7 @@ double ConvLayer::GetParam(int index) const {
 }
 
 // получение градиента веса по индексу
-double ConvLayer::GetGradient(int index) const {
+real ConvLayer::GetGradient(int index) const {
 	int params = fs * fs * fd + 1;
 	int findex = index / params;
 	int windex = index % params;
@@ -7,18 +7,20 @@
 #include <random>
 
 #include "NetworkLayer.hpp"
+#include "Kernels/GemmConv.hpp"
+#include "Kernels/PhaseConv.hpp"
 
 class ConvTransposedLayer : public NetworkLayer {
 	std::default_random_engine generator;
-	std::normal_distribution<double> distribution;
+	std::normal_distribution<real> distribution;
 
 	std::vector<Volume> W; // фильтры
 	std::vector<Volume> dW; // градиенты фильтров
 	std::vector<std::vector<Volume>> paramsW; // параметры фильтров
 
-	std::vector<double> b; // смещения
-	std::vector<double> db; // градиенты смещений
-	std::vector<std::vector<double>> paramsb; // параметры смещений
+	std::vector<real> b; // смещения
+	std::vector<real> db; // градиенты смещений
+	std::vector<std::vector<real>> paramsb; // параметры смещений
 
 	int P; // дополнение нулями
 	int S; // шаг свёртки
@@ -27,6 +29,8 @@ class ConvTransposedLayer : public NetworkLayer {
 	int fs; // размер фильтров
 	int fd; // глубина фильтров
 
+	AlignedVector packedW; // фильтры, упакованные для свёртки по фазам
+
 	void InitParams(); // инициализация параметров для обучения
 	void InitWeights(); // инициализация весовых коэффициентов
 	void LoadWeights(std::ifstream &f); // считывание весовых коэффициентов из файла
@@ -37,19 +41,19 @@ public:
 
 	int GetTrainableParams() const; // получение количества обучаемых параметров
 
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
 	void UpdateWeights(const Optimizer &optimizer, bool trainable); // обновление весовых коэффициентов
 
 	void ResetCache(); // сброс параметров
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
 
-	void SetWeight(int index, int i, int j, int k, double weight);
-	void SetBias(int index, double bias);
+	void SetWeight(int index, int i, int j, int k, real weight);
+	void SetBias(int index, real bias);
 
-	void SetParam(int index, double weight); // установка веса по индексу
-	double GetParam(int index) const; // получение веса по индексу
-	double GetGradient(int index) const; // получение градиента веса по индексу
+	void SetParam(int index, real weight); // установка веса по индексу
+	real GetParam(int index) const; // получение веса по индексу
+	real GetGradient(int index) const; // получение градиента веса по индексу
 	void ZeroGradient(int index); // обнуление градиента веса по индексу
 };
 
@@ -103,7 +107,7 @@ ConvTransposedLayer::ConvTransposedLayer(VolumeSize size, int fc, int fs, int P,
 void ConvTransposedLayer::InitParams() {
 	for (int i = 0; i < OPTIMIZER_PARAMS_COUNT; i++) {
 		paramsW.push_back(std::vector<Volume>(fc, Volume(fs, fs, fd)));
-		paramsb.push_back(std::vector<double>(fc, 0));
+		paramsb.push_back(std::vector<real>(fc, 0));
 	}
 }
 
@@ -136,119 +140,19 @@ int ConvTransposedLayer::GetTrainableParams() const {
 	return fc * (fs * fs * fd + 1);
 }
 
-// прямое распространение
-void ConvTransposedLayer::Forward(const std::vector<Volume> &X) {
-	VolumeSize size;
-
-	size.height = S * (inputSize.height - 1) + 1;
-	size.width = S * (inputSize.width - 1) + 1;
-	size.deep = inputSize.deep;
-
-	std::vector<Volume> input(X.size(), Volume(size));
-
-	#pragma omp parallel for collapse(4)
-	for (size_t n = 0; n < X.size(); n++)
-		for (int d = 0; d < size.deep; d++)
-			for (int i = 0; i < inputSize.height; i++)
-				for (int j = 0; j < inputSize.width; j++)
-					input[n](d, i * S, j * S) = X[n](d, i, j);
-
-	int pad = fs - 1 - P;
-
-	#pragma omp parallel for collapse(3)
-	for (size_t n = 0; n < X.size(); n++) {
-		for (int i = 0; i < outputSize.height; i++) {
-			for (int j = 0; j < outputSize.width; j++) {
-				for (int f = 0; f < fc; f++) {
-					double sum = b[f];
-
-					for (int k = 0; k < fs; k++) {
-						int y = i+k-pad;
-
-						if (y < 0 || y >= size.height)
-							continue;
-
-						for (int l = 0; l < fs; l++) {
-							int x = j+l-pad;
-
-							if (x < 0 || x >= size.width)
-								continue;
-
-							for (int c = 0; c < fd; c++)
-								sum += W[f](c, fs - 1 - k, fs - 1 - l) * input[n](c, y, x);
-						}
-					}
-
-					output[n](f, i, j) = sum;
-				}
-			}
-		}
-	}
+// прямое распространение: каждая фаза шага считается своим подфильтром, без разреженного нулями входа
+void ConvTransposedLayer::Forward(const Tensor &X) {
+	PackPhaseFilters(W, S, true, packedW);
+	PhaseConv(X, packedW, b.data(), output, fs, P, S);
 }
 
 // обратное распространение
-void ConvTransposedLayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
-	#pragma omp parallel for
-	for (int f = 0; f < fc; f++) {
-		for (size_t n = 0; n < dout.size(); n++) {
-			for (int y = 0; y < inputSize.height; y++) {
-				for (int x = 0; x < inputSize.width; x++) {
-					for (int i = 0; i < fs; i++) {
-						int k = i + y * S - P;
-						
-						if (k < 0 || k >= outputSize.height)
-							continue;
-
-						for (int j = 0; j < fs; j++) {
-							int l = j + x * S - P;
-
-							if (l < 0 || l >= outputSize.width)
-								continue;
-
-							for (int c = 0; c < fd; c++)
-								dW[f](c, i, j) += dout[n](f, k, l) * X[n](c, y, x);
-						}
-					}
-
-				}
-			}
-			
-			for (int k = 0; k < outputSize.height; k++)
-				for (int l = 0; l < outputSize.width; l++)
-					db[f] += dout[n](f, k, l);
-		}		
-	}
+void ConvTransposedLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
+	GemmTransposedConvBackwardWeights(dout, X, dW, db, fs, P, S);
 
 	if (calc_dX) {
-		#pragma omp parallel for collapse(4)
-		for (size_t n = 0; n < dout.size(); n++) {
-			for (int c = 0; c < fd; c++) {
-				for (int i = 0; i < inputSize.height; i++) {
-					for (int j = 0; j < inputSize.width; j++) {
-						double sum = 0;
-
-						for (int k = 0; k < fs; k++) {
-							int y = S * i + k - P;
-
-							if (y < 0 || y >= outputSize.height)
-								continue;
-
-							for (int l = 0; l < fs; l++) {
-								int x = S * j + l - P;
-
-								if (x < 0 || x >= outputSize.width)
-									continue;
-
-								for (int f = 0; f < fc; f++)
-									sum += dout[n](f, y, x) * W[f](c, k, l);
-							}
-						}
-
-						dX[n](c, i, j) = sum;
-					}
-				}
-			}
-		}
+		PackPhaseFilters(W, 1, false, packedW); // при единичном шаге фаза одна, и фильтры лежат в порядке [k][l][f][c]
+		GemmTransposedConvBackwardInput(dout, packedW, dX, fs, P, S);
 	}
 }
 
@@ -302,16 +206,16 @@ void ConvTransposedLayer::Save(std::ofstream &f) const {
 	}
 }
 
-void ConvTransposedLayer::SetWeight(int index, int i, int j, int k, double weight) {
+void ConvTransposedLayer::SetWeight(int index, int i, int j, int k, real weight) {
 	W[index](i, j, k) = weight;
 }
 
-void ConvTransposedLayer::SetBias(int index, double bias) {
+void ConvTransposedLayer::SetBias(int index, real bias) {
 	b[index] = bias;
 }
 
 // установка веса по индексу
-void ConvTransposedLayer::SetParam(int index, double weight) {
+void ConvTransposedLayer::SetParam(int index, real weight) {
 	int params = fs * fs * fd + 1;
 	int findex = index / params;
 	int windex = index % params;
@@ -325,7 +229,7 @@ void ConvTransposedLayer::SetParam(int index, double weight) {
 }
 
 // получение веса по индексу
-double ConvTransposedLayer::GetParam(int index) const {
+real ConvTransposedLayer::GetParam(int index) const {
 	int params = fs * fs * fd + 1;
 	int findex = index / params;
 	int windex = index % params;
@@ -337,7 +241,7 @@ double ConvTransposedLayer::GetParam(int index) const {
 }
 
 // получение градиента веса по индексу
-double ConvTransposedLayer::GetGradient(int index) const {
+real ConvTransposedLayer::GetGradient(int index) const {
 	int params = fs * fs * fd + 1;
 	int findex = index / params;
 	int windex = index % params;
@@ -7,61 +7,110 @@
 #include <random>
 
 #include "NetworkLayer.hpp"
+#include "Autotune.hpp"
+#include "QuantizedConvLayer.hpp"
+#include "Kernels/BlockedConv.hpp"
+#include "Kernels/GemmConv.hpp"
+#include "Kernels/ConvKernel.hpp"
+#include "Kernels/PointwiseConv.hpp"
+#include "Kernels/WinogradConv.hpp"
+#include "Kernels/FFTConv.hpp"
+#include "Kernels/ConvAlgorithm.hpp"
 
 class ConvWithoutStrideLayer : public NetworkLayer {
 	std::default_random_engine generator;
-	std::normal_distribution<double> distribution;
+	std::normal_distribution<real> distribution;
 
 	std::vector<Volume> W; // фильтры
 	std::vector<Volume> dW; // градиенты фильтров
 	std::vector<std::vector<Volume>> paramsW; // параметры фильтров
 
-	std::vector<double> b; // смещения
-	std::vector<double> db; // градиенты смещений
-	std::vector<std::vector<double>> paramsb; // параметры смещений
+	std::vector<real> b; // смещения
+	std::vector<real> db; // градиенты смещений
+	std::vector<std::vector<real>> paramsb; // параметры смещений
 
 	int P; // дополнение нулями
+	int D; // разрежение фильтра (расстояние между соседними ядрами во входе)
 
 	int fc; // количество фильтров
 	int fs; // размер фильтров
 	int fd; // глубина фильтров
 
+	Layout layout; // расположение входа и выхода
+	ConvAlgorithm algorithm; // алгоритм свёртки в канальном расположении
+	AlignedVector packedW; // фильтры, упакованные для блочной свёртки, GEMM или специализированного ядра
+	AlignedVector packedWT; // фильтры, упакованные для градиентов входа
+	bool packed; // соответствуют ли упакованные фильтры текущим весам
+	bool packedT; // соответствуют ли упакованные для градиентов входа фильтры текущим весам
+	ConvKernelFunction kernel; // ядро, специализированное под размер фильтра и шаг (nullptr, если его нет)
+
+	WinogradTiles tiles; // матрицы преобразований Винограда
+	AlignedVector winogradW; // фильтры в области Винограда
+	AlignedVector winogradWT; // повёрнутые фильтры в области Винограда для градиентов входа
+	FFTSpectra fftW; // спектры фильтров
+	FFTSpectra fftWT; // спектры повёрнутых фильтров для градиентов входа
+	bool transformed; // соответствуют ли преобразованные фильтры текущим весам
+
+	Epilogue epilogue; // слитые со свёрткой при выводе активация и нормализация
+
 	void InitParams(); // инициализация параметров для обучения
 	void InitWeights(); // инициализация весовых коэффициентов
 	void LoadWeights(std::ifstream &f); // считывание весовых коэффициентов из файла
+	void UpdateInfo(); // обновление информации о слое
+	void TransformFilters(); // преобразование фильтров для свёртки Винограда или через FFT
+	void PackFilters(); // упаковка фильтров для прямого распространения
+	void PackTransposedFilters(); // упаковка фильтров для градиентов входа
 
 public:
-	ConvWithoutStrideLayer(VolumeSize size, int fc, int fs, int P);
-	ConvWithoutStrideLayer(VolumeSize size, int fc, int fs, int P, std::ifstream &f);
+	ConvWithoutStrideLayer(VolumeSize size, int fc, int fs, int P, int D);
+	ConvWithoutStrideLayer(VolumeSize size, int fc, int fs, int P, int D, std::ifstream &f);
 
 	int GetTrainableParams() const; // получение количества обучаемых параметров
-
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	Layout GetLayout() const; // расположение входа и выхода слоя
+	void SetLayout(Layout layout); // установка расположения входа и выхода
+	ConvAlgorithm GetAlgorithm() const; // алгоритм свёртки
+	void SetAlgorithm(ConvAlgorithm algorithm); // установка алгоритма свёртки
+	void ChooseAlgorithm(); // выбор алгоритма свёртки по оценке количества операций
+	int Autotune(AutotuneCache &cache, int batchSize, bool training); // выбор самого быстрого алгоритма свёртки замерами
+
+	void ForwardOutput(const Tensor &X); // прямое распространение при выводе
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
 	void UpdateWeights(const Optimizer &optimizer, bool trainable); // обновление весовых коэффициентов
 
+	bool FuseScaleShift(const std::vector<real> &scale, const std::vector<real> &shift); // встраивание поканального преобразования выхода
+	bool FuseActivation(EpilogueActivation activation, real alpha); // встраивание активации выхода
+	NetworkLayer* Quantize(const QuantizationParams &input) const; // квантованная копия свёртки для вывода
+
 	void ResetCache(); // сброс параметров
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
 	void SetBatchSize(int batchSize); // установка размера батча
 
-	void SetWeight(int index, int i, int j, int k, double weight);
-	void SetBias(int index, double bias);
+	void SetWeight(int index, int i, int j, int k, real weight);
+	void SetBias(int index, real bias);
 
-	void SetParam(int index, double weight); // установка веса по индексу
-	double GetParam(int index) const; // получение веса по индексу
-	double GetGradient(int index) const; // получение градиента веса по индексу
+	void SetParam(int index, real weight); // установка веса по индексу
+	real GetParam(int index) const; // получение веса по индексу
+	real GetGradient(int index) const; // получение градиента веса по индексу
 	void ZeroGradient(int index); // обнуление градиента веса по индексу
 };
 
-ConvWithoutStrideLayer::ConvWithoutStrideLayer(VolumeSize size, int fc, int fs, int P) : NetworkLayer(size, size.width - fs + 2 * P + 1, size.height - fs + 2 * P + 1, fc), distribution(0.0, sqrt(2.0 / (fs*fs*size.deep))) {
+ConvWithoutStrideLayer::ConvWithoutStrideLayer(VolumeSize size, int fc, int fs, int P, int D) : NetworkLayer(size, size.width - D * (fs - 1) + 2 * P, size.height - D * (fs - 1) + 2 * P, fc), distribution(0.0, sqrt(2.0 / (fs*fs*size.deep))) {
 	this->P = P;
+	this->D = D;
 
 	this->fc = fc;
 	this->fs = fs;
 	this->fd = size.deep;
+	this->layout = Layout::Channels;
+	this->algorithm = ConvAlgorithm::Gemm;
+	this->kernel = D == 1 ? GetConvKernel(fs, 1) : nullptr;
+	this->transformed = false;
+	this->packed = false;
+	this->packedT = false;
 
 	name = "conv";
-	info = std::to_string(fc) + " filters [" + std::to_string(fs) + "x" + std::to_string(fs) + "x" + std::to_string(fd) + "] P:" + std::to_string(P);
+	UpdateInfo();
 
 	for (int i = 0; i < fc; i++) {
 		W.push_back(Volume(fs, fs, fd));
@@ -75,15 +124,22 @@ ConvWithoutStrideLayer::ConvWithoutStrideLayer(VolumeSize size, int fc, int fs,
 	InitWeights();
 }
 
-ConvWithoutStrideLayer::ConvWithoutStrideLayer(VolumeSize size, int fc, int fs, int P, std::ifstream &f) : NetworkLayer(size, size.width - fs + 2 * P + 1, size.height - fs + 2 * P + 1, fc), distribution(0.0, sqrt(2.0 / (fs*fs*size.deep))) {
+ConvWithoutStrideLayer::ConvWithoutStrideLayer(VolumeSize size, int fc, int fs, int P, int D, std::ifstream &f) : NetworkLayer(size, size.width - D * (fs - 1) + 2 * P, size.height - D * (fs - 1) + 2 * P, fc), distribution(0.0, sqrt(2.0 / (fs*fs*size.deep))) {
 	this->P = P;
+	this->D = D;
 
 	this->fc = fc;
 	this->fs = fs;
 	this->fd = size.deep;
+	this->layout = Layout::Channels;
+	this->algorithm = ConvAlgorithm::Gemm;
+	this->kernel = D == 1 ? GetConvKernel(fs, 1) : nullptr;
+	this->transformed = false;
+	this->packed = false;
+	this->packedT = false;
 
 	name = "conv";
-	info = std::to_string(fc) + " filters [" + std::to_string(fs) + "x" + std::to_string(fs) + "x" + std::to_string(fd) + "] P:" + std::to_string(P);
+	UpdateInfo();
 
 	for (int i = 0; i < fc; i++) {
 		W.push_back(Volume(fs, fs, fd));
@@ -101,7 +157,7 @@ ConvWithoutStrideLayer::ConvWithoutStrideLayer(VolumeSize size, int fc, int fs,
 void ConvWithoutStrideLayer::InitParams() {
 	for (int i = 0; i < OPTIMIZER_PARAMS_COUNT; i++) {
 		paramsW.push_back(std::vector<Volume>(fc, Volume(fs, fs, fd)));
-		paramsb.push_back(std::vector<double>(fc, 0));
+		paramsb.push_back(std::vector<real>(fc, 0));
 	}
 }
 
@@ -134,23 +190,234 @@ int ConvWithoutStrideLayer::GetTrainableParams() const {
 	return fc * (fs * fs * fd + 1);
 }
 
+// расположение входа и выхода слоя
+Layout ConvWithoutStrideLayer::GetLayout() const {
+	return layout;
+}
+
+// установка расположения входа и выхода
+void ConvWithoutStrideLayer::SetLayout(Layout layout) {
+	if (layout == Layout::Any)
+		throw std::runtime_error("Invalid conv layout");
+
+	this->layout = layout;
+	this->packed = false;
+	UpdateInfo();
+}
+
+// алгоритм свёртки
+ConvAlgorithm ConvWithoutStrideLayer::GetAlgorithm() const {
+	return algorithm;
+}
+
+// установка алгоритма свёртки (используется только в канальном расположении)
+void ConvWithoutStrideLayer::SetAlgorithm(ConvAlgorithm algorithm) {
+	if (IsWinograd(algorithm) && fs != 3)
+		throw std::runtime_error("Winograd convolution requires 3x3 filters");
+
+	if ((IsWinograd(algorithm) || algorithm == ConvAlgorithm::Specialized) && D > 1)
+		throw std::runtime_error(ConvAlgorithmToString(algorithm) + " convolution does not support dilation");
+
+	if (algorithm == ConvAlgorithm::Specialized && !kernel)
+		throw std::runtime_error("No specialized conv kernel for filter size " + std::to_string(fs));
+
+	if (algorithm == ConvAlgorithm::Pointwise && fs != 1)
+		throw std::runtime_error("Pointwise convolution requires 1x1 filters");
+
+	this->algorithm = algorithm;
+	this->transformed = false;
+	this->packed = false;
+	this->packedT = false;
+
+	if (IsWinograd(algorithm))
+		tiles = GetWinogradTiles(algorithm == ConvAlgorithm::Winograd4 ? 4 : 2);
+
+	if (algorithm == ConvAlgorithm::FFT) {
+		fftW.size = ChooseFFTSize(inputSize, outputSize, D * (fs - 1) + 1, 1);
+		fftWT.size = ChooseFFTSize(outputSize, inputSize, D * (fs - 1) + 1, 1);
+	}
+
+	UpdateInfo();
+}
+
+// выбор алгоритма свёртки по оценке количества операций
+void ConvWithoutStrideLayer::ChooseAlgorithm() {
+	SetAlgorithm(ChooseConvAlgorithm(inputSize, outputSize, fs, 1, D));
+}
+
+// выбор самого быстрого алгоритма свёртки замерами всех подходящих слою алгоритмов на батче batchSize
+// результат запоминается в кэше по форме слоя, и при повторной настройке алгоритм берётся из кэша без замеров
+int ConvWithoutStrideLayer::Autotune(AutotuneCache &cache, int batchSize, bool training) {
+	if (layout == Layout::Blocked)
+		return 0; // в блочном расположении алгоритм один
+
+	std::string key = ConvAutotuneKey("convnostride", inputSize, fc, fs, P, 1, D, batchSize, training);
+	std::string value;
+
+	if (cache.Find(key, value)) {
+		SetAlgorithm(StringToConvAlgorithm(value));
+		return 0;
+	}
+
+	std::vector<ConvAlgorithm> algorithms = GetAutotuneConvAlgorithms();
+	ConvAlgorithm best = algorithm;
+	double bestTime = INFINITY;
+
+	for (size_t i = 0; i < algorithms.size(); i++) {
+		try {
+			SetAlgorithm(algorithms[i]);
+		}
+		catch (const std::runtime_error &) {
+			continue; // алгоритм не поддерживает форму слоя
+		}
+
+		double time = MeasureLayerPass(*this, batchSize, training);
+
+		if (time < bestTime) {
+			best = algorithms[i];
+			bestTime = time;
+		}
+	}
+
+	SetAlgorithm(best);
+	cache.Set(key, ConvAlgorithmToString(best));
+	return 1;
+}
+
+// обновление информации о слое
+void ConvWithoutStrideLayer::UpdateInfo() {
+	info = std::to_string(fc) + " filters [" + std::to_string(fs) + "x" + std::to_string(fs) + "x" + std::to_string(fd) + "] P:" + std::to_string(P);
+
+	if (D > 1)
+		info += " D:" + std::to_string(D);
+
+	if (layout == Layout::Blocked)
+		info += " layout: blocked";
+	else if (algorithm != ConvAlgorithm::Gemm)
+		info += " algorithm: " + ConvAlgorithmToString(algorithm);
+
+	if (!epilogue.Empty())
+		info += " epilogue: " + EpilogueToString(epilogue);
+}
+
+// преобразование фильтров для свёртки Винограда или через FFT (выполняется только после изменения весов)
+void ConvWithoutStrideLayer::TransformFilters() {
+	if (transformed)
+		return;
+
+	if (algorithm == ConvAlgorithm::FFT) {
+		FFTTransformFilters(W, fs, D, false, fftW);
+		FFTTransformFilters(W, fs, D, true, fftWT);
+	}
+	else {
+		WinogradTransformFilters(W, tiles, false, winogradW);
+		WinogradTransformFilters(W, tiles, true, winogradWT);
+	}
+
+	transformed = true;
+}
+
+// упаковка фильтров для прямого распространения (выполняется только после изменения весов, алгоритма или расположения)
+void ConvWithoutStrideLayer::PackFilters() {
+	if (packed)
+		return;
+
+	if (layout == Layout::Blocked) {
+		PackBlockedFilters(W, fs, fd, packedW);
+	}
+	else if (algorithm == ConvAlgorithm::Specialized || (algorithm == ConvAlgorithm::Pointwise && kernel)) {
+		PackKernelFilters(W, false, packedW);
+	}
+	else {
+		PackGemmFilters(W, packedW);
+	}
+
+	packed = true;
+}
+
+// упаковка фильтров для градиентов входа (выполняется только после изменения весов или алгоритма)
+void ConvWithoutStrideLayer::PackTransposedFilters() {
+	if (packedT)
+		return;
+
+	if (algorithm == ConvAlgorithm::Specialized) {
+		PackKernelFilters(W, true, packedWT);
+	}
+	else {
+		PackGemmFilters(W, packedWT);
+	}
+
+	packedT = true;
+}
+
+// прямое распространение при выводе: свёртка, затем слитые с ней активация и нормализация одним проходом по выходу
+void ConvWithoutStrideLayer::ForwardOutput(const Tensor &X) {
+	Forward(X);
+
+	if (!epilogue.Empty())
+		ApplyEpilogue(epilogue, output, layout);
+}
+
 // прямое распространение
-void ConvWithoutStrideLayer::Forward(const std::vector<Volume> &X) {
+void ConvWithoutStrideLayer::Forward(const Tensor &X) {
+	if (layout == Layout::Blocked) {
+		PackFilters();
+		BlockedConvForward(X, packedW, b, output, fs, P, 1, D);
+		return;
+	}
+
+	if (algorithm == ConvAlgorithm::Gemm) {
+		PackFilters();
+		GemmConvForward(X, packedW, b, output, fs, P, 1, D);
+		return;
+	}
+
+	// произведение матриц свёртки 1x1 быстрее считает ядро 1x1, читающее вход без упаковки
+	if (algorithm == ConvAlgorithm::Pointwise && kernel) {
+		PackFilters();
+		kernel(X, packedW, b.data(), output, P);
+		return;
+	}
+
+	if (algorithm == ConvAlgorithm::Pointwise) {
+		PackFilters();
+		PointwiseConvForward(X, packedW, b, output, P, 1);
+		return;
+	}
+
+	if (algorithm == ConvAlgorithm::Specialized) {
+		PackFilters();
+		kernel(X, packedW, b.data(), output, P);
+		return;
+	}
+
+	if (IsWinograd(algorithm)) {
+		TransformFilters();
+		WinogradConvForward(X, winogradW, b.data(), output, P, tiles);
+		return;
+	}
+
+	if (algorithm == ConvAlgorithm::FFT) {
+		TransformFilters();
+		FFTConvForward(X, fftW, b.data(), output, D * (fs - 1) + 1, P, 1);
+		return;
+	}
+
 	#pragma omp parallel for collapse(4)
 	for (size_t n = 0; n < X.size(); n++) {
 		for (int f = 0; f < fc; f++) {
 			for (int i = 0; i < outputSize.height; i++) {
 				for (int j = 0; j < outputSize.width; j++) {
-					double sum = b[f];
+					real sum = b[f];
 
 					for (int k = 0; k < fs; k++) {
-						int i0 = i + k - P;
+						int i0 = i + D * k - P;
 
 						if (i0 < 0 || i0 >= inputSize.height)
 							continue;
 
 						for (int l = 0; l < fs; l++) {
-							int j0 = j + l - P;
+							int j0 = j + D * l - P;
 
 							if (j0 < 0 || j0 >= inputSize.width)
 								continue;
@@ -168,55 +435,148 @@ void ConvWithoutStrideLayer::Forward(const std::vector<Volume> &X) {
 }
 
 // обратное распространение
-void ConvWithoutStrideLayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
+void ConvWithoutStrideLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
+	if (layout == Layout::Blocked) {
+		BlockedConvBackwardWeights(dout, X, dW, db, fs, P, 1, D);
+
+		if (calc_dX)
+			BlockedConvBackwardInput(dout, W, dX, fs, P, 1, D);
+
+		return;
+	}
+
+	if (algorithm == ConvAlgorithm::Gemm) {
+		GemmConvBackwardWeights(dout, X, dW, db, fs, P, 1, D);
+
+		if (calc_dX) {
+			PackFilters(); // упаковка для GEMM та же, что и при прямом распространении
+			GemmConvBackwardInput(dout, packedW, dX, fs, P, 1, D);
+		}
+
+		return;
+	}
+
+	if (algorithm == ConvAlgorithm::Pointwise) {
+		PointwiseConvBackwardWeights(dout, X, dW, db, P, 1);
+
+		if (calc_dX) {
+			PackTransposedFilters();
+			PointwiseConvBackwardInput(dout, packedWT, dX, P, 1);
+		}
+
+		return;
+	}
+
+	// градиенты фильтров считаются через GEMM, а градиенты входа - тем же ядром с повёрнутыми фильтрами
+	if (algorithm == ConvAlgorithm::Specialized) {
+		GemmConvBackwardWeights(dout, X, dW, db, fs, P, 1, D);
+
+		if (calc_dX) {
+			PackTransposedFilters();
+			kernel(dout, packedWT, nullptr, dX, fs - 1 - P);
+		}
+
+		return;
+	}
+
+	// градиенты фильтров считаются через GEMM, а градиенты входа - свёрткой Винограда с повёрнутыми фильтрами
+	if (IsWinograd(algorithm)) {
+		GemmConvBackwardWeights(dout, X, dW, db, fs, P, 1, D);
+
+		if (calc_dX) {
+			TransformFilters();
+			WinogradConvForward(dout, winogradWT, nullptr, dX, fs - 1 - P, tiles);
+		}
+
+		return;
+	}
+
+	if (algorithm == ConvAlgorithm::FFT) {
+		GemmConvBackwardWeights(dout, X, dW, db, fs, P, 1, D);
+
+		if (calc_dX) {
+			TransformFilters();
+			FFTConvForward(dout, fftWT, nullptr, dX, D * (fs - 1) + 1, D * (fs - 1) - P, 1);
+		}
+
+		return;
+	}
+
+	int total = fs * fs * fd;
+	GradientTiles tiles = GetGradientTiles(dout.size(), outputSize.height);
+	size_t count = fc * total + fc; // градиенты фильтров, затем смещений
+	real *partials = GradientPartials(tiles.parts, count);
+
+	// участки батча (полосы строк выхода) накапливаются потоками в частичные суммы, которые затем складываются деревом
 	#pragma omp parallel for
-	for (int f = 0; f < fc; f++) {
-		for (size_t n = 0; n < dout.size(); n++) {
-			for (int k = 0; k < outputSize.height; k++) {
-				for (int l = 0; l < outputSize.width; l++) {
-					double delta = dout[n](f, k, l);
+	for (int part = 0; part < tiles.parts; part++) {
+		real *gradients = partials + part * count;
+		std::fill(gradients, gradients + count, 0);
 
-					for (int i = 0; i < fs; i++) {
-						int i0 = i + k - P;
+		for (int unit = part * tiles.units / tiles.parts; unit < (part + 1) * tiles.units / tiles.parts; unit++) {
+			int n = unit / tiles.bands;
+			int begin = unit % tiles.bands * tiles.bandRows;
+			int end = std::min(outputSize.height, begin + tiles.bandRows);
 
-						if (i0 < 0 || i0 >= inputSize.height)
-							continue;
+			for (int f = 0; f < fc; f++) {
+				real *dw = gradients + f * total;
 
-						for (int j = 0; j < fs; j++) {
-							int j0 = j + l - P;
+				for (int k = begin; k < end; k++) {
+					for (int l = 0; l < outputSize.width; l++) {
+						real delta = dout[n](f, k, l);
 
-							if (j0 < 0 || j0 >= inputSize.width)
+						for (int i = 0; i < fs; i++) {
+							int i0 = D * i + k - P;
+
+							if (i0 < 0 || i0 >= inputSize.height)
 								continue;
 
-							for (int c = 0; c < fd; c++)
-								dW[f](c, i, j) += delta * X[n](c, i0, j0);
+							for (int j = 0; j < fs; j++) {
+								int j0 = D * j + l - P;
+
+								if (j0 < 0 || j0 >= inputSize.width)
+									continue;
+
+								for (int c = 0; c < fd; c++)
+									dw[(i * fs + j) * fd + c] += delta * X[n](c, i0, j0);
+							}
 						}
-					}
 
-					db[f] += delta;
+						gradients[fc * total + f] += delta;
+					}
 				}
 			}
 		}
 	}
 
+	ReduceGradientPartials(partials, tiles.parts, count);
+
+	#pragma omp parallel for
+	for (int f = 0; f < fc; f++) {
+		for (int i = 0; i < total; i++)
+			dW[f][i] += partials[f * total + i];
+
+		db[f] += partials[fc * total + f];
+	}
+
 	if (calc_dX) {
-		int pad = fs - 1 - P;
+		int pad = D * (fs - 1) - P;
 
 		#pragma omp parallel for collapse(3)
 		for (size_t n = 0; n < dout.size(); n++) {
 			for (int i = 0; i < inputSize.height; i++) {
 				for (int j = 0; j < inputSize.width; j++) {
 					for (int c = 0; c < fd; c++) {
-						double sum = 0;
+						real sum = 0;
 
 						for (int k = 0; k < fs; k++) {
-							int i0 = i+k-pad;
+							int i0 = i + D * k - pad;
 
 							if (i0 < 0 || i0 >= outputSize.height)
 								continue;
 
 							for (int l = 0; l < fs; l++) {
-								int j0 = j+l-pad;
+								int j0 = j + D * l - pad;
 
 								if (j0 < 0 || j0 >= outputSize.width)
 									continue;
@@ -253,6 +613,55 @@ void ConvWithoutStrideLayer::UpdateWeights(const Optimizer &optimizer, bool trai
 
 		db[index] = 0;
 	}
+
+	transformed = transformed && !trainable;
+	packed = packed && !trainable;
+	packedT = packedT && !trainable;
+}
+
+// встраивание поканального преобразования выхода: пока эпилог пуст, оно переносится в фильтры и смещения, иначе добавляется в эпилог
+bool ConvWithoutStrideLayer::FuseScaleShift(const std::vector<real> &scale, const std::vector<real> &shift) {
+	if ((int) scale.size() != fc)
+		return false;
+
+	if (!epilogue.Empty()) {
+		epilogue.AddScaleShift(scale, shift);
+		UpdateInfo();
+		return true;
+	}
+
+	int total = fs * fs * fd;
+
+	for (int f = 0; f < fc; f++) {
+		for (int i = 0; i < total; i++)
+			W[f][i] *= scale[f];
+
+		b[f] = b[f] * scale[f] + shift[f];
+	}
+
+	transformed = false;
+	packed = false;
+	packedT = false;
+	return true;
+}
+
+// встраивание активации выхода (только в пустой эпилог, иначе нарушится порядок операций)
+bool ConvWithoutStrideLayer::FuseActivation(EpilogueActivation activation, real alpha) {
+	if (!epilogue.Empty())
+		return false;
+
+	epilogue.activation = activation;
+	epilogue.alpha = alpha;
+	UpdateInfo();
+	return true;
+}
+
+// квантованная копия свёртки вместе с эпилогом (в блочном расположении свёртка не квантуется)
+NetworkLayer* ConvWithoutStrideLayer::Quantize(const QuantizationParams &input) const {
+	if (layout == Layout::Blocked)
+		return nullptr;
+
+	return new QuantizedConvLayer(inputSize, outputSize, W, b, P, 1, D, epilogue, input);
 }
 
 // сброс параметров
@@ -271,8 +680,22 @@ void ConvWithoutStrideLayer::ResetCache() {
 
 // сохранение слоя в файл
 void ConvWithoutStrideLayer::Save(std::ofstream &f) const {
-	f << "conv " << inputSize << " ";
-	f << fs << " " << fc << " " << P << " 1" << std::endl;
+	if (D > 1) {
+		f << "dilatedconv " << inputSize << " ";
+		f << fs << " " << fc << " " << P << " 1 " << D;
+	}
+	else {
+		f << "conv " << inputSize << " ";
+		f << fs << " " << fc << " " << P << " 1";
+	}
+
+	// расположение и алгоритм, выбранный не по оценке количества операций, дописываются необязательными полями
+	if (layout == Layout::Blocked)
+		f << " layout=" << LayoutToString(layout);
+	else if (algorithm != ChooseConvAlgorithm(inputSize, outputSize, fs, 1, D))
+		f << " algorithm=" << ConvAlgorithmToString(algorithm);
+
+	f << std::endl;
 
 	for (int index = 0; index < fc; index++) {
 		for (int d = 0; d < fd; d++)
@@ -286,20 +709,23 @@ void ConvWithoutStrideLayer::Save(std::ofstream &f) const {
 
 // установка размера батча
 void ConvWithoutStrideLayer::SetBatchSize(int batchSize) {
-	output = std::vector<Volume>(batchSize, Volume(outputSize));
-	dX = std::vector<Volume>(batchSize, Volume(inputSize));
+	output.Resize(batchSize, outputSize);
+	dX.Resize(batchSize, inputSize);
 }
 
-void ConvWithoutStrideLayer::SetWeight(int index, int i, int j, int k, double weight) {
+void ConvWithoutStrideLayer::SetWeight(int index, int i, int j, int k, real weight) {
 	W[index](i, j, k) = weight;
+	transformed = false;
+	packed = false;
+	packedT = false;
 }
 
-void ConvWithoutStrideLayer::SetBias(int index, double bias) {
+void ConvWithoutStrideLayer::SetBias(int index, real bias) {
 	b[index] = bias;
 }
 
 // установка веса по индексу
-void ConvWithoutStrideLayer::SetParam(int index, double weight) {
+void ConvWithoutStrideLayer::SetParam(int index, real weight) {
 	int params = fs * fs * fd + 1;
 	int findex = index / params;
 	int windex = index % params;
@@ -309,11 +735,14 @@ void ConvWithoutStrideLayer::SetParam(int index, double weight) {
 	}
 	else {
 		W[findex][windex] = weight;
+		transformed = false;
+		packed = false;
+		packedT = false;
 	}
 }
 
 // получение веса по индексу
-double ConvWithoutStrideLayer::GetParam(int index) const {
+real ConvWithoutStrideLayer::GetParam(int index) const {
 	int params = fs * fs * fd + 1;
 	int findex = index / params;
 	int windex = index % params;
@@ -325,7 +754,7 @@ double ConvWithoutStrideLayer::GetParam(int index) const {
 }
 
 // получение градиента веса по индексу
-double ConvWithoutStrideLayer::GetGradient(int index) const {
+real ConvWithoutStrideLayer::GetGradient(int index) const {
 	int params = fs * fs * fd + 1;
 	int findex = index / params;
 	int windex = index % params;
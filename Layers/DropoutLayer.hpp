@@ -9,24 +9,26 @@
 #include "NetworkLayer.hpp"
 
 class DropoutLayer : public NetworkLayer {
-	double p;
-	double q;
+	real p;
+	real q;
 	int total;
 
 	std::default_random_engine generator;
 	std::binomial_distribution<int> distribution;
 
 public:
-	DropoutLayer(VolumeSize size, double p);
+	DropoutLayer(VolumeSize size, real p);
 
-	void ForwardOutput(const std::vector<Volume> &X); // прямое распространение
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	void ForwardOutput(const Tensor &X); // прямое распространение
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
+	Layout GetLayout() const; // расположение входа и выхода слоя
+	bool AliasesInput() const; // ссылается ли выход слоя на вход при выводе
 
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
 };
 
-DropoutLayer::DropoutLayer(VolumeSize size, double p) : NetworkLayer(size), distribution(1, 1 - p) {
+DropoutLayer::DropoutLayer(VolumeSize size, real p) : NetworkLayer(size), distribution(1, 1 - p) {
 	this->p = p;
 	this->q = 1 - p;
 	this->total = size.width * size.height * size.deep;
@@ -35,19 +37,15 @@ DropoutLayer::DropoutLayer(VolumeSize size, double p) : NetworkLayer(size), dist
 	info = "p: " + std::to_string(p);
 }
 
-// прямое распространение
-void DropoutLayer::ForwardOutput(const std::vector<Volume> &X) {
-	#pragma omp parallel for collapse(2)
-	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
-		for (int i = 0; i < total; i++) {
-			output[batchIndex][i] = X[batchIndex][i];
-			dX[batchIndex][i] = 1;
-		}
-	}
+// прямое распространение (на этапе вывода слой тождественный, поэтому выход ссылается на вход без копирования)
+void DropoutLayer::ForwardOutput(const Tensor &X) {
+	output.Alias(X);
 }
 
 // прямое распространение
-void DropoutLayer::Forward(const std::vector<Volume> &X) {
+void DropoutLayer::Forward(const Tensor &X) {
+	output.Detach(); // после вывода выход мог ссылаться на вход
+
 	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
 		for (int i = 0; i < total; i++) {
 			if (distribution(generator)) { 
@@ -63,7 +61,7 @@ void DropoutLayer::Forward(const std::vector<Volume> &X) {
 }
 
 // обратное распространение
-void DropoutLayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
+void DropoutLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
 	if (!calc_dX)
 		return;
 
@@ -73,6 +71,16 @@ void DropoutLayer::Backward(const std::vector<Volume> &dout, const std::vector<V
 			dX[batchIndex][i] *= dout[batchIndex][i];
 }
 
+// расположение входа и выхода слоя (поэлементный слой работает с любым)
+Layout DropoutLayer::GetLayout() const {
+	return Layout::Any;
+}
+
+// ссылается ли выход слоя на вход при выводе
+bool DropoutLayer::AliasesInput() const {
+	return true;
+}
+
 // сохранение слоя в файл
 void DropoutLayer::Save(std::ofstream &f) const {
 	f << "dropout " << inputSize << " " << p << std::endl;
@@ -9,43 +9,48 @@
 
 #include "NetworkLayer.hpp"
 #include "../Entities/Matrix.hpp"
+#include "Kernels/SVD.hpp"
+#include "Kernels/Gemm.hpp"
+#include "Kernels/GradientReduction.hpp"
+#include "Kernels/FullyConnectedActivation.hpp"
+
+#include "QuantizedFullyConnectedLayer.hpp"
+#include "SparseFullyConnectedLayer.hpp"
+#include "LowRankFullyConnectedLayer.hpp"
+
+#define FC_COLUMN_BLOCK 256 // столбцов весов в полосе при вычислении градиентов входа малого батча
 
 class FullyConnectedLayer : public NetworkLayer {
 	std::default_random_engine generator;
-	std::normal_distribution<double> distribution;
-
-	// тип активационной функции
-	enum class ActivationType {
-		None,
-		Sigmoid,
-		Tanh,
-		ReLU,
-		LeakyReLU,
-		ELU
-	};
+	std::normal_distribution<real> distribution;
 
 	int inputs;
 	int outputs;
 
-	ActivationType activationType; // тип активационной функции
+	FullyConnectedActivation activationType; // тип активационной функции
 
 	Matrix W; // матрица весовых коэффициентов
 	Matrix dW;
+	AlignedVector packedW; // W^T, упакованная для умножения на батч
+	bool packed; // соответствует ли packedW текущим весам
 	std::vector<Matrix> paramsW;
 
-	std::vector<double> b; // смещения
-	std::vector<double> db;
-	std::vector<std::vector<double>> paramsb;
+	std::vector<real> b; // смещения
+	std::vector<real> db;
+	std::vector<std::vector<real>> paramsb;
 
-	std::vector<Volume> df;
+	Tensor delta; // градиенты по взвешенным суммам нейронов (dout * f'(x), производная вычисляется по выходу)
+	Epilogue epilogue; // слитые с слоем при выводе активация и нормализация
 
 	void InitParams(); // инициализация параметров для обучения
 	void InitWeights(); // инициализация весовых коэффициентов
 	void LoadWeights(std::ifstream &f); // считывание весовых коэффициентов из файла
+	void UpdateInfo(); // обновление информации о слое
 
-	ActivationType GetActivationType(const std::string& type) const; // получение типа активационной функции по строке
-	std::string GetActivationType() const; // получение строки для активационной функции
-	void Activate(int batchIndex, int i, double value); // применение активационной функции
+	void WeightedSums(const Tensor &X); // взвешенные суммы батча без смещений
+	int GetPartSize(int count, int step) const; // размер части при разбиении между потоками
+	void InputGradients(const real *d, int batchSize); // градиенты входа по градиентам взвешенных сумм
+	void WeightGradients(const real *d, const Tensor &X); // накопление градиентов весов и смещений по градиентам взвешенных сумм
 
 public:
 	FullyConnectedLayer(VolumeSize size, int outputs, const std::string& type = "none");
@@ -53,20 +58,28 @@ public:
 
 	int GetTrainableParams() const; // получение количества обучаемых параметров
 
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	void ForwardOutput(const Tensor &X); // прямое распространение без вычисления производных
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
 	void UpdateWeights(const Optimizer &optimizer, bool trainable); // обновление весовых коэффициентов
 
+	bool FuseScaleShift(const std::vector<real> &scale, const std::vector<real> &shift); // встраивание преобразования выхода
+	bool FuseActivation(EpilogueActivation activation, real alpha); // встраивание активации выхода
+	NetworkLayer* Quantize(const QuantizationParams &input) const; // квантованная копия слоя для вывода
+	NetworkLayer* Prune(real sparsity) const; // разреженная копия слоя без наименьших по модулю весов
+	NetworkLayer* Factorize(int rank) const; // копия слоя с весами ранга rank
+
 	void ResetCache(); // сброс параметров
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
 	void SetBatchSize(int batchSize); // установка размера батча
+	void SetInferenceBatchSize(int batchSize); // установка размера батча для вывода без градиентов
 
-	void SetWeight(int i, int j, double weight);
-	void SetBias(int i, double bias);
+	void SetWeight(int i, int j, real weight);
+	void SetBias(int i, real bias);
 
-	void SetParam(int index, double weight); // установка веса по индексу
-	double GetParam(int index) const; // получение веса по индексу
-	double GetGradient(int index) const; // получение градиента веса по индексу
+	void SetParam(int index, real weight); // установка веса по индексу
+	real GetParam(int index) const; // получение веса по индексу
+	real GetGradient(int index) const; // получение градиента веса по индексу
 	void ZeroGradient(int index); // обнуление градиента веса по индексу
 };
 
@@ -74,13 +87,11 @@ FullyConnectedLayer::FullyConnectedLayer(VolumeSize size, int outputs, const std
 	this->inputs = size.height * size.width * size.deep;
 	this->outputs = outputs;
 
-	activationType = GetActivationType(type);
+	activationType = StringToFullyConnectedActivation(type);
 
 	name = "fc";
-	info = std::to_string(outputs) + " neurons";
-
-	if (activationType != ActivationType::None)
-		info += ", f: " + GetActivationType();
+	packed = false;
+	UpdateInfo();
 
 	InitParams();
 	InitWeights();
@@ -90,14 +101,12 @@ FullyConnectedLayer::FullyConnectedLayer(VolumeSize size, int outputs, const std
 	this->inputs = size.height * size.width * size.deep;
 	this->outputs = outputs;
 
-	activationType = GetActivationType(type);
+	activationType = StringToFullyConnectedActivation(type);
 
 	name = "fc";
-	info = std::to_string(outputs) + " neurons";
+	packed = false;
+	UpdateInfo();
 
-	if (activationType != ActivationType::None)
-		info += ", f: " + GetActivationType();
-	
 	InitParams();
 	LoadWeights(f);
 }
@@ -106,7 +115,7 @@ FullyConnectedLayer::FullyConnectedLayer(VolumeSize size, int outputs, const std
 void FullyConnectedLayer::InitParams() {
 	for (int i = 0; i < OPTIMIZER_PARAMS_COUNT; i++) {
 		paramsW.push_back(Matrix(outputs, inputs));
-		paramsb.push_back(std::vector<double>(outputs));
+		paramsb.push_back(std::vector<real>(outputs));
 	}
 }
 
@@ -130,151 +139,156 @@ void FullyConnectedLayer::LoadWeights(std::ifstream &f) {
 	}
 }
 
-// получение типа активационной функции по строке
-FullyConnectedLayer::ActivationType FullyConnectedLayer::GetActivationType(const std::string& type) const {
-	if (type == "sigmoid")
-		return ActivationType::Sigmoid;
+// обновление информации о слое
+void FullyConnectedLayer::UpdateInfo() {
+	info = std::to_string(outputs) + " neurons";
+
+	if (activationType != FullyConnectedActivation::None)
+		info += ", f: " + FullyConnectedActivationToString(activationType);
 
-	if (type == "tanh")
-		return ActivationType::Tanh;
+	if (!epilogue.Empty())
+		info += ", epilogue: " + EpilogueToString(epilogue);
+}
 
-	if (type == "relu")
-		return ActivationType::ReLU;
+// получение количество обучаемых параметров
+int FullyConnectedLayer::GetTrainableParams() const {
+	return outputs * (inputs + 1);
+}
 
-	if (type == "leakyrelu")
-		return ActivationType::LeakyReLU;
+// взвешенные суммы батча без смещений: output (N x outputs) = X * W^T одним умножением, так что каждый блок весов используется всеми примерами
+// W^T упаковывается один раз после изменения весов: иначе при выводе по одному примеру упаковка была бы дороже самого умножения
+// каждая сумма не зависит от остальных строк батча, поэтому выход примера одинаков при любом размере батча
+void FullyConnectedLayer::WeightedSums(const Tensor &X) {
+	if (!packed) {
+		GemmPackMatrix(inputs, outputs, W.Data(), 1, inputs, packedW);
+		packed = true;
+	}
 
-	if (type == "elu")
-		return ActivationType::ELU;
+	GemmPacked(X.size(), outputs, inputs, X.Data(), inputs, 1, packedW.data(), 0, output.Data(), outputs);
+}
 
-	if (type == "none" || type == "")
-		return ActivationType::None;
+// разбиение count строк или столбцов на непрерывные части по числу потоков, кратные step (кроме последней): возвращает размер части
+int FullyConnectedLayer::GetPartSize(int count, int step) const {
+	int parts = std::max(1, std::min(GradientThreads(), count / step));
+	int size = (count + parts - 1) / parts;
 
-	throw std::runtime_error("Invalid activation function");
+	return (size + step - 1) / step * step;
 }
 
-// получение строки для активационной функции
-std::string FullyConnectedLayer::GetActivationType() const {
-	if (activationType == ActivationType::Sigmoid)
-		return "sigmoid";
+// градиенты входа dX (N x inputs) = d * W: каждый поток считает свою полосу столбцов dX по полосе столбцов W, проходя её по строкам
+// сумма каждого значения не зависит от разбиения, поэтому результат одинаков при любом количестве потоков
+void FullyConnectedLayer::InputGradients(const real *d, int batchSize) {
+	int width = GetPartSize(inputs, GEMM_NR);
 
-	if (activationType == ActivationType::Tanh)
-		return "tanh";
+	#pragma omp parallel for
+	for (int start = 0; start < inputs; start += width) {
+		int end = std::min(inputs, start + width);
 
-	if (activationType == ActivationType::ReLU)
-		return "relu";
+		if (batchSize >= GEMM_MR) {
+			Gemm(batchSize, end - start, outputs, d, outputs, 1, W.Data() + start, inputs, 1, 0, dX.Data() + start, inputs);
+			continue;
+		}
 
-	if (activationType == ActivationType::LeakyReLU)
-		return "leakyrelu";
+		for (int block = start; block < end; block += FC_COLUMN_BLOCK) {
+			int blockEnd = std::min(end, block + FC_COLUMN_BLOCK);
 
-	if (activationType == ActivationType::ELU)
-		return "elu";
+			for (int batchIndex = 0; batchIndex < batchSize; batchIndex++) {
+				real *dx = dX.Data() + (size_t) batchIndex * inputs;
 
-	if (activationType == ActivationType::None)
-		return "none";
+				std::fill(dx + block, dx + blockEnd, 0);
 
-	throw std::runtime_error("Invalid activation function");
-}
+				for (int i = 0; i < outputs; i++) {
+					const real *w = W.Data() + (size_t) i * inputs;
+					real value = d[batchIndex * outputs + i];
 
-// применение активационной функции
-void FullyConnectedLayer::Activate(int batchIndex, int i, double value) {
-	if (activationType == ActivationType::None) {
-		output[batchIndex][i] = value;
-		df[batchIndex][i] = 1;
-	}
-	else if (activationType == ActivationType::Sigmoid) {
-		value = 1 / (1 + exp(-value));
-		output[batchIndex][i] = value;
-		df[batchIndex][i] = value * (1 - value);
-	}
-	else if (activationType == ActivationType::Tanh) {
-		value = tanh(value);
-		output[batchIndex][i] = value;
-		df[batchIndex][i] = 1 - value * value;
-	}
-	else if (activationType == ActivationType::ReLU) {
-		if (value > 0) {
-			output[batchIndex][i] = value;
-			df[batchIndex][i] = 1;
-		}
-		else {
-			output[batchIndex][i] = 0;
-			df[batchIndex][i] = 0;
-		}
-	}
-	else if (activationType == ActivationType::LeakyReLU) {
-		if (value > 0) {
-			output[batchIndex][i] = value;
-			df[batchIndex][i] = 1;
-		}
-		else {
-			output[batchIndex][i] = 0.01 * value;
-			df[batchIndex][i] = 0.01;
+					#pragma omp simd
+					for (int j = block; j < blockEnd; j++)
+						dx[j] += value * w[j];
+				}
+			}
 		}
 	}
-	else if (activationType == ActivationType::ELU) {
-		if (value > 0) {
-			output[batchIndex][i] = value;
-			df[batchIndex][i] = 1;
+}
+
+// накопление градиентов весов dW (outputs x inputs) += d^T * X и смещений: каждый поток накапливает свою полосу строк dW и db,
+// поэтому потоки не пишут в общие значения и не нуждаются в редукции
+void FullyConnectedLayer::WeightGradients(const real *d, const Tensor &X) {
+	int batchSize = X.size();
+	int rows = GetPartSize(outputs, GEMM_MR);
+
+	#pragma omp parallel for
+	for (int start = 0; start < outputs; start += rows) {
+		int end = std::min(outputs, start + rows);
+
+		if (batchSize >= GEMM_MR) {
+			Gemm(end - start, inputs, batchSize, d + start, 1, outputs, X.Data(), inputs, 1, 1, dW.Data() + (size_t) start * inputs, inputs);
 		}
 		else {
-			output[batchIndex][i] = exp(value) - 1;
-			df[batchIndex][i] = exp(value);
+			for (int i = start; i < end; i++) {
+				real *dw = dW.Data() + (size_t) i * inputs;
+
+				for (int batchIndex = 0; batchIndex < batchSize; batchIndex++) {
+					const real *x = X.Data() + (size_t) batchIndex * inputs;
+					real value = d[batchIndex * outputs + i];
+
+					#pragma omp simd
+					for (int j = 0; j < inputs; j++)
+						dw[j] += value * x[j];
+				}
+			}
 		}
+
+		for (int batchIndex = 0; batchIndex < batchSize; batchIndex++)
+			for (int i = start; i < end; i++)
+				db[i] += d[batchIndex * outputs + i];
 	}
 }
 
-// получение количество обучаемых параметров
-int FullyConnectedLayer::GetTrainableParams() const {
-	return outputs * (inputs + 1);
-}
+// прямое распространение без вычисления производных (при выводе градиенты не нужны, слитые активация и нормализация применяются сразу)
+void FullyConnectedLayer::ForwardOutput(const Tensor &X) {
+	int batchSize = X.size();
+	real *y = output.Data();
 
-// прямое распространение
-void FullyConnectedLayer::Forward(const std::vector<Volume> &X) {
-	#pragma omp parallel for collapse(2)
-	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
-		for (int i = 0; i < outputs; i++) {
-			double sum = b[i];
+	WeightedSums(X);
 
-			for (int j = 0; j < inputs; j++)
-				sum += W(i, j) * X[batchIndex][j];
+	ActivateRows(activationType, b.data(), y, batchSize, outputs);
 
-			Activate(batchIndex, i, sum);
-		}
-	}
+	if (epilogue.Empty())
+		return;
+
+	#pragma omp parallel for collapse(2)
+	for (int batchIndex = 0; batchIndex < batchSize; batchIndex++)
+		for (int i = 0; i < outputs; i++)
+			y[batchIndex * outputs + i] = epilogue.Apply(y[batchIndex * outputs + i], i);
 }
 
-// обратное распространение
-void FullyConnectedLayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
-	if (calc_dX) {
-		#pragma omp parallel for collapse(2)
-		for (size_t batchIndex = 0; batchIndex < dout.size(); batchIndex++) {
-			for (int j = 0; j < inputs; j++) {
-				double sum = 0;
+// прямое распространение
+void FullyConnectedLayer::Forward(const Tensor &X) {
+	int batchSize = X.size();
+	real *y = output.Data();
 
-				for (int i = 0; i < outputs; i++)
-					sum += W(i, j) * dout[batchIndex][i] * df[batchIndex][i];
+	WeightedSums(X);
 
-				dX[batchIndex][j] = sum;
-			}
-		}
-	}
+	ActivateRows(activationType, b.data(), y, batchSize, outputs);
+}
 
-	for (size_t batchIndex = 0; batchIndex < dout.size(); batchIndex++) {
-		for (int i = 0; i < outputs; i++) {
-			double delta = dout[batchIndex][i] * df[batchIndex][i];
+// обратное распространение: delta = dout * f'(x), dX (N x inputs) = delta * W, dW (outputs x inputs) += delta^T * X, db += сумма delta
+void FullyConnectedLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
+	int batchSize = dout.size();
+	real *d = delta.Data();
 
-			for (int j = 0; j < inputs; j++)
-				dW(i, j) += delta * X[batchIndex][j];
+	ActivationGradientRows(activationType, output.Data(), dout.Data(), d, batchSize, outputs);
 
-			db[i] += delta;
-		}
-	}
+	if (calc_dX)
+		InputGradients(d, batchSize);
+
+	WeightGradients(d, X);
 }
 
 // обновление весовых коэффициентов
 void FullyConnectedLayer::UpdateWeights(const Optimizer &optimizer, bool trainable) {
 	int batchSize = output.size();
+	packed = packed && !trainable;
 
 	#pragma omp parallel for
 	for (int i = 0; i < outputs; i++) {
@@ -292,6 +306,133 @@ void FullyConnectedLayer::UpdateWeights(const Optimizer &optimizer, bool trainab
 	}
 }
 
+// встраивание преобразования выхода: без активации оно переносится в веса и смещения, иначе добавляется в эпилог
+bool FullyConnectedLayer::FuseScaleShift(const std::vector<real> &scale, const std::vector<real> &shift) {
+	if ((int) scale.size() != outputs)
+		return false;
+
+	if (activationType != FullyConnectedActivation::None || !epilogue.Empty()) {
+		epilogue.AddScaleShift(scale, shift);
+		UpdateInfo();
+		return true;
+	}
+
+	for (int i = 0; i < outputs; i++) {
+		for (int j = 0; j < inputs; j++)
+			W(i, j) *= scale[i];
+
+		b[i] = b[i] * scale[i] + shift[i];
+	}
+
+	packed = false;
+	return true;
+}
+
+// встраивание активации выхода (только если у слоя своей активации нет, а эпилог пуст)
+bool FullyConnectedLayer::FuseActivation(EpilogueActivation activation, real alpha) {
+	if (activationType != FullyConnectedActivation::None || !epilogue.Empty())
+		return false;
+
+	epilogue.activation = activation;
+	epilogue.alpha = alpha;
+	UpdateInfo();
+	return true;
+}
+
+// квантованная копия слоя: активация переносится в эпилог (tanh и elu эпилог не представляет, такие слои не квантуются)
+NetworkLayer* FullyConnectedLayer::Quantize(const QuantizationParams &input) const {
+	Epilogue quantized = epilogue;
+
+	if (!ActivationToEpilogue(activationType, quantized))
+		return nullptr;
+
+	std::vector<real> weights(outputs * inputs);
+
+	for (int i = 0; i < outputs; i++)
+		for (int j = 0; j < inputs; j++)
+			weights[i * inputs + j] = W(i, j);
+
+	return new QuantizedFullyConnectedLayer(inputSize, outputs, weights, b, quantized, input);
+}
+
+// прореживание по модулю: остаются round((1 - sparsity) * outputs * inputs) наибольших по модулю весов (при равенстве - первые по порядку)
+// слои со слитым эпилогом не прореживаются, так как разреженный слой создаётся для дообучения и сохранения
+NetworkLayer* FullyConnectedLayer::Prune(real sparsity) const {
+	if (sparsity < 0 || sparsity >= 1)
+		throw std::runtime_error("Sparsity must be in [0, 1)");
+
+	if (!epilogue.Empty())
+		return nullptr;
+
+	size_t total = (size_t) outputs * inputs;
+	size_t keep = std::max((size_t) 1, total - (size_t) (sparsity * total + 0.5));
+	std::vector<real> magnitudes(total);
+
+	for (size_t index = 0; index < total; index++)
+		magnitudes[index] = fabs(W.Data()[index]);
+
+	std::nth_element(magnitudes.begin(), magnitudes.begin() + (total - keep), magnitudes.end());
+	real threshold = magnitudes[total - keep];
+	size_t ties = keep;
+
+	for (size_t index = 0; index < total; index++)
+		if (fabs(W.Data()[index]) > threshold)
+			ties--;
+
+	SparseMatrix sparse;
+	sparse.rows = outputs;
+	sparse.cols = inputs;
+	sparse.offsets.assign(1, 0);
+
+	for (int i = 0; i < outputs; i++) {
+		for (int j = 0; j < inputs; j++) {
+			real magnitude = fabs(W(i, j));
+
+			if (magnitude > threshold || (magnitude == threshold && ties > 0)) {
+				if (magnitude == threshold)
+					ties--;
+
+				sparse.columns.push_back(j);
+				sparse.values.push_back(W(i, j));
+			}
+		}
+
+		sparse.offsets.push_back(sparse.NonZeros());
+	}
+
+	return new SparseFullyConnectedLayer(inputSize, FullyConnectedActivationToString(activationType), sparse, b);
+}
+
+// копия слоя с весами ранга rank: W ~ Us * diag(S) * Vs^T, сингулярные числа делятся поровну между множителями U = Us * sqrt(S) и V = sqrt(S) * Vs^T
+NetworkLayer* FullyConnectedLayer::Factorize(int rank) const {
+	if (rank < 1)
+		throw std::runtime_error("Rank must be positive");
+
+	if (!epilogue.Empty() || rank > std::min(inputs, outputs))
+		return nullptr;
+
+	Matrix Us(outputs, rank);
+	Matrix Vs(inputs, rank);
+	std::vector<real> S;
+
+	TruncatedSVD(W, rank, Us, S, Vs);
+
+	Matrix U(outputs, rank);
+	Matrix V(rank, inputs);
+
+	for (int k = 0; k < rank; k++) {
+		real scale = sqrt(S[k]);
+
+		for (int i = 0; i < outputs; i++)
+			U(i, k) = Us(i, k) * scale;
+
+		for (int j = 0; j < inputs; j++)
+			V(k, j) = Vs(j, k) * scale;
+	}
+
+	return new LowRankFullyConnectedLayer(inputSize, FullyConnectedActivationToString(activationType), U, V, b);
+}
+
 // сброс параметров
 void FullyConnectedLayer::ResetCache() {
 	for (int index = 0; index < OPTIMIZER_PARAMS_COUNT; index++) {
@@ -306,7 +447,7 @@ void FullyConnectedLayer::ResetCache() {
 
 // сохранение слоя в файл
 void FullyConnectedLayer::Save(std::ofstream &f) const {
-	f << "fc " << inputSize << " " << outputs << " " << GetActivationType() << std::endl;
+	f << "fc " << inputSize << " " << outputs << " " << FullyConnectedActivationToString(activationType) << std::endl;
 
 	for (int i = 0; i < outputs; i++) {
 		for (int j = 0; j < inputs; j++)
@@ -318,26 +459,34 @@ void FullyConnectedLayer::Save(std::ofstream &f) const {
 
 // установка размера батча
 void FullyConnectedLayer::SetBatchSize(int batchSize) {
-	output = std::vector<Volume>(batchSize, Volume(outputSize));
-	df = std::vector<Volume>(batchSize, Volume(outputSize));
-	dX = std::vector<Volume>(batchSize, Volume(inputSize));
+	output.Resize(batchSize, outputSize);
+	delta.Resize(batchSize, outputSize);
+	dX.Resize(batchSize, inputSize);
+}
+
+// установка размера батча для вывода без градиентов
+void FullyConnectedLayer::SetInferenceBatchSize(int batchSize) {
+	delta = Tensor();
+	dX = Tensor();
 }
 
-void FullyConnectedLayer::SetWeight(int i, int j, double weight) {
+void FullyConnectedLayer::SetWeight(int i, int j, real weight) {
 	W(i, j) = weight;
+	packed = false;
 }
 
-void FullyConnectedLayer::SetBias(int i, double bias) {
+void FullyConnectedLayer::SetBias(int i, real bias) {
 	b[i] = bias;
 }
 
 // установка веса по индексу
-void FullyConnectedLayer::SetParam(int index, double weight) {
+void FullyConnectedLayer::SetParam(int index, real weight) {
 	int i = index / (inputs + 1);
 	int j = index % (inputs + 1);
 
 	if (j < inputs) {
 		W(i, j) = weight;
+		packed = false;
 	}
 	else {
 		b[i] = weight;
@@ -345,7 +494,7 @@ void FullyConnectedLayer::SetParam(int index, double weight) {
 }
 
 // получение веса по индексу
-double FullyConnectedLayer::GetParam(int index) const {
+real FullyConnectedLayer::GetParam(int index) const {
 	int i = index / (inputs + 1);
 	int j = index % (inputs + 1);
 
@@ -353,7 +502,7 @@ double FullyConnectedLayer::GetParam(int index) const {
 }
 
 // получение градиента веса по индексу
-double FullyConnectedLayer::GetGradient(int index) const {
+real FullyConnectedLayer::GetGradient(int index) const {
 	int i = index / (inputs + 1);
 	int j = index % (inputs + 1);
 
@@ -9,24 +9,26 @@
 #include "NetworkLayer.hpp"
 
 class GaussDropoutLayer : public NetworkLayer {
-	double p;
-	double stddev;
+	real p;
+	real stddev;
 	int total;
 
 	std::default_random_engine generator;
-	std::normal_distribution<double> distribution;
+	std::normal_distribution<real> distribution;
 
 public:
-	GaussDropoutLayer(VolumeSize size, double p);
+	GaussDropoutLayer(VolumeSize size, real p);
 
-	void ForwardOutput(const std::vector<Volume> &X); // прямое распространение
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	void ForwardOutput(const Tensor &X); // прямое распространение
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
+	Layout GetLayout() const; // расположение входа и выхода слоя
+	bool AliasesInput() const; // ссылается ли выход слоя на вход при выводе
 
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
 };
 
-GaussDropoutLayer::GaussDropoutLayer(VolumeSize size, double p) : NetworkLayer(size), distribution(1, sqrt(p / (1 - p))) {
+GaussDropoutLayer::GaussDropoutLayer(VolumeSize size, real p) : NetworkLayer(size), distribution(1, sqrt(p / (1 - p))) {
 	this->p = p;
 	this->stddev = sqrt(p / (1 - p));
 	this->total = size.width * size.height * size.deep;
@@ -35,22 +37,18 @@ GaussDropoutLayer::GaussDropoutLayer(VolumeSize size, double p) : NetworkLayer(s
 	info = "p: " + std::to_string(p) + ", stddev: " + std::to_string(stddev);
 }
 
-// прямое распространение
-void GaussDropoutLayer::ForwardOutput(const std::vector<Volume> &X) {
-	#pragma omp parallel for collapse(2)
-	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
-		for (int i = 0; i < total; i++) {
-			output[batchIndex][i] = X[batchIndex][i];
-			dX[batchIndex][i] = 1;
-		}
-	}
+// прямое распространение (на этапе вывода слой тождественный, поэтому выход ссылается на вход без копирования)
+void GaussDropoutLayer::ForwardOutput(const Tensor &X) {
+	output.Alias(X);
 }
 
 // прямое распространение
-void GaussDropoutLayer::Forward(const std::vector<Volume> &X) {
+void GaussDropoutLayer::Forward(const Tensor &X) {
+	output.Detach(); // после вывода выход мог ссылаться на вход
+
 	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
 		for (int i = 0; i < total; i++) {
-			double noise = distribution(generator);
+			real noise = distribution(generator);
 
 			output[batchIndex][i] = X[batchIndex][i] * noise;
 			dX[batchIndex][i] = noise;
@@ -59,7 +57,7 @@ void GaussDropoutLayer::Forward(const std::vector<Volume> &X) {
 }
 
 // обратное распространение
-void GaussDropoutLayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
+void GaussDropoutLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
 	if (!calc_dX)
 		return;
 
@@ -69,6 +67,16 @@ void GaussDropoutLayer::Backward(const std::vector<Volume> &dout, const std::vec
 			dX[batchIndex][i] *= dout[batchIndex][i];
 }
 
+// расположение входа и выхода слоя (поэлементный слой работает с любым)
+Layout GaussDropoutLayer::GetLayout() const {
+	return Layout::Any;
+}
+
+// ссылается ли выход слоя на вход при выводе
+bool GaussDropoutLayer::AliasesInput() const {
+	return true;
+}
+
 // сохранение слоя в файл
 void GaussDropoutLayer::Save(std::ofstream &f) const {
 	f << "gaussdropout " << inputSize << " " << p << std::endl;
@@ -9,23 +9,25 @@
 #include "NetworkLayer.hpp"
 
 class GaussNoiseLayer : public NetworkLayer {
-	double stddev;
+	real stddev;
 	int total;
 
 	std::default_random_engine generator;
-	std::normal_distribution<double> distribution;
+	std::normal_distribution<real> distribution;
 
 public:
-	GaussNoiseLayer(VolumeSize size, double stddev);
+	GaussNoiseLayer(VolumeSize size, real stddev);
 
-	void ForwardOutput(const std::vector<Volume> &X); // прямое распространение
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	void ForwardOutput(const Tensor &X); // прямое распространение
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
+	Layout GetLayout() const; // расположение входа и выхода слоя
+	bool AliasesInput() const; // ссылается ли выход слоя на вход при выводе
 
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
 };
 
-GaussNoiseLayer::GaussNoiseLayer(VolumeSize size, double stddev) : NetworkLayer(size), distribution(0, stddev) {
+GaussNoiseLayer::GaussNoiseLayer(VolumeSize size, real stddev) : NetworkLayer(size), distribution(0, stddev) {
 	this->stddev = stddev;
 	this->total = size.width * size.height * size.deep;
 
@@ -33,19 +35,15 @@ GaussNoiseLayer::GaussNoiseLayer(VolumeSize size, double stddev) : NetworkLayer(
 	info = "stddev: " + std::to_string(stddev);
 }
 
-// прямое распространение
-void GaussNoiseLayer::ForwardOutput(const std::vector<Volume> &X) {
-	#pragma omp parallel for collapse(2)
-	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
-		for (int i = 0; i < total; i++) {
-			output[batchIndex][i] = X[batchIndex][i];
-			dX[batchIndex][i] = 1;
-		}
-	}
+// прямое распространение (на этапе вывода слой тождественный, поэтому выход ссылается на вход без копирования)
+void GaussNoiseLayer::ForwardOutput(const Tensor &X) {
+	output.Alias(X);
 }
 
 // прямое распространение
-void GaussNoiseLayer::Forward(const std::vector<Volume> &X) {
+void GaussNoiseLayer::Forward(const Tensor &X) {
+	output.Detach(); // после вывода выход мог ссылаться на вход
+
 	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
 		for (int i = 0; i < total; i++) {
 			output[batchIndex][i] = X[batchIndex][i] + distribution(generator);
@@ -55,7 +53,7 @@ void GaussNoiseLayer::Forward(const std::vector<Volume> &X) {
 }
 
 // обратное распространение
-void GaussNoiseLayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
+void GaussNoiseLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
 	if (!calc_dX)
 		return;
 
@@ -65,6 +63,16 @@ void GaussNoiseLayer::Backward(const std::vector<Volume> &dout, const std::vecto
 			dX[batchIndex][i] *= dout[batchIndex][i];
 }
 
+// расположение входа и выхода слоя (поэлементный слой работает с любым)
+Layout GaussNoiseLayer::GetLayout() const {
+	return Layout::Any;
+}
+
+// ссылается ли выход слоя на вход при выводе
+bool GaussNoiseLayer::AliasesInput() const {
+	return true;
+}
+
 // сохранение слоя в файл
 void GaussNoiseLayer::Save(std::ofstream &f) const {
 	f << "gaussnoise " << inputSize << " " << stddev << std::endl;
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <random>
+
+#include "NetworkLayer.hpp"
+#include "Kernels/GemmConv.hpp"
+#include "Kernels/GroupConv.hpp"
+
+// групповая свёртка: фильтры группы видят только fd / groups каналов входа своей группы
+// при groups == fd свёртка поканальная (depthwise) и считается отдельным ядром, векторизованным по каналам
+class GroupConvLayer : public NetworkLayer {
+	std::default_random_engine generator;
+	std::normal_distribution<real> distribution;
+
+	std::vector<Volume> W; // фильтры
+	std::vector<Volume> dW; // градиенты фильтров
+	std::vector<std::vector<Volume>> paramsW; // параметры фильтров
+
+	std::vector<real> b; // смещения
+	std::vector<real> db; // градиенты смещений
+	std::vector<std::vector<real>> paramsb; // параметры смещений
+
+	int P; // дополнение нулями
+	int S; // шаг свёртки
+
+	int fc; // количество фильтров
+	int fs; // размер фильтров
+	int fd; // глубина фильтров (каналов входа в группе)
+	int groups; // количество групп
+
+	bool depthwise; // поканальная ли свёртка (по одному каналу входа в группе)
+	AlignedVector packedW; // упакованные фильтры
+
+	void InitParams(); // инициализация параметров для обучения
+	void InitWeights(); // инициализация весовых коэффициентов
+	void LoadWeights(std::ifstream &f); // считывание весовых коэффициентов из файла
+	void Init(); // проверка групп и создание фильтров
+
+public:
+	GroupConvLayer(VolumeSize size, int fc, int fs, int P, int S, int groups);
+	GroupConvLayer(VolumeSize size, int fc, int fs, int P, int S, int groups, std::ifstream &f);
+
+	int GetTrainableParams() const; // получение количества обучаемых параметров
+
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
+	void UpdateWeights(const Optimizer &optimizer, bool trainable); // обновление весовых коэффициентов
+
+	void ResetCache(); // сброс параметров
+	void Save(std::ofstream &f) const; // сохранение слоя в файл
+
+	void SetParam(int index, real weight); // установка веса по индексу
+	real GetParam(int index) const; // получение веса по индексу
+	real GetGradient(int index) const; // получение градиента веса по индексу
+	void ZeroGradient(int index); // обнуление градиента веса по индексу
+};
+
+GroupConvLayer::GroupConvLayer(VolumeSize size, int fc, int fs, int P, int S, int groups) : NetworkLayer(size, (size.width - fs + 2 * P) / S + 1, (size.height - fs + 2 * P) / S + 1, fc), distribution(0.0, sqrt(2.0 * groups / (fs*fs*size.deep))) {
+	this->P = P;
+	this->S = S;
+
+	this->fc = fc;
+	this->fs = fs;
+	this->groups = groups;
+
+	Init();
+	InitParams();
+	InitWeights();
+}
+
+GroupConvLayer::GroupConvLayer(VolumeSize size, int fc, int fs, int P, int S, int groups, std::ifstream &f) : NetworkLayer(size, (size.width - fs + 2 * P) / S + 1, (size.height - fs + 2 * P) / S + 1, fc), distribution(0.0, sqrt(2.0 * groups / (fs*fs*size.deep))) {
+	this->P = P;
+	this->S = S;
+
+	this->fc = fc;
+	this->fs = fs;
+	this->groups = groups;
+
+	Init();
+	InitParams();
+	LoadWeights(f);
+}
+
+// проверка групп и создание фильтров
+void GroupConvLayer::Init() {
+	if (groups < 1 || inputSize.deep % groups != 0 || fc % groups != 0)
+		throw std::runtime_error("Input depth " + std::to_string(inputSize.deep) + " and filters count " + std::to_string(fc) + " must be divisible by groups " + std::to_string(groups));
+
+	this->fd = inputSize.deep / groups;
+	this->depthwise = fd == 1;
+
+	name = depthwise ? "depthwise conv" : "group conv";
+	info = std::to_string(fc) + " filters [" + std::to_string(fs) + "x" + std::to_string(fs) + "x" + std::to_string(fd) + "] P:" + std::to_string(P) + " S:" + std::to_string(S) + " groups: " + std::to_string(groups);
+
+	for (int i = 0; i < fc; i++) {
+		W.push_back(Volume(fs, fs, fd));
+		dW.push_back(Volume(fs, fs, fd));
+
+		b.push_back(0);
+		db.push_back(0);
+	}
+}
+
+// инициализация параметров для обучения
+void GroupConvLayer::InitParams() {
+	for (int i = 0; i < OPTIMIZER_PARAMS_COUNT; i++) {
+		paramsW.push_back(std::vector<Volume>(fc, Volume(fs, fs, fd)));
+		paramsb.push_back(std::vector<real>(fc, 0));
+	}
+}
+
+// инициализация весовых коэффициентов
+void GroupConvLayer::InitWeights() {
+	for (int index = 0; index < fc; index++) {
+		for (int i = 0; i < fs; i++)
+			for (int j = 0; j < fs; j++)
+				for (int k = 0; k < fd; k++)
+					W[index](k, i, j) = distribution(generator);
+
+		b[index] = 0.01;
+	}
+}
+
+// считывание весовых коэффициентов из файла
+void GroupConvLayer::LoadWeights(std::ifstream &f) {
+	for (int index = 0; index < fc; index++) {
+		for (int d = 0; d < fd; d++)
+			for (int i = 0; i < fs; i++)
+				for (int j = 0; j < fs; j++)
+					f >> W[index](d, i, j);
+
+		f >> b[index];
+	}
+}
+
+// получение количество обучаемых параметров
+int GroupConvLayer::GetTrainableParams() const {
+	return fc * (fs * fs * fd + 1);
+}
+
+// прямое распространение
+void GroupConvLayer::Forward(const Tensor &X) {
+	if (depthwise) {
+		PackDepthwiseFilters(W, packedW);
+		DepthwiseConvForward(X, packedW, b, output, fs, P, S);
+	}
+	else {
+		PackGemmFilters(W, packedW);
+		GroupConvForward(X, packedW, b, output, fs, P, S, groups);
+	}
+}
+
+// обратное распространение
+void GroupConvLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
+	if (depthwise) {
+		DepthwiseConvBackwardWeights(dout, X, dW, db, fs, P, S);
+
+		if (calc_dX) {
+			PackDepthwiseFilters(W, packedW);
+			DepthwiseConvBackwardInput(dout, packedW, dX, fs, P, S);
+		}
+	}
+	else {
+		GroupConvBackwardWeights(dout, X, dW, db, fs, P, S, groups);
+
+		if (calc_dX) {
+			PackGemmFilters(W, packedW);
+			GroupConvBackwardInput(dout, packedW, dX, fs, P, S, groups);
+		}
+	}
+}
+
+// обновление весовых коэффициентов
+void GroupConvLayer::UpdateWeights(const Optimizer &optimizer, bool trainable) {
+	int batchSize = output.size();
+	int total = fd * fs * fs;
+
+	#pragma omp parallel for
+	for (int index = 0; index < fc; index++) {
+		for (int i = 0; i < total; i++) {
+			if (trainable)
+				optimizer.Update(dW[index][i] / batchSize, paramsW[0][index][i], paramsW[1][index][i], paramsW[2][index][i], W[index][i]);
+
+			dW[index][i] = 0;
+		}
+
+		if (trainable)
+			optimizer.Update(db[index] / batchSize, paramsb[0][index], paramsb[1][index], paramsb[2][index], b[index]);
+
+		db[index] = 0;
+	}
+}
+
+// сброс параметров
+void GroupConvLayer::ResetCache() {
+	int total = fd * fs * fs;
+
+	for (int index = 0; index < OPTIMIZER_PARAMS_COUNT; index++) {
+		for (int i = 0; i < fc; i++) {
+			for (int j = 0; j < total; j++)
+				paramsW[index][i][j] = 0;
+
+			paramsb[index][i] = 0;
+		}
+	}
+}
+
+// сохранение слоя в файл
+void GroupConvLayer::Save(std::ofstream &f) const {
+	f << (depthwise ? "depthwiseconv " : "groupconv ") << inputSize << " ";
+	f << fs << " " << fc << " " << P << " " << S << " " << groups << std::endl;
+
+	for (int index = 0; index < fc; index++) {
+		for (int d = 0; d < fd; d++)
+			for (int i = 0; i < fs; i++)
+				for (int j = 0; j < fs; j++)
+					f << std::setprecision(15) << W[index](d, i, j) << " ";
+
+		f << std::setprecision(15) << b[index] << std::endl;
+	}
+}
+
+// установка веса по индексу
+void GroupConvLayer::SetParam(int index, real weight) {
+	int params = fs * fs * fd + 1;
+	int findex = index / params;
+	int windex = index % params;
+
+	if (windex == params - 1)
+		b[findex] = weight;
+	else
+		W[findex][windex] = weight;
+}
+
+// получение веса по индексу
+real GroupConvLayer::GetParam(int index) const {
+	int params = fs * fs * fd + 1;
+	int findex = index / params;
+	int windex = index % params;
+
+	if (windex == params - 1)
+		return b[findex];
+
+	return W[findex][windex];
+}
+
+// получение градиента веса по индексу
+real GroupConvLayer::GetGradient(int index) const {
+	int params = fs * fs * fd + 1;
+	int findex = index / params;
+	int windex = index % params;
+
+	if (windex == params - 1)
+		return db[findex];
+
+	return dW[findex][windex];
+}
+
+// обнуление градиента веса по индексу
+void GroupConvLayer::ZeroGradient(int index) {
+	int params = fs * fs * fd + 1;
+	int findex = index / params;
+	int windex = index % params;
+
+	if (windex == params - 1)
+		db[findex] = 0;
+	else
+		dW[findex][windex] = 0;
+}
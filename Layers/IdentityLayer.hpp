@@ -8,44 +8,52 @@
 #include "NetworkLayer.hpp"
 
 class IdentityLayer : public NetworkLayer {
-	int total;
-
 public:
 	IdentityLayer(VolumeSize size);
 
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
+	bool AliasesInput() const; // ссылается ли выход слоя на вход при выводе
+	Layout GetLayout() const; // расположение входа и выхода слоя
 
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
+	void SetBatchSize(int batchSize); // установка размера батча
 };
 
 IdentityLayer::IdentityLayer(VolumeSize size) : NetworkLayer(size) {
-	total = size.width * size.height * size.deep;
-
 	name = "identity";
 	info = "";
 }
 
-// прямое распространение
-void IdentityLayer::Forward(const std::vector<Volume> &X) {
-	#pragma omp parallel for collapse(2)
-	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++)
-		for (int i = 0; i < total; i++)
-			output[batchIndex][i] = X[batchIndex][i];
+// прямое распространение (выход ссылается на вход без копирования)
+void IdentityLayer::Forward(const Tensor &X) {
+	output.Alias(X);
 }
 
 // обратное распространение
-void IdentityLayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
+void IdentityLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
 	if (!calc_dX)
 		return;
 
-	#pragma omp parallel for collapse(2)
-	for (size_t batchIndex = 0; batchIndex < dout.size(); batchIndex++)
-		for (int i = 0; i < total; i++)
-			dX[batchIndex][i] = dout[batchIndex][i];
+	dX.Alias(dout);
+}
+
+// расположение входа и выхода слоя (поэлементный слой работает с любым)
+Layout IdentityLayer::GetLayout() const {
+	return Layout::Any;
+}
+
+// ссылается ли выход слоя на вход при выводе
+bool IdentityLayer::AliasesInput() const {
+	return true;
 }
 
 // сохранение слоя в файл
 void IdentityLayer::Save(std::ofstream &f) const {
 	f << "identity " << inputSize << std::endl;
+}
+
+// установка размера батча (выход и градиенты ссылаются на чужие значения, поэтому память не выделяется)
+void IdentityLayer::SetBatchSize(int batchSize) {
+
 }
\ No newline at end of file
@@ -12,6 +12,7 @@
 class InceptionLayer : public NetworkLayer {
 	std::vector<NetworkLayer*> convs;
 	std::vector<int> fc;
+	std::vector<Tensor> douts; // градиенты выходов свёрток
 
 	int totalOutput;
 	int totalInput;
@@ -23,29 +24,34 @@ public:
 
 	int GetTrainableParams() const; // получение количества обучаемых параметров
 
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
 	void UpdateWeights(const Optimizer &optimizer, bool trainable); // обновление весовых коэффициентов
 
 	void ResetCache();
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
 	void SetBatchSize(int batchSize); // установка размера батча
+	void SetInferenceBatchSize(int batchSize); // установка размера батча для вывода без градиентов
+	int Autotune(AutotuneCache &cache, int batchSize, bool training); // подбор алгоритмов свёрток
 
-	void SetParam(int index, double weight); // установка веса по индексу
-	double GetParam(int index) const; // получение веса по индексу
-	double GetGradient(int index) const; // получение градиента веса по индексу
+	void SetParam(int index, real weight); // установка веса по индексу
+	real GetParam(int index) const; // получение веса по индексу
+	real GetGradient(int index) const; // получение градиента веса по индексу
 	void ZeroGradient(int index); // обнуление градиента веса по индексу
 };
 
 InceptionLayer::InceptionLayer(VolumeSize size, int fc1, int fc3, int fc5) : NetworkLayer(size, size.width, size.height, fc1 + fc3 + fc5) {
-	convs.push_back(new ConvLayer(size, fc1, 1, 0, 1));
-	convs.push_back(new ConvLayer(size, fc3, 3, 1, 1));
-	convs.push_back(new ConvLayer(size, fc5, 5, 2, 1));
-
 	fc.push_back(fc1);
 	fc.push_back(fc3);
 	fc.push_back(fc5);
 
+	// свёртки 1x1, 3x3 и 5x5 с сохранением размера
+	for (int i = 0; i < 3; i++) {
+		ConvLayer *conv = new ConvLayer(size, fc[i], 2 * i + 1, i, 1, 1);
+		conv->ChooseAlgorithm();
+		convs.push_back(conv);
+	}
+
 	totalInput = size.width * size.height * size.deep;
 	totalOutput = size.width * size.height * (fc1 + fc3 + fc5);
 
@@ -72,9 +78,17 @@ InceptionLayer::InceptionLayer(VolumeSize size, int fc1, int fc3, int fc5, std::
 			throw std::runtime_error("Unknown layer name '" + name + "' for inception layer");
 		
 		int fc, fs, P, S;
+		std::string layout, algorithm;
 		f >> fs >> fc >> P >> S;
+		ReadConvOptions(f, layout, algorithm);
+
+		ConvLayer *conv = new ConvLayer(blockSize, fc, fs, P, S, 1, f);
 
-		convs.push_back(new ConvLayer(blockSize, fc, fs, P, S, f));
+		if (algorithm == "auto")
+			conv->ChooseAlgorithm();
+		else
+			conv->SetAlgorithm(StringToConvAlgorithm(algorithm));
+		convs.push_back(conv);
 	}
 
 	totalInput = size.width * size.height * size.deep;
@@ -97,13 +111,13 @@ int InceptionLayer::GetTrainableParams() const {
 }
 
 // прямое распространение
-void InceptionLayer::Forward(const std::vector<Volume> &X) {
+void InceptionLayer::Forward(const Tensor &X) {
 	int current = 0;
 
 	for (size_t index = 0; index < convs.size(); index++) {
 		convs[index]->Forward(X);
 
-		std::vector<Volume> &convOutput = convs[index]->GetOutput();
+		Tensor &convOutput = convs[index]->GetOutput();
 
 		#pragma omp parallel for collapse(4)
 		for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++)
@@ -117,20 +131,20 @@ void InceptionLayer::Forward(const std::vector<Volume> &X) {
 }
 
 // обратное распространение
-void InceptionLayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
+void InceptionLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
 	int current = 0;
 
 	for (size_t index = 0; index < convs.size(); index++) {
-		std::vector<Volume> douts(dout.size(), Volume(outputSize.width, outputSize.height, fc[index]));
+		Tensor &deltas = douts[index];
 
 		#pragma omp parallel for collapse(4)
 		for (size_t batchIndex = 0; batchIndex < dout.size(); batchIndex++)
 			for (int i = 0; i < outputSize.height; i++)
 				for (int j = 0; j < outputSize.width; j++)
 					for (int k = 0; k < fc[index]; k++)
-						douts[batchIndex](k, i, j) = dout[batchIndex](current + k, i, j);
+						deltas[batchIndex](k, i, j) = dout[batchIndex](current + k, i, j);
 
-		convs[index]->Backward(douts, X, calc_dX);
+		convs[index]->Backward(deltas, X, calc_dX);
 		current += fc[index];
 	}
 
@@ -140,7 +154,7 @@ void InceptionLayer::Backward(const std::vector<Volume> &dout, const std::vector
 	#pragma omp parallel for collapse(2)
 	for (size_t batchIndex = 0; batchIndex < dout.size(); batchIndex++) {
 		for (int i = 0; i < totalInput; i++) {
-			double sum = 0;
+			real sum = 0;
 
 			for (size_t index = 0; index < convs.size(); index++)
 				sum += convs[index]->GetDeltas()[batchIndex][i];
@@ -171,15 +185,38 @@ void InceptionLayer::Save(std::ofstream &f) const {
 
 // установка размера батча
 void InceptionLayer::SetBatchSize(int batchSize) {
-	output = std::vector<Volume>(batchSize, Volume(outputSize));
-	dX = std::vector<Volume>(batchSize, Volume(inputSize));
+	output.Resize(batchSize, outputSize);
+	dX.Resize(batchSize, inputSize);
+
+	douts.resize(convs.size());
+
+	for (size_t i = 0; i < convs.size(); i++) {
+		convs[i]->SetBatchSize(batchSize);
+		douts[i].Resize(batchSize, convs[i]->GetOutputSize());
+	}
+}
+
+// установка размера батча для вывода без градиентов (свёртки не планируются и владеют своими выходами)
+void InceptionLayer::SetInferenceBatchSize(int batchSize) {
+	dX = Tensor();
+	douts.clear();
 
 	for (size_t i = 0; i < convs.size(); i++)
 		convs[i]->SetBatchSize(batchSize);
 }
 
+// подбор самых быстрых алгоритмов свёрток замерами
+int InceptionLayer::Autotune(AutotuneCache &cache, int batchSize, bool training) {
+	int measured = 0;
+
+	for (size_t i = 0; i < convs.size(); i++)
+		measured += convs[i]->Autotune(cache, batchSize, training);
+
+	return measured;
+}
+
 // установка веса по индексу
-void InceptionLayer::SetParam(int index, double weight) {
+void InceptionLayer::SetParam(int index, real weight) {
 	int count = 0;
 
 	for (size_t i = 0; i < convs.size(); i++) {
@@ -195,7 +232,7 @@ void InceptionLayer::SetParam(int index, double weight) {
 }
 
 // получение веса по индексу
-double InceptionLayer::GetParam(int index) const {
+real InceptionLayer::GetParam(int index) const {
 	int count = 0;
 
 	for (size_t i = 0; i < convs.size(); i++) {
@@ -211,7 +248,7 @@ double InceptionLayer::GetParam(int index) const {
 }
 
 // получение градиента веса по индексу
-double InceptionLayer::GetGradient(int index) const {
+real InceptionLayer::GetGradient(int index) const {
 	int count = 0;
 
 	for (size_t i = 0; i < convs.size(); i++) {
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include "../../Entities/Volume.hpp"
+#include "../../Entities/Tensor.hpp"
+#include "../../Entities/Layout.hpp"
+#include "GradientReduction.hpp"
+
+// упаковка фильтров для блочной свёртки: [fc / b][fs][fs][fd][b], неполный последний блок дополняется нулями
+void PackBlockedFilters(const std::vector<Volume> &W, int fs, int fd, AlignedVector &packed) {
+	int fc = W.size();
+	int blocks = (fc + LAYOUT_BLOCK_SIZE - 1) / LAYOUT_BLOCK_SIZE;
+	int blockTotal = fs * fs * fd * LAYOUT_BLOCK_SIZE;
+
+	packed.assign(blocks * blockTotal, 0);
+
+	for (int f = 0; f < fc; f++) {
+		real *block = packed.data() + (f / LAYOUT_BLOCK_SIZE) * blockTotal;
+
+		for (int i = 0; i < fs * fs * fd; i++)
+			block[i * LAYOUT_BLOCK_SIZE + f % LAYOUT_BLOCK_SIZE] = W[f][i];
+	}
+}
+
+// прямое распространение свёртки в блочном расположении (каждый выход считает сразу LAYOUT_BLOCK_SIZE фильтров, ядра фильтра берутся через D положений входа)
+void BlockedConvForward(const Tensor &X, const AlignedVector &packed, const std::vector<real> &b, Tensor &output, int fs, int P, int S, int D) {
+	VolumeSize inputSize = X.GetSize();
+	VolumeSize outputSize = output.GetSize();
+
+	int fd = inputSize.deep;
+	int fc = outputSize.deep;
+	int blocks = (fc + LAYOUT_BLOCK_SIZE - 1) / LAYOUT_BLOCK_SIZE;
+	int inputArea = inputSize.height * inputSize.width;
+	int outputArea = outputSize.height * outputSize.width;
+
+	#pragma omp parallel for collapse(3)
+	for (size_t n = 0; n < X.size(); n++) {
+		for (int fb = 0; fb < blocks; fb++) {
+			for (int i = 0; i < outputSize.height; i++) {
+				int fstart = fb * LAYOUT_BLOCK_SIZE;
+				int fbs = std::min(LAYOUT_BLOCK_SIZE, fc - fstart);
+
+				const real *x = X[n].Data();
+				const real *w = packed.data() + fb * fs * fs * fd * LAYOUT_BLOCK_SIZE;
+				real *y = output[n].Data() + fstart * outputArea;
+
+				for (int j = 0; j < outputSize.width; j++) {
+					real sum[LAYOUT_BLOCK_SIZE];
+
+					for (int fo = 0; fo < LAYOUT_BLOCK_SIZE; fo++)
+						sum[fo] = fo < fbs ? b[fstart + fo] : 0;
+
+					for (int k = 0; k < fs; k++) {
+						int i0 = S * i + D * k - P;
+
+						if (i0 < 0 || i0 >= inputSize.height)
+							continue;
+
+						for (int l = 0; l < fs; l++) {
+							int j0 = S * j + D * l - P;
+
+							if (j0 < 0 || j0 >= inputSize.width)
+								continue;
+
+							const real *wkl = w + (k * fs + l) * fd * LAYOUT_BLOCK_SIZE;
+
+							for (int start = 0; start < fd; start += LAYOUT_BLOCK_SIZE) {
+								int cbs = std::min(LAYOUT_BLOCK_SIZE, fd - start);
+								const real *xp = x + start * inputArea + (i0 * inputSize.width + j0) * cbs;
+								const real *wp = wkl + start * LAYOUT_BLOCK_SIZE;
+
+								for (int c = 0; c < cbs; c++) {
+									real value = xp[c];
+
+									for (int fo = 0; fo < LAYOUT_BLOCK_SIZE; fo++)
+										sum[fo] += value * wp[c * LAYOUT_BLOCK_SIZE + fo];
+								}
+							}
+						}
+					}
+
+					for (int fo = 0; fo < fbs; fo++)
+						y[(i * outputSize.width + j) * fbs + fo] = sum[fo];
+				}
+			}
+		}
+	}
+}
+
+// накопление градиентов фильтров и смещений свёртки в блочном расположении: участки батча считаются потоками в частичные суммы
+void BlockedConvBackwardWeights(const Tensor &dout, const Tensor &X, std::vector<Volume> &dW, std::vector<real> &db, int fs, int P, int S, int D) {
+	VolumeSize inputSize = X.GetSize();
+	VolumeSize outputSize = dout.GetSize();
+
+	int fd = inputSize.deep;
+	int fc = outputSize.deep;
+	int total = fs * fs * fd;
+	int inputArea = inputSize.height * inputSize.width;
+	int outputArea = outputSize.height * outputSize.width;
+
+	GradientTiles tiles = GetGradientTiles(dout.size(), outputSize.height);
+	size_t size = fc * total + fc; // градиенты фильтров, затем смещений
+	real *partials = GradientPartials(tiles.parts, size);
+
+	#pragma omp parallel for
+	for (int part = 0; part < tiles.parts; part++) {
+		real *gradients = partials + part * size;
+		std::fill(gradients, gradients + size, 0);
+
+		for (int unit = part * tiles.units / tiles.parts; unit < (part + 1) * tiles.units / tiles.parts; unit++) {
+			int n = unit / tiles.bands;
+			int begin = unit % tiles.bands * tiles.bandRows;
+			int end = std::min(outputSize.height, begin + tiles.bandRows);
+			const real *x = X[n].Data();
+
+			for (int f = 0; f < fc; f++) {
+				int fstart = f / LAYOUT_BLOCK_SIZE * LAYOUT_BLOCK_SIZE;
+				int fbs = std::min(LAYOUT_BLOCK_SIZE, fc - fstart);
+				const real *d = dout[n].Data() + fstart * outputArea + f - fstart;
+				real *dw = gradients + f * total;
+
+				for (int i = begin; i < end; i++) {
+					for (int j = 0; j < outputSize.width; j++) {
+						real delta = d[(i * outputSize.width + j) * fbs];
+
+						for (int k = 0; k < fs; k++) {
+							int i0 = S * i + D * k - P;
+
+							if (i0 < 0 || i0 >= inputSize.height)
+								continue;
+
+							for (int l = 0; l < fs; l++) {
+								int j0 = S * j + D * l - P;
+
+								if (j0 < 0 || j0 >= inputSize.width)
+									continue;
+
+								real *dwkl = dw + (k * fs + l) * fd;
+
+								for (int start = 0; start < fd; start += LAYOUT_BLOCK_SIZE) {
+									int cbs = std::min(LAYOUT_BLOCK_SIZE, fd - start);
+									const real *xp = x + start * inputArea + (i0 * inputSize.width + j0) * cbs;
+
+									for (int c = 0; c < cbs; c++)
+										dwkl[start + c] += delta * xp[c];
+								}
+							}
+						}
+
+						gradients[fc * total + f] += delta;
+					}
+				}
+			}
+		}
+	}
+
+	ReduceGradientPartials(partials, tiles.parts, size);
+
+	#pragma omp parallel for
+	for (int f = 0; f < fc; f++) {
+		for (int i = 0; i < total; i++)
+			dW[f][i] += partials[f * total + i];
+
+		db[f] += partials[fc * total + f];
+	}
+}
+
+// вычисление градиентов входа свёртки в блочном расположении
+void BlockedConvBackwardInput(const Tensor &dout, const std::vector<Volume> &W, Tensor &dX, int fs, int P, int S, int D) {
+	VolumeSize inputSize = dX.GetSize();
+	VolumeSize outputSize = dout.GetSize();
+
+	int fd = inputSize.deep;
+	int fc = outputSize.deep;
+	int inputArea = inputSize.height * inputSize.width;
+	int outputArea = outputSize.height * outputSize.width;
+
+	#pragma omp parallel for
+	for (size_t n = 0; n < dout.size(); n++) {
+		real *dx = dX[n].Data();
+		std::fill(dx, dx + dX.Total(), 0);
+
+		for (int fstart = 0; fstart < fc; fstart += LAYOUT_BLOCK_SIZE) {
+			int fbs = std::min(LAYOUT_BLOCK_SIZE, fc - fstart);
+			const real *d = dout[n].Data() + fstart * outputArea;
+
+			for (int i = 0; i < outputSize.height; i++) {
+				for (int j = 0; j < outputSize.width; j++) {
+					const real *deltas = d + (i * outputSize.width + j) * fbs;
+
+					for (int k = 0; k < fs; k++) {
+						int i0 = S * i + D * k - P;
+
+						if (i0 < 0 || i0 >= inputSize.height)
+							continue;
+
+						for (int l = 0; l < fs; l++) {
+							int j0 = S * j + D * l - P;
+
+							if (j0 < 0 || j0 >= inputSize.width)
+								continue;
+
+							for (int fo = 0; fo < fbs; fo++) {
+								real delta = deltas[fo];
+								const real *w = W[fstart + fo].Data() + (k * fs + l) * fd;
+
+								for (int start = 0; start < fd; start += LAYOUT_BLOCK_SIZE) {
+									int cbs = std::min(LAYOUT_BLOCK_SIZE, fd - start);
+									real *dxp = dx + start * inputArea + (i0 * inputSize.width + j0) * cbs;
+
+									for (int c = 0; c < cbs; c++)
+										dxp[c] += delta * w[start + c];
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <stdexcept>
+
+#include "../../Entities/ArgParser.hpp"
+#include "FFTConv.hpp"
+#include "ConvKernel.hpp"
+
+#define CONV_KERNEL_MAX_INPUTS 8 // наибольшая глубина входа, при которой специализированное ядро быстрее GEMM
+#define CONV_KERNEL_MAX_OUTPUTS 32 // наибольшее количество фильтров, при котором специализированное ядро быстрее GEMM
+
+// алгоритм вычисления свёртки в канальном расположении
+enum class ConvAlgorithm {
+	Direct, // прямой проход по окнам (эталонная реализация)
+	Specialized, // ядро, специализированное под размер фильтра и шаг, с развёрнутыми циклами по фильтру
+	Gemm, // развёртка окон (im2col) и блочное умножение матриц
+	Pointwise, // свёртка 1x1 как одно умножение матриц на весь батч без развёртки окон (только фильтры 1x1)
+	Winograd2, // Виноград F(2x2, 3x3): в 2.25 раза меньше умножений (только 3x3 с шагом 1)
+	Winograd4, // Виноград F(4x4, 3x3): в 4 раза меньше умножений ценой чуть большей погрешности
+	FFT // свёртка через быстрое преобразование Фурье с перекрытием блоков (выгодна для больших фильтров)
+};
+
+// является ли алгоритм свёрткой Винограда
+bool IsWinograd(ConvAlgorithm algorithm) {
+	return algorithm == ConvAlgorithm::Winograd2 || algorithm == ConvAlgorithm::Winograd4;
+}
+
+// получение названия алгоритма свёртки
+std::string ConvAlgorithmToString(ConvAlgorithm algorithm) {
+	if (algorithm == ConvAlgorithm::Direct)
+		return "direct";
+
+	if (algorithm == ConvAlgorithm::Specialized)
+		return "specialized";
+
+	if (algorithm == ConvAlgorithm::Pointwise)
+		return "pointwise";
+
+	if (algorithm == ConvAlgorithm::Winograd2)
+		return "winograd2";
+
+	if (algorithm == ConvAlgorithm::Winograd4)
+		return "winograd4";
+
+	if (algorithm == ConvAlgorithm::FFT)
+		return "fft";
+
+	return "gemm";
+}
+
+// получение алгоритма свёртки по названию
+ConvAlgorithm StringToConvAlgorithm(const std::string &algorithm) {
+	if (algorithm == "direct")
+		return ConvAlgorithm::Direct;
+
+	if (algorithm == "gemm" || algorithm == "im2col")
+		return ConvAlgorithm::Gemm;
+
+	if (algorithm == "specialized")
+		return ConvAlgorithm::Specialized;
+
+	if (algorithm == "pointwise" || algorithm == "1x1")
+		return ConvAlgorithm::Pointwise;
+
+	if (algorithm == "winograd" || algorithm == "winograd2")
+		return ConvAlgorithm::Winograd2;
+
+	if (algorithm == "winograd4")
+		return ConvAlgorithm::Winograd4;
+
+	if (algorithm == "fft")
+		return ConvAlgorithm::FFT;
+
+	throw std::runtime_error("Invalid conv algorithm '" + algorithm + "'");
+}
+
+// считывание необязательных полей в конце строки описания свёртки в файле модели: расположения и алгоритма (в старых файлах их нет)
+void ReadConvOptions(std::istream &f, std::string &layout, std::string &algorithm) {
+	std::string options;
+	std::getline(f, options);
+
+	ArgParser parser(options);
+	layout = parser.Get("layout", "channels");
+	algorithm = parser.Get("algorithm", "auto");
+}
+
+// выбор алгоритма свёртки в канальном расположении по оценке количества операций:
+// свёртка 1x1 всегда считается одним умножением матриц, FFT выгодна для больших фильтров при большом количестве каналов, специализированное ядро - для неглубоких входов,
+// где у GEMM слишком короткая общая размерность
+// при разрежении D стоимость GEMM не меняется, а FFT считается для фильтра размера D * (fs - 1) + 1; специализированных ядер для разреженных фильтров нет
+ConvAlgorithm ChooseConvAlgorithm(VolumeSize inputSize, VolumeSize outputSize, int fs, int S, int D) {
+	if (fs == 1)
+		return ConvAlgorithm::Pointwise;
+
+	int fe = D * (fs - 1) + 1; // размер разреженного фильтра
+	double gemm = 2.0 * outputSize.height * outputSize.width * outputSize.deep * fs * fs * inputSize.deep;
+	double fft = FFTConvCost(inputSize, outputSize, fe, S, ChooseFFTSize(inputSize, outputSize, fe, S));
+
+	if (fft * FFT_COST_FACTOR < gemm)
+		return ConvAlgorithm::FFT;
+
+	if (D == 1 && GetConvKernel(fs, S) && inputSize.deep <= CONV_KERNEL_MAX_INPUTS && outputSize.deep <= CONV_KERNEL_MAX_OUTPUTS)
+		return ConvAlgorithm::Specialized;
+
+	return ConvAlgorithm::Gemm;
+}
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include "../../Entities/Volume.hpp"
+#include "../../Entities/Tensor.hpp"
+
+#ifdef USE_FLOAT
+#define CONV_KERNEL_OUTPUTS 16 // выходных каналов в блоке ядра (два регистра AVX)
+#else
+#define CONV_KERNEL_OUTPUTS 8 // выходных каналов в блоке ядра (два регистра AVX)
+#endif
+
+#define CONV_KERNEL_PIXELS 4 // соседних выходов строки, вычисляемых ядром одновременно
+
+// упаковка фильтров в блоки по CONV_KERNEL_OUTPUTS выходных каналов: [блок][k][l][вход][канал блока], неполный блок дополняется нулями
+// при flip фильтры поворачиваются на 180 градусов и меняются местами входные и выходные каналы (свёртка для градиентов входа)
+void PackKernelFilters(const std::vector<Volume> &W, bool flip, AlignedVector &packed) {
+	int fc = W.size();
+	int fd = W[0].Deep();
+	int fs = W[0].Width();
+	int outputs = flip ? fd : fc;
+	int inputs = flip ? fc : fd;
+	int blocks = (outputs + CONV_KERNEL_OUTPUTS - 1) / CONV_KERNEL_OUTPUTS;
+	size_t total = (size_t) blocks * fs * fs * inputs * CONV_KERNEL_OUTPUTS;
+
+	if (packed.size() != total)
+		packed.resize(total);
+
+	for (int block = 0; block < blocks; block++) {
+		for (int k = 0; k < fs; k++) {
+			for (int l = 0; l < fs; l++) {
+				for (int i = 0; i < inputs; i++) {
+					real *dst = packed.data() + (((block * fs + k) * fs + l) * inputs + i) * CONV_KERNEL_OUTPUTS;
+
+					for (int j = 0; j < CONV_KERNEL_OUTPUTS; j++) {
+						int o = block * CONV_KERNEL_OUTPUTS + j;
+
+						if (o >= outputs)
+							dst[j] = 0;
+						else
+							dst[j] = flip ? W[i](o, fs - 1 - k, fs - 1 - l) : W[o](i, k, l);
+					}
+				}
+			}
+		}
+	}
+}
+
+// свёртка с фильтрами FS x FS и шагом S, известными при компиляции: циклы по отводам фильтра разворачиваются полностью,
+// а блок из Pixels соседних выходов на CONV_KERNEL_OUTPUTS каналов накапливается в регистрах
+template <int FS, int S>
+struct ConvKernel {
+	// вычисление блока выходов строки, начинающегося с окна (i0, j0); Border - нужны ли проверки выхода окна за границы входа
+	template <bool Border, int Pixels>
+	static inline void Tile(const real *x, const VolumeSize &inputSize, const real *w, int i0, int j0, const real *bias, real *y, int outputs, int count);
+
+	// прямое распространение: output = conv(X, packed) (+ bias), P - дополнение нулями
+	static void Forward(const Tensor &X, const AlignedVector &packed, const real *bias, Tensor &output, int P);
+};
+
+template <int FS, int S>
+template <bool Border, int Pixels>
+inline void ConvKernel<FS, S>::Tile(const real *x, const VolumeSize &inputSize, const real *w, int i0, int j0, const real *bias, real *y, int outputs, int count) {
+	int inputs = inputSize.deep;
+	real acc[Pixels][CONV_KERNEL_OUTPUTS] = {};
+
+	#pragma GCC unroll 8
+	for (int k = 0; k < FS; k++) {
+		if (Border && (i0 + k < 0 || i0 + k >= inputSize.height))
+			continue;
+
+		#pragma GCC unroll 8
+		for (int l = 0; l < FS; l++) {
+			if (Border && (j0 + l < 0 || j0 + l >= inputSize.width))
+				continue; // на границе ядро вызывается для одиночных выходов
+
+			const real *xp = x + ((i0 + k) * inputSize.width + j0 + l) * inputs;
+			const real *wp = w + (k * FS + l) * inputs * CONV_KERNEL_OUTPUTS;
+
+			for (int c = 0; c < inputs; c++) {
+				#pragma GCC unroll 4
+				for (int p = 0; p < Pixels; p++) {
+					real value = xp[p * S * inputs + c];
+
+					#pragma omp simd
+					for (int o = 0; o < CONV_KERNEL_OUTPUTS; o++)
+						acc[p][o] += value * wp[c * CONV_KERNEL_OUTPUTS + o];
+				}
+			}
+		}
+	}
+
+	for (int p = 0; p < Pixels; p++)
+		for (int o = 0; o < count; o++)
+			y[p * outputs + o] = (bias ? bias[o] : 0) + acc[p][o];
+}
+
+template <int FS, int S>
+void ConvKernel<FS, S>::Forward(const Tensor &X, const AlignedVector &packed, const real *bias, Tensor &output, int P) {
+	VolumeSize inputSize = X.GetSize();
+	VolumeSize outputSize = output.GetSize();
+
+	int outputs = outputSize.deep;
+	int blocks = (outputs + CONV_KERNEL_OUTPUTS - 1) / CONV_KERNEL_OUTPUTS;
+	int blockSize = FS * FS * inputSize.deep * CONV_KERNEL_OUTPUTS;
+
+	// внутренняя область: окна выходов с индексами [begin, end) целиком лежат во входе
+	int iBegin = std::min(outputSize.height, std::max(0, (P + S - 1) / S));
+	int iEnd = inputSize.height - FS + P < 0 ? iBegin : std::max(iBegin, std::min(outputSize.height, (inputSize.height - FS + P) / S + 1));
+	int jBegin = std::min(outputSize.width, std::max(0, (P + S - 1) / S));
+	int jEnd = inputSize.width - FS + P < 0 ? jBegin : std::max(jBegin, std::min(outputSize.width, (inputSize.width - FS + P) / S + 1));
+
+	#pragma omp parallel for collapse(2)
+	for (size_t n = 0; n < X.size(); n++) {
+		for (int i = 0; i < outputSize.height; i++) {
+			const real *x = X[n].Data();
+			int i0 = S * i - P;
+			bool inner = i >= iBegin && i < iEnd;
+
+			for (int block = 0; block < blocks; block++) {
+				const real *w = packed.data() + block * blockSize;
+				const real *b = bias ? bias + block * CONV_KERNEL_OUTPUTS : nullptr;
+				real *y = output[n].Data() + i * outputSize.width * outputs + block * CONV_KERNEL_OUTPUTS;
+				int count = std::min(CONV_KERNEL_OUTPUTS, outputs - block * CONV_KERNEL_OUTPUTS);
+
+				if (!inner) {
+					for (int j = 0; j < outputSize.width; j++)
+						Tile<true, 1>(x, inputSize, w, i0, S * j - P, b, y + j * outputs, outputs, count);
+
+					continue;
+				}
+
+				int j = 0;
+
+				for (; j < jBegin; j++)
+					Tile<true, 1>(x, inputSize, w, i0, S * j - P, b, y + j * outputs, outputs, count);
+
+				for (; j + CONV_KERNEL_PIXELS <= jEnd; j += CONV_KERNEL_PIXELS)
+					Tile<false, CONV_KERNEL_PIXELS>(x, inputSize, w, i0, S * j - P, b, y + j * outputs, outputs, count);
+
+				for (; j < jEnd; j++)
+					Tile<false, 1>(x, inputSize, w, i0, S * j - P, b, y + j * outputs, outputs, count);
+
+				for (; j < outputSize.width; j++)
+					Tile<true, 1>(x, inputSize, w, i0, S * j - P, b, y + j * outputs, outputs, count);
+			}
+		}
+	}
+}
+
+// свёртка специализированным ядром
+typedef void (*ConvKernelFunction)(const Tensor &X, const AlignedVector &packed, const real *bias, Tensor &output, int P);
+
+// получение специализированного ядра для фильтров fs x fs и шага S
+template <int S>
+ConvKernelFunction GetConvKernel(int fs) {
+	switch (fs) {
+		case 1:
+			return ConvKernel<1, S>::Forward;
+
+		case 3:
+			return ConvKernel<3, S>::Forward;
+
+		case 5:
+			return ConvKernel<5, S>::Forward;
+
+		case 7:
+			return ConvKernel<7, S>::Forward;
+
+		default:
+			return nullptr;
+	}
+}
+
+// получение специализированного ядра для фильтров fs x fs и шага S (nullptr, если специализации нет)
+ConvKernelFunction GetConvKernel(int fs, int S) {
+	if (S == 1)
+		return GetConvKernel<1>(fs);
+
+	if (S == 2)
+		return GetConvKernel<2>(fs);
+
+	return nullptr;
+}
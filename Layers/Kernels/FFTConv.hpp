@@ -0,0 +1,374 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include "../../Entities/Volume.hpp"
+#include "../../Entities/Tensor.hpp"
+#include "Gemm.hpp"
+
+#define FFT_MIN_SIZE 8 // наименьший размер преобразования
+#define FFT_MAX_SIZE 64 // наибольший размер преобразования (большие входы разбиваются на блоки)
+#define FFT_BLOCK_ROWS 32 // сколько блоков примеров объединяется в одно умножение матриц на частоту
+#define FFT_COST_FACTOR 2 // во сколько раз операция FFT свёртки в среднем дороже операции GEMM (замерено на одном ядре)
+
+// таблицы радикс-2 преобразования Фурье длины size
+struct FFTPlan {
+	int size; // длина преобразования (степень двойки)
+	std::vector<int> reversed; // перестановка с обращёнными битами
+	std::vector<real> cosines; // cos(2 pi k / size), k < size / 2
+	std::vector<real> sines; // -sin(2 pi k / size), k < size / 2
+};
+
+// спектры фильтров: для каждой из size * (size / 2 + 1) частот матрица outputs x inputs
+// мнимая часть хранится и с обратным знаком, чтобы комплексное произведение сводилось к накоплению в GEMM
+struct FFTSpectra {
+	int size; // размер преобразования
+	int outputs; // количество выходных каналов
+	int inputs; // количество входных каналов
+
+	AlignedVector re; // действительная часть [частота][o][i]
+	AlignedVector im; // мнимая часть [частота][o][i]
+	AlignedVector negativeIm; // мнимая часть с обратным знаком
+};
+
+// получение таблиц преобразования длины size (таблицы строятся один раз для каждой длины)
+const FFTPlan& GetFFTPlan(int size) {
+	static thread_local FFTPlan plans[32] = {}; // таблицы по двоичному логарифму длины
+
+	int index = 0;
+
+	while ((1 << index) < size)
+		index++;
+
+	FFTPlan &plan = plans[index];
+
+	if (plan.size == size)
+		return plan;
+
+	plan.size = size;
+	plan.reversed.assign(size, 0);
+	plan.cosines.clear();
+	plan.sines.clear();
+
+	for (int i = 1, j = 0; i < size; i++) {
+		int bit = size >> 1;
+
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+
+		j ^= bit;
+		plan.reversed[i] = j;
+	}
+
+	for (int k = 0; k < size / 2; k++) {
+		plan.cosines.push_back(cos(2 * M_PI * k / size));
+		plan.sines.push_back(-sin(2 * M_PI * k / size));
+	}
+
+	return plan;
+}
+
+// преобразование Фурье size векторов длины count, k-ый из которых начинается с re + k * step (обратное - без нормировки)
+// все каналы обрабатываются одной бабочкой, поэтому внутренний цикл идёт по подряд лежащим значениям
+void FFTVectors(real *re, real *im, const FFTPlan &plan, int step, int count, bool inverse) {
+	int size = plan.size;
+
+	for (int i = 0; i < size; i++) {
+		int j = plan.reversed[i];
+
+		if (i < j) {
+			std::swap_ranges(re + i * step, re + i * step + count, re + j * step);
+			std::swap_ranges(im + i * step, im + i * step + count, im + j * step);
+		}
+	}
+
+	for (int length = 2; length <= size; length *= 2) {
+		int half = length / 2;
+		int twiddleStep = size / length;
+
+		for (int start = 0; start < size; start += length) {
+			for (int k = 0; k < half; k++) {
+				real wr = plan.cosines[k * twiddleStep];
+				real wi = inverse ? -plan.sines[k * twiddleStep] : plan.sines[k * twiddleStep];
+
+				real *ar = re + (start + k) * step;
+				real *ai = im + (start + k) * step;
+				real *br = re + (start + k + half) * step;
+				real *bi = im + (start + k + half) * step;
+
+				#pragma omp simd
+				for (int c = 0; c < count; c++) {
+					real tr = br[c] * wr - bi[c] * wi;
+					real ti = br[c] * wi + bi[c] * wr;
+
+					br[c] = ar[c] - tr;
+					bi[c] = ai[c] - ti;
+					ar[c] += tr;
+					ai[c] += ti;
+				}
+			}
+		}
+	}
+}
+
+// рабочий буфер преобразования, принадлежащий потоку
+real* FFTBuffer(size_t size) {
+	static thread_local AlignedVector buffer;
+
+	if (buffer.size() < size)
+		buffer.resize(size);
+
+	return buffer.data();
+}
+
+// вычисление спектров фильтров (размер преобразования берётся из spectra.size)
+// свёртка в слое - корреляция, поэтому в спектр переводится повёрнутый на 180 градусов фильтр
+// при flip меняются местами входные и выходные каналы, а поворот отменяется (свёртка для градиентов входа)
+// при разрежении D ядра ставятся через D положений, и спектр соответствует фильтру размера D * (fs - 1) + 1
+void FFTTransformFilters(const std::vector<Volume> &W, int fs, int D, bool flip, FFTSpectra &spectra) {
+	int fc = W.size();
+	int fd = W[0].Deep();
+	int size = spectra.size;
+	int half = size / 2 + 1;
+
+	spectra.outputs = flip ? fd : fc;
+	spectra.inputs = flip ? fc : fd;
+
+	int outputs = spectra.outputs;
+	int inputs = spectra.inputs;
+	size_t total = (size_t) size * half * outputs * inputs;
+
+	if (spectra.re.size() != total) {
+		spectra.re.resize(total);
+		spectra.im.resize(total);
+		spectra.negativeIm.resize(total);
+	}
+
+	const FFTPlan &plan = GetFFTPlan(size);
+
+	#pragma omp parallel for
+	for (int o = 0; o < outputs; o++) {
+		real *re = FFTBuffer(2 * size * size * inputs);
+		real *im = re + size * size * inputs;
+
+		std::fill(re, re + 2 * size * size * inputs, 0);
+
+		for (int k = 0; k < fs; k++)
+			for (int l = 0; l < fs; l++)
+				for (int i = 0; i < inputs; i++)
+					re[(D * k * size + D * l) * inputs + i] = flip ? W[i](o, k, l) : W[o](i, fs - 1 - k, fs - 1 - l);
+
+		for (int k = 0; k < fs; k++)
+			FFTVectors(re + D * k * size * inputs, im + D * k * size * inputs, plan, inputs, inputs, false);
+
+		for (int v = 0; v < half; v++)
+			FFTVectors(re + v * inputs, im + v * inputs, plan, size * inputs, inputs, false);
+
+		for (int u = 0; u < size; u++) {
+			for (int v = 0; v < half; v++) {
+				size_t dst = ((size_t) (u * half + v) * outputs + o) * inputs;
+				size_t src = (u * size + v) * inputs;
+
+				for (int i = 0; i < inputs; i++) {
+					spectra.re[dst + i] = re[src + i];
+					spectra.im[dst + i] = im[src + i];
+					spectra.negativeIm[dst + i] = -im[src + i];
+				}
+			}
+		}
+	}
+}
+
+// спектры блоков пачки примеров, принадлежащие вызывающему потоку (растут до наибольшего запрошенного размера)
+real* FFTBlocksBuffer(size_t size) {
+	static thread_local AlignedVector blocks;
+
+	if (blocks.size() < size)
+		blocks.resize(size);
+
+	return blocks.data();
+}
+
+// прямое преобразование блока входа x размера rows x cols (остальная часть окна size x size заполняется нулями)
+// строки вне блока нулевые и не преобразуются, столбцы преобразуются только для половины частот
+void FFTForwardBlock(const real *x, int width, int rows, int cols, int inputs, const FFTPlan &plan, real *re, real *im) {
+	int size = plan.size;
+
+	std::fill(re, re + size * size * inputs, 0);
+	std::fill(im, im + size * size * inputs, 0);
+
+	for (int a = 0; a < rows; a++)
+		std::copy(x + a * width * inputs, x + (a * width + cols) * inputs, re + a * size * inputs);
+
+	for (int a = 0; a < rows; a++)
+		FFTVectors(re + a * size * inputs, im + a * size * inputs, plan, inputs, inputs, false);
+
+	for (int v = 0; v <= size / 2; v++)
+		FFTVectors(re + v * inputs, im + v * inputs, plan, size * inputs, inputs, false);
+}
+
+// свёртка через FFT с перекрытием и сложением: вход разбивается на блоки (size - fs + 1) x (size - fs + 1),
+// линейная свёртка каждого блока с фильтром помещается в преобразование размера size и прибавляется к выходу
+// спектры вещественных сигналов симметричны, поэтому произведения считаются только для половины частот,
+// а блоки нескольких примеров объединяются, чтобы на каждую частоту приходилось одно достаточно большое умножение матриц
+void FFTConvForward(const Tensor &X, const FFTSpectra &spectra, const real *bias, Tensor &output, int fs, int P, int S) {
+	VolumeSize inputSize = X.GetSize();
+	VolumeSize outputSize = output.GetSize();
+
+	int inputs = spectra.inputs;
+	int outputs = spectra.outputs;
+	int size = spectra.size;
+	int half = size / 2 + 1;
+	int frequencies = size * half;
+	int channels = std::max(inputs, outputs);
+
+	int block = size - fs + 1;
+	int blocksW = (inputSize.width + block - 1) / block;
+	int blocksCount = (inputSize.height + block - 1) / block * blocksW;
+	int samples = std::max(1, FFT_BLOCK_ROWS / blocksCount); // примеров в одной пачке
+	real scale = real(1) / (size * size);
+
+	const FFTPlan &plan = GetFFTPlan(size);
+
+	for (size_t n0 = 0; n0 < X.size(); n0 += samples) {
+		int count = std::min(X.size() - n0, (size_t) samples) * blocksCount; // строк в матрицах спектров
+		size_t sizeV = (size_t) frequencies * count * inputs;
+		size_t sizeM = (size_t) frequencies * count * outputs;
+
+		real *vr = FFTBlocksBuffer(2 * (sizeV + sizeM)); // спектры блоков входа [частота][блок][i]
+		real *vi = vr + sizeV;
+		real *mr = vi + sizeV; // спектры блоков выхода [частота][блок][o]
+		real *mi = mr + sizeM;
+
+		#pragma omp parallel for
+		for (int index = 0; index < count; index++) {
+			int t = index % blocksCount;
+			int i0 = (t / blocksW) * block;
+			int j0 = (t % blocksW) * block;
+
+			real *re = FFTBuffer(2 * size * size * channels);
+			real *im = re + size * size * channels;
+			const real *x = X[n0 + index / blocksCount].Data() + (i0 * inputSize.width + j0) * inputs;
+
+			FFTForwardBlock(x, inputSize.width, std::min(block, inputSize.height - i0), std::min(block, inputSize.width - j0), inputs, plan, re, im);
+
+			for (int u = 0; u < size; u++) {
+				for (int v = 0; v < half; v++) {
+					size_t dst = ((size_t) (u * half + v) * count + index) * inputs;
+
+					std::copy(re + (u * size + v) * inputs, re + (u * size + v + 1) * inputs, vr + dst);
+					std::copy(im + (u * size + v) * inputs, im + (u * size + v + 1) * inputs, vi + dst);
+				}
+			}
+		}
+
+		// комплексное произведение с суммированием по каналам: M[f] = V[f] * U[f]^T
+		#pragma omp parallel for
+		for (int f = 0; f < frequencies; f++) {
+			size_t offsetV = (size_t) f * count * inputs;
+			size_t offsetU = (size_t) f * outputs * inputs;
+			size_t offsetM = (size_t) f * count * outputs;
+
+			Gemm(count, outputs, inputs, vr + offsetV, inputs, 1, spectra.re.data() + offsetU, 1, inputs, 0, mr + offsetM, outputs);
+			Gemm(count, outputs, inputs, vi + offsetV, inputs, 1, spectra.negativeIm.data() + offsetU, 1, inputs, 1, mr + offsetM, outputs);
+			Gemm(count, outputs, inputs, vr + offsetV, inputs, 1, spectra.im.data() + offsetU, 1, inputs, 0, mi + offsetM, outputs);
+			Gemm(count, outputs, inputs, vi + offsetV, inputs, 1, spectra.re.data() + offsetU, 1, inputs, 1, mi + offsetM, outputs);
+		}
+
+		// обратное преобразование: недостающие частоты восстанавливаются по симметрии, строки преобразуются только для попадающих в выход позиций
+		// блоки одного примера перекрываются на выходе, поэтому параллельно обрабатываются только разные примеры
+		#pragma omp parallel for
+		for (int sample = 0; sample < count / blocksCount; sample++) {
+			real *re = FFTBuffer(2 * size * size * channels);
+			real *im = re + size * size * channels;
+			real *y = output[n0 + sample].Data();
+
+			for (int i = 0; i < outputSize.height * outputSize.width; i++) {
+				if (bias)
+					std::copy(bias, bias + outputs, y + i * outputs);
+				else
+					std::fill(y + i * outputs, y + (i + 1) * outputs, 0);
+			}
+
+			for (int t = 0; t < blocksCount; t++) {
+				int index = sample * blocksCount + t;
+				int i0 = (t / blocksW) * block + P - fs + 1;
+				int j0 = (t % blocksW) * block + P - fs + 1;
+
+				for (int u = 0; u < size; u++) {
+					for (int v = 0; v < half; v++) {
+						size_t src = ((size_t) (u * half + v) * count + index) * outputs;
+
+						std::copy(mr + src, mr + src + outputs, re + (u * size + v) * outputs);
+						std::copy(mi + src, mi + src + outputs, im + (u * size + v) * outputs);
+					}
+
+					for (int v = half; v < size; v++) {
+						size_t src = ((size_t) (((size - u) % size) * half + size - v) * count + index) * outputs;
+
+						for (int o = 0; o < outputs; o++) {
+							re[(u * size + v) * outputs + o] = mr[src + o];
+							im[(u * size + v) * outputs + o] = -mi[src + o];
+						}
+					}
+				}
+
+				for (int v = 0; v < size; v++)
+					FFTVectors(re + v * outputs, im + v * outputs, plan, size * outputs, outputs, true);
+
+				for (int u = 0; u < size; u++) {
+					int i = i0 + u;
+
+					if (i < 0 || i % S != 0 || i / S >= outputSize.height)
+						continue;
+
+					FFTVectors(re + u * size * outputs, im + u * size * outputs, plan, outputs, outputs, true);
+
+					for (int v = 0; v < size; v++) {
+						int j = j0 + v;
+
+						if (j < 0 || j % S != 0 || j / S >= outputSize.width)
+							continue;
+
+						real *dst = y + ((i / S) * outputSize.width + j / S) * outputs;
+						const real *src = re + (u * size + v) * outputs;
+
+						for (int o = 0; o < outputs; o++)
+							dst[o] += src[o] * scale;
+					}
+				}
+			}
+		}
+	}
+}
+
+// оценка количества операций свёртки через FFT с преобразованием размера size (на один пример)
+double FFTConvCost(VolumeSize inputSize, VolumeSize outputSize, int fs, int S, int size) {
+	int block = size - fs + 1;
+
+	if (block < 1)
+		return INFINITY;
+
+	double blocks = double((inputSize.height + block - 1) / block) * ((inputSize.width + block - 1) / block);
+	double half = size / 2 + 1;
+	double line = 5.0 * size * log2(size); // операций на одно преобразование строки или столбца
+	double rows = std::min(size, (size + S - 1) / S);
+
+	double transform = blocks * (inputSize.deep * (block + half) + outputSize.deep * (size + rows)) * line;
+	double product = blocks * size * half * inputSize.deep * outputSize.deep * 8;
+
+	return transform + product;
+}
+
+// выбор размера преобразования с наименьшей оценкой количества операций
+int ChooseFFTSize(VolumeSize inputSize, VolumeSize outputSize, int fs, int S) {
+	int best = FFT_MAX_SIZE;
+
+	for (int size = FFT_MIN_SIZE; size <= FFT_MAX_SIZE; size *= 2)
+		if (FFTConvCost(inputSize, outputSize, fs, S, size) < FFTConvCost(inputSize, outputSize, fs, S, best))
+			best = size;
+
+	return best;
+}
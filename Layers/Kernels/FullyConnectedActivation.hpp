@@ -0,0 +1,235 @@
+#pragma once
+
+#include <string>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+
+#include "../../Entities/Real.hpp"
+#include "../../Entities/Epilogue.hpp"
+
+// активационные функции полносвязных слоёв (обычного и разреженного)
+enum class FullyConnectedActivation {
+	None,
+	Sigmoid,
+	Tanh,
+	ReLU,
+	LeakyReLU,
+	ELU
+};
+
+// получение активационной функции по строке
+FullyConnectedActivation StringToFullyConnectedActivation(const std::string &type) {
+	if (type == "sigmoid")
+		return FullyConnectedActivation::Sigmoid;
+
+	if (type == "tanh")
+		return FullyConnectedActivation::Tanh;
+
+	if (type == "relu")
+		return FullyConnectedActivation::ReLU;
+
+	if (type == "leakyrelu")
+		return FullyConnectedActivation::LeakyReLU;
+
+	if (type == "elu")
+		return FullyConnectedActivation::ELU;
+
+	if (type == "none" || type == "")
+		return FullyConnectedActivation::None;
+
+	throw std::runtime_error("Invalid activation function");
+}
+
+// получение строки для активационной функции
+std::string FullyConnectedActivationToString(FullyConnectedActivation activation) {
+	if (activation == FullyConnectedActivation::Sigmoid)
+		return "sigmoid";
+
+	if (activation == FullyConnectedActivation::Tanh)
+		return "tanh";
+
+	if (activation == FullyConnectedActivation::ReLU)
+		return "relu";
+
+	if (activation == FullyConnectedActivation::LeakyReLU)
+		return "leakyrelu";
+
+	if (activation == FullyConnectedActivation::ELU)
+		return "elu";
+
+	if (activation == FullyConnectedActivation::None)
+		return "none";
+
+	throw std::runtime_error("Invalid activation function");
+}
+
+// экспонента без вызова библиотечной функции: x = n ln2 + r, |r| <= ln2 / 2, exp(x) = 2^n * exp(r), exp(r) - ряд Тейлора
+// только арифметика и сравнения, поэтому циклы по строкам векторизуются целиком, а значение элемента не зависит от его места в строке
+inline real PolynomialExp(real x) {
+#ifdef USE_FLOAT
+	x = x < -87 ? -87 : (x > 88 ? 88 : x);
+#else
+	x = x < -708 ? -708 : (x > 709 ? 709 : x);
+#endif
+	real n = std::floor(x * (real) 1.4426950408889634 + (real) 0.5);
+	real r = x - n * (real) 0.693145751953125 - n * (real) 1.4286068203094172e-06;
+
+#ifdef USE_FLOAT
+	real p = 1 + r * (1 + r * ((real) 1 / 2 + r * ((real) 1 / 6 + r * ((real) 1 / 24 + r * ((real) 1 / 120 + r * ((real) 1 / 720 + r * ((real) 1 / 5040)))))));
+	int32_t bits = ((int32_t) n + 127) << 23;
+#else
+	real p = 1 + r * (1 + r * (1.0 / 2 + r * (1.0 / 6 + r * (1.0 / 24 + r * (1.0 / 120 + r * (1.0 / 720 + r * (1.0 / 5040 + r * (1.0 / 40320
+	       + r * (1.0 / 362880 + r * (1.0 / 3628800 + r * (1.0 / 39916800 + r * (1.0 / 479001600 + r * (1.0 / 6227020800)))))))))))));
+	int64_t bits = ((int64_t) n + 1023) << 52;
+#endif
+
+	real scale;
+	memcpy(&scale, &bits, sizeof(real));
+	return p * scale;
+}
+
+// активация, известная при компиляции: значение по взвешенной сумме и производная, выраженная через выход y = f(x), поэтому производные не хранятся
+template <FullyConnectedActivation A>
+struct Activation {
+	static real Value(real x);
+	static real Derivative(real y);
+};
+
+template <>
+struct Activation<FullyConnectedActivation::None> {
+	static inline real Value(real x) { return x; }
+	static inline real Derivative(real y) { return 1; }
+};
+
+template <>
+struct Activation<FullyConnectedActivation::Sigmoid> {
+	static inline real Value(real x) { return 1 / (1 + PolynomialExp(-x)); }
+	static inline real Derivative(real y) { return y * (1 - y); }
+};
+
+template <>
+struct Activation<FullyConnectedActivation::Tanh> {
+	static inline real Value(real x) { return 1 - 2 / (PolynomialExp(2 * x) + 1); }
+	static inline real Derivative(real y) { return 1 - y * y; }
+};
+
+template <>
+struct Activation<FullyConnectedActivation::ReLU> {
+	static inline real Value(real x) { return x > 0 ? x : 0; }
+	static inline real Derivative(real y) { return y > 0 ? 1 : 0; }
+};
+
+template <>
+struct Activation<FullyConnectedActivation::LeakyReLU> {
+	static inline real Value(real x) { return x > 0 ? x : (real) 0.01 * x; }
+	static inline real Derivative(real y) { return y > 0 ? 1 : (real) 0.01; }
+};
+
+template <>
+struct Activation<FullyConnectedActivation::ELU> {
+	static inline real Value(real x) { return x > 0 ? x : PolynomialExp(x) - 1; }
+	static inline real Derivative(real y) { return y > 0 ? 1 : y + 1; }
+};
+
+// применение активации к rows строкам взвешенных сумм длины count: y[n][i] = f(y[n][i] + bias[i])
+// внутренний цикл без ветвлений векторизуется целиком
+template <FullyConnectedActivation A>
+void ActivateRows(const real *bias, real *y, int rows, int count) {
+	#pragma omp parallel for
+	for (int n = 0; n < rows; n++) {
+		real *row = y + (size_t) n * count;
+
+		for (int i = 0; i < count; i++)
+			row[i] = Activation<A>::Value(row[i] + bias[i]);
+	}
+}
+
+// градиенты rows строк по взвешенным суммам: delta[n][i] = dout[n][i] * f'(x), производная вычисляется по выходу y
+template <FullyConnectedActivation A>
+void ActivationGradientRows(const real *y, const real *dout, real *delta, int rows, int count) {
+	#pragma omp parallel for
+	for (int n = 0; n < rows; n++) {
+		size_t offset = (size_t) n * count;
+
+		for (int i = 0; i < count; i++)
+			delta[offset + i] = dout[offset + i] * Activation<A>::Derivative(y[offset + i]);
+	}
+}
+
+// применение активации к батчу: тип активации проверяется один раз на батч, строки обрабатываются её специализацией
+void ActivateRows(FullyConnectedActivation activation, const real *bias, real *y, int rows, int count) {
+	switch (activation) {
+		case FullyConnectedActivation::Sigmoid:
+			ActivateRows<FullyConnectedActivation::Sigmoid>(bias, y, rows, count);
+			break;
+
+		case FullyConnectedActivation::Tanh:
+			ActivateRows<FullyConnectedActivation::Tanh>(bias, y, rows, count);
+			break;
+
+		case FullyConnectedActivation::ReLU:
+			ActivateRows<FullyConnectedActivation::ReLU>(bias, y, rows, count);
+			break;
+
+		case FullyConnectedActivation::LeakyReLU:
+			ActivateRows<FullyConnectedActivation::LeakyReLU>(bias, y, rows, count);
+			break;
+
+		case FullyConnectedActivation::ELU:
+			ActivateRows<FullyConnectedActivation::ELU>(bias, y, rows, count);
+			break;
+
+		default:
+			ActivateRows<FullyConnectedActivation::None>(bias, y, rows, count);
+	}
+}
+
+// градиенты батча по взвешенным суммам (тип активации проверяется один раз на батч)
+void ActivationGradientRows(FullyConnectedActivation activation, const real *y, const real *dout, real *delta, int rows, int count) {
+	switch (activation) {
+		case FullyConnectedActivation::Sigmoid:
+			ActivationGradientRows<FullyConnectedActivation::Sigmoid>(y, dout, delta, rows, count);
+			break;
+
+		case FullyConnectedActivation::Tanh:
+			ActivationGradientRows<FullyConnectedActivation::Tanh>(y, dout, delta, rows, count);
+			break;
+
+		case FullyConnectedActivation::ReLU:
+			ActivationGradientRows<FullyConnectedActivation::ReLU>(y, dout, delta, rows, count);
+			break;
+
+		case FullyConnectedActivation::LeakyReLU:
+			ActivationGradientRows<FullyConnectedActivation::LeakyReLU>(y, dout, delta, rows, count);
+			break;
+
+		case FullyConnectedActivation::ELU:
+			ActivationGradientRows<FullyConnectedActivation::ELU>(y, dout, delta, rows, count);
+			break;
+
+		default:
+			ActivationGradientRows<FullyConnectedActivation::None>(y, dout, delta, rows, count);
+	}
+}
+
+// перенос активации в эпилог (tanh и elu эпилог не представляет)
+bool ActivationToEpilogue(FullyConnectedActivation activation, Epilogue &epilogue) {
+	if (activation == FullyConnectedActivation::ReLU) {
+		epilogue.activation = EpilogueActivation::ReLU;
+	}
+	else if (activation == FullyConnectedActivation::LeakyReLU) {
+		epilogue.activation = EpilogueActivation::LeakyReLU;
+		epilogue.alpha = 0.01;
+	}
+	else if (activation == FullyConnectedActivation::Sigmoid) {
+		epilogue.activation = EpilogueActivation::Sigmoid;
+	}
+	else if (activation != FullyConnectedActivation::None) {
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include "../../Entities/Real.hpp"
+#include "../../Entities/AlignedAllocator.hpp"
+
+#define GEMM_MR 4 // строк в блоке микроядра
+#ifdef USE_FLOAT
+#define GEMM_NR 16 // столбцов в блоке микроядра (два регистра AVX на строку)
+#else
+#define GEMM_NR 8 // столбцов в блоке микроядра (два регистра AVX на строку)
+#endif
+
+#define GEMM_MC 128 // строк A в блоке, помещающемся в L2
+#define GEMM_KC 256 // длина общей размерности в блоке
+#define GEMM_NC 1024 // столбцов B в блоке, помещающемся в L3
+
+// упаковка блока A (mc x kc) в полосы по GEMM_MR строк: [полоса][p][i], неполная полоса дополняется нулями
+void GemmPackA(int mc, int kc, const real *A, int rsA, int csA, real *packed) {
+	for (int ir = 0; ir < mc; ir += GEMM_MR) {
+		int mr = std::min(GEMM_MR, mc - ir);
+
+		for (int p = 0; p < kc; p++) {
+			for (int i = 0; i < mr; i++)
+				packed[i] = A[(ir + i) * rsA + p * csA];
+
+			for (int i = mr; i < GEMM_MR; i++)
+				packed[i] = 0;
+
+			packed += GEMM_MR;
+		}
+	}
+}
+
+// упаковка блока B (kc x nc) в полосы по GEMM_NR столбцов: [полоса][p][j], неполная полоса дополняется нулями
+void GemmPackB(int kc, int nc, const real *B, int rsB, int csB, real *packed) {
+	for (int jr = 0; jr < nc; jr += GEMM_NR) {
+		int nr = std::min(GEMM_NR, nc - jr);
+
+		for (int p = 0; p < kc; p++) {
+			for (int j = 0; j < nr; j++)
+				packed[j] = B[p * rsB + (jr + j) * csB];
+
+			for (int j = nr; j < GEMM_NR; j++)
+				packed[j] = 0;
+
+			packed += GEMM_NR;
+		}
+	}
+}
+
+// микроядро: блок C (mr x nr) = beta * C + полоса A * полоса B, аккумуляторы GEMM_MR x GEMM_NR остаются в регистрах
+inline void GemmMicroKernel(int kc, const real *a, const real *b, real beta, real *C, int ldc, int mr, int nr) {
+	real acc[GEMM_MR][GEMM_NR] = {};
+
+	for (int p = 0; p < kc; p++) {
+		for (int i = 0; i < GEMM_MR; i++) {
+			real value = a[i];
+
+			#pragma omp simd
+			for (int j = 0; j < GEMM_NR; j++)
+				acc[i][j] += value * b[j];
+		}
+
+		a += GEMM_MR;
+		b += GEMM_NR;
+	}
+
+	// полный блок записывается циклами с постоянными границами, которые векторизуются (при малом kc запись - основная работа)
+	if (mr == GEMM_MR && nr == GEMM_NR) {
+		for (int i = 0; i < GEMM_MR; i++) {
+			real *c = C + i * ldc;
+
+			if (beta == 0) {
+				#pragma omp simd
+				for (int j = 0; j < GEMM_NR; j++)
+					c[j] = acc[i][j];
+			}
+			else {
+				#pragma omp simd
+				for (int j = 0; j < GEMM_NR; j++)
+					c[j] += acc[i][j];
+			}
+		}
+	}
+	else if (beta == 0) {
+		for (int i = 0; i < mr; i++)
+			for (int j = 0; j < nr; j++)
+				C[i * ldc + j] = acc[i][j];
+	}
+	else {
+		for (int i = 0; i < mr; i++)
+			for (int j = 0; j < nr; j++)
+				C[i * ldc + j] += acc[i][j];
+	}
+}
+
+// упаковка всей матрицы B (K x N) блоками kc x nc в порядке их обхода умножением, для многократного умножения на неизменную матрицу
+void GemmPackMatrix(int K, int N, const real *B, int rsB, int csB, AlignedVector &packed) {
+	size_t size = (size_t) (N + GEMM_NR - 1) / GEMM_NR * GEMM_NR * K;
+
+	if (packed.size() < size)
+		packed.resize(size);
+
+	real *pb = packed.data();
+
+	for (int jc = 0; jc < N; jc += GEMM_NC) {
+		int nc = std::min(GEMM_NC, N - jc);
+
+		for (int pc = 0; pc < K; pc += GEMM_KC) {
+			int kc = std::min(GEMM_KC, K - pc);
+
+			GemmPackB(kc, nc, B + pc * rsB + jc * csB, rsB, csB, pb);
+			pb += (nc + GEMM_NR - 1) / GEMM_NR * GEMM_NR * kc;
+		}
+	}
+}
+
+// умножение блоками: B упаковывается по ходу в буфер потока или берётся готовым из packedB (упакованным GemmPackMatrix)
+void GemmBlocks(int M, int N, int K, const real *A, int rsA, int csA, const real *B, int rsB, int csB, const real *packedB, real beta, real *C, int ldc) {
+	static thread_local AlignedVector packedA;
+	static thread_local AlignedVector bufferB;
+
+	size_t sizeA = (size_t) (std::min(M, GEMM_MC) + GEMM_MR - 1) / GEMM_MR * GEMM_MR * std::min(K, GEMM_KC);
+	size_t sizeB = (size_t) (std::min(N, GEMM_NC) + GEMM_NR - 1) / GEMM_NR * GEMM_NR * std::min(K, GEMM_KC);
+
+	if (packedA.size() < sizeA)
+		packedA.resize(sizeA);
+
+	if (packedB == nullptr && bufferB.size() < sizeB)
+		bufferB.resize(sizeB);
+
+	real *pa = packedA.data();
+	const real *block = packedB;
+
+	for (int jc = 0; jc < N; jc += GEMM_NC) {
+		int nc = std::min(GEMM_NC, N - jc);
+
+		for (int pc = 0; pc < K; pc += GEMM_KC) {
+			int kc = std::min(GEMM_KC, K - pc);
+			real blockBeta = pc == 0 ? beta : 1;
+			const real *pb = block;
+
+			if (packedB == nullptr) {
+				GemmPackB(kc, nc, B + pc * rsB + jc * csB, rsB, csB, bufferB.data());
+				pb = bufferB.data();
+			}
+			else {
+				block += (nc + GEMM_NR - 1) / GEMM_NR * GEMM_NR * kc;
+			}
+
+			for (int ic = 0; ic < M; ic += GEMM_MC) {
+				int mc = std::min(GEMM_MC, M - ic);
+				int panelsM = (mc + GEMM_MR - 1) / GEMM_MR;
+				int panelsN = (nc + GEMM_NR - 1) / GEMM_NR;
+
+				GemmPackA(mc, kc, A + ic * rsA + pc * csA, rsA, csA, pa);
+
+				// внутри параллельной области (например, по примерам батча) этот цикл выполняется одним потоком
+				#pragma omp parallel for collapse(2) if(panelsM * panelsN > 1)
+				for (int jr = 0; jr < panelsN; jr++) {
+					for (int ir = 0; ir < panelsM; ir++) {
+						int mr = std::min(GEMM_MR, mc - ir * GEMM_MR);
+						int nr = std::min(GEMM_NR, nc - jr * GEMM_NR);
+
+						real *c = C + (ic + ir * GEMM_MR) * ldc + jc + jr * GEMM_NR;
+						GemmMicroKernel(kc, pa + ir * GEMM_MR * kc, pb + jr * GEMM_NR * kc, blockBeta, c, ldc, mr, nr);
+					}
+				}
+			}
+		}
+	}
+}
+
+// C (M x N, строки через ldc) = beta * C + A (M x K) * B (K x N), beta равно 0 (перезапись) или 1 (накопление)
+// элемент A(i, p) берётся как A[i * rsA + p * csA], B(p, j) - как B[p * rsB + j * csB], поэтому транспонированные матрицы передаются без копирования
+// буферы упаковки принадлежат потоку, так что умножения в разных потоках независимы, а повторные вызовы не выделяют память
+void Gemm(int M, int N, int K, const real *A, int rsA, int csA, const real *B, int rsB, int csB, real beta, real *C, int ldc) {
+	GemmBlocks(M, N, K, A, rsA, csA, B, rsB, csB, nullptr, beta, C, ldc);
+}
+
+// C = beta * C + A * B с заранее упакованной GemmPackMatrix матрицей B: результат тот же, что у Gemm, но без упаковки B при каждом вызове
+// (при малом M упаковка B дороже самого умножения)
+void GemmPacked(int M, int N, int K, const real *A, int rsA, int csA, const real *packedB, real beta, real *C, int ldc) {
+	GemmBlocks(M, N, K, A, rsA, csA, nullptr, 0, 0, packedB, beta, C, ldc);
+}
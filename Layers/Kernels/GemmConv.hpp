@@ -0,0 +1,260 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include "../../Entities/Volume.hpp"
+#include "../../Entities/Tensor.hpp"
+#include "Gemm.hpp"
+#include "GradientReduction.hpp"
+
+// упаковка фильтров в матрицу fc x (fs * fs * fd), строка которой - фильтр в порядке [k][l][c]
+void PackGemmFilters(const std::vector<Volume> &W, AlignedVector &packed) {
+	int total = W[0].Total();
+
+	if (packed.size() != W.size() * total)
+		packed.resize(W.size() * total);
+
+	for (size_t f = 0; f < W.size(); f++)
+		std::copy(W[f].Data(), W[f].Data() + total, packed.data() + f * total);
+}
+
+// развёртка окон строк выхода [begin, end) в матрицу ((end - begin) * OW) x (fs * fs * fd): в канальном расположении каналы одного положения окна лежат подряд
+// при разрежении D ядра окна берутся из входа через D положений
+void Im2colRows(const real *x, const VolumeSize &inputSize, const VolumeSize &outputSize, int fs, int P, int S, int D, int begin, int end, real *col) {
+	int fd = inputSize.deep;
+	int cols = fs * fs * fd;
+
+	for (int i = begin; i < end; i++) {
+		for (int j = 0; j < outputSize.width; j++) {
+			real *row = col + ((i - begin) * outputSize.width + j) * cols;
+
+			for (int k = 0; k < fs; k++) {
+				int i0 = S * i + D * k - P;
+
+				for (int l = 0; l < fs; l++) {
+					int j0 = S * j + D * l - P;
+					real *dst = row + (k * fs + l) * fd;
+
+					if (i0 < 0 || i0 >= inputSize.height || j0 < 0 || j0 >= inputSize.width)
+						std::fill(dst, dst + fd, 0);
+					else
+						std::copy(x + (i0 * inputSize.width + j0) * fd, x + (i0 * inputSize.width + j0 + 1) * fd, dst);
+				}
+			}
+		}
+	}
+}
+
+// развёртка окон примера в матрицу (OH * OW) x (fs * fs * fd)
+void Im2col(const real *x, const VolumeSize &inputSize, const VolumeSize &outputSize, int fs, int P, int S, int D, real *col) {
+	Im2colRows(x, inputSize, outputSize, fs, P, S, D, 0, outputSize.height, col);
+}
+
+// свёртка матрицы окон обратно в пример с накоплением перекрывающихся значений (dx должен быть обнулён)
+void Col2im(const real *col, const VolumeSize &inputSize, const VolumeSize &outputSize, int fs, int P, int S, int D, real *dx) {
+	int fd = inputSize.deep;
+	int cols = fs * fs * fd;
+
+	for (int i = 0; i < outputSize.height; i++) {
+		for (int j = 0; j < outputSize.width; j++) {
+			const real *row = col + (i * outputSize.width + j) * cols;
+
+			for (int k = 0; k < fs; k++) {
+				int i0 = S * i + D * k - P;
+
+				if (i0 < 0 || i0 >= inputSize.height)
+					continue;
+
+				for (int l = 0; l < fs; l++) {
+					int j0 = S * j + D * l - P;
+
+					if (j0 < 0 || j0 >= inputSize.width)
+						continue;
+
+					const real *src = row + (k * fs + l) * fd;
+					real *dst = dx + (i0 * inputSize.width + j0) * fd;
+
+					for (int c = 0; c < fd; c++)
+						dst[c] += src[c];
+				}
+			}
+		}
+	}
+}
+
+// матрица окон, принадлежащая потоку (растёт до наибольшего запрошенного размера)
+real* Im2colBuffer(size_t size) {
+	static thread_local AlignedVector col;
+
+	if (col.size() < size)
+		col.resize(size);
+
+	return col.data();
+}
+
+// прямое распространение свёртки через GEMM: output[n] (OH * OW x fc) = im2col(X[n]) * W^T + b
+void GemmConvForward(const Tensor &X, const AlignedVector &packed, const std::vector<real> &b, Tensor &output, int fs, int P, int S, int D) {
+	VolumeSize inputSize = X.GetSize();
+	VolumeSize outputSize = output.GetSize();
+
+	int fc = outputSize.deep;
+	int rows = outputSize.height * outputSize.width;
+	int cols = fs * fs * inputSize.deep;
+
+	#pragma omp parallel for
+	for (size_t n = 0; n < X.size(); n++) {
+		real *col = Im2colBuffer(rows * cols);
+		real *y = output[n].Data();
+
+		Im2col(X[n].Data(), inputSize, outputSize, fs, P, S, D, col);
+
+		for (int r = 0; r < rows; r++)
+			std::copy(b.begin(), b.end(), y + r * fc);
+
+		Gemm(rows, fc, cols, col, cols, 1, packed.data(), 1, cols, 1, y, fc);
+	}
+}
+
+// накопление градиентов фильтров и смещений свёртки через GEMM: dW (fc x cols) += dout[n]^T * im2col(X[n])
+// каждый поток умножает свои участки батча (полосы строк выхода) в частичную сумму, суммы складываются деревом
+void GemmConvBackwardWeights(const Tensor &dout, const Tensor &X, std::vector<Volume> &dW, std::vector<real> &db, int fs, int P, int S, int D) {
+	VolumeSize inputSize = X.GetSize();
+	VolumeSize outputSize = dout.GetSize();
+
+	int fc = outputSize.deep;
+	int cols = fs * fs * inputSize.deep;
+
+	GradientTiles tiles = GetGradientTiles(dout.size(), outputSize.height);
+	size_t size = fc * cols + fc; // градиенты фильтров, затем смещений
+	real *partials = GradientPartials(tiles.parts, size);
+
+	#pragma omp parallel for if(tiles.parts > 1)
+	for (int part = 0; part < tiles.parts; part++) {
+		real *gradients = partials + part * size;
+		real *col = Im2colBuffer(tiles.bandRows * outputSize.width * cols);
+
+		std::fill(gradients, gradients + size, 0);
+
+		for (int unit = part * tiles.units / tiles.parts; unit < (part + 1) * tiles.units / tiles.parts; unit++) {
+			int n = unit / tiles.bands;
+			int begin = unit % tiles.bands * tiles.bandRows;
+			int end = std::min(outputSize.height, begin + tiles.bandRows);
+
+			int rows = (end - begin) * outputSize.width;
+			const real *d = dout[n].Data() + begin * outputSize.width * fc;
+
+			Im2colRows(X[n].Data(), inputSize, outputSize, fs, P, S, D, begin, end, col);
+			Gemm(fc, cols, rows, d, 1, fc, col, cols, 1, 1, gradients, cols);
+
+			for (int r = 0; r < rows; r++)
+				for (int f = 0; f < fc; f++)
+					gradients[fc * cols + f] += d[r * fc + f];
+		}
+	}
+
+	ReduceGradientPartials(partials, tiles.parts, size);
+
+	#pragma omp parallel for
+	for (int f = 0; f < fc; f++) {
+		for (int i = 0; i < cols; i++)
+			dW[f][i] += partials[f * cols + i];
+
+		db[f] += partials[fc * cols + f];
+	}
+}
+
+// вычисление градиентов входа свёртки через GEMM: col2im(dout[n] * W)
+void GemmConvBackwardInput(const Tensor &dout, const AlignedVector &packed, Tensor &dX, int fs, int P, int S, int D) {
+	VolumeSize inputSize = dX.GetSize();
+	VolumeSize outputSize = dout.GetSize();
+
+	int fc = outputSize.deep;
+	int rows = outputSize.height * outputSize.width;
+	int cols = fs * fs * inputSize.deep;
+
+	#pragma omp parallel for
+	for (size_t n = 0; n < dout.size(); n++) {
+		real *col = Im2colBuffer(rows * cols);
+		real *dx = dX[n].Data();
+
+		Gemm(rows, cols, fc, dout[n].Data(), fc, 1, packed.data(), cols, 1, 0, col, cols);
+
+		std::fill(dx, dx + dX.Total(), 0);
+		Col2im(col, inputSize, outputSize, fs, P, S, D, dx);
+	}
+}
+
+// накопление градиентов фильтров и смещений транспонированной свёртки через GEMM: выход транспонированной свёртки играет роль входа обычной,
+// поэтому im2col(dout[n])^T * X[n] даёт градиенты в порядке [k][l][f][c] без разреженного нулями входа
+// участки батча - полосы строк входа, смещения накапливаются по соответствующим полосам строк выхода
+void GemmTransposedConvBackwardWeights(const Tensor &dout, const Tensor &X, std::vector<Volume> &dW, std::vector<real> &db, int fs, int P, int S) {
+	VolumeSize inputSize = X.GetSize();
+	VolumeSize outputSize = dout.GetSize();
+
+	int fd = inputSize.deep;
+	int fc = outputSize.deep;
+	int area = fs * fs;
+	int cols = area * fc;
+
+	GradientTiles tiles = GetGradientTiles(dout.size(), inputSize.height);
+	size_t size = cols * fd + fc; // градиенты фильтров, затем смещений
+	real *partials = GradientPartials(tiles.parts, size);
+
+	#pragma omp parallel for if(tiles.parts > 1)
+	for (int part = 0; part < tiles.parts; part++) {
+		real *gradients = partials + part * size;
+		real *col = Im2colBuffer(tiles.bandRows * inputSize.width * cols);
+
+		std::fill(gradients, gradients + size, 0);
+
+		for (int unit = part * tiles.units / tiles.parts; unit < (part + 1) * tiles.units / tiles.parts; unit++) {
+			int n = unit / tiles.bands;
+			int begin = unit % tiles.bands * tiles.bandRows;
+			int end = std::min(inputSize.height, begin + tiles.bandRows);
+
+			int rows = (end - begin) * inputSize.width;
+			const real *x = X[n].Data() + begin * inputSize.width * fd;
+
+			Im2colRows(dout[n].Data(), outputSize, inputSize, fs, P, S, 1, begin, end, col);
+			Gemm(cols, fd, rows, col, 1, cols, x, fd, 1, 1, gradients, fd);
+
+			int rowsBegin = std::min(outputSize.height, begin * S);
+			int rowsEnd = end == inputSize.height ? outputSize.height : std::min(outputSize.height, end * S);
+			const real *d = dout[n].Data();
+
+			for (int r = rowsBegin * outputSize.width; r < rowsEnd * outputSize.width; r++)
+				for (int f = 0; f < fc; f++)
+					gradients[cols * fd + f] += d[r * fc + f];
+		}
+	}
+
+	ReduceGradientPartials(partials, tiles.parts, size);
+
+	#pragma omp parallel for
+	for (int f = 0; f < fc; f++) {
+		for (int kl = 0; kl < area; kl++)
+			for (int c = 0; c < fd; c++)
+				dW[f][kl * fd + c] += partials[(kl * fc + f) * fd + c];
+
+		db[f] += partials[cols * fd + f];
+	}
+}
+
+// вычисление градиентов входа транспонированной свёртки через GEMM: это свёртка dout[n] с шагом, im2col(dout[n]) * W (фильтры в порядке [k][l][f][c])
+void GemmTransposedConvBackwardInput(const Tensor &dout, const AlignedVector &packed, Tensor &dX, int fs, int P, int S) {
+	VolumeSize inputSize = dX.GetSize();
+	VolumeSize outputSize = dout.GetSize();
+
+	int fd = inputSize.deep;
+	int rows = inputSize.height * inputSize.width;
+	int cols = fs * fs * outputSize.deep;
+
+	#pragma omp parallel for
+	for (size_t n = 0; n < dout.size(); n++) {
+		real *col = Im2colBuffer(rows * cols);
+
+		Im2col(dout[n].Data(), outputSize, inputSize, fs, P, S, 1, col);
+		Gemm(rows, fd, cols, col, cols, 1, packed.data(), fd, 1, 0, dX[n].Data(), fd);
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "../../Entities/Real.hpp"
+#include "../../Entities/AlignedAllocator.hpp"
+
+#define GRADIENT_REDUCE_BLOCK 1024 // значений частичной суммы, складываемых одним потоком за раз
+
+// разбиение накопления градиентов на участки (пример x полоса строк выхода): участки делятся на parts непрерывных диапазонов,
+// каждый из которых поток накапливает в свою частичную сумму, так что параллельность не ограничена количеством фильтров
+// если примеров меньше, чем потоков, примеры режутся на полосы строк, чтобы занять все потоки и при малом батче
+struct GradientTiles {
+	int height; // строк выхода в примере
+	int bands; // полос в примере
+	int bandRows; // строк выхода в полосе
+	int units; // количество участков
+	int parts; // количество частичных сумм
+};
+
+// количество потоков, между которыми делится накопление градиентов
+int GradientThreads() {
+#ifdef _OPENMP
+	return omp_get_max_threads();
+#else
+	return 1;
+#endif
+}
+
+// разбиение батча из batchSize примеров с height строками выхода на участки
+GradientTiles GetGradientTiles(int batchSize, int height) {
+	int threads = GradientThreads();
+
+	GradientTiles tiles;
+	tiles.height = height;
+	tiles.bands = batchSize >= threads ? 1 : std::max(1, std::min(height, (threads + batchSize - 1) / batchSize));
+	tiles.bandRows = (height + tiles.bands - 1) / tiles.bands;
+	tiles.bands = (height + tiles.bandRows - 1) / tiles.bandRows;
+	tiles.units = batchSize * tiles.bands;
+	tiles.parts = std::max(1, std::min(tiles.units, threads));
+
+	return tiles;
+}
+
+// частичные суммы градиентов: parts массивов по size значений подряд (буфер принадлежит вызывающему потоку и только растёт)
+real* GradientPartials(int parts, size_t size) {
+	static thread_local AlignedVector partials;
+
+	if (partials.size() < parts * size)
+		partials.resize(parts * size);
+
+	return partials.data();
+}
+
+// детерминированная попарная редукция частичных сумм в первую: на шаге step к сумме p прибавляется сумма p + step,
+// поэтому порядок сложений задаётся только количеством частей и не зависит от расписания потоков
+void ReduceGradientPartials(real *partials, int parts, size_t size) {
+	for (int step = 1; step < parts; step *= 2) {
+		int pairs = (parts + step - 1) / (2 * step);
+		int blocks = (size + GRADIENT_REDUCE_BLOCK - 1) / GRADIENT_REDUCE_BLOCK;
+
+		#pragma omp parallel for collapse(2)
+		for (int pair = 0; pair < pairs; pair++) {
+			for (int block = 0; block < blocks; block++) {
+				real *dst = partials + (size_t) pair * 2 * step * size;
+				const real *src = dst + step * size;
+
+				size_t begin = (size_t) block * GRADIENT_REDUCE_BLOCK;
+				size_t end = std::min(size, begin + GRADIENT_REDUCE_BLOCK);
+
+				#pragma omp simd
+				for (size_t i = begin; i < end; i++)
+					dst[i] += src[i];
+			}
+		}
+	}
+}
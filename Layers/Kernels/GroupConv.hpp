@@ -0,0 +1,367 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include "../../Entities/Volume.hpp"
+#include "../../Entities/Tensor.hpp"
+#include "Gemm.hpp"
+#include "GemmConv.hpp"
+#include "GradientReduction.hpp"
+
+// групповая свёртка: каналы входа и фильтры делятся на groups групп, фильтры группы g видят только каналы входа группы g
+// выход f относится к группе f / (fc / groups), поэтому фильтры и каналы одной группы лежат подряд
+
+// упаковка фильтров поканальной свёртки (по одному входному каналу на группу): [k][l][выход]
+void PackDepthwiseFilters(const std::vector<Volume> &W, AlignedVector &packed) {
+	int fc = W.size();
+	int fs = W[0].Width();
+
+	if (packed.size() != fs * fs * fc)
+		packed.resize(fs * fs * fc);
+
+	for (int kl = 0; kl < fs * fs; kl++)
+		for (int f = 0; f < fc; f++)
+			packed[kl * fc + f] = W[f][kl];
+}
+
+// прямое распространение поканальной свёртки: каждый выход - свёртка одного канала входа, вычисления векторизуются по каналам
+// m - количество выходов на канал входа (множитель глубины)
+void DepthwiseConvForward(const Tensor &X, const AlignedVector &packed, const std::vector<real> &b, Tensor &output, int fs, int P, int S) {
+	VolumeSize inputSize = X.GetSize();
+	VolumeSize outputSize = output.GetSize();
+
+	int fd = inputSize.deep;
+	int fc = outputSize.deep;
+	int m = fc / fd;
+
+	#pragma omp parallel for collapse(2)
+	for (size_t n = 0; n < X.size(); n++) {
+		for (int i = 0; i < outputSize.height; i++) {
+			const real *x = X[n].Data();
+
+			for (int j = 0; j < outputSize.width; j++) {
+				real *y = output[n].Data() + (i * outputSize.width + j) * fc;
+				std::copy(b.begin(), b.end(), y);
+
+				for (int k = 0; k < fs; k++) {
+					int i0 = S * i + k - P;
+
+					if (i0 < 0 || i0 >= inputSize.height)
+						continue;
+
+					for (int l = 0; l < fs; l++) {
+						int j0 = S * j + l - P;
+
+						if (j0 < 0 || j0 >= inputSize.width)
+							continue;
+
+						const real *xp = x + (i0 * inputSize.width + j0) * fd;
+						const real *w = packed.data() + (k * fs + l) * fc;
+
+						if (m == 1) {
+							#pragma omp simd
+							for (int c = 0; c < fc; c++)
+								y[c] += xp[c] * w[c];
+						}
+						else {
+							for (int c = 0; c < fd; c++)
+								for (int t = 0; t < m; t++)
+									y[c * m + t] += xp[c] * w[c * m + t];
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+// накопление градиентов фильтров и смещений поканальной свёртки: участки батча считаются потоками в частичные суммы [k][l][выход]
+void DepthwiseConvBackwardWeights(const Tensor &dout, const Tensor &X, std::vector<Volume> &dW, std::vector<real> &db, int fs, int P, int S) {
+	VolumeSize inputSize = X.GetSize();
+	VolumeSize outputSize = dout.GetSize();
+
+	int fd = inputSize.deep;
+	int fc = outputSize.deep;
+	int m = fc / fd;
+
+	GradientTiles tiles = GetGradientTiles(dout.size(), outputSize.height);
+	size_t size = fs * fs * fc + fc; // градиенты фильтров, затем смещений
+	real *partials = GradientPartials(tiles.parts, size);
+
+	#pragma omp parallel for
+	for (int part = 0; part < tiles.parts; part++) {
+		real *gradients = partials + part * size;
+		std::fill(gradients, gradients + size, 0);
+
+		for (int unit = part * tiles.units / tiles.parts; unit < (part + 1) * tiles.units / tiles.parts; unit++) {
+			int n = unit / tiles.bands;
+			int begin = unit % tiles.bands * tiles.bandRows;
+			int end = std::min(outputSize.height, begin + tiles.bandRows);
+			const real *x = X[n].Data();
+
+			for (int i = begin; i < end; i++) {
+				for (int j = 0; j < outputSize.width; j++) {
+					const real *d = dout[n].Data() + (i * outputSize.width + j) * fc;
+
+					for (int k = 0; k < fs; k++) {
+						int i0 = S * i + k - P;
+
+						if (i0 < 0 || i0 >= inputSize.height)
+							continue;
+
+						for (int l = 0; l < fs; l++) {
+							int j0 = S * j + l - P;
+
+							if (j0 < 0 || j0 >= inputSize.width)
+								continue;
+
+							const real *xp = x + (i0 * inputSize.width + j0) * fd;
+							real *g = gradients + (k * fs + l) * fc;
+
+							if (m == 1) {
+								#pragma omp simd
+								for (int c = 0; c < fc; c++)
+									g[c] += d[c] * xp[c];
+							}
+							else {
+								for (int c = 0; c < fd; c++)
+									for (int t = 0; t < m; t++)
+										g[c * m + t] += d[c * m + t] * xp[c];
+							}
+						}
+					}
+
+					real *gb = gradients + fs * fs * fc;
+
+					#pragma omp simd
+					for (int f = 0; f < fc; f++)
+						gb[f] += d[f];
+				}
+			}
+		}
+	}
+
+	ReduceGradientPartials(partials, tiles.parts, size);
+
+	#pragma omp parallel for
+	for (int f = 0; f < fc; f++) {
+		for (int kl = 0; kl < fs * fs; kl++)
+			dW[f][kl] += partials[kl * fc + f];
+
+		db[f] += partials[fs * fs * fc + f];
+	}
+}
+
+// вычисление градиентов входа поканальной свёртки: каждый вход собирает градиенты накрывающих его выходов,
+// поэтому при шаге больше 1 градиенты выхода не разреживаются нулями, а строки входа считаются независимо
+void DepthwiseConvBackwardInput(const Tensor &dout, const AlignedVector &packed, Tensor &dX, int fs, int P, int S) {
+	VolumeSize inputSize = dX.GetSize();
+	VolumeSize outputSize = dout.GetSize();
+
+	int fd = inputSize.deep;
+	int fc = outputSize.deep;
+	int m = fc / fd;
+
+	#pragma omp parallel for collapse(2)
+	for (size_t n = 0; n < dout.size(); n++) {
+		for (int i = 0; i < inputSize.height; i++) {
+			for (int j = 0; j < inputSize.width; j++) {
+				real *dx = dX[n].Data() + (i * inputSize.width + j) * fd;
+				std::fill(dx, dx + fd, 0);
+
+				for (int k = 0; k < fs; k++) {
+					int i0 = i + P - k;
+
+					if (i0 < 0 || i0 % S != 0 || i0 / S >= outputSize.height)
+						continue;
+
+					for (int l = 0; l < fs; l++) {
+						int j0 = j + P - l;
+
+						if (j0 < 0 || j0 % S != 0 || j0 / S >= outputSize.width)
+							continue;
+
+						const real *d = dout[n].Data() + ((i0 / S) * outputSize.width + j0 / S) * fc;
+						const real *w = packed.data() + (k * fs + l) * fc;
+
+						if (m == 1) {
+							#pragma omp simd
+							for (int c = 0; c < fd; c++)
+								dx[c] += d[c] * w[c];
+						}
+						else {
+							for (int c = 0; c < fd; c++)
+								for (int t = 0; t < m; t++)
+									dx[c] += d[c * m + t] * w[c * m + t];
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+// развёртка окон строк выхода [begin, end) группы каналов [c0, c0 + channels) в матрицу ((end - begin) * OW) x (fs * fs * channels)
+void GroupIm2col(const real *x, const VolumeSize &inputSize, const VolumeSize &outputSize, int fs, int P, int S, int begin, int end, int c0, int channels, real *col) {
+	int fd = inputSize.deep;
+	int cols = fs * fs * channels;
+
+	for (int i = begin; i < end; i++) {
+		for (int j = 0; j < outputSize.width; j++) {
+			real *row = col + ((i - begin) * outputSize.width + j) * cols;
+
+			for (int k = 0; k < fs; k++) {
+				int i0 = S * i + k - P;
+
+				for (int l = 0; l < fs; l++) {
+					int j0 = S * j + l - P;
+					real *dst = row + (k * fs + l) * channels;
+
+					if (i0 < 0 || i0 >= inputSize.height || j0 < 0 || j0 >= inputSize.width) {
+						std::fill(dst, dst + channels, 0);
+					}
+					else {
+						const real *src = x + (i0 * inputSize.width + j0) * fd + c0;
+						std::copy(src, src + channels, dst);
+					}
+				}
+			}
+		}
+	}
+}
+
+// свёртка матрицы окон группы каналов обратно в пример с накоплением перекрывающихся значений
+void GroupCol2im(const real *col, const VolumeSize &inputSize, const VolumeSize &outputSize, int fs, int P, int S, int c0, int channels, real *dx) {
+	int fd = inputSize.deep;
+	int cols = fs * fs * channels;
+
+	for (int i = 0; i < outputSize.height; i++) {
+		for (int j = 0; j < outputSize.width; j++) {
+			const real *row = col + (i * outputSize.width + j) * cols;
+
+			for (int k = 0; k < fs; k++) {
+				int i0 = S * i + k - P;
+
+				if (i0 < 0 || i0 >= inputSize.height)
+					continue;
+
+				for (int l = 0; l < fs; l++) {
+					int j0 = S * j + l - P;
+
+					if (j0 < 0 || j0 >= inputSize.width)
+						continue;
+
+					const real *src = row + (k * fs + l) * channels;
+					real *dst = dx + (i0 * inputSize.width + j0) * fd + c0;
+
+					for (int c = 0; c < channels; c++)
+						dst[c] += src[c];
+				}
+			}
+		}
+	}
+}
+
+// прямое распространение групповой свёртки: для каждой группы своё умножение матриц, результат пишется в каналы группы выхода
+void GroupConvForward(const Tensor &X, const AlignedVector &packed, const std::vector<real> &b, Tensor &output, int fs, int P, int S, int groups) {
+	VolumeSize inputSize = X.GetSize();
+	VolumeSize outputSize = output.GetSize();
+
+	int fc = outputSize.deep;
+	int inputs = inputSize.deep / groups;
+	int outputs = fc / groups;
+	int rows = outputSize.height * outputSize.width;
+	int cols = fs * fs * inputs;
+
+	#pragma omp parallel for
+	for (size_t n = 0; n < X.size(); n++) {
+		real *col = Im2colBuffer(rows * cols);
+		real *y = output[n].Data();
+
+		for (int r = 0; r < rows; r++)
+			std::copy(b.begin(), b.end(), y + r * fc);
+
+		for (int g = 0; g < groups; g++) {
+			GroupIm2col(X[n].Data(), inputSize, outputSize, fs, P, S, 0, outputSize.height, g * inputs, inputs, col);
+			Gemm(rows, outputs, cols, col, cols, 1, packed.data() + g * outputs * cols, 1, cols, 1, y + g * outputs, fc);
+		}
+	}
+}
+
+// накопление градиентов фильтров и смещений групповой свёртки: dW группы += dout группы ^T * im2col(X группы)
+// участки батча (полосы строк выхода) считаются потоками в частичные суммы, которые затем складываются деревом
+void GroupConvBackwardWeights(const Tensor &dout, const Tensor &X, std::vector<Volume> &dW, std::vector<real> &db, int fs, int P, int S, int groups) {
+	VolumeSize inputSize = X.GetSize();
+	VolumeSize outputSize = dout.GetSize();
+
+	int fc = outputSize.deep;
+	int inputs = inputSize.deep / groups;
+	int outputs = fc / groups;
+	int cols = fs * fs * inputs;
+
+	GradientTiles tiles = GetGradientTiles(dout.size(), outputSize.height);
+	size_t size = fc * cols + fc; // градиенты фильтров, затем смещений
+	real *partials = GradientPartials(tiles.parts, size);
+
+	#pragma omp parallel for if(tiles.parts > 1)
+	for (int part = 0; part < tiles.parts; part++) {
+		real *gradients = partials + part * size;
+		real *col = Im2colBuffer(tiles.bandRows * outputSize.width * cols);
+
+		std::fill(gradients, gradients + size, 0);
+
+		for (int unit = part * tiles.units / tiles.parts; unit < (part + 1) * tiles.units / tiles.parts; unit++) {
+			int n = unit / tiles.bands;
+			int begin = unit % tiles.bands * tiles.bandRows;
+			int end = std::min(outputSize.height, begin + tiles.bandRows);
+
+			int rows = (end - begin) * outputSize.width;
+			const real *d = dout[n].Data() + begin * outputSize.width * fc;
+
+			for (int g = 0; g < groups; g++) {
+				GroupIm2col(X[n].Data(), inputSize, outputSize, fs, P, S, begin, end, g * inputs, inputs, col);
+				Gemm(outputs, cols, rows, d + g * outputs, 1, fc, col, cols, 1, 1, gradients + g * outputs * cols, cols);
+			}
+
+			for (int r = 0; r < rows; r++)
+				for (int f = 0; f < fc; f++)
+					gradients[fc * cols + f] += d[r * fc + f];
+		}
+	}
+
+	ReduceGradientPartials(partials, tiles.parts, size);
+
+	#pragma omp parallel for
+	for (int f = 0; f < fc; f++) {
+		for (int i = 0; i < cols; i++)
+			dW[f][i] += partials[f * cols + i];
+
+		db[f] += partials[fc * cols + f];
+	}
+}
+
+// вычисление градиентов входа групповой свёртки: col2im(dout группы * W группы) в каналы группы входа
+void GroupConvBackwardInput(const Tensor &dout, const AlignedVector &packed, Tensor &dX, int fs, int P, int S, int groups) {
+	VolumeSize inputSize = dX.GetSize();
+	VolumeSize outputSize = dout.GetSize();
+
+	int fc = outputSize.deep;
+	int inputs = inputSize.deep / groups;
+	int outputs = fc / groups;
+	int rows = outputSize.height * outputSize.width;
+	int cols = fs * fs * inputs;
+
+	#pragma omp parallel for
+	for (size_t n = 0; n < dout.size(); n++) {
+		real *col = Im2colBuffer(rows * cols);
+		real *dx = dX[n].Data();
+
+		std::fill(dx, dx + dX.Total(), 0);
+
+		for (int g = 0; g < groups; g++) {
+			Gemm(rows, cols, outputs, dout[n].Data() + g * outputs, fc, 1, packed.data() + g * outputs * cols, cols, 1, 0, col, cols);
+			GroupCol2im(col, inputSize, outputSize, fs, P, S, g * inputs, inputs, dx);
+		}
+	}
+}
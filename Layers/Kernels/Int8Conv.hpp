@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "../../Entities/Volume.hpp"
+#include "../../Entities/Tensor.hpp"
+#include "Int8Gemm.hpp"
+
+// квантованная свёртка: пример квантуется в байты, окна разворачиваются в строки длины paddedDepth, которые умножаются на int8 фильтры
+// дополнение свёртки - нулевая точка входа (квантованный ноль), хвост строки до paddedDepth обнуляется (ему соответствуют нулевые веса)
+
+// буфер квантованных значений, принадлежащий потоку (растёт до наибольшего запрошенного размера)
+uint8_t* QuantizedBuffer(size_t size) {
+	static thread_local AlignedUInt8Vector buffer;
+
+	if (buffer.size() < size)
+		buffer.resize(size);
+
+	return buffer.data();
+}
+
+// развёртка окон квантованного примера в матрицу (OH * OW) x cols, строка - окно в порядке [k][l][c], дополненное нулями до cols
+void Int8Im2col(const uint8_t *x, const VolumeSize &inputSize, const VolumeSize &outputSize, int fs, int P, int S, int D, uint8_t zeroPoint, int cols, uint8_t *col) {
+	int fd = inputSize.deep;
+	int depth = fs * fs * fd;
+
+	for (int i = 0; i < outputSize.height; i++) {
+		for (int j = 0; j < outputSize.width; j++) {
+			uint8_t *row = col + (size_t) (i * outputSize.width + j) * cols;
+
+			for (int k = 0; k < fs; k++) {
+				int i0 = S * i + D * k - P;
+				int j0 = S * j - P;
+				uint8_t *dst = row + k * fs * fd;
+
+				// строка окна целиком внутри входа при D = 1 лежит во входе подряд
+				if (D == 1 && i0 >= 0 && i0 < inputSize.height && j0 >= 0 && j0 + fs <= inputSize.width) {
+					const uint8_t *src = x + (i0 * inputSize.width + j0) * fd;
+
+					for (int c = 0; c < fs * fd; c++)
+						dst[c] = src[c];
+
+					continue;
+				}
+
+				for (int l = 0; l < fs; l++, j0 += D, dst += fd) {
+					if (i0 < 0 || i0 >= inputSize.height || j0 < 0 || j0 >= inputSize.width)
+						std::fill(dst, dst + fd, zeroPoint);
+					else
+						std::copy(x + (i0 * inputSize.width + j0) * fd, x + (i0 * inputSize.width + j0 + 1) * fd, dst);
+				}
+			}
+
+			std::fill(row + depth, row + cols, 0);
+		}
+	}
+}
+
+// прямое распространение квантованной свёртки: output[n] (OH * OW x fc) = эпилог(im2col(q(X[n])) * W^T * multiplier + offset)
+// свёртка 1x1 с шагом 1 без дополнения при fd, кратном INT8_GEMM_KU, умножает квантованный пример без развёртки
+void Int8ConvForward(const Tensor &X, const Int8Weights &weights, const QuantizationParams &input, const std::vector<real> &multipliers, const std::vector<real> &offsets, const Epilogue &epilogue, Tensor &output, int fs, int P, int S, int D) {
+	VolumeSize inputSize = X.GetSize();
+	VolumeSize outputSize = output.GetSize();
+
+	int total = X.Total();
+	int rows = outputSize.height * outputSize.width;
+	int cols = weights.paddedDepth;
+	bool direct = fs == 1 && P == 0 && S == 1 && cols == inputSize.deep;
+
+	#pragma omp parallel for
+	for (size_t n = 0; n < X.size(); n++) {
+		uint8_t *q = QuantizedBuffer(total + (direct ? 0 : (size_t) rows * cols));
+		uint8_t *col = direct ? q : q + total;
+
+		QuantizeInputs(X[n].Data(), total, input, q);
+
+		if (!direct)
+			Int8Im2col(q, inputSize, outputSize, fs, P, S, D, input.zeroPoint, cols, col);
+
+		Int8Gemm(rows, col, cols, weights, multipliers.data(), offsets.data(), epilogue, output[n].Data(), outputSize.deep);
+	}
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "../../Entities/Real.hpp"
+#include "../../Entities/AlignedAllocator.hpp"
+#include "../../Entities/Quantization.hpp"
+#include "../../Entities/Epilogue.hpp"
+
+#define INT8_GEMM_MR 4 // строк входов в блоке микроядра
+#define INT8_GEMM_NR 16 // выходов в блоке микроядра (два регистра AVX2 по 8 сумм int32)
+#define INT8_GEMM_KU 4 // байт общей размерности в одной 32-битной ячейке регистра
+
+// квантованные по выходам веса слоя (строка весов выхода - фильтр свёртки или строка матрицы полносвязного слоя)
+// веса упакованы панелями по INT8_GEMM_NR выходов в порядке [панель][p / 4][выход панели][p % 4]: одна загрузка даёт
+// по 4 подряд идущих веса на каждый из 8 выходов, что совпадает с форматом vpmaddubsw / vpdpbusd
+struct Int8Weights {
+	int outputs; // количество выходов
+	int depth; // длина строки весов
+	int paddedDepth; // длина строки, дополненная нулями до кратной INT8_GEMM_KU (строка входов должна иметь такую же длину)
+	AlignedInt8Vector packed; // упакованные веса
+	std::vector<real> scales; // масштабы весов выходов
+	std::vector<int32_t> sums; // суммы квантованных весов выходов (для поправки на нулевую точку входа)
+};
+
+// симметричное квантование весов по выходам: w ≈ scale_n * q, |q| <= QUANTIZED_WEIGHT_MAX, W - матрица outputs x depth по строкам
+void QuantizeWeights(const real *W, int outputs, int depth, Int8Weights &weights) {
+	int panels = (outputs + INT8_GEMM_NR - 1) / INT8_GEMM_NR;
+
+	weights.outputs = outputs;
+	weights.depth = depth;
+	weights.paddedDepth = (depth + INT8_GEMM_KU - 1) / INT8_GEMM_KU * INT8_GEMM_KU;
+	weights.packed.assign((size_t) panels * INT8_GEMM_NR * weights.paddedDepth, 0);
+	weights.scales.assign(outputs, 1);
+	weights.sums.assign(outputs, 0);
+
+	for (int n = 0; n < outputs; n++) {
+		const real *w = W + (size_t) n * depth;
+		real max = 0;
+
+		for (int p = 0; p < depth; p++)
+			max = std::max(max, (real) fabs(w[p]));
+
+		if (max > 0)
+			weights.scales[n] = max / QUANTIZED_WEIGHT_MAX;
+
+		int8_t *panel = weights.packed.data() + (size_t) (n / INT8_GEMM_NR) * INT8_GEMM_NR * weights.paddedDepth;
+
+		for (int p = 0; p < depth; p++) {
+			int q = (int) std::floor(w[p] / weights.scales[n] + 0.5);
+			q = std::min(QUANTIZED_WEIGHT_MAX, std::max(-QUANTIZED_WEIGHT_MAX, q));
+
+			panel[(p / INT8_GEMM_KU * INT8_GEMM_NR + n % INT8_GEMM_NR) * INT8_GEMM_KU + p % INT8_GEMM_KU] = q;
+			weights.sums[n] += q;
+		}
+	}
+}
+
+// множители и сдвиги перевода сумм в значения: (acc - zeroPoint * sum_n) * inputScale * scale_n + b_n = acc * multiplier_n + offset_n
+// дополняются нулями до целого числа панелей, чтобы перевод блока микроядра шёл по полной ширине
+void GetDequantization(const Int8Weights &weights, const QuantizationParams &input, const std::vector<real> &b, std::vector<real> &multipliers, std::vector<real> &offsets) {
+	int panels = (weights.outputs + INT8_GEMM_NR - 1) / INT8_GEMM_NR;
+
+	multipliers.assign(panels * INT8_GEMM_NR, 0);
+	offsets.assign(panels * INT8_GEMM_NR, 0);
+
+	for (int n = 0; n < weights.outputs; n++) {
+		multipliers[n] = input.scale * weights.scales[n];
+		offsets[n] = b[n] - (real) input.zeroPoint * weights.sums[n] * multipliers[n];
+	}
+}
+
+#ifdef __AVX2__
+// acc + сумма по четвёркам байт произведений беззнаковых a на знаковые b
+inline __m256i Int8DotProduct(__m256i acc, __m256i a, __m256i b) {
+#if defined(__AVX512VNNI__) && defined(__AVX512VL__)
+	return _mm256_dpbusd_epi32(acc, a, b);
+#elif defined(__AVXVNNI__)
+	return _mm256_dpbusd_avx_epi32(acc, a, b);
+#else
+	__m256i pairs = _mm256_maddubs_epi16(a, b); // входы не больше 127, поэтому пары не насыщаются
+	return _mm256_add_epi32(acc, _mm256_madd_epi16(pairs, _mm256_set1_epi16(1)));
+#endif
+}
+#endif
+
+// микроядро: суммы int32 блока mr x INT8_GEMM_NR = строки входов A (через lda байт) * панель весов, строки сверх mr повторяют последнюю
+inline void Int8MicroKernel(int groups, const uint8_t *A, int lda, const int8_t *panel, int mr, int32_t acc[INT8_GEMM_MR][INT8_GEMM_NR]) {
+	const uint8_t *rows[INT8_GEMM_MR];
+
+	for (int i = 0; i < INT8_GEMM_MR; i++)
+		rows[i] = A + std::min(i, mr - 1) * lda;
+
+#ifdef __AVX2__
+	__m256i sums[INT8_GEMM_MR][2];
+
+	for (int i = 0; i < INT8_GEMM_MR; i++)
+		sums[i][0] = sums[i][1] = _mm256_setzero_si256();
+
+	for (int g = 0; g < groups; g++) {
+		__m256i b0 = _mm256_load_si256((const __m256i*) panel);
+		__m256i b1 = _mm256_load_si256((const __m256i*) (panel + 32));
+
+		for (int i = 0; i < INT8_GEMM_MR; i++) {
+			int32_t value;
+			memcpy(&value, rows[i] + g * INT8_GEMM_KU, sizeof(value));
+
+			__m256i a = _mm256_set1_epi32(value);
+			sums[i][0] = Int8DotProduct(sums[i][0], a, b0);
+			sums[i][1] = Int8DotProduct(sums[i][1], a, b1);
+		}
+
+		panel += INT8_GEMM_NR * INT8_GEMM_KU;
+	}
+
+	for (int i = 0; i < INT8_GEMM_MR; i++) {
+		_mm256_storeu_si256((__m256i*) acc[i], sums[i][0]);
+		_mm256_storeu_si256((__m256i*) (acc[i] + 8), sums[i][1]);
+	}
+#else
+	for (int i = 0; i < INT8_GEMM_MR; i++)
+		for (int j = 0; j < INT8_GEMM_NR; j++)
+			acc[i][j] = 0;
+
+	for (int g = 0; g < groups; g++) {
+		for (int i = 0; i < INT8_GEMM_MR; i++) {
+			const uint8_t *a = rows[i] + g * INT8_GEMM_KU;
+
+			for (int j = 0; j < INT8_GEMM_NR; j++)
+				for (int u = 0; u < INT8_GEMM_KU; u++)
+					acc[i][j] += (int32_t) a[u] * panel[j * INT8_GEMM_KU + u];
+		}
+
+		panel += INT8_GEMM_NR * INT8_GEMM_KU;
+	}
+#endif
+}
+
+// перевод сумм строки блока (выходы n0, ..., n0 + nr - 1) в значения с эпилогом: активация выбирается один раз на строку, чтобы циклы векторизовались
+inline void Int8StoreRow(const int32_t *acc, const real *multipliers, const real *offsets, const Epilogue &epilogue, int n0, int nr, real *c) {
+	real values[INT8_GEMM_NR];
+
+	#pragma omp simd
+	for (int j = 0; j < INT8_GEMM_NR; j++)
+		values[j] = acc[j] * multipliers[n0 + j] + offsets[n0 + j];
+
+	if (epilogue.activation == EpilogueActivation::ReLU) {
+		#pragma omp simd
+		for (int j = 0; j < INT8_GEMM_NR; j++)
+			values[j] = values[j] > 0 ? values[j] : 0;
+	}
+	else if (epilogue.activation == EpilogueActivation::LeakyReLU) {
+		#pragma omp simd
+		for (int j = 0; j < INT8_GEMM_NR; j++)
+			values[j] = values[j] > 0 ? values[j] : epilogue.alpha * values[j];
+	}
+	else if (epilogue.activation == EpilogueActivation::Sigmoid) {
+		for (int j = 0; j < nr; j++)
+			values[j] = 1.0 / (1 + exp(-values[j]));
+	}
+
+	if (epilogue.scale.empty()) {
+		std::copy(values, values + nr, c);
+		return;
+	}
+
+	const real *scale = epilogue.scale.data() + n0;
+	const real *shift = epilogue.shift.data() + n0;
+
+	#pragma omp simd
+	for (int j = 0; j < nr; j++)
+		c[j] = values[j] * scale[j] + shift[j];
+}
+
+// C (M x outputs, строки через ldc) = эпилог(A * W^T * multiplier + offset), A - M строк квантованных входов длины paddedDepth через lda байт
+// суммы копятся в int32 без переполнения: |a * w| <= 127 * 127, поэтому точны до 2^31 / 127^2 ≈ 133000 слагаемых
+void Int8Gemm(int M, const uint8_t *A, int lda, const Int8Weights &weights, const real *multipliers, const real *offsets, const Epilogue &epilogue, real *C, int ldc) {
+	int panelsM = (M + INT8_GEMM_MR - 1) / INT8_GEMM_MR;
+	int panelsN = (weights.outputs + INT8_GEMM_NR - 1) / INT8_GEMM_NR;
+	int groups = weights.paddedDepth / INT8_GEMM_KU;
+
+	// внутри параллельной области (например, по примерам батча) этот цикл выполняется одним потоком
+	#pragma omp parallel for collapse(2) if(panelsM * panelsN > 1)
+	for (int jr = 0; jr < panelsN; jr++) {
+		for (int ir = 0; ir < panelsM; ir++) {
+			int mr = std::min(INT8_GEMM_MR, M - ir * INT8_GEMM_MR);
+			int nr = std::min(INT8_GEMM_NR, weights.outputs - jr * INT8_GEMM_NR);
+			int32_t acc[INT8_GEMM_MR][INT8_GEMM_NR];
+
+			Int8MicroKernel(groups, A + (size_t) ir * INT8_GEMM_MR * lda, lda, weights.packed.data() + (size_t) jr * INT8_GEMM_NR * weights.paddedDepth, mr, acc);
+
+			for (int i = 0; i < mr; i++)
+				Int8StoreRow(acc[i], multipliers, offsets, epilogue, jr * INT8_GEMM_NR, nr, C + (size_t) (ir * INT8_GEMM_MR + i) * ldc + jr * INT8_GEMM_NR);
+		}
+	}
+}
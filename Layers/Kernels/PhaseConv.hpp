@@ -0,0 +1,129 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include "../../Entities/Volume.hpp"
+#include "../../Entities/Tensor.hpp"
+#include "Gemm.hpp"
+#include "GemmConv.hpp"
+
+// свёртка с шагом S по фазам: значение источника (y, x) попадает в положения результата (S * y + k - P, S * x + l - P),
+// поэтому строки результата с (i + P) mod S = a собираются только ядрами k = a, a + S, ... (так же для столбцов)
+// каждая из S^2 фаз - обычная свёртка источника с подфильтром из ceil((fs - a) / S) x ceil((fs - b) / S) ядер, которая считается через GEMM
+// так считаются градиенты входа свёртки с шагом и прямой проход транспонированной свёртки без разреженного нулями тензора,
+// который тратит впустую (S^2 - 1) / S^2 умножений
+
+// количество ядер фильтра размера fs, попадающих в фазу a
+int PhaseTaps(int fs, int S, int a) {
+	return a < fs ? (fs - a + S - 1) / S : 0;
+}
+
+// упаковка подфильтров фаз подряд, подфильтр фазы (a, b) - матрица (taps_a * taps_b * источник) x результат в порядке [m][m'][s][r] для ядра (a + S * m, b + S * m')
+// при transposed источник - вход транспонированной свёртки (fd каналов), результат - её выход (fc каналов),
+// иначе источник - градиенты выхода свёртки (fc каналов), результат - градиенты её входа (fd каналов)
+void PackPhaseFilters(const std::vector<Volume> &W, int S, bool transposed, AlignedVector &packed) {
+	int fc = W.size();
+	int fd = W[0].Deep();
+	int fs = W[0].Width();
+
+	int sd = transposed ? fd : fc;
+	int dd = transposed ? fc : fd;
+
+	if (packed.size() != fc * fs * fs * fd)
+		packed.resize(fc * fs * fs * fd);
+
+	real *w = packed.data();
+
+	for (int a = 0; a < S; a++) {
+		for (int b = 0; b < S; b++) {
+			for (int k = a; k < fs; k += S) {
+				for (int l = b; l < fs; l += S) {
+					for (int s = 0; s < sd; s++)
+						for (int r = 0; r < dd; r++)
+							w[s * dd + r] = transposed ? W[r][(k * fs + l) * fd + s] : W[s][(k * fs + l) * fd + r];
+
+					w += sd * dd;
+				}
+			}
+		}
+	}
+}
+
+// развёртка окон фазы (a, b) источника x: строка на каждое положение фазы, в ней taps_a * taps_b положений источника по sd значений
+void PhaseIm2col(const real *x, const VolumeSize &srcSize, const VolumeSize &dstSize, int fs, int P, int S, int a, int b, real *col) {
+	int sd = srcSize.deep;
+	int ta = PhaseTaps(fs, S, a);
+	int tb = PhaseTaps(fs, S, b);
+	int i0 = ((a - P) % S + S) % S;
+	int j0 = ((b - P) % S + S) % S;
+
+	for (int i = i0; i < dstSize.height; i += S) {
+		int y = (i + P - a) / S;
+
+		for (int j = j0; j < dstSize.width; j += S) {
+			int x0 = (j + P - b) / S;
+
+			for (int m = 0; m < ta; m++) {
+				for (int m1 = 0; m1 < tb; m1++) {
+					int yi = y - m;
+					int xi = x0 - m1;
+
+					if (yi < 0 || yi >= srcSize.height || xi < 0 || xi >= srcSize.width)
+						std::fill(col, col + sd, 0);
+					else
+						std::copy(x + (yi * srcSize.width + xi) * sd, x + (yi * srcSize.width + xi + 1) * sd, col);
+
+					col += sd;
+				}
+			}
+		}
+	}
+}
+
+// dst[n](i, j) = bias + сумма по ядрам фазы положения (i, j) и каналам s источника src[n]((i + P - k) / S, (j + P - l) / S, s) * W[k][l][s] (bias может отсутствовать)
+void PhaseConv(const Tensor &src, const AlignedVector &packed, const real *bias, Tensor &dst, int fs, int P, int S) {
+	VolumeSize srcSize = src.GetSize();
+	VolumeSize dstSize = dst.GetSize();
+
+	int sd = srcSize.deep;
+	int dd = dstSize.deep;
+	size_t rows = ((dstSize.height + S - 1) / S) * ((dstSize.width + S - 1) / S); // положений в наибольшей фазе
+	int taps = PhaseTaps(fs, S, 0);
+
+	#pragma omp parallel for
+	for (size_t n = 0; n < src.size(); n++) {
+		real *col = Im2colBuffer(rows * (taps * taps * sd + dd));
+		real *result = col + rows * taps * taps * sd;
+		const real *w = packed.data();
+		real *y = dst[n].Data();
+
+		for (int a = 0; a < S; a++) {
+			for (int b = 0; b < S; b++) {
+				int i0 = ((a - P) % S + S) % S;
+				int j0 = ((b - P) % S + S) % S;
+				int height = i0 < dstSize.height ? (dstSize.height - 1 - i0) / S + 1 : 0;
+				int width = j0 < dstSize.width ? (dstSize.width - 1 - j0) / S + 1 : 0;
+				int cols = PhaseTaps(fs, S, a) * PhaseTaps(fs, S, b) * sd;
+
+				for (int r = 0; r < height * width; r++) {
+					if (bias)
+						std::copy(bias, bias + dd, result + r * dd);
+					else
+						std::fill(result + r * dd, result + (r + 1) * dd, 0);
+				}
+
+				if (cols > 0 && height * width > 0) {
+					PhaseIm2col(src[n].Data(), srcSize, dstSize, fs, P, S, a, b, col);
+					Gemm(height * width, dd, cols, col, cols, 1, w, dd, 1, 1, result, dd);
+				}
+
+				for (int i = 0; i < height; i++)
+					for (int j = 0; j < width; j++)
+						std::copy(result + (i * width + j) * dd, result + (i * width + j + 1) * dd, y + ((i0 + i * S) * dstSize.width + j0 + j * S) * dd);
+
+				w += cols * dd;
+			}
+		}
+	}
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include "../../Entities/Volume.hpp"
+#include "../../Entities/Tensor.hpp"
+#include "Gemm.hpp"
+#include "GemmConv.hpp"
+#include "GradientReduction.hpp"
+
+// свёртка 1x1 в канальном расположении - это умножение матрицы положений (N * OH * OW) x fd на матрицу фильтров fd x fc,
+// поэтому весь батч обрабатывается одним умножением матриц без развёртки окон
+// при шаге 1 без дополнения матрицей положений служит сам вход, иначе в неё собираются нужные положения (в S^2 раз меньше входа)
+
+// матрица положений батча: сам вход или собранные с шагом S положения (буфер принадлежит вызывающему потоку)
+const real* PointwiseInputs(const Tensor &X, const VolumeSize &outputSize, int P, int S) {
+	if (P == 0 && S == 1)
+		return X.Data();
+
+	VolumeSize inputSize = X.GetSize();
+	size_t rows = outputSize.height * outputSize.width;
+	real *col = Im2colBuffer(X.size() * rows * inputSize.deep);
+
+	#pragma omp parallel for
+	for (size_t n = 0; n < X.size(); n++)
+		Im2col(X[n].Data(), inputSize, outputSize, 1, P, S, 1, col + n * rows * inputSize.deep);
+
+	return col;
+}
+
+// прямое распространение свёртки 1x1: output (N * OH * OW x fc) = inputs * W^T + b
+void PointwiseConvForward(const Tensor &X, const AlignedVector &packed, const std::vector<real> &b, Tensor &output, int P, int S) {
+	int fd = X.GetSize().deep;
+	int fc = output.GetSize().deep;
+	int rows = output.size() * output.Total() / fc;
+
+	const real *inputs = PointwiseInputs(X, output.GetSize(), P, S);
+	real *y = output.Data();
+
+	#pragma omp parallel for
+	for (int r = 0; r < rows; r++)
+		std::copy(b.begin(), b.end(), y + r * fc);
+
+	Gemm(rows, fc, fd, inputs, fd, 1, packed.data(), 1, fd, 1, y, fc);
+}
+
+// накопление градиентов фильтров и смещений свёртки 1x1: dW (fc x fd) += dout^T * inputs
+// участки батча (полосы строк выхода) умножаются потоками в частичные суммы, которые затем складываются деревом
+void PointwiseConvBackwardWeights(const Tensor &dout, const Tensor &X, std::vector<Volume> &dW, std::vector<real> &db, int P, int S) {
+	VolumeSize inputSize = X.GetSize();
+	VolumeSize outputSize = dout.GetSize();
+
+	int fd = inputSize.deep;
+	int fc = outputSize.deep;
+
+	GradientTiles tiles = GetGradientTiles(dout.size(), outputSize.height);
+	size_t size = fc * fd + fc; // градиенты фильтров, затем смещений
+	real *partials = GradientPartials(tiles.parts, size);
+
+	#pragma omp parallel for if(tiles.parts > 1)
+	for (int part = 0; part < tiles.parts; part++) {
+		real *gradients = partials + part * size;
+		real *col = P == 0 && S == 1 ? nullptr : Im2colBuffer(tiles.bandRows * outputSize.width * fd);
+
+		std::fill(gradients, gradients + size, 0);
+
+		for (int unit = part * tiles.units / tiles.parts; unit < (part + 1) * tiles.units / tiles.parts; unit++) {
+			int n = unit / tiles.bands;
+			int begin = unit % tiles.bands * tiles.bandRows;
+			int end = std::min(outputSize.height, begin + tiles.bandRows);
+
+			int rows = (end - begin) * outputSize.width;
+			const real *d = dout[n].Data() + begin * outputSize.width * fc;
+			const real *inputs = X[n].Data() + begin * inputSize.width * fd;
+
+			if (col) {
+				Im2colRows(X[n].Data(), inputSize, outputSize, 1, P, S, 1, begin, end, col);
+				inputs = col;
+			}
+
+			Gemm(fc, fd, rows, d, 1, fc, inputs, fd, 1, 1, gradients, fd);
+
+			for (int r = 0; r < rows; r++)
+				for (int f = 0; f < fc; f++)
+					gradients[fc * fd + f] += d[r * fc + f];
+		}
+	}
+
+	ReduceGradientPartials(partials, tiles.parts, size);
+
+	#pragma omp parallel for
+	for (int f = 0; f < fc; f++) {
+		for (int c = 0; c < fd; c++)
+			dW[f][c] += partials[f * fd + c];
+
+		db[f] += partials[fc * fd + f];
+	}
+}
+
+// вычисление градиентов входа свёртки 1x1: dout * W, при шаге или дополнении результат раскладывается по своим положениям
+void PointwiseConvBackwardInput(const Tensor &dout, const AlignedVector &packed, Tensor &dX, int P, int S) {
+	VolumeSize inputSize = dX.GetSize();
+	VolumeSize outputSize = dout.GetSize();
+
+	int fd = inputSize.deep;
+	int fc = outputSize.deep;
+	int rows = outputSize.height * outputSize.width;
+
+	if (P == 0 && S == 1) {
+		Gemm(dout.size() * rows, fd, fc, dout.Data(), fc, 1, packed.data(), fd, 1, 0, dX.Data(), fd);
+		return;
+	}
+
+	real *col = Im2colBuffer(dout.size() * rows * fd);
+	Gemm(dout.size() * rows, fd, fc, dout.Data(), fc, 1, packed.data(), fd, 1, 0, col, fd);
+
+	#pragma omp parallel for
+	for (size_t n = 0; n < dout.size(); n++) {
+		real *dx = dX[n].Data();
+
+		std::fill(dx, dx + dX.Total(), 0);
+		Col2im(col + n * rows * fd, inputSize, outputSize, 1, P, S, 1, dx);
+	}
+}
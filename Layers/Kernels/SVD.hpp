@@ -0,0 +1,218 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <algorithm>
+#include <stdexcept>
+
+#include "../../Entities/Real.hpp"
+#include "../../Entities/Matrix.hpp"
+#include "Gemm.hpp"
+
+#define SVD_MAX_SWEEPS 60 // максимальное число проходов по парам столбцов
+#define SVD_OVERSAMPLING 10 // дополнительные векторы при поиске подпространства наибольших сингулярных чисел
+#define SVD_POWER_ITERATIONS 4 // число степенных итераций при поиске подпространства
+
+// вращение Якоби пары столбцов x и y длины size, делающее их ортогональными; в z и w (длины count) применяется то же вращение
+// возвращает, понадобилось ли вращение (столбцы ещё не ортогональны с точностью tolerance)
+bool JacobiRotation(real *x, real *y, int size, real *z, real *w, int count, real tolerance) {
+	real alpha = 0;
+	real beta = 0;
+	real gamma = 0;
+
+	for (int i = 0; i < size; i++) {
+		alpha += x[i] * x[i];
+		beta += y[i] * y[i];
+		gamma += x[i] * y[i];
+	}
+
+	if (alpha == 0 || beta == 0 || fabs(gamma) <= tolerance * sqrt(alpha * beta))
+		return false;
+
+	real zeta = (beta - alpha) / (2 * gamma);
+	real t = (zeta >= 0 ? 1 : -1) / (fabs(zeta) + sqrt(1 + zeta * zeta));
+	real c = 1 / sqrt(1 + t * t);
+	real s = c * t;
+
+	for (int i = 0; i < size; i++) {
+		real xi = x[i];
+		x[i] = c * xi - s * y[i];
+		y[i] = s * xi + c * y[i];
+	}
+
+	for (int i = 0; i < count; i++) {
+		real zi = z[i];
+		z[i] = c * zi - s * w[i];
+		w[i] = s * zi + c * w[i];
+	}
+
+	return true;
+}
+
+// сингулярное разложение A (rows x cols) ~ U * diag(S) * V^T, где U - rows x rank, V - cols x rank, S - rank наибольших сингулярных чисел по убыванию
+// односторонний метод Якоби: столбцы G (A или A^T, чтобы столбцов было не больше, чем строк) вращаются попарно до ортогональности,
+// тогда их нормы - сингулярные числа, нормированные столбцы - сингулярные векторы одной стороны, а накопленные вращения - другой;
+// пары столбцов перебираются турами кругового турнира, пары одного тура не пересекаются и вращаются параллельно
+void JacobiSVD(const Matrix &A, int rank, Matrix &U, std::vector<real> &S, Matrix &V) {
+	int rows = A.Rows();
+	int cols = A.Cols();
+	bool transposed = rows < cols;
+	int size = transposed ? cols : rows; // длина столбцов G
+	int count = transposed ? rows : cols; // число столбцов G
+
+	if (rank < 1 || rank > count)
+		throw std::runtime_error("Invalid SVD rank");
+
+	std::vector<std::vector<real>> g(count, std::vector<real>(size)); // столбцы G
+	std::vector<std::vector<real>> rotations(count, std::vector<real>(count, 0)); // столбцы накопленных вращений J
+
+	for (int k = 0; k < count; k++) {
+		for (int i = 0; i < size; i++)
+			g[k][i] = transposed ? A(k, i) : A(i, k);
+
+		rotations[k][k] = 1;
+	}
+
+	int players = count + count % 2; // участники турнира (при нечётном числе столбцов один отдыхает)
+	std::vector<int> order(players);
+	std::iota(order.begin(), order.end(), 0);
+
+	real tolerance = std::numeric_limits<real>::epsilon() * count;
+	bool rotated = true;
+
+	for (int sweep = 0; sweep < SVD_MAX_SWEEPS && rotated; sweep++) {
+		rotated = false;
+
+		for (int round = 0; round < players - 1; round++) {
+			#pragma omp parallel for reduction(||:rotated)
+			for (int pair = 0; pair < players / 2; pair++) {
+				int first = std::min(order[pair], order[players - 1 - pair]);
+				int second = std::max(order[pair], order[players - 1 - pair]);
+
+				if (second < count && JacobiRotation(g[first].data(), g[second].data(), size, rotations[first].data(), rotations[second].data(), count, tolerance))
+					rotated = true;
+			}
+
+			std::rotate(order.begin() + 1, order.end() - 1, order.end()); // первый участник на месте, остальные сдвигаются по кругу
+		}
+	}
+
+	std::vector<std::pair<real, int>> norms(count); // минус норма столбца и его индекс, чтобы сортировка по возрастанию упорядочила нормы по убыванию
+
+	for (int k = 0; k < count; k++) {
+		real norm = 0;
+
+		for (int i = 0; i < size; i++)
+			norm += g[k][i] * g[k][i];
+
+		norms[k] = std::make_pair(-sqrt(norm), k);
+	}
+
+	std::sort(norms.begin(), norms.end());
+
+	U = Matrix(rows, rank);
+	V = Matrix(cols, rank);
+	S.assign(rank, 0);
+
+	for (int r = 0; r < rank; r++) {
+		int k = norms[r].second;
+		S[r] = -norms[r].first;
+
+		real scale = S[r] > 0 ? 1 / S[r] : 0;
+
+		// G = L * diag(S) * J^T: при G = A левые векторы A - нормированные столбцы G, правые - столбцы J, при G = A^T наоборот
+		for (int i = 0; i < size; i++) {
+			if (transposed)
+				V(i, r) = g[k][i] * scale;
+			else
+				U(i, r) = g[k][i] * scale;
+		}
+
+		for (int i = 0; i < count; i++) {
+			if (transposed)
+				U(i, r) = rotations[k][i];
+			else
+				V(i, r) = rotations[k][i];
+		}
+	}
+}
+
+// ортонормирование столбцов M модифицированным методом Грама-Шмидта (дважды для устойчивости), линейно зависимые столбцы обнуляются
+void OrthonormalizeColumns(Matrix &M) {
+	for (int k = 0; k < M.Cols(); k++) {
+		for (int pass = 0; pass < 2; pass++) {
+			for (int j = 0; j < k; j++) {
+				real dot = 0;
+
+				for (int i = 0; i < M.Rows(); i++)
+					dot += M(i, j) * M(i, k);
+
+				for (int i = 0; i < M.Rows(); i++)
+					M(i, k) -= dot * M(i, j);
+			}
+		}
+
+		real norm = 0;
+
+		for (int i = 0; i < M.Rows(); i++)
+			norm += M(i, k) * M(i, k);
+
+		real scale = norm > 0 ? 1 / sqrt(norm) : 0;
+
+		for (int i = 0; i < M.Rows(); i++)
+			M(i, k) *= scale;
+	}
+}
+
+// усечённое сингулярное разложение A (rows x cols) ~ U * diag(S) * V^T ранга rank
+// при ранге, близком к полному, раскладывается вся матрица, иначе сначала ищется ортонормированный базис Q (rows x l, l = rank + SVD_OVERSAMPLING)
+// подпространства наибольших сингулярных чисел: случайная проекция A * Omega, уточнённая степенными итерациями (A * A^T)^q;
+// тогда A ~ Q * Q^T * A, и методом Якоби раскладывается только малая матрица B = Q^T * A (l x cols): B = Ub * diag(S) * V^T, U = Q * Ub
+// (все произведения с A выполняются Gemm, поэтому стоимость O(rows * cols * l) вместо O(rows * cols * min(rows, cols)) на проход Якоби)
+void TruncatedSVD(const Matrix &A, int rank, Matrix &U, std::vector<real> &S, Matrix &V) {
+	int rows = A.Rows();
+	int cols = A.Cols();
+	int l = rank + SVD_OVERSAMPLING;
+
+	if (rank < 1 || rank > std::min(rows, cols))
+		throw std::runtime_error("Invalid SVD rank");
+
+	if (l >= std::min(rows, cols)) {
+		JacobiSVD(A, rank, U, S, V);
+		return;
+	}
+
+	std::default_random_engine generator;
+	std::normal_distribution<real> distribution(0.0, 1.0);
+
+	Matrix omega(cols, l);
+	Matrix Q(rows, l);
+	Matrix Z(cols, l);
+
+	for (int j = 0; j < cols; j++)
+		for (int k = 0; k < l; k++)
+			omega(j, k) = distribution(generator);
+
+	Gemm(rows, l, cols, A.Data(), cols, 1, omega.Data(), l, 1, 0, Q.Data(), l);
+	OrthonormalizeColumns(Q);
+
+	for (int iteration = 0; iteration < SVD_POWER_ITERATIONS; iteration++) {
+		Gemm(cols, l, rows, A.Data(), 1, cols, Q.Data(), l, 1, 0, Z.Data(), l); // Z = A^T * Q
+		OrthonormalizeColumns(Z);
+		Gemm(rows, l, cols, A.Data(), cols, 1, Z.Data(), l, 1, 0, Q.Data(), l); // Q = A * Z
+		OrthonormalizeColumns(Q);
+	}
+
+	Matrix B(l, cols);
+	Matrix Ub(l, rank);
+
+	Gemm(l, cols, rows, Q.Data(), 1, l, A.Data(), cols, 1, 0, B.Data(), cols); // B = Q^T * A
+	JacobiSVD(B, rank, Ub, S, V);
+
+	U = Matrix(rows, rank);
+	Gemm(rows, rank, l, Q.Data(), l, 1, Ub.Data(), rank, 1, 0, U.Data(), rank);
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <algorithm>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "../../Entities/Real.hpp"
+#include "../../Entities/AlignedAllocator.hpp"
+#include "../../Entities/SparseMatrix.hpp"
+
+#define SPARSE_BATCH_BLOCK 16 // примеров батча, обрабатываемых одним проходом по разреженной строке
+
+// разреженные умножения батча: строки батча упаковываются блоками по SPARSE_BATCH_BLOCK примеров так, что значения одного столбца
+// всех примеров блока лежат подряд, тогда каждое ненулевое значение умножается сразу на SPARSE_BATCH_BLOCK чисел одной векторной операцией
+
+// регистр из SPARSE_LANES вещественных чисел: суммы блока держатся в SPARSE_BATCH_BLOCK / SPARSE_LANES регистрах
+// (компилятор сам векторизует цикл по ненулевым значениям сборками по столбцам и держит суммы в памяти, что втрое медленнее)
+#if defined(__AVX512F__) && defined(USE_FLOAT)
+#define SPARSE_LANES 16
+typedef __m512 SparseRegister;
+inline SparseRegister SparseBroadcast(real value) { return _mm512_set1_ps(value); }
+inline SparseRegister SparseLoad(const real *x) { return _mm512_load_ps(x); }
+inline SparseRegister SparseFma(SparseRegister a, SparseRegister b, SparseRegister c) { return _mm512_fmadd_ps(a, b, c); }
+inline void SparseStore(real *x, SparseRegister value) { _mm512_store_ps(x, value); }
+inline real SparseReduce(SparseRegister value) { return _mm512_reduce_add_ps(value); }
+#elif defined(__AVX512F__)
+#define SPARSE_LANES 8
+typedef __m512d SparseRegister;
+inline SparseRegister SparseBroadcast(real value) { return _mm512_set1_pd(value); }
+inline SparseRegister SparseLoad(const real *x) { return _mm512_load_pd(x); }
+inline SparseRegister SparseFma(SparseRegister a, SparseRegister b, SparseRegister c) { return _mm512_fmadd_pd(a, b, c); }
+inline void SparseStore(real *x, SparseRegister value) { _mm512_store_pd(x, value); }
+inline real SparseReduce(SparseRegister value) { return _mm512_reduce_add_pd(value); }
+#elif defined(__AVX2__) && defined(__FMA__) && defined(USE_FLOAT)
+#define SPARSE_LANES 8
+typedef __m256 SparseRegister;
+inline SparseRegister SparseBroadcast(real value) { return _mm256_set1_ps(value); }
+inline SparseRegister SparseLoad(const real *x) { return _mm256_load_ps(x); }
+inline SparseRegister SparseFma(SparseRegister a, SparseRegister b, SparseRegister c) { return _mm256_fmadd_ps(a, b, c); }
+inline void SparseStore(real *x, SparseRegister value) { _mm256_store_ps(x, value); }
+inline real SparseReduce(SparseRegister value) {
+	__m128 sum = _mm_add_ps(_mm256_castps256_ps128(value), _mm256_extractf128_ps(value, 1));
+	sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+	return _mm_cvtss_f32(_mm_add_ss(sum, _mm_movehdup_ps(sum)));
+}
+#elif defined(__AVX2__) && defined(__FMA__)
+#define SPARSE_LANES 4
+typedef __m256d SparseRegister;
+inline SparseRegister SparseBroadcast(real value) { return _mm256_set1_pd(value); }
+inline SparseRegister SparseLoad(const real *x) { return _mm256_load_pd(x); }
+inline SparseRegister SparseFma(SparseRegister a, SparseRegister b, SparseRegister c) { return _mm256_fmadd_pd(a, b, c); }
+inline void SparseStore(real *x, SparseRegister value) { _mm256_store_pd(x, value); }
+inline real SparseReduce(SparseRegister value) {
+	__m128d sum = _mm_add_pd(_mm256_castpd256_pd128(value), _mm256_extractf128_pd(value, 1));
+	return _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+}
+#endif
+
+// sums[t] = сумма по ненулевым значениям k строки (по порядку) values[k] * x[columns[k] * SPARSE_BATCH_BLOCK + t]
+// порядок сложений у всех примеров блока один и тот же, поэтому результат примера не зависит от его места в блоке
+inline void SparseRowProduct(int begin, int end, const int *columns, const real *values, const real *x, real *sums) {
+#ifdef SPARSE_LANES
+	SparseRegister acc[SPARSE_BATCH_BLOCK / SPARSE_LANES];
+
+	for (int r = 0; r < SPARSE_BATCH_BLOCK / SPARSE_LANES; r++)
+		acc[r] = SparseBroadcast(0);
+
+	for (int k = begin; k < end; k++) {
+		const real *column = x + (size_t) columns[k] * SPARSE_BATCH_BLOCK;
+		SparseRegister value = SparseBroadcast(values[k]);
+
+		for (int r = 0; r < SPARSE_BATCH_BLOCK / SPARSE_LANES; r++)
+			acc[r] = SparseFma(value, SparseLoad(column + r * SPARSE_LANES), acc[r]);
+	}
+
+	for (int r = 0; r < SPARSE_BATCH_BLOCK / SPARSE_LANES; r++)
+		SparseStore(sums + r * SPARSE_LANES, acc[r]);
+#else
+	for (int t = 0; t < SPARSE_BATCH_BLOCK; t++)
+		sums[t] = 0;
+
+	for (int k = begin; k < end; k++) {
+		const real *column = x + (size_t) columns[k] * SPARSE_BATCH_BLOCK;
+
+		for (int t = 0; t < SPARSE_BATCH_BLOCK; t++)
+			sums[t] += values[k] * column[t];
+	}
+#endif
+}
+
+// упаковка N строк длины cols (через ld): packed[(block * cols + j) * SPARSE_BATCH_BLOCK + t] = X[block * SPARSE_BATCH_BLOCK + t][j],
+// недостающие примеры последнего блока дополняются нулями
+void SparsePackRows(const real *X, int N, int cols, int ld, AlignedVector &packed) {
+	int blocks = (N + SPARSE_BATCH_BLOCK - 1) / SPARSE_BATCH_BLOCK;
+
+	if (packed.size() < (size_t) blocks * cols * SPARSE_BATCH_BLOCK)
+		packed.resize((size_t) blocks * cols * SPARSE_BATCH_BLOCK);
+
+	#pragma omp parallel for collapse(2)
+	for (int block = 0; block < blocks; block++) {
+		for (int j = 0; j < cols; j++) {
+			real *dst = packed.data() + ((size_t) block * cols + j) * SPARSE_BATCH_BLOCK;
+			int count = std::min(SPARSE_BATCH_BLOCK, N - block * SPARSE_BATCH_BLOCK);
+
+			for (int t = 0; t < count; t++)
+				dst[t] = X[(size_t) (block * SPARSE_BATCH_BLOCK + t) * ld + j];
+
+			for (int t = count; t < SPARSE_BATCH_BLOCK; t++)
+				dst[t] = 0;
+		}
+	}
+}
+
+// Y (N x A.rows, строки через ldy) = X * A^T, X - N строк длины A.cols, упакованных SparsePackRows
+// выход примера не зависит от размера батча, так как его суммы считаются одинаково в любом блоке
+void SparseMultiply(const SparseMatrix &A, const real *packed, int N, real *Y, int ldy) {
+	int blocks = (N + SPARSE_BATCH_BLOCK - 1) / SPARSE_BATCH_BLOCK;
+
+	#pragma omp parallel for collapse(2)
+	for (int block = 0; block < blocks; block++) {
+		for (int i = 0; i < A.rows; i++) {
+			alignas(MEMORY_ALIGNMENT) real sums[SPARSE_BATCH_BLOCK];
+			SparseRowProduct(A.offsets[i], A.offsets[i + 1], A.columns.data(), A.values.data(), packed + (size_t) block * A.cols * SPARSE_BATCH_BLOCK, sums);
+
+			int count = std::min(SPARSE_BATCH_BLOCK, N - block * SPARSE_BATCH_BLOCK);
+
+			for (int t = 0; t < count; t++)
+				Y[(size_t) (block * SPARSE_BATCH_BLOCK + t) * ldy + i] = sums[t];
+		}
+	}
+}
+
+// сумма SPARSE_BATCH_BLOCK произведений d[t] * x[t]
+inline real SparseBlockDot(const real *d, const real *x) {
+#ifdef SPARSE_LANES
+	SparseRegister acc = SparseBroadcast(0);
+
+	for (int r = 0; r < SPARSE_BATCH_BLOCK / SPARSE_LANES; r++)
+		acc = SparseFma(SparseLoad(d + r * SPARSE_LANES), SparseLoad(x + r * SPARSE_LANES), acc);
+
+	return SparseReduce(acc);
+#else
+	real sum = 0;
+
+	for (int t = 0; t < SPARSE_BATCH_BLOCK; t++)
+		sum += d[t] * x[t];
+
+	return sum;
+#endif
+}
+
+// накопление градиентов ненулевых значений A: dValues[k] += сумма по примерам D[n][i] * X[n][j], где (i, j) - позиция k-го значения
+// D (N x A.rows) и X (N x A.cols) упакованы SparsePackRows, дополнение нулями в сумму не вносит ничего
+// блоки примеров обходятся снаружи, чтобы упакованный блок X оставался в кэше, пока через него проходят все строки A (строки делятся между потоками)
+void SparseGradients(const SparseMatrix &A, const real *packedD, const real *packedX, int N, real *dValues) {
+	int blocks = (N + SPARSE_BATCH_BLOCK - 1) / SPARSE_BATCH_BLOCK;
+
+	for (int block = 0; block < blocks; block++) {
+		const real *x = packedX + (size_t) block * A.cols * SPARSE_BATCH_BLOCK;
+
+		#pragma omp parallel for
+		for (int i = 0; i < A.rows; i++) {
+			const real *d = packedD + ((size_t) block * A.rows + i) * SPARSE_BATCH_BLOCK;
+
+			for (int k = A.offsets[i]; k < A.offsets[i + 1]; k++)
+				dValues[k] += SparseBlockDot(d, x + (size_t) A.columns[k] * SPARSE_BATCH_BLOCK);
+		}
+	}
+}
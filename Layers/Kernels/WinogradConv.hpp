@@ -0,0 +1,258 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include "../../Entities/Volume.hpp"
+#include "../../Entities/Tensor.hpp"
+#include "Gemm.hpp"
+
+#define WINOGRAD_MAX_TILE 6 // наибольший размер входного тайла (F(4x4, 3x3))
+
+// матрицы преобразований Винограда F(m x m, 3x3): Y = AT [(G g GT) * (BT d B)] A
+struct WinogradTiles {
+	int m; // размер выходного тайла
+	int alpha; // размер входного тайла (m + 2)
+
+	real BT[WINOGRAD_MAX_TILE][WINOGRAD_MAX_TILE]; // преобразование входа
+	real G[WINOGRAD_MAX_TILE][3]; // преобразование фильтра
+	real AT[WINOGRAD_MAX_TILE][WINOGRAD_MAX_TILE]; // обратное преобразование выхода
+};
+
+// получение матриц преобразований для выходного тайла m x m (2 или 4)
+WinogradTiles GetWinogradTiles(int m) {
+	WinogradTiles tiles = {};
+
+	if (m == 2) {
+		real BT[4][4] = { { 1, 0, -1, 0 }, { 0, 1, 1, 0 }, { 0, -1, 1, 0 }, { 0, 1, 0, -1 } };
+		real G[4][3] = { { 1, 0, 0 }, { 0.5, 0.5, 0.5 }, { 0.5, -0.5, 0.5 }, { 0, 0, 1 } };
+		real AT[2][4] = { { 1, 1, 1, 0 }, { 0, 1, -1, -1 } };
+
+		tiles.m = 2;
+		tiles.alpha = 4;
+
+		for (int i = 0; i < 4; i++) {
+			for (int j = 0; j < 4; j++)
+				tiles.BT[i][j] = BT[i][j];
+
+			for (int j = 0; j < 3; j++)
+				tiles.G[i][j] = G[i][j];
+		}
+
+		for (int i = 0; i < 2; i++)
+			for (int j = 0; j < 4; j++)
+				tiles.AT[i][j] = AT[i][j];
+	}
+	else if (m == 4) {
+		real BT[6][6] = { { 4, 0, -5, 0, 1, 0 }, { 0, -4, -4, 1, 1, 0 }, { 0, 4, -4, -1, 1, 0 }, { 0, -2, -1, 2, 1, 0 }, { 0, 2, -1, -2, 1, 0 }, { 0, 4, 0, -5, 0, 1 } };
+		real G[6][3] = { { 1.0 / 4, 0, 0 }, { -1.0 / 6, -1.0 / 6, -1.0 / 6 }, { -1.0 / 6, 1.0 / 6, -1.0 / 6 }, { 1.0 / 24, 1.0 / 12, 1.0 / 6 }, { 1.0 / 24, -1.0 / 12, 1.0 / 6 }, { 0, 0, 1 } };
+		real AT[4][6] = { { 1, 1, 1, 1, 1, 0 }, { 0, 1, -1, 2, -2, 0 }, { 0, 1, 1, 4, 4, 0 }, { 0, 1, -1, 8, -8, 1 } };
+
+		tiles.m = 4;
+		tiles.alpha = 6;
+
+		for (int i = 0; i < 6; i++) {
+			for (int j = 0; j < 6; j++)
+				tiles.BT[i][j] = BT[i][j];
+
+			for (int j = 0; j < 3; j++)
+				tiles.G[i][j] = G[i][j];
+		}
+
+		for (int i = 0; i < 4; i++)
+			for (int j = 0; j < 6; j++)
+				tiles.AT[i][j] = AT[i][j];
+	}
+	else {
+		throw std::runtime_error("Unsupported Winograd tile size");
+	}
+
+	return tiles;
+}
+
+// преобразование фильтров 3x3: U[a][b][o][i] = (G g[o][i] GT)[a][b]
+// при flip фильтры поворачиваются на 180 градусов и меняются местами входные и выходные каналы (свёртка для градиентов входа)
+void WinogradTransformFilters(const std::vector<Volume> &W, const WinogradTiles &tiles, bool flip, AlignedVector &U) {
+	int fc = W.size();
+	int fd = W[0].Deep();
+	int outputs = flip ? fd : fc;
+	int inputs = flip ? fc : fd;
+	int alpha = tiles.alpha;
+
+	if (U.size() != alpha * alpha * outputs * inputs)
+		U.resize(alpha * alpha * outputs * inputs);
+
+	#pragma omp parallel for collapse(2)
+	for (int o = 0; o < outputs; o++) {
+		for (int i = 0; i < inputs; i++) {
+			real g[3][3];
+			real tmp[WINOGRAD_MAX_TILE][3];
+
+			for (int k = 0; k < 3; k++)
+				for (int l = 0; l < 3; l++)
+					g[k][l] = flip ? W[i](o, 2 - k, 2 - l) : W[o](i, k, l);
+
+			for (int a = 0; a < alpha; a++)
+				for (int l = 0; l < 3; l++)
+					tmp[a][l] = tiles.G[a][0] * g[0][l] + tiles.G[a][1] * g[1][l] + tiles.G[a][2] * g[2][l];
+
+			for (int a = 0; a < alpha; a++)
+				for (int b = 0; b < alpha; b++)
+					U[((a * alpha + b) * outputs + o) * inputs + i] = tmp[a][0] * tiles.G[b][0] + tmp[a][1] * tiles.G[b][1] + tmp[a][2] * tiles.G[b][2];
+		}
+	}
+}
+
+// свёртка 3x3 с шагом 1 методом Винограда: output = conv(X, U) (+ bias), P - дополнение нулями
+// тайлы каждого примера преобразуются целиком, после чего для каждой из alpha^2 частот выполняется одно умножение матриц
+void WinogradConvForward(const Tensor &X, const AlignedVector &U, const real *bias, Tensor &output, int P, const WinogradTiles &tiles) {
+	VolumeSize inputSize = X.GetSize();
+	VolumeSize outputSize = output.GetSize();
+
+	int inputs = inputSize.deep;
+	int outputs = outputSize.deep;
+	int m = tiles.m;
+	int alpha = tiles.alpha;
+
+	int tilesH = (outputSize.height + m - 1) / m;
+	int tilesW = (outputSize.width + m - 1) / m;
+	int tilesCount = tilesH * tilesW;
+
+	#pragma omp parallel for
+	for (size_t n = 0; n < X.size(); n++) {
+		static thread_local AlignedVector V; // преобразованные тайлы входа [a][b][тайл][i]
+		static thread_local AlignedVector M; // произведения в области Винограда [a][b][тайл][o]
+		static thread_local AlignedVector buffer; // тайл входа или выхода [a][b][канал] и промежуточный результат
+
+		size_t sizeV = alpha * alpha * tilesCount * inputs;
+		size_t sizeM = alpha * alpha * tilesCount * outputs;
+		size_t sizeBuffer = 2 * alpha * alpha * std::max(inputs, outputs);
+
+		if (V.size() < sizeV)
+			V.resize(sizeV);
+
+		if (M.size() < sizeM)
+			M.resize(sizeM);
+
+		if (buffer.size() < sizeBuffer)
+			buffer.resize(sizeBuffer);
+
+		const real *x = X[n].Data();
+		real *y = output[n].Data();
+		real *d = buffer.data();
+		real *tmp = buffer.data() + alpha * alpha * std::max(inputs, outputs);
+
+		// преобразование входа: V = BT d B для всех каналов тайла сразу (каналы лежат подряд)
+		for (int t = 0; t < tilesCount; t++) {
+			int i0 = (t / tilesW) * m - P;
+			int j0 = (t % tilesW) * m - P;
+
+			for (int a = 0; a < alpha; a++) {
+				for (int b = 0; b < alpha; b++) {
+					real *dst = d + (a * alpha + b) * inputs;
+					int i = i0 + a;
+					int j = j0 + b;
+
+					if (i < 0 || i >= inputSize.height || j < 0 || j >= inputSize.width)
+						std::fill(dst, dst + inputs, 0);
+					else
+						std::copy(x + (i * inputSize.width + j) * inputs, x + (i * inputSize.width + j + 1) * inputs, dst);
+				}
+			}
+
+			for (int a = 0; a < alpha; a++) {
+				for (int b = 0; b < alpha; b++) {
+					real *dst = tmp + (a * alpha + b) * inputs;
+					std::fill(dst, dst + inputs, 0);
+
+					for (int k = 0; k < alpha; k++) {
+						real coef = tiles.BT[a][k];
+
+						if (coef == 0)
+							continue;
+
+						const real *src = d + (k * alpha + b) * inputs;
+
+						for (int c = 0; c < inputs; c++)
+							dst[c] += coef * src[c];
+					}
+				}
+			}
+
+			for (int a = 0; a < alpha; a++) {
+				for (int b = 0; b < alpha; b++) {
+					real *dst = V.data() + ((a * alpha + b) * tilesCount + t) * inputs;
+					std::fill(dst, dst + inputs, 0);
+
+					for (int k = 0; k < alpha; k++) {
+						real coef = tiles.BT[b][k];
+
+						if (coef == 0)
+							continue;
+
+						const real *src = tmp + (a * alpha + k) * inputs;
+
+						for (int c = 0; c < inputs; c++)
+							dst[c] += coef * src[c];
+					}
+				}
+			}
+		}
+
+		// поэлементное произведение по частотам с суммированием по каналам: M[ab] = V[ab] * U[ab]^T
+		for (int ab = 0; ab < alpha * alpha; ab++) {
+			const real *v = V.data() + ab * tilesCount * inputs;
+			const real *u = U.data() + ab * outputs * inputs;
+
+			Gemm(tilesCount, outputs, inputs, v, inputs, 1, u, 1, inputs, 0, M.data() + ab * tilesCount * outputs, outputs);
+		}
+
+		// обратное преобразование: Y = AT M A, выходящие за границу значения тайла отбрасываются
+		for (int t = 0; t < tilesCount; t++) {
+			int i0 = (t / tilesW) * m;
+			int j0 = (t % tilesW) * m;
+
+			for (int a = 0; a < m; a++) {
+				for (int b = 0; b < alpha; b++) {
+					real *dst = tmp + (a * alpha + b) * outputs;
+					std::fill(dst, dst + outputs, 0);
+
+					for (int k = 0; k < alpha; k++) {
+						real coef = tiles.AT[a][k];
+
+						if (coef == 0)
+							continue;
+
+						const real *src = M.data() + ((k * alpha + b) * tilesCount + t) * outputs;
+
+						for (int f = 0; f < outputs; f++)
+							dst[f] += coef * src[f];
+					}
+				}
+			}
+
+			for (int a = 0; a < m && i0 + a < outputSize.height; a++) {
+				for (int b = 0; b < m && j0 + b < outputSize.width; b++) {
+					real *dst = y + ((i0 + a) * outputSize.width + j0 + b) * outputs;
+
+					if (bias)
+						std::copy(bias, bias + outputs, dst);
+					else
+						std::fill(dst, dst + outputs, 0);
+
+					for (int k = 0; k < alpha; k++) {
+						real coef = tiles.AT[b][k];
+
+						if (coef == 0)
+							continue;
+
+						const real *src = tmp + (a * alpha + k) * outputs;
+
+						for (int f = 0; f < outputs; f++)
+							dst[f] += coef * src[f];
+					}
+				}
+			}
+		}
+	}
+}
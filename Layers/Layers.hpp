@@ -5,11 +5,16 @@
 #include "ConvLayer.hpp"
 #include "ConvWithoutStrideLayer.hpp"
 #include "ConvTransposedLayer.hpp"
+#include "GroupConvLayer.hpp"
 #include "MaxPoolingLayer.hpp"
 #include "AveragePoolingLayer.hpp"
 #include "UpscaleLayer.hpp"
 #include "UpscaleBilinearLayer.hpp"
 #include "FullyConnectedLayer.hpp"
+#include "QuantizedConvLayer.hpp"
+#include "QuantizedFullyConnectedLayer.hpp"
+#include "SparseFullyConnectedLayer.hpp"
+#include "LowRankFullyConnectedLayer.hpp"
 
 #include "ResidualLayer.hpp"
 #include "InceptionLayer.hpp"
@@ -36,6 +41,7 @@
 #include "Activations/SoftmaxLayer.hpp"
 
 #include "NetworkBlock.hpp"
+#include "LayoutLayer.hpp"
 
 #include "../Entities/ArgParser.hpp"
 
@@ -45,6 +51,10 @@ NetworkLayer* ParseConvLayer(VolumeSize size, ArgParser &parser) {
 	std::string fc = "";
 	std::string S = "1";
 	std::string P = "0";
+	std::string layout = "channels";
+	std::string algorithm = "auto";
+	std::string groups = "1";
+	std::string D = "1";
 
 	for (size_t i = 0; i < parser.size(); i++) {
 		std::string arg = parser[i];
@@ -58,9 +68,21 @@ NetworkLayer* ParseConvLayer(VolumeSize size, ArgParser &parser) {
 		else if (arg == "S") {
 			S = parser.Get(arg);
 		}
+		else if (arg == "dilation" || arg == "D") {
+			D = parser.Get(arg);
+		}
 		else if (arg == "padding" || arg == "P") {
 			P = parser.Get(arg);
 		}
+		else if (arg == "layout") {
+			layout = parser.Get(arg);
+		}
+		else if (arg == "algorithm") {
+			algorithm = parser.Get(arg);
+		}
+		else if (arg == "groups" || arg == "G") {
+			groups = parser.Get(arg);
+		}
 		else if (arg != "conv" && arg != "convolution")
 			throw std::runtime_error("Invalid conv argument '" + arg + "'");
 	}
@@ -71,6 +93,87 @@ NetworkLayer* ParseConvLayer(VolumeSize size, ArgParser &parser) {
 	if (fs == "")
 		throw std::runtime_error("Unable to add conv layer. Filters size is not set");
 
+	if (std::stoi(D) < 1)
+		throw std::runtime_error("Unable to add conv layer. Dilation must be positive");
+
+	int pad;
+	int extent = std::stoi(D) * (std::stoi(fs) - 1); // размер разреженного фильтра без единицы
+
+	if (P == "same") {
+		pad = extent / 2;
+	}
+	else if (P == "valid") {
+		pad = 0;
+	}
+	else if (P == "full") {
+		pad = extent;
+	}
+	else {
+		pad = std::stoi(P);
+	}
+
+	if (groups != "1") {
+		if (layout != "channels" || algorithm != "auto")
+			throw std::runtime_error("Unable to add conv layer. Layout and algorithm are not supported for grouped conv");
+
+		if (D != "1")
+			throw std::runtime_error("Unable to add conv layer. Dilation is not supported for grouped conv");
+
+		return new GroupConvLayer(size, std::stoi(fc), std::stoi(fs), pad, std::stoi(S), std::stoi(groups));
+	}
+
+	if (S == "1") {
+		ConvWithoutStrideLayer *layer = new ConvWithoutStrideLayer(size, std::stoi(fc), std::stoi(fs), pad, std::stoi(D));
+		layer->SetLayout(StringToLayout(layout));
+
+		if (algorithm == "auto")
+			layer->ChooseAlgorithm();
+		else
+			layer->SetAlgorithm(StringToConvAlgorithm(algorithm));
+
+		return layer;
+	}
+
+	ConvLayer *layer = new ConvLayer(size, std::stoi(fc), std::stoi(fs), pad, std::stoi(S), std::stoi(D));
+	layer->SetLayout(StringToLayout(layout));
+
+	if (algorithm == "auto")
+		layer->ChooseAlgorithm();
+	else
+		layer->SetAlgorithm(StringToConvAlgorithm(algorithm));
+
+	return layer;
+}
+
+// парсинг поканального свёрточного слоя
+NetworkLayer* ParseDepthwiseConvLayer(VolumeSize size, ArgParser &parser) {
+	std::string fs = "";
+	std::string S = "1";
+	std::string P = "0";
+	std::string multiplier = "1";
+
+	for (size_t i = 0; i < parser.size(); i++) {
+		std::string arg = parser[i];
+
+		if (arg == "filter_size" || arg == "fs") {
+			fs = parser.Get(arg);
+		}
+		else if (arg == "S") {
+			S = parser.Get(arg);
+		}
+		else if (arg == "padding" || arg == "P") {
+			P = parser.Get(arg);
+		}
+		else if (arg == "multiplier" || arg == "depth_multiplier") {
+			multiplier = parser.Get(arg);
+		}
+		else if (arg != "depthwiseconv" && arg != "depthwise")
+			throw std::runtime_error("Invalid depthwise conv argument '" + arg + "'");
+	}
+
+	if (fs == "")
+		throw std::runtime_error("Unable to add depthwise conv layer. Filters size is not set");
+
 	int pad;
 
 	if (P == "same") {
@@ -86,10 +189,7 @@ NetworkLayer* ParseConvLayer(VolumeSize size, ArgParser &parser) {
 		pad = std::stoi(P);
 	}
 
-	if (S == "1")
-		return new ConvWithoutStrideLayer(size, std::stoi(fc), std::stoi(fs), pad);
-
-	return new ConvLayer(size, std::stoi(fc), std::stoi(fs), pad, std::stoi(S));
+	return new GroupConvLayer(size, size.deep * std::stoi(multiplier), std::stoi(fs), pad, std::stoi(S), size.deep);
 }
 
 // парсинг свёрточного транспонированного слоя
@@ -211,6 +311,64 @@ NetworkLayer* ParseFullyConnectedLayer(VolumeSize size, ArgParser &parser) {
 	return new FullyConnectedLayer(size, std::stoi(outputs), type);
 }
 
+// парсинг разреженного полносвязного слоя (со случайной маской)
+NetworkLayer* ParseSparseFullyConnectedLayer(VolumeSize size, ArgParser &parser) {
+	std::string outputs = "";
+	std::string type = "none";
+	std::string sparsity = "0.9";
+
+	for (size_t i = 0; i < parser.size(); i++) {
+		std::string arg = parser[i];
+
+		if (arg == "outputs" || arg == "size") {
+			outputs = parser.Get(arg);
+		}
+		else if (arg == "activation") {
+			type = parser.Get(arg);
+		}
+		else if (arg == "sparsity") {
+			sparsity = parser.Get(arg);
+		}
+		else if (arg != "sparsefc")
+			throw std::runtime_error("Invalid sparsefc argument '" + arg + "'");
+	}
+
+	if (outputs == "")
+		throw std::runtime_error("Unable to add sparse full connected layer. Outputs is not set");
+
+	return new SparseFullyConnectedLayer(size, std::stoi(outputs), type, std::stod(sparsity));
+}
+
+NetworkLayer* ParseLowRankFullyConnectedLayer(VolumeSize size, ArgParser &parser) {
+	std::string outputs = "";
+	std::string rank = "";
+	std::string type = "none";
+
+	for (size_t i = 0; i < parser.size(); i++) {
+		std::string arg = parser[i];
+
+		if (arg == "outputs" || arg == "size") {
+			outputs = parser.Get(arg);
+		}
+		else if (arg == "rank") {
+			rank = parser.Get(arg);
+		}
+		else if (arg == "activation") {
+			type = parser.Get(arg);
+		}
+		else if (arg != "lowrankfc")
+			throw std::runtime_error("Invalid lowrankfc argument '" + arg + "'");
+	}
+
+	if (outputs == "")
+		throw std::runtime_error("Unable to add low rank full connected layer. Outputs is not set");
+
+	if (rank == "")
+		throw std::runtime_error("Unable to add low rank full connected layer. Rank is not set");
+
+	return new LowRankFullyConnectedLayer(size, std::stoi(outputs), std::stoi(rank), type);
+}
+
 // парсинг слоёв дропаута
 NetworkLayer* ParseDropoutLayers(VolumeSize size, ArgParser &parser) {
 	std::string p = "0.5";
@@ -355,6 +513,9 @@ NetworkLayer* CreateLayer(VolumeSize size, const std::string &layerConf) {
 	if (parser["conv"] || parser["convolution"]) {
 		layer = ParseConvLayer(size, parser);
 	}
+	else if (parser["depthwiseconv"] || parser["depthwise"]) {
+		layer = ParseDepthwiseConvLayer(size, parser);
+	}
 	else if (parser["convtransposed"] || parser["deconv"] || parser["deconvolution"]) {
 		layer = ParseConvTransposedLayer(size, parser);
 	}
@@ -367,6 +528,12 @@ NetworkLayer* CreateLayer(VolumeSize size, const std::string &layerConf) {
 	else if (parser["fc"] || parser["fullconnected"]) {
 		layer = ParseFullyConnectedLayer(size, parser);
 	}
+	else if (parser["sparsefc"]) {
+		layer = ParseSparseFullyConnectedLayer(size, parser);
+	}
+	else if (parser["lowrankfc"]) {
+		layer = ParseLowRankFullyConnectedLayer(size, parser);
+	}
 	else if (parser["residual"] || parser["res"]) {
 		layer = ParseResidualLayer(size, parser);
 	}
@@ -444,14 +611,44 @@ NetworkLayer* CreateLayer(VolumeSize size, const std::string &layerConf) {
 NetworkLayer* LoadLayer(VolumeSize size, const std::string &layerType, std::ifstream &f) {
 	NetworkLayer *layer = nullptr;
 
-	if (layerType == "conv" || layerType == "convolution") {
-		int fc, fs, P, S;
+	if (layerType == "conv" || layerType == "convolution" || layerType == "dilatedconv") {
+		int fc, fs, P, S, D = 1;
 		f >> fs >> fc >> P >> S;
+
+		if (layerType == "dilatedconv")
+			f >> D;
+
+		std::string layout, algorithm;
+		ReadConvOptions(f, layout, algorithm);
 		
-		if (S == 1)
-			layer = new ConvWithoutStrideLayer(size, fc, fs, P, f);
-		else
-			layer = new ConvLayer(size, fc, fs, P, S, f);
+		if (S == 1) {
+			ConvWithoutStrideLayer *conv = new ConvWithoutStrideLayer(size, fc, fs, P, D, f);
+			conv->SetLayout(StringToLayout(layout));
+
+			if (algorithm == "auto")
+				conv->ChooseAlgorithm();
+			else
+				conv->SetAlgorithm(StringToConvAlgorithm(algorithm));
+
+			layer = conv;
+		}
+		else {
+			ConvLayer *conv = new ConvLayer(size, fc, fs, P, S, D, f);
+			conv->SetLayout(StringToLayout(layout));
+
+			if (algorithm == "auto")
+				conv->ChooseAlgorithm();
+			else
+				conv->SetAlgorithm(StringToConvAlgorithm(algorithm));
+
+			layer = conv;
+		}
+	}
+	else if (layerType == "groupconv" || layerType == "depthwiseconv") {
+		int fc, fs, P, S, groups;
+		f >> fs >> fc >> P >> S >> groups;
+
+		layer = new GroupConvLayer(size, fc, fs, P, S, groups, f);
 	}
 	else if (layerType == "convtransposed" || layerType == "deconvolution") {
 		int fc, fs, P, S;
@@ -490,6 +687,20 @@ NetworkLayer* LoadLayer(VolumeSize size, const std::string &layerType, std::ifst
 
 		layer = new FullyConnectedLayer(size, outputs, type, f);
 	}
+	else if (layerType == "sparsefc") {
+		int outputs;
+		std::string type;
+		f >> outputs >> type;
+
+		layer = new SparseFullyConnectedLayer(size, outputs, type, f);
+	}
+	else if (layerType == "lowrankfc") {
+		int outputs, rank;
+		std::string type;
+		f >> outputs >> rank >> type;
+
+		layer = new LowRankFullyConnectedLayer(size, outputs, rank, type, f);
+	}
 	else if (layerType == "residual" || layerType == "res") {
 		int features;
 		f >> features;
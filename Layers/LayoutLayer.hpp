@@ -0,0 +1,78 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+
+#include "NetworkLayer.hpp"
+
+// слой преобразования расположения значений, вставляемый сетью между слоями с разными расположениями
+class LayoutLayer : public NetworkLayer {
+	Layout from; // исходное расположение
+	Layout to; // требуемое расположение
+
+	void Convert(const real *src, real *dst, Layout srcLayout) const; // преобразование одного примера
+
+public:
+	LayoutLayer(VolumeSize size, Layout from, Layout to);
+
+	Layout GetFrom() const; // исходное расположение
+	Layout GetTo() const; // требуемое расположение
+
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
+
+	void Save(std::ofstream &f) const; // сохранение слоя в файл
+};
+
+LayoutLayer::LayoutLayer(VolumeSize size, Layout from, Layout to) : NetworkLayer(size) {
+	if (from == Layout::Any || to == Layout::Any || from == to)
+		throw std::runtime_error("Invalid layout conversion");
+
+	this->from = from;
+	this->to = to;
+
+	name = "layout";
+	info = LayoutToString(from) + " -> " + LayoutToString(to);
+}
+
+// преобразование одного примера
+void LayoutLayer::Convert(const real *src, real *dst, Layout srcLayout) const {
+	if (srcLayout == Layout::Channels)
+		ChannelsToBlocked(src, dst, inputSize);
+	else
+		BlockedToChannels(src, dst, inputSize);
+}
+
+// исходное расположение
+Layout LayoutLayer::GetFrom() const {
+	return from;
+}
+
+// требуемое расположение
+Layout LayoutLayer::GetTo() const {
+	return to;
+}
+
+// прямое распространение
+void LayoutLayer::Forward(const Tensor &X) {
+	#pragma omp parallel for
+	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++)
+		Convert(X[batchIndex].Data(), output[batchIndex].Data(), from);
+}
+
+// обратное распространение
+void LayoutLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
+	if (!calc_dX)
+		return;
+
+	#pragma omp parallel for
+	for (size_t batchIndex = 0; batchIndex < dout.size(); batchIndex++)
+		Convert(dout[batchIndex].Data(), dX[batchIndex].Data(), to);
+}
+
+// сохранение слоя в файл (слой не сохраняется: сеть вставляет его сама при согласовании расположений)
+void LayoutLayer::Save(std::ofstream &f) const {
+
+}
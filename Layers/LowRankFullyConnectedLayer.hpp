@@ -0,0 +1,426 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <random>
+
+#include "NetworkLayer.hpp"
+#include "../Entities/Matrix.hpp"
+#include "Kernels/Gemm.hpp"
+#include "Kernels/FullyConnectedActivation.hpp"
+
+// полносвязный слой с весами ранга rank: W = U * V, U - outputs x rank, V - rank x inputs
+// выход считается через скрытый слой H = X * V^T (N x rank) без смещений и активации: Y = f(H * U^T + b), поэтому стоимость rank * (inputs + outputs) вместо inputs * outputs;
+// создаётся случайно или усечённым сингулярным разложением весов обученного полносвязного слоя
+class LowRankFullyConnectedLayer : public NetworkLayer {
+	std::default_random_engine generator;
+
+	int inputs;
+	int outputs;
+	int rank;
+
+	FullyConnectedActivation activationType; // тип активационной функции
+
+	Matrix U; // левый множитель весов
+	Matrix dU;
+	std::vector<Matrix> paramsU;
+
+	Matrix V; // правый множитель весов
+	Matrix dV;
+	std::vector<Matrix> paramsV;
+
+	AlignedVector packedU; // U^T, упакованная для умножения на скрытый батч
+	AlignedVector packedV; // V^T, упакованная для умножения на батч входов
+	bool packed; // соответствуют ли packedU и packedV текущим весам
+
+	std::vector<real> b; // смещения
+	std::vector<real> db;
+	std::vector<std::vector<real>> paramsb;
+
+	AlignedVector hidden; // скрытый батч H = X * V^T
+	AlignedVector dHidden; // градиенты скрытого батча
+	Tensor delta; // градиенты по взвешенным суммам нейронов (dout * f'(x), производная вычисляется по выходу)
+	Epilogue epilogue; // слитые с слоем при выводе активация и нормализация
+
+	void InitParams(); // инициализация параметров для обучения
+	void InitWeights(); // инициализация весовых коэффициентов
+	void LoadWeights(std::ifstream &f); // считывание весовых коэффициентов из файла
+	void UpdateInfo(); // обновление информации о слое
+
+	void WeightedSums(const Tensor &X); // взвешенные суммы батча без смещений через скрытый батч
+
+public:
+	LowRankFullyConnectedLayer(VolumeSize size, int outputs, int rank, const std::string &type);
+	LowRankFullyConnectedLayer(VolumeSize size, int outputs, int rank, const std::string &type, std::ifstream &f);
+	LowRankFullyConnectedLayer(VolumeSize size, const std::string &type, const Matrix &U, const Matrix &V, const std::vector<real> &b);
+
+	int GetTrainableParams() const; // получение количества обучаемых параметров
+
+	void ForwardOutput(const Tensor &X); // прямое распространение без вычисления производных
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
+	void UpdateWeights(const Optimizer &optimizer, bool trainable); // обновление весовых коэффициентов
+
+	bool FuseScaleShift(const std::vector<real> &scale, const std::vector<real> &shift); // встраивание преобразования выхода
+	bool FuseActivation(EpilogueActivation activation, real alpha); // встраивание активации выхода
+
+	void ResetCache(); // сброс параметров
+	void Save(std::ofstream &f) const; // сохранение слоя в файл
+	void SetBatchSize(int batchSize); // установка размера батча
+	void SetInferenceBatchSize(int batchSize); // установка размера батча для вывода без градиентов
+
+	void SetParam(int index, real weight); // установка веса по индексу
+	real GetParam(int index) const; // получение веса по индексу
+	real GetGradient(int index) const; // получение градиента веса по индексу
+	void ZeroGradient(int index); // обнуление градиента веса по индексу
+};
+
+LowRankFullyConnectedLayer::LowRankFullyConnectedLayer(VolumeSize size, int outputs, int rank, const std::string &type) : NetworkLayer(size, 1, 1, outputs), U(outputs, rank), dU(outputs, rank), V(rank, size.height * size.width * size.deep), dV(rank, size.height * size.width * size.deep), b(outputs, 0.01), db(outputs) {
+	if (rank < 1)
+		throw std::runtime_error("Rank must be positive");
+
+	this->inputs = size.height * size.width * size.deep;
+	this->outputs = outputs;
+	this->rank = rank;
+
+	activationType = StringToFullyConnectedActivation(type);
+
+	name = "lowrankfc";
+	packed = false;
+	InitWeights();
+	InitParams();
+	UpdateInfo();
+}
+
+LowRankFullyConnectedLayer::LowRankFullyConnectedLayer(VolumeSize size, int outputs, int rank, const std::string &type, std::ifstream &f) : NetworkLayer(size, 1, 1, outputs), U(outputs, rank), dU(outputs, rank), V(rank, size.height * size.width * size.deep), dV(rank, size.height * size.width * size.deep), b(outputs), db(outputs) {
+	if (rank < 1)
+		throw std::runtime_error("Rank must be positive");
+
+	this->inputs = size.height * size.width * size.deep;
+	this->outputs = outputs;
+	this->rank = rank;
+
+	activationType = StringToFullyConnectedActivation(type);
+
+	name = "lowrankfc";
+	packed = false;
+	LoadWeights(f);
+	InitParams();
+	UpdateInfo();
+}
+
+LowRankFullyConnectedLayer::LowRankFullyConnectedLayer(VolumeSize size, const std::string &type, const Matrix &U, const Matrix &V, const std::vector<real> &b) : NetworkLayer(size, 1, 1, U.Rows()), U(U), dU(U.Rows(), U.Cols()), V(V), dV(V.Rows(), V.Cols()), b(b), db(U.Rows()) {
+	this->inputs = size.height * size.width * size.deep;
+	this->outputs = U.Rows();
+	this->rank = U.Cols();
+
+	if (rank < 1 || V.Rows() != rank || V.Cols() != inputs || (int) b.size() != outputs)
+		throw std::runtime_error("Invalid low rank weights size");
+
+	activationType = StringToFullyConnectedActivation(type);
+
+	name = "lowrankfc";
+	packed = false;
+	InitParams();
+	UpdateInfo();
+}
+
+// инициализация параметров для обучения
+void LowRankFullyConnectedLayer::InitParams() {
+	for (int i = 0; i < OPTIMIZER_PARAMS_COUNT; i++) {
+		paramsU.push_back(Matrix(outputs, rank));
+		paramsV.push_back(Matrix(rank, inputs));
+		paramsb.push_back(std::vector<real>(outputs));
+	}
+}
+
+// инициализация весовых коэффициентов: V сохраняет дисперсию входа в скрытом слое, U даёт выходу ту же дисперсию, что у обычного слоя
+void LowRankFullyConnectedLayer::InitWeights() {
+	std::normal_distribution<real> distributionU(0.0, sqrt(2.0 / rank));
+	std::normal_distribution<real> distributionV(0.0, sqrt(1.0 / inputs));
+
+	for (int i = 0; i < outputs; i++)
+		for (int k = 0; k < rank; k++)
+			U(i, k) = distributionU(generator);
+
+	for (int k = 0; k < rank; k++)
+		for (int j = 0; j < inputs; j++)
+			V(k, j) = distributionV(generator);
+}
+
+// считывание весовых коэффициентов из файла: строки U со смещениями нейронов, затем строки V
+void LowRankFullyConnectedLayer::LoadWeights(std::ifstream &f) {
+	for (int i = 0; i < outputs; i++) {
+		for (int k = 0; k < rank; k++)
+			f >> U(i, k);
+
+		f >> b[i];
+	}
+
+	for (int k = 0; k < rank; k++)
+		for (int j = 0; j < inputs; j++)
+			f >> V(k, j);
+
+	if (!f)
+		throw std::runtime_error("Invalid low rank weights");
+}
+
+// обновление информации о слое
+void LowRankFullyConnectedLayer::UpdateInfo() {
+	info = std::to_string(outputs) + " neurons, rank: " + std::to_string(rank);
+
+	if (activationType != FullyConnectedActivation::None)
+		info += ", f: " + FullyConnectedActivationToString(activationType);
+
+	if (!epilogue.Empty())
+		info += ", epilogue: " + EpilogueToString(epilogue);
+}
+
+// получение количества обучаемых параметров
+int LowRankFullyConnectedLayer::GetTrainableParams() const {
+	return rank * (inputs + outputs) + outputs;
+}
+
+// взвешенные суммы батча без смещений: H (N x rank) = X * V^T, Y (N x outputs) = H * U^T
+void LowRankFullyConnectedLayer::WeightedSums(const Tensor &X) {
+	int batchSize = X.size();
+
+	if (!packed) {
+		GemmPackMatrix(inputs, rank, V.Data(), 1, inputs, packedV);
+		GemmPackMatrix(rank, outputs, U.Data(), 1, rank, packedU);
+		packed = true;
+	}
+
+	if (hidden.size() < (size_t) batchSize * rank)
+		hidden.resize((size_t) batchSize * rank);
+
+	GemmPacked(batchSize, rank, inputs, X.Data(), inputs, 1, packedV.data(), 0, hidden.data(), rank);
+	GemmPacked(batchSize, outputs, rank, hidden.data(), rank, 1, packedU.data(), 0, output.Data(), outputs);
+}
+
+// прямое распространение без вычисления производных (слитые активация и нормализация применяются сразу)
+void LowRankFullyConnectedLayer::ForwardOutput(const Tensor &X) {
+	int batchSize = X.size();
+	real *y = output.Data();
+
+	WeightedSums(X);
+
+	ActivateRows(activationType, b.data(), y, batchSize, outputs);
+
+	if (epilogue.Empty())
+		return;
+
+	#pragma omp parallel for collapse(2)
+	for (int batchIndex = 0; batchIndex < batchSize; batchIndex++)
+		for (int i = 0; i < outputs; i++)
+			y[batchIndex * outputs + i] = epilogue.Apply(y[batchIndex * outputs + i], i);
+}
+
+// прямое распространение
+void LowRankFullyConnectedLayer::Forward(const Tensor &X) {
+	int batchSize = X.size();
+	real *y = output.Data();
+
+	WeightedSums(X);
+
+	ActivateRows(activationType, b.data(), y, batchSize, outputs);
+}
+
+// обратное распространение: delta = dout * f'(x), dH (N x rank) = delta * U, dU += delta^T * H, dX = dH * V, dV += dH^T * X, db += сумма delta
+void LowRankFullyConnectedLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
+	int batchSize = dout.size();
+	real *d = delta.Data();
+
+	ActivationGradientRows(activationType, output.Data(), dout.Data(), d, batchSize, outputs);
+
+	if (dHidden.size() < (size_t) batchSize * rank)
+		dHidden.resize((size_t) batchSize * rank);
+
+	Gemm(batchSize, rank, outputs, d, outputs, 1, U.Data(), rank, 1, 0, dHidden.data(), rank);
+	Gemm(outputs, rank, batchSize, d, 1, outputs, hidden.data(), rank, 1, 1, dU.Data(), rank);
+
+	if (calc_dX)
+		Gemm(batchSize, inputs, rank, dHidden.data(), rank, 1, V.Data(), inputs, 1, 0, dX.Data(), inputs);
+
+	Gemm(rank, inputs, batchSize, dHidden.data(), 1, rank, X.Data(), inputs, 1, 1, dV.Data(), inputs);
+
+	#pragma omp parallel for
+	for (int i = 0; i < outputs; i++)
+		for (int batchIndex = 0; batchIndex < batchSize; batchIndex++)
+			db[i] += d[batchIndex * outputs + i];
+}
+
+// обновление весовых коэффициентов
+void LowRankFullyConnectedLayer::UpdateWeights(const Optimizer &optimizer, bool trainable) {
+	int batchSize = output.size();
+	packed = packed && !trainable;
+
+	#pragma omp parallel for
+	for (int i = 0; i < outputs; i++) {
+		for (int k = 0; k < rank; k++) {
+			if (trainable)
+				optimizer.Update(dU(i, k) / batchSize, paramsU[0](i, k), paramsU[1](i, k), paramsU[2](i, k), U(i, k));
+
+			dU(i, k) = 0;
+		}
+
+		if (trainable)
+			optimizer.Update(db[i] / batchSize, paramsb[0][i], paramsb[1][i], paramsb[2][i], b[i]);
+
+		db[i] = 0;
+	}
+
+	#pragma omp parallel for
+	for (int k = 0; k < rank; k++) {
+		for (int j = 0; j < inputs; j++) {
+			if (trainable)
+				optimizer.Update(dV(k, j) / batchSize, paramsV[0](k, j), paramsV[1](k, j), paramsV[2](k, j), V(k, j));
+
+			dV(k, j) = 0;
+		}
+	}
+}
+
+// встраивание преобразования выхода: без активации оно переносится в строки U и смещения, иначе добавляется в эпилог
+bool LowRankFullyConnectedLayer::FuseScaleShift(const std::vector<real> &scale, const std::vector<real> &shift) {
+	if ((int) scale.size() != outputs)
+		return false;
+
+	if (activationType != FullyConnectedActivation::None || !epilogue.Empty()) {
+		epilogue.AddScaleShift(scale, shift);
+		UpdateInfo();
+		return true;
+	}
+
+	for (int i = 0; i < outputs; i++) {
+		for (int k = 0; k < rank; k++)
+			U(i, k) *= scale[i];
+
+		b[i] = b[i] * scale[i] + shift[i];
+	}
+
+	packed = false;
+	return true;
+}
+
+// встраивание активации выхода (только если у слоя своей активации нет, а эпилог пуст)
+bool LowRankFullyConnectedLayer::FuseActivation(EpilogueActivation activation, real alpha) {
+	if (activationType != FullyConnectedActivation::None || !epilogue.Empty())
+		return false;
+
+	epilogue.activation = activation;
+	epilogue.alpha = alpha;
+	UpdateInfo();
+	return true;
+}
+
+// сброс параметров
+void LowRankFullyConnectedLayer::ResetCache() {
+	for (int index = 0; index < OPTIMIZER_PARAMS_COUNT; index++) {
+		for (int i = 0; i < outputs; i++) {
+			for (int k = 0; k < rank; k++)
+				paramsU[index](i, k) = 0;
+
+			paramsb[index][i] = 0;
+		}
+
+		for (int k = 0; k < rank; k++)
+			for (int j = 0; j < inputs; j++)
+				paramsV[index](k, j) = 0;
+	}
+}
+
+// сохранение слоя в файл
+void LowRankFullyConnectedLayer::Save(std::ofstream &f) const {
+	f << "lowrankfc " << inputSize << " " << outputs << " " << rank << " " << FullyConnectedActivationToString(activationType) << std::endl;
+
+	for (int i = 0; i < outputs; i++) {
+		for (int k = 0; k < rank; k++)
+			f << std::setprecision(15) << U(i, k) << " ";
+
+		f << std::setprecision(15) << b[i] << std::endl;
+	}
+
+	for (int k = 0; k < rank; k++) {
+		for (int j = 0; j < inputs; j++)
+			f << std::setprecision(15) << V(k, j) << " ";
+
+		f << std::endl;
+	}
+}
+
+// установка размера батча
+void LowRankFullyConnectedLayer::SetBatchSize(int batchSize) {
+	output.Resize(batchSize, outputSize);
+	delta.Resize(batchSize, outputSize);
+	dX.Resize(batchSize, inputSize);
+	hidden.resize((size_t) batchSize * rank);
+	dHidden.resize((size_t) batchSize * rank);
+}
+
+// установка размера батча для вывода без градиентов
+void LowRankFullyConnectedLayer::SetInferenceBatchSize(int batchSize) {
+	delta = Tensor();
+	dX = Tensor();
+	hidden.resize((size_t) batchSize * rank);
+	dHidden = AlignedVector();
+}
+
+// установка веса по индексу: сначала U по строкам, затем V по строкам, затем смещения
+void LowRankFullyConnectedLayer::SetParam(int index, real weight) {
+	if (index < outputs * rank) {
+		U(index / rank, index % rank) = weight;
+		packed = false;
+	}
+	else if (index < rank * (inputs + outputs)) {
+		index -= outputs * rank;
+		V(index / inputs, index % inputs) = weight;
+		packed = false;
+	}
+	else {
+		b[index - rank * (inputs + outputs)] = weight;
+	}
+}
+
+// получение веса по индексу
+real LowRankFullyConnectedLayer::GetParam(int index) const {
+	if (index < outputs * rank)
+		return U(index / rank, index % rank);
+
+	if (index < rank * (inputs + outputs)) {
+		index -= outputs * rank;
+		return V(index / inputs, index % inputs);
+	}
+
+	return b[index - rank * (inputs + outputs)];
+}
+
+// получение градиента веса по индексу
+real LowRankFullyConnectedLayer::GetGradient(int index) const {
+	if (index < outputs * rank)
+		return dU(index / rank, index % rank);
+
+	if (index < rank * (inputs + outputs)) {
+		index -= outputs * rank;
+		return dV(index / inputs, index % inputs);
+	}
+
+	return db[index - rank * (inputs + outputs)];
+}
+
+// обнуление градиента веса по индексу
+void LowRankFullyConnectedLayer::ZeroGradient(int index) {
+	if (index < outputs * rank) {
+		dU(index / rank, index % rank) = 0;
+	}
+	else if (index < rank * (inputs + outputs)) {
+		index -= outputs * rank;
+		dV(index / inputs, index % inputs) = 0;
+	}
+	else {
+		db[index - rank * (inputs + outputs)] = 0;
+	}
+}
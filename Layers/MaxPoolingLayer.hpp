@@ -4,6 +4,7 @@
 #include <fstream>
 #include <iomanip>
 #include <vector>
+#include <algorithm>
 
 #include "NetworkLayer.hpp"
 
@@ -16,8 +17,9 @@ class MaxPoolingLayer : public NetworkLayer {
 public:
 	MaxPoolingLayer(VolumeSize size, int scale = 2);
 
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	void ForwardOutput(const Tensor &X); // прямое распространение без запоминания максимумов
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
 
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
 };
@@ -41,8 +43,28 @@ MaxPoolingLayer::MaxPoolingLayer(VolumeSize size, int scale) : NetworkLayer(size
 		dj[i] = i / scale;
 }
 
+// прямое распространение без запоминания положений максимумов (при выводе градиенты не нужны)
+void MaxPoolingLayer::ForwardOutput(const Tensor &X) {
+	#pragma omp parallel for collapse(4)
+	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
+		for (int d = 0; d < inputSize.deep; d++) {
+			for (int i = 0; i < inputSize.height; i += scale) {
+				for (int j = 0; j < inputSize.width; j += scale) {
+					real max = X[batchIndex](d, i, j);
+
+					for (int y = i; y < i + scale; y++)
+						for (int x = j; x < j + scale; x++)
+							max = std::max(max, X[batchIndex](d, y, x));
+
+					output[batchIndex](d, di[i], dj[j]) = max;
+				}
+			}
+		}
+	}
+}
+
 // прямое распространение
-void MaxPoolingLayer::Forward(const std::vector<Volume> &X) {
+void MaxPoolingLayer::Forward(const Tensor &X) {
 	#pragma omp parallel for collapse(4)
 	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
 		for (int d = 0; d < inputSize.deep; d++) {
@@ -50,11 +72,11 @@ void MaxPoolingLayer::Forward(const std::vector<Volume> &X) {
 				for (int j = 0; j < inputSize.width; j += scale) {
 					int imax = i;
 					int jmax = j;
-					double max = X[batchIndex](d, i, j);
+					real max = X[batchIndex](d, i, j);
 
 					for (int y = i; y < i + scale; y++) {
 						for (int x = j; x < j + scale; x++) {
-							double value = X[batchIndex](d, y, x);
+							real value = X[batchIndex](d, y, x);
 							dX[batchIndex](d, y, x) = 0;
 
 							if (value > max) {
@@ -74,7 +96,7 @@ void MaxPoolingLayer::Forward(const std::vector<Volume> &X) {
 }
 
 // обратное распространение
-void MaxPoolingLayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
+void MaxPoolingLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
 	if (!calc_dX)
 		return;
 
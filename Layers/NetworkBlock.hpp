@@ -38,6 +38,8 @@ class NetworkBlock : public NetworkLayer {
 	std::vector<std::vector<NetworkLayer *>> blocks;
 	MergeType type;
 
+	std::vector<Tensor> douts; // градиенты ветвей при объединении стеком
+
 	void MergeSum();
 	void MergeStack();
 
@@ -55,18 +57,21 @@ public:
 	void PrintConfig() const;
 	int GetTrainableParams() const; // получение количества обучаемых параметров
 
-	void ForwardOutput(const std::vector<Volume> &X); // прямое распространение
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	void ForwardOutput(const Tensor &X); // прямое распространение
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
 	void UpdateWeights(const Optimizer &optimizer, bool trainable); // обновление весовых коэффициентов
 
 	void ResetCache();
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
 	void SetBatchSize(int batchSize); // установка размера батча
+	void SetInferenceBatchSize(int batchSize); // установка размера батча для вывода без градиентов
+	int PlanInference(InferencePlan &plan, int input); // добавление слоёв ветвей и объединения в план вывода
+	int Autotune(AutotuneCache &cache, int batchSize, bool training); // подбор алгоритмов слоёв ветвей
 
-	void SetParam(int index, double weight); // установка веса по индексу
-	double GetParam(int index) const; // получение веса по индексу
-	double GetGradient(int index) const; // получение градиента веса по индексу
+	void SetParam(int index, real weight); // установка веса по индексу
+	real GetParam(int index) const; // получение веса по индексу
+	real GetGradient(int index) const; // получение градиента веса по индексу
 	void ZeroGradient(int index); // обнуление градиента веса по индексу
 };
 
@@ -111,7 +116,7 @@ void NetworkBlock::MergeSum() {
 	#pragma omp parallel for collapse(2)
 	for (size_t batchIndex = 0; batchIndex < output.size(); batchIndex++) {
 		for (int i = 0; i < total; i++) {
-			double sum = 0;
+			real sum = 0;
 
 			for (size_t j = 0; j < blocks.size(); j++)
 				sum += blocks[j][blocks[j].size() - 1]->GetOutput()[batchIndex][i];
@@ -129,7 +134,7 @@ void NetworkBlock::MergeStack() {
 		NetworkLayer *layer = blocks[index][blocks[index].size() - 1];
 
 		int deep = layer->GetOutputSize().deep;
-		std::vector<Volume> &out = layer->GetOutput();
+		Tensor &out = layer->GetOutput();
 
 		#pragma omp parallel for collapse(4)
 		for (size_t batchIndex = 0; batchIndex < output.size(); batchIndex++)
@@ -166,6 +171,9 @@ void NetworkBlock::AddLayer(int index, NetworkLayer* layer) {
 	if (index < 0 || index >= blocks.size())
 		throw std::runtime_error("Invalid index for inserting layer");
 
+	if (layer->GetLayout() == Layout::Blocked)
+		throw std::runtime_error("Blocked layout is not supported inside blocks");
+
 	blocks[index].push_back(layer);
 }
 
@@ -238,7 +246,7 @@ int NetworkBlock::GetTrainableParams() const {
 }
 
 // прямое распространение
-void NetworkBlock::ForwardOutput(const std::vector<Volume> &X) {
+void NetworkBlock::ForwardOutput(const Tensor &X) {
 	for (size_t i = 0; i < blocks.size(); i++) {
 		blocks[i][0]->ForwardOutput(X);
 
@@ -255,7 +263,7 @@ void NetworkBlock::ForwardOutput(const std::vector<Volume> &X) {
 }
 
 // прямое распространение
-void NetworkBlock::Forward(const std::vector<Volume> &X) {
+void NetworkBlock::Forward(const Tensor &X) {
 	for (size_t i = 0; i < blocks.size(); i++) {
 		blocks[i][0]->Forward(X);
 
@@ -272,7 +280,7 @@ void NetworkBlock::Forward(const std::vector<Volume> &X) {
 }
 
 // обратное распространение
-void NetworkBlock::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
+void NetworkBlock::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
 	if (type == MergeType::Sum) {
 		for (size_t i = 0; i < blocks.size(); i++) {
 			int last = blocks[i].size() - 1;
@@ -297,22 +305,22 @@ void NetworkBlock::Backward(const std::vector<Volume> &dout, const std::vector<V
 			NetworkLayer *layer = blocks[index][blocks[index].size() - 1];
 
 			int deep = layer->GetOutputSize().deep;
-			std::vector<Volume> douts(dout.size(), Volume(outputSize.width, outputSize.height, deep));
+			Tensor &deltas = douts[index];
 
 			#pragma omp parallel for collapse(4)
 			for (size_t batchIndex = 0; batchIndex < dout.size(); batchIndex++)
 				for (int i = 0; i < outputSize.height; i++)
 					for (int j = 0; j < outputSize.width; j++)
 						for (int k = 0; k < deep; k++)
-							douts[batchIndex](k, i, j) = dout[batchIndex](current + k, i, j);
+							deltas[batchIndex](k, i, j) = dout[batchIndex](current + k, i, j);
 
 			int last = blocks[index].size() - 1;
 
 			if (last == 0) {
-				blocks[index][0]->Backward(douts, X, true);
+				blocks[index][0]->Backward(deltas, X, true);
 			}
 			else {
-				blocks[index][last]->Backward(douts, blocks[index][last - 1]->GetOutput(), true);
+				blocks[index][last]->Backward(deltas, blocks[index][last - 1]->GetOutput(), true);
 
 				for (int i = last - 1; i > 0; i--)
 					blocks[index][i]->Backward(blocks[index][i + 1]->GetDeltas(), blocks[index][i - 1]->GetOutput(), true);
@@ -332,7 +340,7 @@ void NetworkBlock::Backward(const std::vector<Volume> &dout, const std::vector<V
 	#pragma omp parallel for collapse(2)
 	for (size_t batchIndex = 0; batchIndex < dout.size(); batchIndex++) {
 		for (int i = 0; i < totalInput; i++) {
-			double sum = 0;
+			real sum = 0;
 
 			for (size_t index = 0; index < blocks.size(); index++)
 				sum += blocks[index][0]->GetDeltas()[batchIndex][i];
@@ -369,16 +377,56 @@ void NetworkBlock::Save(std::ofstream &f) const {
 
 // установка размера батча
 void NetworkBlock::SetBatchSize(int batchSize) {
-	output = std::vector<Volume>(batchSize, Volume(outputSize));
-	dX = std::vector<Volume>(batchSize, Volume(inputSize));
+	output.Resize(batchSize, outputSize);
+	dX.Resize(batchSize, inputSize);
 
 	for (size_t i = 0; i < blocks.size(); i++)
 		for (size_t j = 0; j < blocks[i].size(); j++)
 			blocks[i][j]->SetBatchSize(batchSize);
+
+	if (type == MergeType::Stack) {
+		douts.resize(blocks.size());
+
+		for (size_t i = 0; i < blocks.size(); i++)
+			douts[i].Resize(batchSize, blocks[i][blocks[i].size() - 1]->GetOutputSize());
+	}
+}
+
+// установка размера батча для вывода без градиентов (слои ветвей готовит и размещает планировщик сети)
+void NetworkBlock::SetInferenceBatchSize(int batchSize) {
+	dX = Tensor();
+	douts.clear();
+}
+
+// добавление слоёв ветвей и объединения в план вывода (вход блока живёт, пока его не прочитают все ветви)
+int NetworkBlock::PlanInference(InferencePlan &plan, int input) {
+	std::vector<int> outputs;
+
+	for (size_t i = 0; i < blocks.size(); i++) {
+		int value = input;
+
+		for (size_t j = 0; j < blocks[i].size(); j++)
+			value = blocks[i][j]->PlanInference(plan, value);
+
+		outputs.push_back(value);
+	}
+
+	return plan.AddLayer(this, outputs, outputSize.width * outputSize.height * outputSize.deep);
+}
+
+// подбор самых быстрых алгоритмов слоёв ветвей замерами
+int NetworkBlock::Autotune(AutotuneCache &cache, int batchSize, bool training) {
+	int measured = 0;
+
+	for (size_t i = 0; i < blocks.size(); i++)
+		for (size_t j = 0; j < blocks[i].size(); j++)
+			measured += blocks[i][j]->Autotune(cache, batchSize, training);
+
+	return measured;
 }
 
 // установка веса по индексу
-void NetworkBlock::SetParam(int index, double weight) {
+void NetworkBlock::SetParam(int index, real weight) {
 	int count = 0;
 
 	for (size_t i = 0; i < blocks.size(); i++) {
@@ -396,7 +444,7 @@ void NetworkBlock::SetParam(int index, double weight) {
 }
 
 // получение веса по индексу
-double NetworkBlock::GetParam(int index) const {
+real NetworkBlock::GetParam(int index) const {
 	int count = 0;
 
 	for (size_t i = 0; i < blocks.size(); i++) {
@@ -414,7 +462,7 @@ double NetworkBlock::GetParam(int index) const {
 }
 
 // получение градиента веса по индексу
-double NetworkBlock::GetGradient(int index) const {
+real NetworkBlock::GetGradient(int index) const {
 	int count = 0;
 
 	for (size_t i = 0; i < blocks.size(); i++) {
@@ -5,6 +5,12 @@
 #include <vector>
 
 #include "../Entities/Volume.hpp"
+#include "../Entities/Tensor.hpp"
+#include "../Entities/Layout.hpp"
+#include "../Entities/Epilogue.hpp"
+#include "../Entities/InferencePlan.hpp"
+#include "../Entities/AutotuneCache.hpp"
+#include "../Entities/Quantization.hpp"
 #include "../Entities/Optimizers.hpp"
 
 class NetworkLayer {
@@ -15,35 +21,51 @@ protected:
 	std::string name; // имя слоя
 	std::string info; // информация о слое
 
-	std::vector<Volume> output;
-	std::vector<Volume> dX;
+	Tensor output;
+	Tensor dX;
 
 public:
 	NetworkLayer(VolumeSize inputSize, int outputWidth, int outputHeight, int outputDeep);
 	NetworkLayer(VolumeSize size, VolumeSize newSize);
 	NetworkLayer(VolumeSize size);
+	virtual ~NetworkLayer() {}
 
 	VolumeSize GetInputSize() const; // получение размера входа слоя
 	VolumeSize GetOutputSize() const; // получение размера выхода слоя
 
-	std::vector<Volume>& GetOutput();
-	std::vector<Volume>& GetDeltas();
+	Tensor& GetOutput();
+	Tensor& GetDeltas();
+	int GetBatchSize() const; // текущий размер батча
 
 	virtual void PrintConfig() const; // вывод параметров слоя	
 	virtual int GetTrainableParams() const; // получение количества обучаемых параметров
+	virtual Layout GetLayout() const; // расположение входа и выхода слоя
+	virtual bool AliasesInput() const; // ссылается ли выход слоя на вход при выводе
 
-	virtual void ForwardOutput(const std::vector<Volume> &X); // прямое распространение
-	virtual void Forward(const std::vector<Volume> &X) = 0; // прямое распространение
-	virtual void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) = 0; // обратное распространение
+	virtual bool GetScaleShift(std::vector<real> &scale, std::vector<real> &shift) const { return false; } // представление слоя при выводе поканальным преобразованием scale * x + shift
+	virtual bool GetActivation(EpilogueActivation &activation, real &alpha) const { return false; } // представление слоя при выводе активацией эпилога
+	virtual bool FuseScaleShift(const std::vector<real> &scale, const std::vector<real> &shift) { return false; } // встраивание поканального преобразования выхода в слой
+	virtual bool FuseActivation(EpilogueActivation activation, real alpha) { return false; } // встраивание активации выхода в слой
+
+	virtual void ForwardOutput(const Tensor &X); // прямое распространение
+	virtual void Forward(const Tensor &X) = 0; // прямое распространение
+	virtual void Backward(const Tensor &dout, const Tensor &X, bool calc_dX) = 0; // обратное распространение
 	virtual void UpdateWeights(const Optimizer &optimizer, bool trainable) {} // обновление весовых коэффициентов
 	
 	virtual void ResetCache() {}
 	virtual void Save(std::ofstream &f) const = 0; // сохранение слоя в файл
 	virtual void SetBatchSize(int batchSize); // установка размера батча
-
-	virtual void SetParam(int index, double weight) { throw std::runtime_error("Layer has no trainable parameters"); } // установка веса по индексу
-	virtual double GetParam(int index) const { throw std::runtime_error("Layer has no trainable parameters"); } // получение веса по индексу
-	virtual double GetGradient(int index) const { throw std::runtime_error("Layer has no trainable parameters"); } // получение градиента веса по индексу
+	virtual void SetInferenceBatchSize(int batchSize); // установка размера батча для вывода без градиентов
+	void SetOutputBuffer(real *data, int batchSize); // размещение выхода слоя во внешнем буфере
+	virtual int PlanInference(InferencePlan &plan, int input); // добавление слоя в план вывода
+	virtual int Autotune(AutotuneCache &cache, int batchSize, bool training) { return 0; } // подбор самого быстрого алгоритма замерами на батче (возвращает количество замеренных слоёв)
+	virtual NetworkLayer* Quantize(const QuantizationParams &input) const { return nullptr; } // квантованная копия слоя для вывода по параметрам квантования входа (nullptr, если слой не квантуется)
+	virtual NetworkLayer* Prune(real sparsity) const { return nullptr; } // разреженная копия слоя без доли sparsity наименьших по модулю весов (nullptr, если слой не прореживается)
+	virtual NetworkLayer* Factorize(int rank) const { return nullptr; } // копия слоя с весами ранга rank по усечённому сингулярному разложению (nullptr, если слой не раскладывается)
+
+	virtual void SetParam(int index, real weight) { throw std::runtime_error("Layer has no trainable parameters"); } // установка веса по индексу
+	virtual real GetParam(int index) const { throw std::runtime_error("Layer has no trainable parameters"); } // получение веса по индексу
+	virtual real GetGradient(int index) const { throw std::runtime_error("Layer has no trainable parameters"); } // получение градиента веса по индексу
 	virtual void ZeroGradient(int index) { throw std::runtime_error("Layer has no trainable parameters"); } // обнуление градиента веса по индексу
 };
 
@@ -87,14 +109,19 @@ VolumeSize NetworkLayer::GetOutputSize() const {
 	return outputSize;
 }
 
-std::vector<Volume>& NetworkLayer::GetOutput() {
+Tensor& NetworkLayer::GetOutput() {
 	return output;
 }
 
-std::vector<Volume>& NetworkLayer::GetDeltas() {
+Tensor& NetworkLayer::GetDeltas() {
 	return dX;
 }
 
+// текущий размер батча (буферы слоя могут быть выделены и под больший батч)
+int NetworkLayer::GetBatchSize() const {
+	return output.size();
+}
+
 // вывод параметров слоя
 void NetworkLayer::PrintConfig() const {
 	std::cout << "| " << std::left << std::setw(16) << name << " | ";
@@ -109,15 +136,43 @@ int NetworkLayer::GetTrainableParams() const {
 	return 0;
 }
 
+// расположение входа и выхода слоя
+Layout NetworkLayer::GetLayout() const {
+	return Layout::Channels;
+}
+
+// ссылается ли выход слоя на вход при выводе (такой слой не копирует значения и не занимает памяти под выход)
+bool NetworkLayer::AliasesInput() const {
+	return false;
+}
+
 // прямое распространение
-void NetworkLayer::ForwardOutput(const std::vector<Volume> &X) {
+void NetworkLayer::ForwardOutput(const Tensor &X) {
 	Forward(X);
 }
 
 // установка размера батча
 void NetworkLayer::SetBatchSize(int batchSize) {
-	output = std::vector<Volume>(batchSize, Volume(outputSize));
-	dX = std::vector<Volume>(batchSize, Volume(inputSize));
+	output.Resize(batchSize, outputSize);
+	dX.Resize(batchSize, inputSize);
+}
+
+// установка размера батча для вывода: выход размещает планировщик сети, а градиенты по входу не нужны и освобождаются
+void NetworkLayer::SetInferenceBatchSize(int batchSize) {
+	dX = Tensor();
+}
+
+// размещение выхода слоя во внешнем буфере (буфер принадлежит сети и должен вмещать batchSize выходов)
+void NetworkLayer::SetOutputBuffer(real *data, int batchSize) {
+	output.Alias(data, batchSize, outputSize);
+}
+
+// добавление слоя в план вывода, возвращает значение, в котором окажется выход слоя
+int NetworkLayer::PlanInference(InferencePlan &plan, int input) {
+	if (AliasesInput())
+		return input; // выход ссылается на вход и памяти не занимает
+
+	return plan.AddLayer(this, {input}, outputSize.width * outputSize.height * outputSize.deep);
 }
 
 // загрузка слоя из файла
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+
+#include "NetworkLayer.hpp"
+#include "Kernels/Int8Gemm.hpp"
+#include "Kernels/Int8Conv.hpp"
+
+// квантованная свёртка для вывода: int8 фильтры с масштабом на каждый фильтр и uint8 вход с масштабом и нулевой точкой из калибровки
+// создаётся из обученной свёртки (вместе с её эпилогом) методом Quantize, обучать и сохранять её нельзя
+class QuantizedConvLayer : public NetworkLayer {
+	int P; // дополнение нулями
+	int S; // шаг свёртки
+	int D; // разрежение фильтра
+
+	int fc; // количество фильтров
+	int fs; // размер фильтров
+	int fd; // глубина фильтров
+
+	QuantizationParams input; // квантование входа
+	Int8Weights weights; // квантованные фильтры
+	std::vector<real> multipliers; // множители перевода сумм в значения
+	std::vector<real> offsets; // сдвиги перевода сумм в значения (смещения с поправкой на нулевую точку)
+	Epilogue epilogue; // активация и нормализация исходной свёртки
+
+public:
+	QuantizedConvLayer(VolumeSize inputSize, VolumeSize outputSize, const std::vector<Volume> &W, const std::vector<real> &b, int P, int S, int D, const Epilogue &epilogue, const QuantizationParams &input);
+
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
+
+	void Save(std::ofstream &f) const; // сохранение слоя в файл
+	void SetBatchSize(int batchSize); // установка размера батча
+};
+
+QuantizedConvLayer::QuantizedConvLayer(VolumeSize inputSize, VolumeSize outputSize, const std::vector<Volume> &W, const std::vector<real> &b, int P, int S, int D, const Epilogue &epilogue, const QuantizationParams &input) : NetworkLayer(inputSize, outputSize) {
+	this->P = P;
+	this->S = S;
+	this->D = D;
+
+	this->fc = W.size();
+	this->fs = W[0].Width();
+	this->fd = W[0].Deep();
+
+	this->input = input;
+	this->epilogue = epilogue;
+
+	int total = fs * fs * fd;
+	std::vector<real> filters(fc * total);
+
+	for (int f = 0; f < fc; f++)
+		std::copy(W[f].Data(), W[f].Data() + total, filters.begin() + f * total);
+
+	QuantizeWeights(filters.data(), fc, total, weights);
+	GetDequantization(weights, input, b, multipliers, offsets);
+
+	name = "qconv";
+	info = std::to_string(fc) + " filters [" + std::to_string(fs) + "x" + std::to_string(fs) + "x" + std::to_string(fd) + "] P:" + std::to_string(P) + " S:" + std::to_string(S);
+
+	if (D > 1)
+		info += " D:" + std::to_string(D);
+
+	info += " int8";
+
+	if (!epilogue.Empty())
+		info += " epilogue: " + EpilogueToString(epilogue);
+}
+
+// прямое распространение
+void QuantizedConvLayer::Forward(const Tensor &X) {
+	Int8ConvForward(X, weights, input, multipliers, offsets, epilogue, output, fs, P, S, D);
+}
+
+// обратное распространение
+void QuantizedConvLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
+	throw std::runtime_error("Quantized layers support inference only");
+}
+
+// сохранение слоя в файл
+void QuantizedConvLayer::Save(std::ofstream &f) const {
+	throw std::runtime_error("Quantized layers can not be saved");
+}
+
+// установка размера батча (градиенты по входу не нужны)
+void QuantizedConvLayer::SetBatchSize(int batchSize) {
+	output.Resize(batchSize, outputSize);
+}
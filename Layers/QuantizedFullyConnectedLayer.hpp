@@ -0,0 +1,76 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+
+#include "NetworkLayer.hpp"
+#include "Kernels/Int8Gemm.hpp"
+#include "Kernels/Int8Conv.hpp"
+
+// квантованный полносвязный слой для вывода: int8 веса с масштабом на каждый нейрон и uint8 вход с масштабом и нулевой точкой из калибровки
+// весь батч квантуется в строки и умножается на веса одним int8 умножением матриц
+class QuantizedFullyConnectedLayer : public NetworkLayer {
+	int inputs;
+	int outputs;
+
+	QuantizationParams input; // квантование входа
+	Int8Weights weights; // квантованные веса
+	std::vector<real> multipliers; // множители перевода сумм в значения
+	std::vector<real> offsets; // сдвиги перевода сумм в значения (смещения с поправкой на нулевую точку)
+	Epilogue epilogue; // активация и нормализация исходного слоя
+
+public:
+	QuantizedFullyConnectedLayer(VolumeSize size, int outputs, const std::vector<real> &W, const std::vector<real> &b, const Epilogue &epilogue, const QuantizationParams &input);
+
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
+
+	void Save(std::ofstream &f) const; // сохранение слоя в файл
+	void SetBatchSize(int batchSize); // установка размера батча
+};
+
+QuantizedFullyConnectedLayer::QuantizedFullyConnectedLayer(VolumeSize size, int outputs, const std::vector<real> &W, const std::vector<real> &b, const Epilogue &epilogue, const QuantizationParams &input) : NetworkLayer(size, 1, 1, outputs) {
+	this->inputs = size.height * size.width * size.deep;
+	this->outputs = outputs;
+	this->input = input;
+	this->epilogue = epilogue;
+
+	QuantizeWeights(W.data(), outputs, inputs, weights);
+	GetDequantization(weights, input, b, multipliers, offsets);
+
+	name = "qfc";
+	info = std::to_string(outputs) + " neurons, int8";
+
+	if (!epilogue.Empty())
+		info += ", epilogue: " + EpilogueToString(epilogue);
+}
+
+// прямое распространение
+void QuantizedFullyConnectedLayer::Forward(const Tensor &X) {
+	int cols = weights.paddedDepth;
+	uint8_t *q = QuantizedBuffer(X.size() * cols);
+
+	#pragma omp parallel for
+	for (size_t n = 0; n < X.size(); n++) {
+		QuantizeInputs(X[n].Data(), inputs, input, q + n * cols);
+		std::fill(q + n * cols + inputs, q + (n + 1) * cols, 0);
+	}
+
+	Int8Gemm(X.size(), q, cols, weights, multipliers.data(), offsets.data(), epilogue, output.Data(), outputs);
+}
+
+// обратное распространение
+void QuantizedFullyConnectedLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
+	throw std::runtime_error("Quantized layers support inference only");
+}
+
+// сохранение слоя в файл
+void QuantizedFullyConnectedLayer::Save(std::ofstream &f) const {
+	throw std::runtime_error("Quantized layers can not be saved");
+}
+
+// установка размера батча (градиенты по входу не нужны)
+void QuantizedFullyConnectedLayer::SetBatchSize(int batchSize) {
+	output.Resize(batchSize, outputSize);
+}
@@ -8,47 +8,49 @@
 #include "NetworkLayer.hpp"
 
 class ReshapeLayer : public NetworkLayer {
-	int total;
-
 public:
 	ReshapeLayer(VolumeSize size, VolumeSize newSize);
 
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
+	bool AliasesInput() const; // ссылается ли выход слоя на вход при выводе
 
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
+	void SetBatchSize(int batchSize); // установка размера батча
 };
 
 ReshapeLayer::ReshapeLayer(VolumeSize size, VolumeSize newSize) : NetworkLayer(size, newSize) {
 	if (size.width * size.height * size.deep != newSize.width * newSize.height * newSize.deep)
 		throw std::runtime_error("Unable to reshape");
 
-	total = size.width * size.height * size.deep;
-
 	name = "reshape";
 	info = "";
 }
 
-// прямое распространение
-void ReshapeLayer::Forward(const std::vector<Volume> &X) {
-	#pragma omp parallel for collapse(2)
-	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++)
-		for (int i = 0; i < total; i++)
-			output[batchIndex][i] = X[batchIndex][i];
+// прямое распространение (выход ссылается на вход без копирования)
+void ReshapeLayer::Forward(const Tensor &X) {
+	output.Alias(X, outputSize);
 }
 
 // обратное распространение
-void ReshapeLayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
+void ReshapeLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
 	if (!calc_dX)
 		return;
 
-	#pragma omp parallel for collapse(2)
-	for (size_t batchIndex = 0; batchIndex < dout.size(); batchIndex++)
-		for (int i = 0; i < total; i++)
-			dX[batchIndex][i] = dout[batchIndex][i];
+	dX.Alias(dout, inputSize);
+}
+
+// ссылается ли выход слоя на вход при выводе
+bool ReshapeLayer::AliasesInput() const {
+	return true;
 }
 
 // сохранение слоя в файл
 void ReshapeLayer::Save(std::ofstream &f) const {
 	f << "reshape " << inputSize << " " << outputSize << std::endl;
+}
+
+// установка размера батча (выход и градиенты ссылаются на чужие значения, поэтому память не выделяется)
+void ReshapeLayer::SetBatchSize(int batchSize) {
+
 }
\ No newline at end of file
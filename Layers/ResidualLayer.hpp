@@ -22,28 +22,32 @@ public:
 
 	int GetTrainableParams() const; // получение количества обучаемых параметров
 
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
 	void UpdateWeights(const Optimizer &optimizer, bool trainable); // обновление весовых коэффициентов
 
 	void ResetCache();
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
 	void SetBatchSize(int batchSize); // установка размера батча
+	void SetInferenceBatchSize(int batchSize); // установка размера батча для вывода без градиентов
+	int Autotune(AutotuneCache &cache, int batchSize, bool training); // подбор алгоритмов свёрток блока
 
-	void SetParam(int index, double weight); // установка веса по индексу
-	double GetParam(int index) const; // получение веса по индексу
-	double GetGradient(int index) const; // получение градиента веса по индексу
+	void SetParam(int index, real weight); // установка веса по индексу
+	real GetParam(int index) const; // получение веса по индексу
+	real GetGradient(int index) const; // получение градиента веса по индексу
 	void ZeroGradient(int index); // обнуление градиента веса по индексу
 };
 
 ResidualLayer::ResidualLayer(VolumeSize size, int featureMapsOut) : NetworkLayer(size, size.width, size.height, featureMapsOut) {
-	convBlock.push_back(new ConvLayer(size, featureMapsOut, 3, 1, 1));
+	convBlock.push_back(new ConvLayer(size, featureMapsOut, 3, 1, 1, 1));
 	convBlock.push_back(new BatchNormalization2DLayer(outputSize, 0.9));
-	convBlock.push_back(new ConvLayer(outputSize, featureMapsOut, 3, 1, 1));
+	convBlock.push_back(new ConvLayer(outputSize, featureMapsOut, 3, 1, 1, 1));
 	convBlock.push_back(new BatchNormalization2DLayer(outputSize, 0.9));
 
 	if (size.deep != featureMapsOut) {
-		skipBlock = new ConvLayer(size, featureMapsOut, 1, 0, 1);
+		ConvLayer *skip = new ConvLayer(size, featureMapsOut, 1, 0, 1, 1);
+		skip->ChooseAlgorithm(); // проекция 1x1 считается одним умножением матриц
+		skipBlock = skip;
 	}
 	else {
 		skipBlock = nullptr;
@@ -72,11 +76,19 @@ ResidualLayer::ResidualLayer(VolumeSize size, int featureMapsOut, std::ifstream
 
 		if (name == "conv") {
 			int fc, fs, P, S;
-			f >> fs >> fc >> P >> S;		
-			convBlock.push_back(new ConvLayer(blockSize, fc, fs, P, S, f));
+			std::string layout, algorithm;
+			f >> fs >> fc >> P >> S;
+			ReadConvOptions(f, layout, algorithm);
+
+			ConvLayer *conv = new ConvLayer(blockSize, fc, fs, P, S, 1, f);
+
+			if (algorithm != "auto")
+				conv->SetAlgorithm(StringToConvAlgorithm(algorithm));
+
+			convBlock.push_back(conv);
 		}
 		else if (name == "batchnormalization2D") {
-			double momentum;
+			real momentum;
 			f >> momentum;
 			convBlock.push_back(new BatchNormalization2DLayer(blockSize, momentum, f));
 		}
@@ -94,8 +106,18 @@ ResidualLayer::ResidualLayer(VolumeSize size, int featureMapsOut, std::ifstream
 		if (name != "conv")
 			throw std::runtime_error("Invalid skip layer config");
 
+		std::string layout, algorithm;
 		f >> tmp >> tmp >> tmp >> tmp;
-		skipBlock = new ConvLayer(blockSize, featureMapsOut, 1, 0, 1, f);
+		ReadConvOptions(f, layout, algorithm);
+
+		ConvLayer *skip = new ConvLayer(blockSize, featureMapsOut, 1, 0, 1, 1, f);
+
+		if (algorithm == "auto")
+			skip->ChooseAlgorithm();
+		else
+			skip->SetAlgorithm(StringToConvAlgorithm(algorithm));
+
+		skipBlock = skip;
 	}
 	else {
 		skipBlock = nullptr;
@@ -124,18 +146,18 @@ int ResidualLayer::GetTrainableParams() const {
 }
 
 // прямое распространение
-void ResidualLayer::Forward(const std::vector<Volume> &X) {
+void ResidualLayer::Forward(const Tensor &X) {
 	convBlock[0]->Forward(X);
 
 	for (size_t i = 1; i < convBlock.size(); i++)
 		convBlock[i]->Forward(convBlock[i - 1]->GetOutput());
 
-	std::vector<Volume> &convOutput = convBlock[last]->GetOutput();
+	Tensor &convOutput = convBlock[last]->GetOutput();
 
 	if (skipBlock) {
 		skipBlock->Forward(X);
 
-		std::vector<Volume> &skipOutput = skipBlock->GetOutput();
+		Tensor &skipOutput = skipBlock->GetOutput();
 
 		#pragma omp parallel for collapse(2)
 		for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++)
@@ -151,7 +173,7 @@ void ResidualLayer::Forward(const std::vector<Volume> &X) {
 }
 
 // обратное распространение
-void ResidualLayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
+void ResidualLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
 	if (last == 0) {
 		convBlock[0]->Backward(dout, X, calc_dX);
 	}
@@ -167,12 +189,12 @@ void ResidualLayer::Backward(const std::vector<Volume> &dout, const std::vector<
 	if (!calc_dX)
 		return;
 
-	std::vector<Volume> &deltas = convBlock[0]->GetDeltas();
+	Tensor &deltas = convBlock[0]->GetDeltas();
 
 	if (skipBlock) {
 		skipBlock->Backward(dout, X, true);
 		
-		std::vector<Volume> &skipDeltas = skipBlock->GetDeltas();
+		Tensor &skipDeltas = skipBlock->GetDeltas();
 
 		#pragma omp parallel for collapse(2)
 		for (size_t batchIndex = 0; batchIndex < dout.size(); batchIndex++)
@@ -217,8 +239,8 @@ void ResidualLayer::Save(std::ofstream &f) const {
 
 // установка размера батча
 void ResidualLayer::SetBatchSize(int batchSize) {
-	output = std::vector<Volume>(batchSize, Volume(outputSize));
-	dX = std::vector<Volume>(batchSize, Volume(inputSize));
+	output.Resize(batchSize, outputSize);
+	dX.Resize(batchSize, inputSize);
 
 	for (size_t i = 0; i < convBlock.size(); i++)
 		convBlock[i]->SetBatchSize(batchSize);
@@ -227,8 +249,32 @@ void ResidualLayer::SetBatchSize(int batchSize) {
 		skipBlock->SetBatchSize(batchSize);
 }
 
+// установка размера батча для вывода без градиентов (внутренние слои не планируются и владеют своими выходами)
+void ResidualLayer::SetInferenceBatchSize(int batchSize) {
+	dX = Tensor();
+
+	for (size_t i = 0; i < convBlock.size(); i++)
+		convBlock[i]->SetBatchSize(batchSize);
+
+	if (skipBlock)
+		skipBlock->SetBatchSize(batchSize);
+}
+
+// подбор самых быстрых алгоритмов свёрток блока замерами
+int ResidualLayer::Autotune(AutotuneCache &cache, int batchSize, bool training) {
+	int measured = 0;
+
+	for (size_t i = 0; i < convBlock.size(); i++)
+		measured += convBlock[i]->Autotune(cache, batchSize, training);
+
+	if (skipBlock)
+		measured += skipBlock->Autotune(cache, batchSize, training);
+
+	return measured;
+}
+
 // установка веса по индексу
-void ResidualLayer::SetParam(int index, double weight) {
+void ResidualLayer::SetParam(int index, real weight) {
 	int count = 0;
 
 	for (size_t i = 0; i < convBlock.size(); i++) {
@@ -246,7 +292,7 @@ void ResidualLayer::SetParam(int index, double weight) {
 }
 
 // получение веса по индексу
-double ResidualLayer::GetParam(int index) const {
+real ResidualLayer::GetParam(int index) const {
 	int count = 0;
 
 	for (size_t i = 0; i < convBlock.size(); i++) {
@@ -262,7 +308,7 @@ double ResidualLayer::GetParam(int index) const {
 }
 
 // получение градиента веса по индексу
-double ResidualLayer::GetGradient(int index) const {
+real ResidualLayer::GetGradient(int index) const {
 	int count = 0;
 
 	for (size_t i = 0; i < convBlock.size(); i++) {
@@ -12,41 +12,42 @@ class SamplerLayer : public NetworkLayer {
 	int total;
 	int outputs;
 
-	double kl;
+	real kl;
 
 	NetworkLayer *muLayer;
 	NetworkLayer *stdLayer;
 
-	std::vector<Volume> deltas;
-	std::vector<Volume> dL_mu;
-	std::vector<Volume> dL_std;
+	Tensor deltas;
+	Tensor dL_mu;
+	Tensor dL_std;
 
 	std::default_random_engine generator;
-	std::normal_distribution<double> distribution;
+	std::normal_distribution<real> distribution;
 
 public:
-	SamplerLayer(VolumeSize size, int outputs, double kl);
-	SamplerLayer(VolumeSize size, int outputs, double kl, std::ifstream &f);
+	SamplerLayer(VolumeSize size, int outputs, real kl);
+	SamplerLayer(VolumeSize size, int outputs, real kl, std::ifstream &f);
 
 	int GetTrainableParams() const; // получение количества обучаемых параметров
 
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
 	void UpdateWeights(const Optimizer &optimizer, bool trainable); // обновление весовых коэффициентов
 
 	void ResetCache();
 	void SetBatchSize(int batchSize); // установка размера батча
+	void SetInferenceBatchSize(int batchSize); // установка размера батча для вывода без градиентов
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
 
-	void SetKL(double kl); // установка коэффициента функции потерь
+	void SetKL(real kl); // установка коэффициента функции потерь
 
-	void SetParam(int index, double weight); // установка веса по индексу
-	double GetParam(int index) const; // получение веса по индексу
-	double GetGradient(int index) const; // получение градиента веса по индексу
+	void SetParam(int index, real weight); // установка веса по индексу
+	real GetParam(int index) const; // получение веса по индексу
+	real GetGradient(int index) const; // получение градиента веса по индексу
 	void ZeroGradient(int index); // обнуление градиента веса по индексу
 };
 
-SamplerLayer::SamplerLayer(VolumeSize size, int outputs, double kl) : NetworkLayer(size, 1, 1, outputs), distribution(0, 1) {
+SamplerLayer::SamplerLayer(VolumeSize size, int outputs, real kl) : NetworkLayer(size, 1, 1, outputs), distribution(0, 1) {
 	this->outputs = outputs;
 	this->total = size.width * size.height * size.deep;
 	this->kl = kl;
@@ -61,7 +62,7 @@ SamplerLayer::SamplerLayer(VolumeSize size, int outputs, double kl) : NetworkLay
 		info += ", kl: " + std::to_string(kl);
 }
 
-SamplerLayer::SamplerLayer(VolumeSize size, int outputs, double kl, std::ifstream &f) : NetworkLayer(size, 1, 1, outputs), distribution(0, 1) {
+SamplerLayer::SamplerLayer(VolumeSize size, int outputs, real kl, std::ifstream &f) : NetworkLayer(size, 1, 1, outputs), distribution(0, 1) {
 	this->outputs = outputs;
 	this->total = size.width * size.height * size.deep;
 	this->kl = kl;
@@ -86,17 +87,17 @@ int SamplerLayer::GetTrainableParams() const {
 }
 
 // прямое распространение
-void SamplerLayer::Forward(const std::vector<Volume> &X) {
+void SamplerLayer::Forward(const Tensor &X) {
 	muLayer->Forward(X);
 	stdLayer->Forward(X);
 
-	std::vector<Volume> &mu = muLayer->GetOutput();
-	std::vector<Volume> &std = stdLayer->GetOutput();
+	Tensor &mu = muLayer->GetOutput();
+	Tensor &std = stdLayer->GetOutput();
 
 	#pragma omp parallel for collapse(2)
 	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
 		for (int i = 0; i < outputs; i++) {
-			double e = exp(0.5 * std[batchIndex][i]) * distribution(generator);
+			real e = exp(0.5 * std[batchIndex][i]) * distribution(generator);
 
 			output[batchIndex][i] = e + mu[batchIndex][i];
 			deltas[batchIndex][i] = 0.5 * e;
@@ -109,7 +110,7 @@ void SamplerLayer::Forward(const std::vector<Volume> &X) {
 }
 
 // обратное распространение
-void SamplerLayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
+void SamplerLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
 	#pragma omp parallel for collapse(2)
 	for (size_t batchIndex = 0; batchIndex < dout.size(); batchIndex++) {
 		for (int i = 0; i < outputs; i++) {
@@ -124,8 +125,8 @@ void SamplerLayer::Backward(const std::vector<Volume> &dout, const std::vector<V
 	if (!calc_dX)
 		return;
 
-	std::vector<Volume> &dmu = muLayer->GetDeltas();
-	std::vector<Volume> &dstd = stdLayer->GetDeltas();
+	Tensor &dmu = muLayer->GetDeltas();
+	Tensor &dstd = stdLayer->GetDeltas();
 
 	#pragma omp parallel for collapse(2)
 	for (size_t batchIndex = 0; batchIndex < dout.size(); batchIndex++)
@@ -156,21 +157,33 @@ void SamplerLayer::SetBatchSize(int batchSize) {
 	muLayer->SetBatchSize(batchSize);
 	stdLayer->SetBatchSize(batchSize);
 
-	output = std::vector<Volume>(batchSize, Volume(outputSize));
-	dX = std::vector<Volume>(batchSize, Volume(inputSize));
+	output.Resize(batchSize, outputSize);
+	dX.Resize(batchSize, inputSize);
 	
-	deltas = std::vector<Volume>(batchSize, Volume(outputSize));
-	dL_mu = std::vector<Volume>(batchSize, Volume(outputSize));
-	dL_std = std::vector<Volume>(batchSize, Volume(outputSize));
+	deltas.Resize(batchSize, outputSize);
+	dL_mu.Resize(batchSize, outputSize);
+	dL_std.Resize(batchSize, outputSize);
+}
+
+// установка размера батча для вывода без градиентов (слой сэмплирует и при выводе, поэтому его буферы сохраняются)
+void SamplerLayer::SetInferenceBatchSize(int batchSize) {
+	muLayer->SetBatchSize(batchSize);
+	stdLayer->SetBatchSize(batchSize);
+
+	dX = Tensor();
+
+	deltas.Resize(batchSize, outputSize);
+	dL_mu.Resize(batchSize, outputSize);
+	dL_std.Resize(batchSize, outputSize);
 }
 
 // установка коэффициента функции потерь
-void SamplerLayer::SetKL(double kl) {
+void SamplerLayer::SetKL(real kl) {
 	this->kl = kl;
 }
 
 // установка веса по индексу
-void SamplerLayer::SetParam(int index, double weight) {
+void SamplerLayer::SetParam(int index, real weight) {
 	int n = muLayer->GetTrainableParams();
 
 	if (index < n)
@@ -180,7 +193,7 @@ void SamplerLayer::SetParam(int index, double weight) {
 }
 
 // получение веса по индексу
-double SamplerLayer::GetParam(int index) const {
+real SamplerLayer::GetParam(int index) const {
 	int n = muLayer->GetTrainableParams();
 
 	if (index < n)
@@ -190,7 +203,7 @@ double SamplerLayer::GetParam(int index) const {
 }
 
 // получение градиента веса по индексу
-double SamplerLayer::GetGradient(int index) const {
+real SamplerLayer::GetGradient(int index) const {
 	int n = muLayer->GetTrainableParams();
 
 	if (index < n)
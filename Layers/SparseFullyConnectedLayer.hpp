@@ -0,0 +1,398 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <numeric>
+#include <algorithm>
+
+#include "NetworkLayer.hpp"
+#include "../Entities/SparseMatrix.hpp"
+#include "Kernels/SparseGemm.hpp"
+#include "Kernels/FullyConnectedActivation.hpp"
+
+// разреженный полносвязный слой: веса хранятся в формате CSR, нулевые веса не хранятся и не обучаются,
+// поэтому дообучение сохраняет маску разреженности; создаётся прореживанием обученного полносвязного слоя или со случайной маской
+class SparseFullyConnectedLayer : public NetworkLayer {
+	std::default_random_engine generator;
+
+	int inputs;
+	int outputs;
+
+	FullyConnectedActivation activationType; // тип активационной функции
+
+	SparseMatrix W; // ненулевые веса по строкам нейронов
+	AlignedVector dW; // градиенты ненулевых весов
+	std::vector<AlignedVector> paramsW;
+
+	SparseMatrix WT; // транспонированные веса для градиентов входа
+	std::vector<int> order; // индексы весов W, из которых берутся значения WT
+	bool transposed; // соответствуют ли значения WT текущим весам
+
+	std::vector<real> b; // смещения
+	std::vector<real> db;
+	std::vector<std::vector<real>> paramsb;
+
+	Tensor delta; // градиенты по взвешенным суммам нейронов (dout * f'(x), производная вычисляется по выходу)
+	AlignedVector packedX; // упакованный блоками батч входов
+	AlignedVector packedDelta; // упакованный блоками батч градиентов взвешенных сумм
+	Epilogue epilogue; // слитые с слоем при выводе активация и нормализация
+
+	void InitParams(); // инициализация параметров для обучения
+	void InitWeights(real sparsity); // случайная маска и инициализация весовых коэффициентов
+	void LoadWeights(std::ifstream &f); // считывание весовых коэффициентов из файла
+	void UpdateInfo(); // обновление информации о слое
+	void UpdateTransposed(); // перенос текущих весов в транспонированные
+
+public:
+	SparseFullyConnectedLayer(VolumeSize size, int outputs, const std::string &type, real sparsity);
+	SparseFullyConnectedLayer(VolumeSize size, int outputs, const std::string &type, std::ifstream &f);
+	SparseFullyConnectedLayer(VolumeSize size, const std::string &type, const SparseMatrix &W, const std::vector<real> &b);
+
+	int GetTrainableParams() const; // получение количества обучаемых параметров
+	real GetSparsity() const; // доля нулевых весов
+
+	void ForwardOutput(const Tensor &X); // прямое распространение без вычисления производных
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
+	void UpdateWeights(const Optimizer &optimizer, bool trainable); // обновление весовых коэффициентов
+
+	bool FuseScaleShift(const std::vector<real> &scale, const std::vector<real> &shift); // встраивание преобразования выхода
+	bool FuseActivation(EpilogueActivation activation, real alpha); // встраивание активации выхода
+
+	void ResetCache(); // сброс параметров
+	void Save(std::ofstream &f) const; // сохранение слоя в файл
+	void SetBatchSize(int batchSize); // установка размера батча
+	void SetInferenceBatchSize(int batchSize); // установка размера батча для вывода без градиентов
+
+	void SetParam(int index, real weight); // установка веса по индексу
+	real GetParam(int index) const; // получение веса по индексу
+	real GetGradient(int index) const; // получение градиента веса по индексу
+	void ZeroGradient(int index); // обнуление градиента веса по индексу
+};
+
+SparseFullyConnectedLayer::SparseFullyConnectedLayer(VolumeSize size, int outputs, const std::string &type, real sparsity) : NetworkLayer(size, 1, 1, outputs), b(outputs, 0.01), db(outputs) {
+	if (sparsity < 0 || sparsity >= 1)
+		throw std::runtime_error("Sparsity must be in [0, 1)");
+
+	this->inputs = size.height * size.width * size.deep;
+	this->outputs = outputs;
+
+	activationType = StringToFullyConnectedActivation(type);
+
+	name = "sparsefc";
+	InitWeights(sparsity);
+	InitParams();
+	UpdateInfo();
+}
+
+SparseFullyConnectedLayer::SparseFullyConnectedLayer(VolumeSize size, int outputs, const std::string &type, std::ifstream &f) : NetworkLayer(size, 1, 1, outputs), b(outputs), db(outputs) {
+	this->inputs = size.height * size.width * size.deep;
+	this->outputs = outputs;
+
+	activationType = StringToFullyConnectedActivation(type);
+
+	name = "sparsefc";
+	LoadWeights(f);
+	InitParams();
+	UpdateInfo();
+}
+
+SparseFullyConnectedLayer::SparseFullyConnectedLayer(VolumeSize size, const std::string &type, const SparseMatrix &W, const std::vector<real> &b) : NetworkLayer(size, 1, 1, W.rows), W(W), b(b), db(W.rows) {
+	this->inputs = size.height * size.width * size.deep;
+	this->outputs = W.rows;
+
+	if (W.cols != inputs || (int) b.size() != outputs)
+		throw std::runtime_error("Invalid sparse weights size");
+
+	activationType = StringToFullyConnectedActivation(type);
+
+	name = "sparsefc";
+	InitParams();
+	UpdateInfo();
+}
+
+// инициализация параметров для обучения
+void SparseFullyConnectedLayer::InitParams() {
+	dW = AlignedVector(W.NonZeros(), 0);
+
+	for (int i = 0; i < OPTIMIZER_PARAMS_COUNT; i++) {
+		paramsW.push_back(AlignedVector(W.NonZeros(), 0));
+		paramsb.push_back(std::vector<real>(outputs));
+	}
+
+	TransposeSparse(W, WT, order);
+	transposed = true;
+}
+
+// случайная маска (у каждого нейрона одинаковое число входов) и инициализация весовых коэффициентов по числу входов нейрона
+void SparseFullyConnectedLayer::InitWeights(real sparsity) {
+	int count = std::max(1, (int) (inputs * (1 - sparsity) + 0.5));
+	std::normal_distribution<real> distribution(0.0, sqrt(2.0 / count));
+	std::vector<int> columns(inputs);
+
+	W.rows = outputs;
+	W.cols = inputs;
+	W.offsets.assign(1, 0);
+	W.columns.clear();
+	W.values.clear();
+
+	for (int i = 0; i < outputs; i++) {
+		std::iota(columns.begin(), columns.end(), 0);
+		std::shuffle(columns.begin(), columns.end(), generator);
+		std::sort(columns.begin(), columns.begin() + count);
+
+		for (int k = 0; k < count; k++) {
+			W.columns.push_back(columns[k]);
+			W.values.push_back(distribution(generator));
+		}
+
+		W.offsets.push_back(W.NonZeros());
+	}
+}
+
+// считывание весовых коэффициентов из файла: количество ненулевых весов, затем строки нейронов (число весов, пары столбец-вес, смещение)
+void SparseFullyConnectedLayer::LoadWeights(std::ifstream &f) {
+	int nonZeros;
+	f >> nonZeros;
+
+	W.rows = outputs;
+	W.cols = inputs;
+	W.offsets.assign(outputs + 1, 0);
+	W.columns.resize(nonZeros);
+	W.values.resize(nonZeros);
+
+	for (int i = 0; i < outputs; i++) {
+		int count;
+		f >> count;
+
+		W.offsets[i + 1] = W.offsets[i] + count;
+
+		if (count < 0 || W.offsets[i + 1] > nonZeros)
+			throw std::runtime_error("Invalid sparse weights");
+
+		for (int k = W.offsets[i]; k < W.offsets[i + 1]; k++) {
+			f >> W.columns[k] >> W.values[k];
+
+			if (W.columns[k] < 0 || W.columns[k] >= inputs || (k > W.offsets[i] && W.columns[k] <= W.columns[k - 1]))
+				throw std::runtime_error("Invalid sparse weights");
+		}
+
+		f >> b[i];
+	}
+
+	if (W.offsets[outputs] != nonZeros)
+		throw std::runtime_error("Invalid sparse weights");
+}
+
+// обновление информации о слое
+void SparseFullyConnectedLayer::UpdateInfo() {
+	std::stringstream ss;
+	ss << std::setprecision(3) << GetSparsity() * 100;
+
+	info = std::to_string(outputs) + " neurons, sparsity: " + ss.str() + "%";
+
+	if (activationType != FullyConnectedActivation::None)
+		info += ", f: " + FullyConnectedActivationToString(activationType);
+
+	if (!epilogue.Empty())
+		info += ", epilogue: " + EpilogueToString(epilogue);
+}
+
+// перенос текущих весов в транспонированные (структура не меняется, поэтому достаточно копирования)
+void SparseFullyConnectedLayer::UpdateTransposed() {
+	if (transposed)
+		return;
+
+	#pragma omp parallel for
+	for (int k = 0; k < WT.NonZeros(); k++)
+		WT.values[k] = W.values[order[k]];
+
+	transposed = true;
+}
+
+// получение количества обучаемых параметров
+int SparseFullyConnectedLayer::GetTrainableParams() const {
+	return W.NonZeros() + outputs;
+}
+
+// доля нулевых весов
+real SparseFullyConnectedLayer::GetSparsity() const {
+	return 1 - (real) W.NonZeros() / ((real) inputs * outputs);
+}
+
+// прямое распространение без вычисления производных
+void SparseFullyConnectedLayer::ForwardOutput(const Tensor &X) {
+	int batchSize = X.size();
+	real *y = output.Data();
+
+	SparsePackRows(X.Data(), batchSize, inputs, inputs, packedX);
+	SparseMultiply(W, packedX.data(), batchSize, y, outputs);
+
+	ActivateRows(activationType, b.data(), y, batchSize, outputs);
+
+	if (epilogue.Empty())
+		return;
+
+	#pragma omp parallel for collapse(2)
+	for (int batchIndex = 0; batchIndex < batchSize; batchIndex++)
+		for (int i = 0; i < outputs; i++)
+			y[batchIndex * outputs + i] = epilogue.Apply(y[batchIndex * outputs + i], i);
+}
+
+// прямое распространение
+void SparseFullyConnectedLayer::Forward(const Tensor &X) {
+	int batchSize = X.size();
+	real *y = output.Data();
+
+	SparsePackRows(X.Data(), batchSize, inputs, inputs, packedX);
+	SparseMultiply(W, packedX.data(), batchSize, y, outputs);
+
+	ActivateRows(activationType, b.data(), y, batchSize, outputs);
+}
+
+// обратное распространение: delta = dout * f'(x), dX = delta * W (умножением на транспонированные веса), градиенты только ненулевых весов
+void SparseFullyConnectedLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
+	int batchSize = dout.size();
+	real *d = delta.Data();
+
+	ActivationGradientRows(activationType, output.Data(), dout.Data(), d, batchSize, outputs);
+
+	SparsePackRows(d, batchSize, outputs, outputs, packedDelta);
+
+	if (calc_dX) {
+		UpdateTransposed();
+		SparseMultiply(WT, packedDelta.data(), batchSize, dX.Data(), inputs);
+	}
+
+	SparsePackRows(X.Data(), batchSize, inputs, inputs, packedX);
+	SparseGradients(W, packedDelta.data(), packedX.data(), batchSize, dW.data());
+
+	#pragma omp parallel for
+	for (int i = 0; i < outputs; i++)
+		for (int batchIndex = 0; batchIndex < batchSize; batchIndex++)
+			db[i] += d[batchIndex * outputs + i];
+}
+
+// обновление весовых коэффициентов (обновляются только ненулевые веса, поэтому маска сохраняется)
+void SparseFullyConnectedLayer::UpdateWeights(const Optimizer &optimizer, bool trainable) {
+	int batchSize = output.size();
+	transposed = transposed && !trainable;
+
+	#pragma omp parallel for
+	for (int i = 0; i < outputs; i++) {
+		for (int k = W.offsets[i]; k < W.offsets[i + 1]; k++) {
+			if (trainable)
+				optimizer.Update(dW[k] / batchSize, paramsW[0][k], paramsW[1][k], paramsW[2][k], W.values[k]);
+
+			dW[k] = 0;
+		}
+
+		if (trainable)
+			optimizer.Update(db[i] / batchSize, paramsb[0][i], paramsb[1][i], paramsb[2][i], b[i]);
+
+		db[i] = 0;
+	}
+}
+
+// встраивание преобразования выхода: без активации оно переносится в веса и смещения, иначе добавляется в эпилог
+bool SparseFullyConnectedLayer::FuseScaleShift(const std::vector<real> &scale, const std::vector<real> &shift) {
+	if ((int) scale.size() != outputs)
+		return false;
+
+	if (activationType != FullyConnectedActivation::None || !epilogue.Empty()) {
+		epilogue.AddScaleShift(scale, shift);
+		UpdateInfo();
+		return true;
+	}
+
+	for (int i = 0; i < outputs; i++) {
+		for (int k = W.offsets[i]; k < W.offsets[i + 1]; k++)
+			W.values[k] *= scale[i];
+
+		b[i] = b[i] * scale[i] + shift[i];
+	}
+
+	transposed = false;
+	return true;
+}
+
+// встраивание активации выхода (только если у слоя своей активации нет, а эпилог пуст)
+bool SparseFullyConnectedLayer::FuseActivation(EpilogueActivation activation, real alpha) {
+	if (activationType != FullyConnectedActivation::None || !epilogue.Empty())
+		return false;
+
+	epilogue.activation = activation;
+	epilogue.alpha = alpha;
+	UpdateInfo();
+	return true;
+}
+
+// сброс параметров
+void SparseFullyConnectedLayer::ResetCache() {
+	for (int index = 0; index < OPTIMIZER_PARAMS_COUNT; index++) {
+		std::fill(paramsW[index].begin(), paramsW[index].end(), 0);
+		std::fill(paramsb[index].begin(), paramsb[index].end(), 0);
+	}
+}
+
+// сохранение слоя в файл
+void SparseFullyConnectedLayer::Save(std::ofstream &f) const {
+	f << "sparsefc " << inputSize << " " << outputs << " " << FullyConnectedActivationToString(activationType) << " " << W.NonZeros() << std::endl;
+
+	for (int i = 0; i < outputs; i++) {
+		f << (W.offsets[i + 1] - W.offsets[i]) << " ";
+
+		for (int k = W.offsets[i]; k < W.offsets[i + 1]; k++)
+			f << W.columns[k] << " " << std::setprecision(15) << W.values[k] << " ";
+
+		f << std::setprecision(15) << b[i] << std::endl;
+	}
+}
+
+// установка размера батча
+void SparseFullyConnectedLayer::SetBatchSize(int batchSize) {
+	output.Resize(batchSize, outputSize);
+	delta.Resize(batchSize, outputSize);
+	dX.Resize(batchSize, inputSize);
+}
+
+// установка размера батча для вывода без градиентов
+void SparseFullyConnectedLayer::SetInferenceBatchSize(int batchSize) {
+	delta = Tensor();
+	dX = Tensor();
+	packedDelta = AlignedVector();
+}
+
+// установка веса по индексу: сначала ненулевые веса по строкам, затем смещения
+void SparseFullyConnectedLayer::SetParam(int index, real weight) {
+	if (index < W.NonZeros()) {
+		W.values[index] = weight;
+		transposed = false;
+	}
+	else {
+		b[index - W.NonZeros()] = weight;
+	}
+}
+
+// получение веса по индексу
+real SparseFullyConnectedLayer::GetParam(int index) const {
+	return index < W.NonZeros() ? W.values[index] : b[index - W.NonZeros()];
+}
+
+// получение градиента веса по индексу
+real SparseFullyConnectedLayer::GetGradient(int index) const {
+	return index < W.NonZeros() ? dW[index] : db[index - W.NonZeros()];
+}
+
+// обнуление градиента веса по индексу
+void SparseFullyConnectedLayer::ZeroGradient(int index) {
+	if (index < W.NonZeros())
+		dW[index] = 0;
+	else
+		db[index - W.NonZeros()] = 0;
+}
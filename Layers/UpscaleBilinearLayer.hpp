@@ -13,8 +13,8 @@ class UpscaleBilinearLayer : public NetworkLayer {
 public:
 	UpscaleBilinearLayer(VolumeSize size, int scale = 2);
 
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
 
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
 };
@@ -27,7 +27,7 @@ UpscaleBilinearLayer::UpscaleBilinearLayer(VolumeSize size, int scale) : Network
 }
 
 // прямое распространение
-void UpscaleBilinearLayer::Forward(const std::vector<Volume> &X) {
+void UpscaleBilinearLayer::Forward(const Tensor &X) {
 	#pragma omp parallel for collapse(4)
 	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
 		for (int d = 0; d < inputSize.deep; d++) {
@@ -36,13 +36,13 @@ void UpscaleBilinearLayer::Forward(const std::vector<Volume> &X) {
 					int y = std::min(i / scale, inputSize.height - 2);
 					int x = std::min(j / scale, inputSize.width - 2);
 
-					double dy = (i / (double)scale) - y;
-					double dx = (j / (double)scale) - x;
+					real dy = (i / (real)scale) - y;
+					real dx = (j / (real)scale) - x;
 
-					double p1 = X[batchIndex](d, y, x) * (1 - dx) * (1 - dy);
-					double p2 = X[batchIndex](d, y, x + 1) * dx * (1 - dy);
-					double p3 = X[batchIndex](d, y + 1, x) * (1 - dx) * dy;
-					double p4 = X[batchIndex](d, y + 1, x + 1) * dx * dy;
+					real p1 = X[batchIndex](d, y, x) * (1 - dx) * (1 - dy);
+					real p2 = X[batchIndex](d, y, x + 1) * dx * (1 - dy);
+					real p3 = X[batchIndex](d, y + 1, x) * (1 - dx) * dy;
+					real p4 = X[batchIndex](d, y + 1, x + 1) * dx * dy;
 
 					output[batchIndex](d, i, j) = p1 + p2 + p3 + p4;		
 				}
@@ -52,7 +52,7 @@ void UpscaleBilinearLayer::Forward(const std::vector<Volume> &X) {
 }
 
 // обратное распространение
-void UpscaleBilinearLayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
+void UpscaleBilinearLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
 	if (!calc_dX)
 		return;
 
@@ -68,10 +68,10 @@ void UpscaleBilinearLayer::Backward(const std::vector<Volume> &dout, const std::
 					int y = std::min(i / scale, inputSize.height - 2);
 					int x = std::min(j / scale, inputSize.width - 2);
 
-					double dy = (i / (double)scale) - y;
-					double dx = (j / (double)scale) - x;
+					real dy = (i / (real)scale) - y;
+					real dx = (j / (real)scale) - x;
 
-					double delta = dout[batchIndex](d, i, j);
+					real delta = dout[batchIndex](d, i, j);
 
 					dX[batchIndex](d, y, x) += delta * (1 - dx) * (1 - dy);		
 					dX[batchIndex](d, y, x + 1) += delta * dx * (1 - dy);		
@@ -13,8 +13,8 @@ class UpscaleLayer : public NetworkLayer {
 public:
 	UpscaleLayer(VolumeSize size, int scale = 2);
 
-	void Forward(const std::vector<Volume> &X); // прямое распространение
-	void Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX); // обратное распространение
+	void Forward(const Tensor &X); // прямое распространение
+	void Backward(const Tensor &dout, const Tensor &X, bool calc_dX); // обратное распространение
 
 	void Save(std::ofstream &f) const; // сохранение слоя в файл
 };
@@ -27,13 +27,13 @@ UpscaleLayer::UpscaleLayer(VolumeSize size, int scale) : NetworkLayer(size, size
 }
 
 // прямое распространение
-void UpscaleLayer::Forward(const std::vector<Volume> &X) {
+void UpscaleLayer::Forward(const Tensor &X) {
 	#pragma omp parallel for collapse(4)
 	for (size_t batchIndex = 0; batchIndex < X.size(); batchIndex++) {
 		for (int d = 0; d < inputSize.deep; d++) {
 			for (int i = 0; i < inputSize.height; i++) {
 				for (int j = 0; j < inputSize.width; j++) {
-					double value = X[batchIndex](d, i, j);
+					real value = X[batchIndex](d, i, j);
 
 					for (int y = 0; y < scale; y++)
 						for (int x = 0; x < scale; x++)
@@ -45,7 +45,7 @@ void UpscaleLayer::Forward(const std::vector<Volume> &X) {
 }
 
 // обратное распространение
-void UpscaleLayer::Backward(const std::vector<Volume> &dout, const std::vector<Volume> &X, bool calc_dX) {
+void UpscaleLayer::Backward(const Tensor &dout, const Tensor &X, bool calc_dX) {
 	if (!calc_dX)
 		return;
 
@@ -54,7 +54,7 @@ void UpscaleLayer::Backward(const std::vector<Volume> &dout, const std::vector<V
 		for (int d = 0; d < inputSize.deep; d++) {
 			for (int i = 0; i < inputSize.height; i++) {
 				for (int j = 0; j < inputSize.width; j++) {
-					double delta = 0;
+					real delta = 0;
 
 					for (int y = 0; y < scale; y++)
 						for (int x = 0; x < scale; x++)
@@ -5,6 +5,9 @@
 #include <vector>
 #include <string>
 #include <chrono>
+#include <memory>
+#include <limits>
+#include <cmath>
 
 #include "Layers/Layers.hpp"
 
@@ -23,17 +26,41 @@ class Network {
 	std::vector<NetworkLayer*> layers; // слои сети
 	std::vector<bool> isLearnable; // обучаемы ли слои
 
-	std::vector<std::vector<Volume>> inputBatches;
-	std::vector<std::vector<Volume>> outputBatches;
+	std::vector<std::shared_ptr<LayoutLayer>> converters; // преобразования расположения входов слоёв (nullptr, если не требуются)
+	std::vector<std::shared_ptr<LayoutLayer>> outputConverters; // преобразования выходов слоёв в канальное расположение
 
-	std::vector<Volume>& Forward(const std::vector<Volume> &input, int start = 0);
-	std::vector<Volume>& GetOutput(const std::vector<Volume> &input, int start, int end);
+	std::vector<Tensor> inputBatches;
+	std::vector<Tensor> outputBatches;
 
-	void InitBatches(const std::vector<Volume> &inputData, const std::vector<Volume> outputData, size_t batchSize, const std::string augmentation = "");
+	Tensor volumeInput; // вход сети при вычислении выхода по одному объёму
+	Tensor deltas; // градиенты ошибки по выходу сети
+
+	InferencePlan inferencePlan; // план размещения активаций при выводе
+	int inferenceBatchSize; // размер батча, под который построен план (0, если плана нет)
+	bool inferenceOnly; // оптимизирована ли сеть для вывода (такую сеть нельзя обучать и сохранять)
+
+	std::vector<Layout> layouts; // расположения выходов слоёв при последнем согласовании
+
+	void GetLayouts(std::vector<Layout> &layouts) const; // расположения выходов слоёв
+	void NegotiateLayouts(); // вставка преобразований между слоями с разными расположениями
+	Layout GetInputLayout(int layer) const; // расположение, в котором слой получает вход
+
+	Tensor& ForwardLayer(int layer, const Tensor &input, bool training); // прямое распространение через слой с учётом преобразования расположения
+	Tensor& ConvertOutput(int layer); // выход слоя в канальном расположении
+	void Backward(const Tensor &input, int start); // обратное распространение ошибки по слоям
+
+	const Tensor& PackInput(const Volume &input); // размещение одного объёма во входном тензоре
+
+	Tensor& Forward(const Tensor &input, int start = 0);
+	Tensor& GetOutput(const Tensor &input, int start, int end, bool planned = true);
+	void ApplyInferencePlan(int batchSize); // размещение выходов слоёв в общих буферах плана
+	void ResetInferencePlan(); // сброс плана при изменении слоёв
+
+	void InitBatches(const std::vector<Volume> &inputData, const std::vector<Volume> &outputData, size_t batchSize, const std::string augmentation = "");
 	void SetBatchSize(int batchSize); // установка размера батча
 	void ResetCache(); // сброс промежуточных данных
 
-	double TrainBatch(const std::vector<Volume> &inputBatch, const std::vector<Volume> outputBatch, const LossFunction &E, const Optimizer &optimizer, int start = 0); // обучение батча
+	double TrainBatch(const Tensor &inputBatch, const Tensor &outputBatch, const LossFunction &E, const Optimizer &optimizer, int start = 0); // обучение батча
 
 public:
 	Network(int width, int height, int deep);
@@ -51,14 +78,22 @@ public:
 	Volume& GetOutput(const Volume& input); // получение выхода сети
 	Volume& GetOutputFromLayer(const Volume& input, int start); // получение выхода сети, начиная со слоя start
 
-	std::vector<Volume>& GetOutput(); // получение текущего выхода сети
-	std::vector<Volume>& GetOutput(const std::vector<Volume> &inputs); // получение выхода сети
-	std::vector<Volume>& GetOutputFromLayer(const std::vector<Volume>& inputs, int start); // получение выхода сети, начиная со слоя start
-	std::vector<Volume>& GetOutputAtLayer(const std::vector<Volume> &inputs, int layer); // получение выхода сети на заданном слое
+	Tensor& GetOutput(); // получение текущего выхода сети
+	Tensor& GetOutput(const Tensor &inputs); // получение выхода сети
+	Tensor& GetOutputFromLayer(const Tensor& inputs, int start); // получение выхода сети, начиная со слоя start
+	Tensor& GetOutputAtLayer(const Tensor &inputs, int layer); // получение выхода сети на заданном слое
+
+	void PlanInference(int batchSize = 1); // планирование памяти активаций для вывода
+	void OptimizeForInference(); // встраивание нормализации и активаций в предыдущие слои и удаление тождественных при выводе слоёв
+	size_t GetInferenceMemory() const; // количество чисел в общих буферах плана вывода
+	int Autotune(int batchSize, bool training = true, const std::string &cachePath = AUTOTUNE_CACHE_PATH); // выбор самых быстрых алгоритмов слоёв замерами с кэшем результатов
+	int Quantize(const std::vector<Volume> &calibration, size_t batchSize = 32); // замена свёрточных и полносвязных слоёв на int8 по калибровочным примерам
+	int Prune(real sparsity, int minParams = 0); // замена полносвязных слоёв разреженными без доли sparsity наименьших по модулю весов
+	int Factorize(int rank, int minParams = 0); // замена полносвязных слоёв произведением двух матриц ранга rank по усечённому сингулярному разложению
 
 	NetworkLayer* GetLayer(int layer); // получение слоя по индексу
 
-	double TrainOnBatch(const std::vector<Volume> &inputData, const std::vector<Volume> &outputData, const Optimizer &optimizer, const LossFunction &E, int start = 0);
+	double TrainOnBatch(const Tensor &inputData, const Tensor &outputData, const Optimizer &optimizer, const LossFunction &E, int start = 0);
 	double Train(const std::vector<Volume> &inputData, const std::vector<Volume> &outputData, size_t batchSize, size_t epochs, const Optimizer &optimizer, const LossFunction &E, const std::string augmentation = ""); // обучение сети
 	double GetError(const std::vector<Volume> &inputData, const std::vector<Volume> &outputData, const LossFunction &E); // получение ошибки на заданной выборке без изменения весовых коэффициентов
 	void LRFind(const std::string &path, const std::vector<Volume> &inputData, const std::vector<Volume> &outputData, size_t batchSize, double minLR, double maxLR, Optimizer &optimizer, const LossFunction &E); // поиск оптимальной скорости обучения
@@ -70,7 +105,7 @@ public:
 	void SetLayerLearnable(int layer, bool learnable); // изменение обучаемости слоя
 	void SetLearnable(bool learnable); // изменение обучаемости сети
 
-	void GradientChecking(const std::vector<Volume> &input, const std::vector<Volume> &output, const LossFunction &E); // численная проверка расчёта градиентов
+	void GradientChecking(const Tensor &input, const Tensor &output, const LossFunction &E); // численная проверка расчёта градиентов
 	void PrintGradientsStats();
 };
 
@@ -80,35 +115,376 @@ Network::Network(int width, int height, int deep) {
 	inputSize.deep = deep;
 
 	outputSize = inputSize;
+	inferenceBatchSize = 0;
+	inferenceOnly = false;
 }
 
 Network::Network(const std::string &path) {
+	inferenceBatchSize = 0;
+	inferenceOnly = false;
 	Load(path);
 }
 
+// расположения выходов слоёв (вектор заполняется на месте, поэтому при неизменном числе слоёв память не выделяется)
+void Network::GetLayouts(std::vector<Layout> &layouts) const {
+	Layout current = Layout::Channels; // вход сети всегда в канальном расположении
+
+	layouts.resize(layers.size());
+
+	for (size_t i = 0; i < layers.size(); i++) {
+		Layout layout = layers[i]->GetLayout();
+
+		if (layout != Layout::Any)
+			current = layout;
+
+		layouts[i] = current;
+	}
+}
+
+// вставка преобразований между слоями с разными расположениями (вызывается при каждой установке размера батча, поэтому не выделяет память, если слои не менялись)
+void Network::NegotiateLayouts() {
+	GetLayouts(layouts);
+
+	converters.resize(layers.size());
+	outputConverters.resize(layers.size());
+
+	for (size_t i = 0; i < layers.size(); i++) {
+		Layout from = i == 0 ? Layout::Channels : layouts[i - 1];
+		Layout to = layers[i]->GetLayout();
+
+		if (to == Layout::Any || to == from) {
+			converters[i] = nullptr;
+		}
+		else if (converters[i] == nullptr || converters[i]->GetFrom() != from || converters[i]->GetTo() != to || converters[i]->GetInputSize() != layers[i]->GetInputSize()) {
+			converters[i] = std::make_shared<LayoutLayer>(layers[i]->GetInputSize(), from, to);
+		}
+
+		if (layouts[i] == Layout::Channels) {
+			outputConverters[i] = nullptr;
+		}
+		else if (outputConverters[i] == nullptr || outputConverters[i]->GetFrom() != layouts[i] || outputConverters[i]->GetInputSize() != layers[i]->GetOutputSize()) {
+			outputConverters[i] = std::make_shared<LayoutLayer>(layers[i]->GetOutputSize(), layouts[i], Layout::Channels);
+		}
+	}
+}
+
+// расположение, в котором слой получает вход
+Layout Network::GetInputLayout(int layer) const {
+	if (layer == 0)
+		return Layout::Channels;
+
+	return outputConverters[layer - 1] == nullptr ? Layout::Channels : outputConverters[layer - 1]->GetFrom();
+}
+
+// прямое распространение через слой с учётом преобразования расположения
+Tensor& Network::ForwardLayer(int layer, const Tensor &input, bool training) {
+	const Tensor *X = &input;
+
+	if (converters[layer] != nullptr) {
+		converters[layer]->Forward(input);
+		X = &converters[layer]->GetOutput();
+	}
+
+	if (training)
+		layers[layer]->Forward(*X);
+	else
+		layers[layer]->ForwardOutput(*X);
+
+	return layers[layer]->GetOutput();
+}
+
+// выход слоя в канальном расположении
+Tensor& Network::ConvertOutput(int layer) {
+	if (outputConverters[layer] == nullptr)
+		return layers[layer]->GetOutput();
+
+	outputConverters[layer]->Forward(layers[layer]->GetOutput());
+	return outputConverters[layer]->GetOutput();
+}
+
+// обратное распространение ошибки по слоям
+void Network::Backward(const Tensor &input, int start) {
+	int last = layers.size() - 1;
+	const Tensor *dout = &deltas;
+
+	if (outputConverters[last] != nullptr) {
+		outputConverters[last]->Backward(deltas, layers[last]->GetOutput(), true);
+		dout = &outputConverters[last]->GetDeltas();
+	}
+
+	for (int i = last; i >= start; i--) {
+		const Tensor &X = i == start ? input : layers[i - 1]->GetOutput();
+		bool calc_dX = i > start;
+
+		if (converters[i] == nullptr) {
+			layers[i]->Backward(*dout, X, calc_dX);
+			dout = &layers[i]->GetDeltas();
+		}
+		else {
+			layers[i]->Backward(*dout, converters[i]->GetOutput(), calc_dX);
+			converters[i]->Backward(layers[i]->GetDeltas(), X, calc_dX);
+			dout = &converters[i]->GetDeltas();
+		}
+	}
+}
+
 // прямое распространение сигналов по сети
-std::vector<Volume>& Network::Forward(const std::vector<Volume> &input, int start) {
-	layers[start]->Forward(input);
+Tensor& Network::Forward(const Tensor &input, int start) {
+	if (GetInputLayout(start) != Layout::Channels)
+		throw std::runtime_error("Unable to start from layer " + std::to_string(start) + ": its input is not in channels layout");
+
+	ForwardLayer(start, input, true);
 
 	for (size_t i = start + 1; i < layers.size(); i++)
-		layers[i]->Forward(layers[i - 1]->GetOutput());
+		ForwardLayer(i, layers[i - 1]->GetOutput(), true);
 
-	return layers[layers.size() - 1]->GetOutput();
+	return ConvertOutput(layers.size() - 1);
 }
 
-std::vector<Volume>& Network::GetOutput(const std::vector<Volume> &inputs, int start, int end) {
-	SetBatchSize(inputs.size());
+// размещение одного объёма во входном тензоре (тензор живёт в сети, поэтому выходы слоёв могут на него ссылаться)
+const Tensor& Network::PackInput(const Volume &input) {
+	if (volumeInput.size() != 1 || volumeInput.GetSize() != input.GetSize())
+		volumeInput = Tensor(1, input.GetSize());
+
+	volumeInput[0] = input;
+	return volumeInput;
+}
+
+Tensor& Network::GetOutput(const Tensor &inputs, int start, int end, bool planned) {
+	// план описывает только полный проход по сети, остальные проходы используют собственные выходы слоёв
+	planned = planned && inferenceBatchSize > 0 && start == 0 && end == layers.size() - 1;
+
+	if (!planned) {
+		SetBatchSize(inputs.size());
+	}
+	else if ((int) inputs.size() > inferenceBatchSize) {
+		PlanInference(inputs.size());
+	}
+	else {
+		ApplyInferencePlan(inputs.size());
+	}
+
+	if (GetInputLayout(start) != Layout::Channels)
+		throw std::runtime_error("Unable to start from layer " + std::to_string(start) + ": its input is not in channels layout");
 
-	layers[start]->ForwardOutput(inputs);
+	ForwardLayer(start, inputs, false);
 
 	for (size_t i = start + 1; i <= end; i++)
-		layers[i]->ForwardOutput(layers[i - 1]->GetOutput());
+		ForwardLayer(i, layers[i - 1]->GetOutput(), false);
+
+	return ConvertOutput(end);
+}
+
+// размещение выходов слоёв в общих буферах плана (повторное размещение не выделяет память)
+void Network::ApplyInferencePlan(int batchSize) {
+	for (size_t i = 0; i < inferencePlan.StepsCount(); i++)
+		inferencePlan.GetLayer(i)->SetOutputBuffer(inferencePlan.GetOutput(i), batchSize);
+}
+
+// сброс плана при изменении слоёв
+void Network::ResetInferencePlan() {
+	inferencePlan.Clear();
+	inferenceBatchSize = 0;
+}
+
+// планирование памяти активаций для вывода: анализ времени жизни выходов слоёв (включая ветви блоков)
+// и назначение им небольшого набора общих буферов, градиенты при этом не выделяются
+void Network::PlanInference(int batchSize) {
+	if (layers.size() == 0)
+		throw std::runtime_error("Unable to plan inference. No layers");
+
+	NegotiateLayouts();
+	inferencePlan.Clear();
+	deltas = Tensor();
+
+	int value = -1; // вход сети
+
+	for (size_t i = 0; i < layers.size(); i++) {
+		if (converters[i] != nullptr)
+			value = converters[i]->PlanInference(inferencePlan, value);
+
+		value = layers[i]->PlanInference(inferencePlan, value);
+	}
+
+	if (outputConverters[layers.size() - 1] != nullptr)
+		value = outputConverters[layers.size() - 1]->PlanInference(inferencePlan, value);
+
+	inferencePlan.Build(batchSize, value);
+
+	for (size_t i = 0; i < inferencePlan.StepsCount(); i++)
+		inferencePlan.GetLayer(i)->SetInferenceBatchSize(batchSize);
+
+	inferenceBatchSize = batchSize;
+	ApplyInferencePlan(batchSize);
+}
+
+// оптимизация сети для вывода: слои, тождественные при выводе (dropout, шум), удаляются, а нормализация и активации
+// встраиваются в эпилог предыдущего свёрточного или полносвязного слоя (нормализация сразу после слоя переносится прямо в его веса)
+// после оптимизации сеть можно только выполнять: обучение и сохранение запрещены
+void Network::OptimizeForInference() {
+	std::vector<NetworkLayer*> optimized;
+	std::vector<bool> learnable;
+
+	for (size_t i = 0; i < layers.size(); i++) {
+		std::vector<real> scale, shift;
+		EpilogueActivation activation;
+		real alpha;
+
+		if (layers[i]->AliasesInput() && layers[i]->GetInputSize() == layers[i]->GetOutputSize()) {
+			delete layers[i]; // при выводе слой тождественный
+			continue;
+		}
+
+		if (optimized.size() > 0) {
+			NetworkLayer *last = optimized[optimized.size() - 1];
+
+			if ((layers[i]->GetScaleShift(scale, shift) && last->FuseScaleShift(scale, shift)) || (layers[i]->GetActivation(activation, alpha) && last->FuseActivation(activation, alpha))) {
+				delete layers[i]; // слой встроен в эпилог предыдущего
+				continue;
+			}
+		}
 
-	return layers[end]->GetOutput();
+		optimized.push_back(layers[i]);
+		learnable.push_back(isLearnable[i]);
+	}
+
+	layers = optimized;
+	isLearnable = learnable;
+	inferenceOnly = true;
+
+	if (layers.size() > 0)
+		outputSize = layers[layers.size() - 1]->GetOutputSize();
+
+	ResetInferencePlan();
+}
+
+// выбор самых быстрых алгоритмов слоёв для батча batchSize замерами (при training замеряется шаг обучения, иначе прямое распространение при выводе)
+// результаты сохраняются в файл кэша по форме слоя и подписи процессора, поэтому повторная настройка того же процессора не замеряет ничего
+// веса не меняются, накопленные градиенты обнуляются; возвращается количество замеренных слоёв
+int Network::Autotune(int batchSize, bool training, const std::string &cachePath) {
+	if (layers.size() == 0)
+		throw std::runtime_error("Unable to autotune. No layers");
+
+	AutotuneCache cache(cachePath);
+	int measured = 0;
+
+	for (size_t i = 0; i < layers.size(); i++)
+		measured += layers[i]->Autotune(cache, batchSize, training && !inferenceOnly);
+
+	cache.Save();
+	ResetInferencePlan(); // замеры меняют размер батча слоёв
+	return measured;
+}
+
+// квантование сети для вывода: калибровочные примеры прогоняются через сеть, по диапазонам входов слоёв выбираются параметры квантования,
+// и свёрточные и полносвязные слои (вместе с эпилогами, поэтому OptimizeForInference лучше вызвать раньше) заменяются int8 копиями
+// после квантования сеть можно только выполнять; возвращается количество квантованных слоёв
+int Network::Quantize(const std::vector<Volume> &calibration, size_t batchSize) {
+	if (layers.size() == 0)
+		throw std::runtime_error("Unable to quantize. No layers");
+
+	if (calibration.size() == 0)
+		throw std::runtime_error("Unable to quantize. No calibration data");
+
+	std::vector<real> mins(layers.size(), INFINITY);
+	std::vector<real> maxs(layers.size(), -INFINITY);
+
+	for (size_t start = 0; start < calibration.size(); start += batchSize) {
+		size_t size = std::min(batchSize, calibration.size() - start);
+		Tensor batch(std::vector<Volume>(calibration.begin() + start, calibration.begin() + start + size));
+
+		GetOutput(batch, 0, layers.size() - 1, false);
+
+		for (size_t i = 0; i < layers.size(); i++) {
+			const Tensor &input = converters[i] != nullptr ? converters[i]->GetOutput() : (i == 0 ? batch : layers[i - 1]->GetOutput());
+			const real *x = input.Data();
+
+			for (size_t j = 0; j < size * input.Total(); j++) {
+				mins[i] = std::min(mins[i], x[j]);
+				maxs[i] = std::max(maxs[i], x[j]);
+			}
+		}
+	}
+
+	int quantized = 0;
+
+	for (size_t i = 0; i < layers.size(); i++) {
+		NetworkLayer *layer = layers[i]->Quantize(GetQuantizationParams(mins[i], maxs[i]));
+
+		if (layer == nullptr)
+			continue;
+
+		delete layers[i];
+		layers[i] = layer;
+		isLearnable[i] = false;
+		quantized++;
+	}
+
+	inferenceOnly = true;
+	ResetInferencePlan();
+	return quantized;
+}
+
+// прореживание сети: полносвязные слои не меньше чем с minParams параметрами заменяются разреженными, в которых остаётся доля 1 - sparsity
+// наибольших по модулю весов; в отличие от квантования сеть остаётся обучаемой (дообучение не меняет маску) и сохраняемой
+// возвращается количество прореженных слоёв
+int Network::Prune(real sparsity, int minParams) {
+	int pruned = 0;
+
+	for (size_t i = 0; i < layers.size(); i++) {
+		if (layers[i]->GetTrainableParams() < minParams)
+			continue;
+
+		NetworkLayer *layer = layers[i]->Prune(sparsity);
+
+		if (layer == nullptr)
+			continue;
+
+		delete layers[i];
+		layers[i] = layer;
+		pruned++;
+	}
+
+	ResetInferencePlan();
+	return pruned;
+}
+
+// разложение сети: полносвязные слои не меньше чем с minParams параметрами заменяются слоями с весами ранга rank по усечённому сингулярному разложению,
+// если это уменьшает число параметров; сеть остаётся обучаемой и сохраняемой, разложенная сеть загружается как обычная
+// возвращается количество разложенных слоёв
+int Network::Factorize(int rank, int minParams) {
+	int factorized = 0;
+
+	for (size_t i = 0; i < layers.size(); i++) {
+		if (layers[i]->GetTrainableParams() < minParams)
+			continue;
+
+		NetworkLayer *layer = layers[i]->Factorize(rank);
+
+		if (layer == nullptr)
+			continue;
+
+		if (layer->GetTrainableParams() >= layers[i]->GetTrainableParams()) {
+			delete layer;
+			continue;
+		}
+
+		delete layers[i];
+		layers[i] = layer;
+		factorized++;
+	}
+
+	ResetInferencePlan();
+	return factorized;
+}
+
+// количество чисел в общих буферах плана вывода
+size_t Network::GetInferenceMemory() const {
+	return inferencePlan.GetMemory();
 }
 
 // инициализация индексов батчей
-void Network::InitBatches(const std::vector<Volume> &inputData, const std::vector<Volume> outputData, size_t batchSize, const std::string augmentation) {
+void Network::InitBatches(const std::vector<Volume> &inputData, const std::vector<Volume> &outputData, size_t batchSize, const std::string augmentation) {
 	// формируем индексы для обучающего множества
 	size_t total = inputData.size();
 	std::vector<int> indexes;
@@ -128,40 +504,54 @@ void Network::InitBatches(const std::vector<Volume> &inputData, const std::vecto
 		DataAugmentation generator(augmentation);
 
 		for (size_t index = 0; index < total; index += batchSize) {
-			std::vector<Volume> inputBatch;
-			std::vector<Volume> outputBatch;
+			size_t size = std::min(batchSize, total - index);
+
+			Tensor inputBatch(size, inputData[0].GetSize());
+			Tensor outputBatch(size, outputData[0].GetSize());
 
-			// формируем индексы батча
-			for (size_t i = 0; i < batchSize && index + i < total; i++) {
-				inputBatch.push_back(generator.Make(inputData[indexes[index + i]]));
-				outputBatch.push_back(outputData[indexes[index + i]]);
+			// формируем батч
+			for (size_t i = 0; i < size; i++) {
+				inputBatch[i] = generator.Make(inputData[indexes[index + i]]);
+				outputBatch[i] = outputData[indexes[index + i]];
 			}
 
-			inputBatches.push_back(inputBatch);
-			outputBatches.push_back(outputBatch);
+			inputBatches.push_back(std::move(inputBatch));
+			outputBatches.push_back(std::move(outputBatch));
 		}
 	}
 	else {
 		for (size_t index = 0; index < total; index += batchSize) {
-			std::vector<Volume> inputBatch;
-			std::vector<Volume> outputBatch;
+			size_t size = std::min(batchSize, total - index);
 
-			// формируем индексы батча
-			for (size_t i = 0; i < batchSize && index + i < total; i++) {
-				inputBatch.push_back(inputData[indexes[index + i]]);
-				outputBatch.push_back(outputData[indexes[index + i]]);
+			Tensor inputBatch(size, inputData[0].GetSize());
+			Tensor outputBatch(size, outputData[0].GetSize());
+
+			// формируем батч
+			for (size_t i = 0; i < size; i++) {
+				inputBatch[i] = inputData[indexes[index + i]];
+				outputBatch[i] = outputData[indexes[index + i]];
 			}
 
-			inputBatches.push_back(inputBatch);
-			outputBatches.push_back(outputBatch);
+			inputBatches.push_back(std::move(inputBatch));
+			outputBatches.push_back(std::move(outputBatch));
 		}
 	}
 }
 
 // установка размера батча
 void Network::SetBatchSize(int batchSize) {
-	for (int i = 0; i < layers.size(); i++)
+	NegotiateLayouts();
+	deltas.Resize(batchSize, outputSize);
+
+	for (int i = 0; i < layers.size(); i++) {
+		if (converters[i] != nullptr)
+			converters[i]->SetBatchSize(batchSize);
+
 		layers[i]->SetBatchSize(batchSize);
+
+		if (outputConverters[i] != nullptr)
+			outputConverters[i]->SetBatchSize(batchSize);
+	}
 }
 
  // сброс промежуточных данных
@@ -179,6 +569,7 @@ void Network::AddLayer(const std::string& layerConf) {
 	isLearnable.push_back(true);
 
 	outputSize = layer->GetOutputSize();
+	ResetInferencePlan();
 }
 
 // добавление блока
@@ -207,6 +598,7 @@ void Network::AddBlock(const std::vector<std::vector<std::string>>& blockConf, c
 	isLearnable.push_back(true);
 
 	outputSize = block->GetOutputSize();
+	ResetInferencePlan();
 }
 
 // добавление слоёв другой сети
@@ -226,6 +618,7 @@ void Network::AddNetwork(const Network& network) {
 	}
 
 	outputSize = layers[layers.size() - 1]->GetOutputSize();
+	ResetInferencePlan();
 }
 
 // удаление слоя
@@ -242,6 +635,7 @@ void Network::RemoveLayer(int layer) {
 	}
 
 	layers.erase(layers.begin() + layer); // удаляем слой
+	ResetInferencePlan();
 
 	// если слоёв не осталось
 	if (layers.size() == 0) {
@@ -262,12 +656,23 @@ void Network::PrintConfig() const {
 	std::cout << "+------------------+--------------+---------------+--------------+----------------------------" << std::endl;
 
 	int trainable = 0;
+	std::vector<Layout> layouts;
+	GetLayouts(layouts);
 
 	for (size_t i = 0; i < layers.size(); i++) {
+		Layout from = i == 0 ? Layout::Channels : layouts[i - 1];
+		Layout to = layers[i]->GetLayout();
+
+		if (to != Layout::Any && to != from)
+			LayoutLayer(layers[i]->GetInputSize(), from, to).PrintConfig();
+
 		layers[i]->PrintConfig();
 		trainable += layers[i]->GetTrainableParams();
 	}
 
+	if (layers.size() > 0 && layouts[layers.size() - 1] != Layout::Channels)
+		LayoutLayer(outputSize, layouts[layers.size() - 1], Layout::Channels).PrintConfig();
+
 	std::cout << "+------------------+--------------+---------------+--------------+----------------------------" << std::endl;
 	std::cout << "Total trainable params: " << trainable << std::endl;
 	std::cout << std::endl;
@@ -285,37 +690,36 @@ VolumeSize Network::GetOutputSize() const {
 
 // получение выхода сети
 Volume& Network::GetOutput(const Volume& input) {
-	SetBatchSize(1);
-	layers[0]->ForwardOutput({ input });
-
-	for (size_t i = 1; i < layers.size(); i++)
-		layers[i]->ForwardOutput(layers[i - 1]->GetOutput());
-
-	return layers[layers.size() - 1]->GetOutput()[0];
+	return GetOutput(PackInput(input), 0, layers.size() - 1)[0];
 }
 
 // получение выхода сети, начиная со слоя start
 Volume& Network::GetOutputFromLayer(const Volume& input, int start) {
-	return GetOutput({ input }, start, layers.size() - 1)[0];
+	return GetOutput(PackInput(input), start, layers.size() - 1)[0];
 }
 
 // получение текущего выхода сети
-std::vector<Volume>& Network::GetOutput() {
-	return layers[layers.size() - 1]->GetOutput();
+Tensor& Network::GetOutput() {
+	size_t last = layers.size() - 1;
+
+	if (last < outputConverters.size() && outputConverters[last] != nullptr)
+		return outputConverters[last]->GetOutput();
+
+	return layers[last]->GetOutput();
 }
 
 // получение выхода сети
-std::vector<Volume>& Network::GetOutput(const std::vector<Volume> &inputs) {
+Tensor& Network::GetOutput(const Tensor &inputs) {
 	return GetOutput(inputs, 0, layers.size() - 1);
 }
 
 // получение выхода сети, начиная со слоя start
-std::vector<Volume>& Network::GetOutputFromLayer(const std::vector<Volume>& inputs, int start) {
+Tensor& Network::GetOutputFromLayer(const Tensor& inputs, int start) {
 	return GetOutput(inputs, start, layers.size() - 1);
 }
 
 // получение выхода сети на заданном слое
-std::vector<Volume>& Network::GetOutputAtLayer(const std::vector<Volume> &inputs, int layer) {
+Tensor& Network::GetOutputAtLayer(const Tensor &inputs, int layer) {
 	return GetOutput(inputs, 0, layer);
 }
 
@@ -328,27 +732,14 @@ NetworkLayer* Network::GetLayer(int layer) {
 }
 
 // обучение батча
-double Network::TrainBatch(const std::vector<Volume> &inputBatch, const std::vector<Volume> outputBatch, const LossFunction &E, const Optimizer &optimizer, int start) {
-	size_t size = inputBatch.size();
-	size_t last = layers.size() - 1;
-
-	std::vector<Volume> output = Forward(inputBatch, start); // получаем выход сети
-	std::vector<Volume> deltas(size, Volume(outputSize)); // создаём дельты
+double Network::TrainBatch(const Tensor &inputBatch, const Tensor &outputBatch, const LossFunction &E, const Optimizer &optimizer, int start) {
+	if (inferenceOnly)
+		throw std::runtime_error("Unable to train network optimized for inference");
 
+	Tensor &output = Forward(inputBatch, start); // получаем выход сети
 	double loss = E.CalculateLoss(output, outputBatch, deltas); // расчитываем ошибку
 
-	// распространям ошибку по слоям
-	if (last == 0) {
-		layers[last]->Backward(deltas, inputBatch, true);
-	}
-	else {
-		layers[last]->Backward(deltas, layers[last - 1]->GetOutput(), true);
-
-		for (size_t i = last - 1; i > start; i--)
-			layers[i]->Backward(layers[i + 1]->GetDeltas(), layers[i - 1]->GetOutput(), true);
-
-		layers[start]->Backward(layers[start + 1]->GetDeltas(), inputBatch, false);
-	}
+	Backward(inputBatch, start); // распространям ошибку по слоям
 
 	// обновляем высовые кожффициенты слоёв
 	for (size_t i = start; i < layers.size(); i++)
@@ -357,7 +748,7 @@ double Network::TrainBatch(const std::vector<Volume> &inputBatch, const std::vec
 	return loss; // возвращаем ошибку
 }
 
-double Network::TrainOnBatch(const std::vector<Volume> &inputData, const std::vector<Volume> &outputData, const Optimizer &optimizer, const LossFunction &E, int start) {
+double Network::TrainOnBatch(const Tensor &inputData, const Tensor &outputData, const Optimizer &optimizer, const LossFunction &E, int start) {
 	SetBatchSize(inputData.size());
 
 	return TrainBatch(inputData, outputData, E, optimizer, start);
@@ -460,6 +851,9 @@ void Network::LRFind(const std::string &path, const std::vector<Volume> &inputDa
 
 // сохранение сети в файл
 void Network::Save(const std::string &path, bool verbose) const {
+	if (inferenceOnly)
+		throw std::runtime_error("Unable to save network optimized for inference");
+
 	std::ofstream f(path); // создаём файл для сети
 
 	f << inputSize.width << " " << inputSize.height << " " << inputSize.deep << std::endl; // записываем размер входа
@@ -484,6 +878,9 @@ void Network::Load(const std::string &path, bool verbose) {
 	f >> inputSize;
 
 	layers.clear();
+	isLearnable.clear();
+	ResetInferencePlan();
+	inferenceOnly = false;
 	std::string layerType;
 
 	while (f >> layerType) {
@@ -505,12 +902,18 @@ void Network::Load(const std::string &path, bool verbose) {
 
 // визуализация активаций нейронной сети на каждом из уровней
 void Network::Visualize(const Volume& input, const std::string &path, int blockSize) {
-	Volume &output = GetOutput(input);
+	GetOutput(PackInput(input), 0, layers.size() - 1, false); // нужны выходы всех слоёв, поэтому план не используется
 
 	input.Save(path + "input", blockSize);
 
-	for (size_t i = 0; i < layers.size(); i++)
-		layers[i]->GetOutput()[0].Save(path + "layer" + std::to_string(i + 1), blockSize);
+	for (size_t i = 0; i < layers.size(); i++) {
+		Volume activation = layers[i]->GetOutput()[0];
+
+		if (outputConverters[i] != nullptr)
+			BlockedToChannels(layers[i]->GetOutput()[0].Data(), activation.Data(), activation.GetSize());
+
+		activation.Save(path + "layer" + std::to_string(i + 1), blockSize);
+	}
 }
 
 // изменение обучаемости слоя
@@ -527,8 +930,10 @@ void Network::SetLearnable(bool learnable) {
 		isLearnable[i] = learnable;
 }
 
-void Network::GradientChecking(const std::vector<Volume> &inputData, const std::vector<Volume> &outputData, const LossFunction &E) {
-	size_t last = layers.size() - 1;
+void Network::GradientChecking(const Tensor &inputData, const Tensor &outputData, const LossFunction &E) {
+	if (inferenceOnly)
+		throw std::runtime_error("Unable to check gradients of network optimized for inference");
+
 	size_t batchSize = inputData.size();
 
 	SetBatchSize(batchSize);
@@ -547,9 +952,13 @@ void Network::GradientChecking(const std::vector<Volume> &inputData, const std::
 		double maxGrad = 0;
 		double maxDf = 0;
 
+		// шаг и допуск подобраны для double, для float они растут как кубический корень и его квадрат отношения машинных эпсилонов
+		double precision = std::numeric_limits<real>::epsilon() / std::numeric_limits<double>::epsilon();
+		double eps = 4e-6 * cbrt(precision);
+		double tolerance = 1e-7 * cbrt(precision * precision);
+
 		for (int index = 0; index < trainableParams; index++) {
 			double weight = layers[i]->GetParam(index);
-			double eps = 4e-6;
 
 			layers[i]->SetParam(index, weight + eps);
 			double E1 = E.CalculateLoss(Forward(inputData), outputData);
@@ -560,20 +969,8 @@ void Network::GradientChecking(const std::vector<Volume> &inputData, const std::
 			layers[i]->SetParam(index, weight);
 			layers[i]->ZeroGradient(index);
 
-			std::vector<Volume> deltas(batchSize, Volume(outputSize));
 			E.CalculateLoss(Forward(inputData), outputData, deltas);
-
-			if (last == 0) {
-				layers[0]->Backward(deltas, inputData, false);
-			}
-			else {
-				layers[last]->Backward(deltas, layers[last - 1]->GetOutput(), true);
-
-				for (size_t i = last - 1; i > 0; i--)
-					layers[i]->Backward(layers[i + 1]->GetDeltas(), layers[i - 1]->GetOutput(), true);
-
-				layers[0]->Backward(layers[1]->GetDeltas(), inputData, false);
-			}
+			Backward(inputData, 0);
 
 			double grad = layers[i]->GetGradient(index);
 			double num_grad = (E1 - E2) / (eps * 2);
@@ -581,7 +978,7 @@ void Network::GradientChecking(const std::vector<Volume> &inputData, const std::
 			maxGrad = std::max(fabs(grad), maxGrad);
 			maxDf = std::max(fabs(grad - num_grad), maxDf);
 
-			if (fabs(grad - num_grad) > 1e-7) {
+			if (fabs(grad - num_grad) > tolerance) {
 				std::cout << index << ". grad: " << grad << ", num_grad: " << num_grad << ", |grad - num_grad|: " << fabs(grad - num_grad) << std::endl;
 				throw std::runtime_error("GradientChecking failed at layer " + std::to_string(i + 1));
 			}
@@ -600,7 +997,7 @@ void Network::PrintGradientsStats() {
 	std::cout << "+-------+---------------+---------------+" << std::endl;
 
 	for (size_t i = 0; i < layers.size(); i++) {
-		std::vector<Volume> &dX = layers[i]->GetDeltas();
+		Tensor &dX = layers[i]->GetDeltas();
 
 		double min = dX[0].Min();
 		double max = dX[0].Max();
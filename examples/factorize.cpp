@@ -0,0 +1,78 @@
+#include <iostream>
+#include <fstream>
+#include <random>
+#include "../Network.hpp"
+
+using namespace std;
+
+// количество обучаемых параметров сети
+int GetTrainableParams(Network &network) {
+	int params = 0;
+
+	for (int i = 0; i < network.LayersCount(); i++)
+		params += network.GetLayer(i)->GetTrainableParams();
+
+	return params;
+}
+
+// размер файла в байтах
+long FileSize(const string &path) {
+	ifstream f(path, ios::binary | ios::ate);
+	return f.tellg();
+}
+
+// разложение полносвязных слоёв сохранённой сети: factorize [модель] [результат] [ранг] [минимум параметров слоя]
+// результат загружается Network::Load как обычная сеть и может быть дообучен
+int main(int argc, char **argv) {
+	string model = argc > 1 ? argv[1] : "../models/mnist_99.67.txt"; // обученная сеть
+	string factorizedModel = argc > 2 ? argv[2] : "mnist_low_rank.txt"; // разложенная сеть
+	int rank = argc > 3 ? stoi(argv[3]) : 32; // ранг весов разложенных слоёв
+	int minParams = argc > 4 ? stoi(argv[4]) : 10000; // слои с меньшим числом параметров не раскладываются
+
+	int count = 64; // число случайных входов для сравнения выходов
+
+	Network network(model);
+	int params = GetTrainableParams(network);
+
+	VolumeSize inputSize = network.GetLayer(0)->GetInputSize();
+	Tensor inputs(count, inputSize);
+	default_random_engine generator;
+	uniform_real_distribution<real> distribution(0, 1);
+
+	for (int i = 0; i < count * inputSize.height * inputSize.width * inputSize.deep; i++)
+		inputs.Data()[i] = distribution(generator);
+
+	Tensor expected = network.GetOutput(inputs);
+
+	int factorized = network.Factorize(rank, minParams); // заменяем крупные полносвязные слои произведениями матриц ранга rank
+	network.PrintConfig();
+	network.Save(factorizedModel, false);
+
+	Network loaded(factorizedModel);
+	Tensor &output = loaded.GetOutput(inputs);
+
+	real maxDelta = 0;
+	int agreement = 0;
+
+	for (int n = 0; n < count; n++) {
+		int expectedClass = 0;
+		int outputClass = 0;
+
+		for (int i = 0; i < expected[n].Total(); i++) {
+			maxDelta = max(maxDelta, (real) fabs(output[n][i] - expected[n][i]));
+
+			if (expected[n][i] > expected[n][expectedClass])
+				expectedClass = i;
+
+			if (output[n][i] > output[n][outputClass])
+				outputClass = i;
+		}
+
+		agreement += expectedClass == outputClass;
+	}
+
+	cout << "Factorized layers: " << factorized << " (rank " << rank << ")" << endl;
+	cout << "Params: " << params << " (original) vs " << GetTrainableParams(loaded) << " (factorized)" << endl;
+	cout << "Model file: " << FileSize(model) << " bytes (original) vs " << FileSize(factorizedModel) << " bytes (factorized)" << endl;
+	cout << "Max output delta: " << maxDelta << ", same class: " << agreement << " / " << count << endl;
+}
@@ -76,7 +76,7 @@ vector<Volume> GenerateNoise(int batchSize, int latentDim) {
 }
 
 // генерация случайных данных
-vector<Volume>& GenerateFakeExamples(Network &generator, int latentDim, int batchSize) {
+Tensor& GenerateFakeExamples(Network &generator, int latentDim, int batchSize) {
 	vector<Volume> noise = GenerateNoise(batchSize, latentDim);
 
 	return generator.GetOutput(noise);
@@ -100,7 +100,7 @@ void DenormImage(Volume &volume) {
 
 // сохранение сгенерированных картинок  сети
 void SaveExamples(Network &generator, int latentDim, int count, int epoch, int w, int h, int d) {
-	vector<Volume>& fakeData = GenerateFakeExamples(generator, latentDim, count);
+	Tensor& fakeData = GenerateFakeExamples(generator, latentDim, count);
 		
 	string path = "epoch" + to_string(epoch);
 	system((string("mkdir ") + path).c_str());
@@ -115,7 +115,7 @@ void SaveExamples(Network &generator, int latentDim, int count, int epoch, int w
 }
 
 // точность классификации
-double Accuracy(vector<Volume> &output, vector<Volume> &targets) {
+double Accuracy(Tensor &output, vector<Volume> &targets) {
 	double acc = 0;
 
 	for (int i = 0; i < output.size(); i++) {
@@ -183,7 +183,7 @@ int main() {
 
 		for (int batch = 0; batch < batchCount; batch++) {
 			vector<Volume> realData = GenerateRealExamples(loader.trainInputData, halfBatch); // выбираем случайные реальные картинки
-			vector<Volume> fakeData = GenerateFakeExamples(generator, latentDim, halfBatch); // генерируем картинки из шума
+			Tensor fakeData = GenerateFakeExamples(generator, latentDim, halfBatch); // генерируем картинки из шума
 			vector<Volume> noise = GenerateNoise(batchSize, latentDim); // генерируем шум
 
 			vector<Volume> realOutputs(halfBatch, Volume(1, 1, 1));
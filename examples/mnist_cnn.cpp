@@ -49,6 +49,7 @@ int main() {
 	network.AddLayer("fullconnected outputs=10");
 	network.AddLayer("softmax");
 
+	network.Autotune(batchSize); // подбираем самые быстрые алгоритмы свёрток (результаты замеров сохраняются в кэш)
 	network.PrintConfig(); // выводим конфигурацию сети
 
 	Optimizer optimizer = Optimizer::AdaMax(learningRate); // оптимизатор - Adamax
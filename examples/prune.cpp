@@ -0,0 +1,72 @@
+#include <iostream>
+#include <fstream>
+#include "../Network.hpp"
+#include "../Entities/DataLoader.hpp"
+
+using namespace std;
+
+// среднее время (мс) вывода батча из batchSize примеров
+double MeasureInference(Network &network, const vector<Volume> &data, int batchSize, int repeats) {
+	Tensor batch(vector<Volume>(data.begin(), data.begin() + batchSize));
+	network.PlanInference(batchSize);
+	network.GetOutput(batch); // прогрев
+
+	TimePoint t0 = Time::now();
+
+	for (int i = 0; i < repeats; i++)
+		network.GetOutput(batch);
+
+	TimePoint t1 = Time::now();
+	return chrono::duration<double, milli>(t1 - t0).count() / repeats;
+}
+
+// размер файла в байтах
+long FileSize(const string &path) {
+	ifstream f(path, ios::binary | ios::ate);
+	return f.tellg();
+}
+
+int main() {
+	string dir = "../dataset/"; // путь к папке с файлами
+	string train = dir + "mnist_train.csv"; // обучающая выборка (на ней дообучается прореженная сеть)
+	string test = dir + "mnist_test.csv"; // тестовая выборка
+	string labels = dir + "mnist.txt"; // файл с классами
+	string model = "../models/mnist_99.67.txt"; // обученная сеть
+	string prunedModel = "mnist_pruned.txt"; // прореженная сеть
+
+	int width = 28; // ширина изображений
+	int height = 28; // высота изображений
+	int deep = 1; // количество каналов
+
+	real sparsity = 0.9; // доля удаляемых весов
+	int minParams = 10000; // слои с меньшим числом параметров не прореживаются
+	int trainCount = 10000; // число примеров для дообучения
+	int fineTuneEpochs = 1; // число эпох дообучения
+	int batchSize = 64; // размер батча при замере времени
+	int repeats = 50; // число замеров
+
+	DataLoader loader(train, width, height, deep, labels, trainCount);
+
+	Network network(model);
+
+	double denseAcc = loader.Test(network, test, "Dense accuracy: ", 10000);
+	double denseTime = MeasureInference(network, loader.trainInputData, batchSize, repeats);
+
+	int pruned = network.Prune(sparsity, minParams); // заменяем крупные полносвязные слои разреженными
+	network.PrintConfig();
+
+	double prunedAcc = loader.Test(network, test, "Pruned accuracy: ", 10000);
+
+	// дообучение сохраняет маску: обновляются только оставшиеся веса
+	network.Train(loader.trainInputData, loader.trainOutputData, 32, fineTuneEpochs, Optimizer::Adam(0.0001), LossFunction::CrossEntropy());
+
+	double tunedAcc = loader.Test(network, test, "Fine-tuned accuracy: ", 10000);
+	double sparseTime = MeasureInference(network, loader.trainInputData, batchSize, repeats);
+
+	network.Save(prunedModel);
+
+	cout << "Pruned layers: " << pruned << endl;
+	cout << "Accuracy: " << denseAcc << " (dense) vs " << prunedAcc << " (pruned) vs " << tunedAcc << " (fine-tuned)" << endl;
+	cout << "Model file: " << FileSize(model) << " bytes (dense) vs " << FileSize(prunedModel) << " bytes (sparse)" << endl;
+	cout << "Batch " << batchSize << " time: " << denseTime << " ms (dense) vs " << sparseTime << " ms (sparse), speedup: " << denseTime / sparseTime << "x" << endl;
+}
@@ -0,0 +1,61 @@
+#include <iostream>
+#include <fstream>
+#include "../Network.hpp"
+#include "../Entities/DataLoader.hpp"
+
+using namespace std;
+
+// среднее время (мс) вывода батча из batchSize примеров
+double MeasureInference(Network &network, const vector<Volume> &data, int batchSize, int repeats) {
+	Tensor batch(vector<Volume>(data.begin(), data.begin() + batchSize));
+	network.PlanInference(batchSize);
+	network.GetOutput(batch); // прогрев
+
+	TimePoint t0 = Time::now();
+
+	for (int i = 0; i < repeats; i++)
+		network.GetOutput(batch);
+
+	TimePoint t1 = Time::now();
+	return chrono::duration<double, milli>(t1 - t0).count() / repeats;
+}
+
+int main() {
+	string dir = "../dataset/"; // путь к папке с файлами
+	string train = dir + "mnist_train.csv"; // обучающая выборка (из неё берутся калибровочные примеры)
+	string test = dir + "mnist_test.csv"; // тестовая выборка
+	string labels = dir + "mnist.txt"; // файл с классами
+	string model = "../models/mnist_99.67.txt"; // обученная сеть
+
+	int width = 28; // ширина изображений
+	int height = 28; // высота изображений
+	int deep = 1; // количество каналов
+
+	int calibrationCount = 1000; // число калибровочных примеров
+	int batchSize = 64; // размер батча при замере времени
+	int repeats = 50; // число замеров
+
+	DataLoader loader(train, width, height, deep, labels, calibrationCount); // загружаем калибровочные данные
+
+	Network network(model);
+	network.OptimizeForInference(); // встраиваем нормализацию и активации в свёртки, чтобы квантовать их вместе
+
+	int params = 0;
+
+	for (int i = 0; i < network.LayersCount(); i++)
+		params += network.GetLayer(i)->GetTrainableParams();
+
+	double floatAcc = loader.Test(network, test, "Float accuracy: ", 10000);
+	double floatTime = MeasureInference(network, loader.trainInputData, batchSize, repeats);
+
+	int quantized = network.Quantize(loader.trainInputData); // калибруем диапазоны входов и заменяем слои на int8
+	network.PrintConfig();
+
+	double int8Acc = loader.Test(network, test, "Int8 accuracy: ", 10000);
+	double int8Time = MeasureInference(network, loader.trainInputData, batchSize, repeats);
+
+	cout << "Quantized layers: " << quantized << endl;
+	cout << "Accuracy: " << floatAcc << " (float) vs " << int8Acc << " (int8), delta: " << (int8Acc - floatAcc) << endl;
+	cout << "Weights: " << params * sizeof(real) << " bytes (float) vs ~" << params << " bytes (int8)" << endl;
+	cout << "Batch " << batchSize << " time: " << floatTime << " ms (float) vs " << int8Time << " ms (int8), speedup: " << floatTime / int8Time << "x" << endl;
+}
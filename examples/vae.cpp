@@ -146,8 +146,8 @@ void ShowLatentDistribution(Network &network, int latentDim, const string &path,
 			zMin = min(out[0], out[1]);
 		}
 		else {
-			zMin = min(zMin, min(out[0], out[1]));
-			zMax = max(zMax, max(out[0], out[1]));
+			zMin = min(zMin, (double) min(out[0], out[1]));
+			zMax = max(zMax, (double) max(out[0], out[1]));
 		}
 
 		z.push_back(out);
@@ -177,7 +177,7 @@ void ShowLatentDistribution(Network &network, int latentDim, const string &path,
 // сохранение сгенерированных картинок сети
 void SaveExamples(Network &network, int latentDim, const string& path, int decoderStart, VolumeSize size, int count) {
 	vector<Volume> noise = GenerateNoise(count, latentDim);
-	vector<Volume> results = network.GetOutputFromLayer(noise, decoderStart);
+	Tensor results = network.GetOutputFromLayer(noise, decoderStart);
 
 	for (int i = 0; i < count; i++) {
 		DenormImage(results[i], size);		
@@ -192,7 +192,7 @@ void SavePredictions(Network &network, const string& path, const vector<Volume>
 	for (int i = 0; i < count; i++)
 		input.push_back(realData[rand() % realData.size()]);
 
-	vector<Volume> predictions = network.GetOutput(input);
+	Tensor predictions = network.GetOutput(input);
 
 	for (int i = 0; i < count; i++) {
 		DenormImage(predictions[i], size);
@@ -132,7 +132,7 @@ void SetHsv(Volume& img, int x, int y, double H, double V) {
 // сохранение сгенерированных картинок сети
 void SaveExamples(Network &network, int latentDim, const string& path, int decoderStart, VolumeSize size, int count) {
 	vector<Volume> noise = GenerateNoise(count, latentDim);
-	vector<Volume> results = network.GetOutputFromLayer(noise, decoderStart);
+	Tensor results = network.GetOutputFromLayer(noise, decoderStart);
 
 	for (int i = 0; i < count; i++) {
 		DenormImage(results[i], size);		
@@ -147,7 +147,7 @@ void SavePredictions(Network &network, const string& path, const vector<Volume>
 	for (int i = 0; i < count; i++)
 		input.push_back(realData[rand() % realData.size()]);
 
-	vector<Volume> predictions = network.GetOutput(input);
+	Tensor predictions = network.GetOutput(input);
 
 	for (int i = 0; i < count; i++) {
 		DenormImage(predictions[i], size);
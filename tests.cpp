@@ -1,19 +1,53 @@
 #include <iostream>
 #include <cassert>
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include <limits>
+#include <omp.h>
 
 #include "Layers/ConvLayer.hpp"
+#include "Layers/ConvWithoutStrideLayer.hpp"
 #include "Layers/ConvTransposedLayer.hpp"
+#include "Layers/GroupConvLayer.hpp"
 #include "Layers/UpscaleLayer.hpp"
 #include "Layers/UpscaleBilinearLayer.hpp"
 #include "Layers/MaxPoolingLayer.hpp"
 #include "Layers/AveragePoolingLayer.hpp"
 #include "Layers/FullyConnectedLayer.hpp"
 #include "Layers/DropoutLayer.hpp"
+#include "Layers/ReshapeLayer.hpp"
+#include "Layers/IdentityLayer.hpp"
 #include "Layers/BatchNormalizationLayer.hpp"
 #include "Network.hpp"
 
 using namespace std;
 
+std::atomic<size_t> heapAllocations(0); // выделения глобальным operator new (в том числе std::vector и std::string)
+
+void* operator new(size_t size) {
+	heapAllocations++;
+	void *pointer = malloc(size == 0 ? 1 : size);
+
+	if (pointer == nullptr)
+		throw std::bad_alloc();
+
+	return pointer;
+}
+
+void operator delete(void *pointer) noexcept {
+	free(pointer);
+}
+
+void operator delete(void *pointer, size_t size) noexcept {
+	free(pointer);
+}
+
+// допуск сравнения, заданный для double, пересчитанный под точность real (для float растёт в eps(float) / eps(double) раз)
+real Tolerance(double tolerance) {
+	return tolerance * (numeric_limits<real>::epsilon() / numeric_limits<double>::epsilon());
+}
+
 void FullyConnectedLayerTest() {
 	cout << "Full connected tests: ";
 	VolumeSize size;
@@ -72,18 +106,530 @@ void FullyConnectedLayerTest() {
 	layer.Backward({deltas}, {input}, true);
 	Volume &prev = layer.GetDeltas()[0];
 
-	assert(fabs(prev(0, 0, 0) + 0.05) < 1e-15);
-	assert(fabs(prev(1, 0, 0) - 0.15) < 1e-15);
-	assert(fabs(prev(2, 0, 0) + 0.35) < 1e-15);
-	assert(fabs(prev(3, 0, 0) + 1.55) < 1e-15);
-	assert(fabs(prev(4, 0, 0) - 2.65) < 1e-15);
-	assert(fabs(prev(5, 0, 0) - 3.4) < 1e-15);
-	assert(fabs(prev(6, 0, 0) - 0.65) < 1e-15);
-	assert(fabs(prev(7, 0, 0) + 2.1) < 1e-15);
+	assert(fabs(prev(0, 0, 0) + 0.05) < Tolerance(1e-15));
+	assert(fabs(prev(1, 0, 0) - 0.15) < Tolerance(1e-15));
+	assert(fabs(prev(2, 0, 0) + 0.35) < Tolerance(1e-15));
+	assert(fabs(prev(3, 0, 0) + 1.55) < Tolerance(1e-15));
+	assert(fabs(prev(4, 0, 0) - 2.65) < Tolerance(1e-15));
+	assert(fabs(prev(5, 0, 0) - 3.4) < Tolerance(1e-15));
+	assert(fabs(prev(6, 0, 0) - 0.65) < Tolerance(1e-15));
+	assert(fabs(prev(7, 0, 0) + 2.1) < Tolerance(1e-15));
 
 	std::cout << "OK" << std::endl;
 }
 
+void FullyConnectedGemmTest() {
+	cout << "Full connected GEMM tests: ";
+
+	VolumeSize size;
+	size.height = 2;
+	size.width = 5;
+	size.deep = 30;
+
+	int inputs = 300; // больше блока общей размерности GEMM
+	int outputs = 19;
+	int batchSize = 6;
+
+	FullyConnectedLayer layer(size, outputs, "leakyrelu");
+	layer.SetBatchSize(batchSize);
+
+	Tensor X(batchSize, size);
+	Tensor dout(batchSize, 1, 1, outputs);
+
+	for (int i = 0; i < batchSize * inputs; i++)
+		X.Data()[i] = sin(i * 0.37);
+
+	for (int i = 0; i < batchSize * outputs; i++)
+		dout.Data()[i] = cos(i * 0.11);
+
+	layer.Forward(X);
+	layer.Backward(dout, X, true);
+
+	// прямой и обратный проходы совпадают с поэлементным вычислением
+	vector<real> deltas(batchSize * outputs);
+
+	for (int n = 0; n < batchSize; n++) {
+		for (int i = 0; i < outputs; i++) {
+			real sum = layer.GetParam(i * (inputs + 1) + inputs);
+
+			for (int j = 0; j < inputs; j++)
+				sum += layer.GetParam(i * (inputs + 1) + j) * X[n][j];
+
+			assert(fabs(layer.GetOutput()[n][i] - (sum > 0 ? sum : 0.01 * sum)) < Tolerance(1e-12));
+			deltas[n * outputs + i] = dout[n][i] * (sum > 0 ? 1 : 0.01);
+		}
+	}
+
+	for (int n = 0; n < batchSize; n++) {
+		for (int j = 0; j < inputs; j++) {
+			real sum = 0;
+
+			for (int i = 0; i < outputs; i++)
+				sum += layer.GetParam(i * (inputs + 1) + j) * deltas[n * outputs + i];
+
+			assert(fabs(layer.GetDeltas()[n][j] - sum) < Tolerance(1e-12));
+		}
+	}
+
+	for (int i = 0; i < outputs; i++) {
+		for (int j = 0; j <= inputs; j++) {
+			real sum = 0;
+
+			for (int n = 0; n < batchSize; n++)
+				sum += deltas[n * outputs + i] * (j < inputs ? X[n][j] : 1);
+
+			assert(fabs(layer.GetGradient(i * (inputs + 1) + j) - sum) < Tolerance(1e-12));
+		}
+	}
+
+	// полосы строк dW и столбцов dX делятся между потоками без редукции, поэтому градиенты не зависят от количества потоков
+	int threads = omp_get_max_threads();
+	Tensor deltasX = layer.GetDeltas();
+	vector<real> gradients(layer.GetTrainableParams());
+
+	for (int j = 0; j < layer.GetTrainableParams(); j++)
+		gradients[j] = layer.GetGradient(j);
+
+	vector<int> counts = { 1, 3, 7 };
+
+	for (size_t t = 0; t < counts.size(); t++) {
+		omp_set_num_threads(counts[t]);
+		layer.UpdateWeights(Optimizer::SGD(0.1), false); // только обнуляет градиенты
+		layer.Backward(dout, X, true);
+
+		for (int n = 0; n < batchSize; n++)
+			for (int j = 0; j < inputs; j++)
+				assert(layer.GetDeltas()[n][j] == deltasX[n][j]);
+
+		for (int j = 0; j < layer.GetTrainableParams(); j++)
+			assert(layer.GetGradient(j) == gradients[j]);
+	}
+
+	omp_set_num_threads(threads);
+
+	// выход примера не зависит от размера батча, а изменённые веса упаковываются заново
+	Tensor expected = layer.GetOutput();
+
+	for (int n = 0; n < batchSize; n++) {
+		layer.SetBatchSize(1);
+		layer.ForwardOutput({ X[n] });
+
+		for (int i = 0; i < outputs; i++)
+			assert(layer.GetOutput()[0][i] == expected[n][i]);
+	}
+
+	layer.SetParam(0, layer.GetParam(0) + 1);
+	layer.ForwardOutput({ X[0] });
+
+	real sum = layer.GetParam(inputs);
+
+	for (int j = 0; j < inputs; j++)
+		sum += layer.GetParam(j) * X[0][j];
+
+	assert(fabs(layer.GetOutput()[0][0] - (sum > 0 ? sum : 0.01 * sum)) < Tolerance(1e-12));
+	cout << "OK" << endl;
+}
+
+void FullyConnectedActivationTest() {
+	cout << "Fully connected activation tests: ";
+
+	int count = 203;
+	std::vector<real> bias(count), sums(count), dout(count);
+
+	for (int i = 0; i < count; i++) {
+		bias[i] = 0.25 - (i % 7) * 0.125;
+		sums[i] = (i - count / 2) * 0.37;
+		dout[i] = 1 + (i % 5) * 0.5;
+	}
+
+	std::vector<real> shiftedBias(count + 1);
+
+	for (int i = 0; i < count; i++)
+		shiftedBias[i + 1] = bias[i];
+
+	for (int a = 0; a <= (int) FullyConnectedActivation::ELU; a++) {
+		FullyConnectedActivation activation = (FullyConnectedActivation) a;
+		std::vector<real> y(sums);
+		std::vector<real> shifted(1, 0);
+		shifted.insert(shifted.end(), sums.begin(), sums.end());
+		std::vector<real> delta(count);
+
+		ActivateRows(activation, bias.data(), y.data(), 1, count);
+		ActivateRows(activation, shiftedBias.data() + 1, shifted.data() + 1, 1, count); // та же строка, невыровненная на элемент
+		ActivationGradientRows(activation, y.data(), dout.data(), delta.data(), 1, count);
+
+		for (int i = 0; i < count; i++) {
+			real x = sums[i] + bias[i];
+			real value = x;
+			real df = 1;
+
+			if (activation == FullyConnectedActivation::Sigmoid) {
+				value = 1 / (1 + exp(-x));
+				df = value * (1 - value);
+			}
+			else if (activation == FullyConnectedActivation::Tanh) {
+				value = tanh(x);
+				df = 1 - value * value;
+			}
+			else if (activation == FullyConnectedActivation::ReLU) {
+				value = x > 0 ? x : 0;
+				df = x > 0 ? 1 : 0;
+			}
+			else if (activation == FullyConnectedActivation::LeakyReLU) {
+				value = x > 0 ? x : 0.01 * x;
+				df = x > 0 ? 1 : 0.01;
+			}
+			else if (activation == FullyConnectedActivation::ELU) {
+				value = x > 0 ? x : exp(x) - 1;
+				df = x > 0 ? 1 : exp(x);
+			}
+
+			assert(fabs(y[i] - value) < Tolerance(1e-13) * (1 + fabs(value)));
+			assert(fabs(delta[i] - dout[i] * df) < Tolerance(1e-13) * dout[i]);
+			assert(shifted[i + 1] == y[i]);
+		}
+	}
+
+	cout << "OK" << endl;
+}
+
+void SparseFullyConnectedTest() {
+	cout << "Sparse full connected tests: ";
+
+	VolumeSize size;
+	size.height = 2;
+	size.width = 5;
+	size.deep = 30;
+
+	int inputs = 300;
+	int outputs = 19;
+	int batchSize = 21; // больше блока примеров разреженного умножения и не кратен ему
+
+	FullyConnectedLayer dense(size, outputs, "leakyrelu");
+
+	for (int i = 0; i < outputs * (inputs + 1); i++)
+		dense.SetParam(i, sin(i * 1.7) + 0.3 * cos(i * 0.13));
+
+	// прореживание оставляет 20% наибольших по модулю весов, остальные обнуляются в плотном слое для сравнения
+	SparseFullyConnectedLayer *sparse = dynamic_cast<SparseFullyConnectedLayer*>(dense.Prune(0.8));
+	assert(sparse != nullptr);
+	assert(sparse->GetTrainableParams() == inputs * outputs / 5 + outputs);
+
+	vector<real> magnitudes;
+
+	for (int i = 0; i < outputs; i++)
+		for (int j = 0; j < inputs; j++)
+			magnitudes.push_back(fabs(dense.GetParam(i * (inputs + 1) + j)));
+
+	sort(magnitudes.begin(), magnitudes.end());
+	real threshold = magnitudes[magnitudes.size() - inputs * outputs / 5];
+	int index = 0;
+
+	for (int i = 0; i < outputs; i++) {
+		for (int j = 0; j < inputs; j++) {
+			if (fabs(dense.GetParam(i * (inputs + 1) + j)) >= threshold)
+				assert(sparse->GetParam(index++) == dense.GetParam(i * (inputs + 1) + j));
+			else
+				dense.SetParam(i * (inputs + 1) + j, 0);
+		}
+	}
+
+	Tensor X(batchSize, size);
+	Tensor dout(batchSize, 1, 1, outputs);
+
+	for (int i = 0; i < batchSize * inputs; i++)
+		X.Data()[i] = sin(i * 0.37);
+
+	for (int i = 0; i < batchSize * outputs; i++)
+		dout.Data()[i] = cos(i * 0.11);
+
+	dense.SetBatchSize(batchSize);
+	sparse->SetBatchSize(batchSize);
+
+	dense.Forward(X);
+	dense.Backward(dout, X, true);
+	sparse->Forward(X);
+	sparse->Backward(dout, X, true);
+
+	for (int i = 0; i < batchSize * outputs; i++)
+		assert(fabs(sparse->GetOutput().Data()[i] - dense.GetOutput().Data()[i]) < Tolerance(1e-12));
+
+	for (int i = 0; i < batchSize * inputs; i++)
+		assert(fabs(sparse->GetDeltas().Data()[i] - dense.GetDeltas().Data()[i]) < Tolerance(1e-12));
+
+	index = 0;
+
+	for (int i = 0; i < outputs; i++) {
+		for (int j = 0; j < inputs; j++)
+			if (dense.GetParam(i * (inputs + 1) + j) != 0)
+				assert(fabs(sparse->GetGradient(index++) - dense.GetGradient(i * (inputs + 1) + j)) < Tolerance(1e-12));
+
+		assert(fabs(sparse->GetGradient(sparse->GetTrainableParams() - outputs + i) - dense.GetGradient(i * (inputs + 1) + inputs)) < Tolerance(1e-12));
+	}
+
+	// выход примера не зависит от размера батча
+	Tensor expected = sparse->GetOutput();
+	sparse->SetBatchSize(1);
+
+	for (int n = 0; n < batchSize; n++) {
+		sparse->ForwardOutput({ X[n] });
+
+		for (int i = 0; i < outputs; i++)
+			assert(sparse->GetOutput()[0][i] == expected[n][i]);
+	}
+
+	delete sparse;
+
+	// прореженная сеть дообучается с сохранением маски, сохраняется и загружается
+	Network network(10, 10, 3);
+	network.AddLayer("fc outputs=32 activation=relu");
+	network.AddLayer("fc outputs=4");
+
+	assert(network.Prune(0.75, 1000) == 1); // маленький выходной слой не прореживается
+	assert(network.GetLayer(0)->GetTrainableParams() == 300 * 32 / 4 + 32);
+
+	Tensor inputs3(4, 10, 10, 3);
+	Tensor targets(4, 1, 1, 4);
+
+	for (int i = 0; i < 4 * 300; i++)
+		inputs3.Data()[i] = sin(i * 0.21);
+
+	for (int i = 0; i < 4 * 4; i++)
+		targets.Data()[i] = cos(i * 0.5);
+
+	double loss = network.TrainOnBatch(inputs3, targets, Optimizer::SGD(0.01), LossFunction::MSE());
+
+	for (int i = 0; i < 20; i++)
+		network.TrainOnBatch(inputs3, targets, Optimizer::SGD(0.01), LossFunction::MSE());
+
+	assert(network.TrainOnBatch(inputs3, targets, Optimizer::SGD(0.01), LossFunction::MSE()) < loss);
+	assert(network.GetLayer(0)->GetTrainableParams() == 300 * 32 / 4 + 32);
+
+	Tensor trained = network.GetOutput(inputs3);
+	network.Save("sparse_network_test.txt", false);
+
+	Network loaded(10, 10, 3);
+	loaded.Load("sparse_network_test.txt", false);
+	remove("sparse_network_test.txt");
+
+	Tensor &output = loaded.GetOutput(inputs3);
+
+	for (int i = 0; i < 4 * 4; i++)
+		assert(fabs(output.Data()[i] - trained.Data()[i]) < Tolerance(1e-10));
+
+	cout << "OK" << endl;
+}
+
+// численная проверка градиентов разреженного слоя в сети
+void SparseFullyConnectedGradientCheckingTest() {
+	default_random_engine generator;
+	normal_distribution<double> distribution(0.0, 1.0);
+
+	Tensor inputs(3, 4, 4, 3);
+	Tensor outputs(3, 1, 1, 10);
+
+	for (int i = 0; i < 3 * inputs.Total(); i++)
+		inputs.Data()[i] = distribution(generator);
+
+	for (int i = 0; i < 3 * outputs.Total(); i++)
+		outputs.Data()[i] = distribution(generator);
+
+	Network network(4, 4, 3);
+
+	network.AddLayer("sparsefc outputs=18 activation=elu sparsity=0.5");
+	network.AddLayer("fullconnected outputs=10 activation=sigmoid");
+
+	network.GradientChecking(inputs, outputs, LossFunction::MSE());
+	network.GradientChecking(inputs, outputs, LossFunction::Logcosh());
+}
+
+void LowRankFullyConnectedTest() {
+	cout << "Low rank full connected tests: ";
+
+	// сингулярное разложение в полном ранге восстанавливает матрицу, сингулярные векторы ортонормированы, числа упорядочены по убыванию
+	for (int transposed = 0; transposed < 2; transposed++) {
+		int rows = transposed ? 37 : 23;
+		int cols = transposed ? 23 : 37;
+		int rank = 23;
+
+		Matrix A(rows, cols);
+		Matrix U(rows, rank);
+		Matrix V(cols, rank);
+		vector<real> S;
+
+		for (int i = 0; i < rows; i++)
+			for (int j = 0; j < cols; j++)
+				A(i, j) = sin(i * 1.3 + j * j * 0.7) + 0.1 * cos(i * j * 0.05);
+
+		TruncatedSVD(A, rank, U, S, V);
+
+		for (int k = 1; k < rank; k++)
+			assert(S[k] <= S[k - 1]);
+
+		for (int i = 0; i < rows; i++) {
+			for (int j = 0; j < cols; j++) {
+				real value = 0;
+
+				for (int k = 0; k < rank; k++)
+					value += U(i, k) * S[k] * V(j, k);
+
+				assert(fabs(value - A(i, j)) < Tolerance(1e-10));
+			}
+		}
+
+		for (int k = 0; k < rank; k++) {
+			for (int l = 0; l < rank; l++) {
+				real u = 0;
+				real v = 0;
+
+				for (int i = 0; i < rows; i++)
+					u += U(i, k) * U(i, l);
+
+				for (int j = 0; j < cols; j++)
+					v += V(j, k) * V(j, l);
+
+				assert(fabs(u - (k == l)) < Tolerance(1e-10));
+				assert(fabs(v - (k == l)) < Tolerance(1e-10));
+			}
+		}
+	}
+
+	VolumeSize size;
+	size.height = 2;
+	size.width = 5;
+	size.deep = 30;
+
+	int inputs = 300;
+	int outputs = 19;
+	int rank = 5;
+	int batchSize = 7;
+
+	// веса ранга 5 раскладываются без потерь: выход и градиенты входа совпадают с обычным слоем
+	FullyConnectedLayer dense(size, outputs, "tanh");
+
+	for (int i = 0; i < outputs; i++) {
+		for (int j = 0; j < inputs; j++) {
+			real weight = 0;
+
+			for (int k = 0; k < rank; k++)
+				weight += sin(i * 0.9 + k) * cos(j * 0.07 * (k + 1)) / (k + 1);
+
+			dense.SetWeight(i, j, weight * 0.1);
+		}
+
+		dense.SetBias(i, 0.05 * i - 0.3);
+	}
+
+	NetworkLayer *truncated = dense.Factorize(rank - 1);
+	assert(truncated != nullptr);
+	assert(dense.Factorize(outputs + 1) == nullptr); // ранг больше меньшей размерности весов
+	delete truncated;
+
+	LowRankFullyConnectedLayer *lowRank = dynamic_cast<LowRankFullyConnectedLayer*>(dense.Factorize(rank));
+	assert(lowRank != nullptr);
+	assert(lowRank->GetTrainableParams() == rank * (inputs + outputs) + outputs);
+
+	Tensor X(batchSize, size);
+	Tensor dout(batchSize, 1, 1, outputs);
+
+	for (int i = 0; i < batchSize * inputs; i++)
+		X.Data()[i] = sin(i * 0.37);
+
+	for (int i = 0; i < batchSize * outputs; i++)
+		dout.Data()[i] = cos(i * 0.11);
+
+	dense.SetBatchSize(batchSize);
+	lowRank->SetBatchSize(batchSize);
+
+	dense.Forward(X);
+	dense.Backward(dout, X, true);
+	lowRank->Forward(X);
+	lowRank->Backward(dout, X, true);
+
+	for (int i = 0; i < batchSize * outputs; i++)
+		assert(fabs(lowRank->GetOutput().Data()[i] - dense.GetOutput().Data()[i]) < Tolerance(1e-10));
+
+	for (int i = 0; i < batchSize * inputs; i++)
+		assert(fabs(lowRank->GetDeltas().Data()[i] - dense.GetDeltas().Data()[i]) < Tolerance(1e-10));
+
+	for (int i = 0; i < outputs; i++)
+		assert(fabs(lowRank->GetGradient(rank * (inputs + outputs) + i) - dense.GetGradient(i * (inputs + 1) + inputs)) < Tolerance(1e-10));
+
+	// выход примера не зависит от размера батча
+	Tensor expected = lowRank->GetOutput();
+	lowRank->SetBatchSize(1);
+
+	for (int n = 0; n < batchSize; n++) {
+		lowRank->ForwardOutput({ X[n] });
+
+		for (int i = 0; i < outputs; i++)
+			assert(lowRank->GetOutput()[0][i] == expected[n][i]);
+	}
+
+	delete lowRank;
+
+	// разложенная сеть обучается, сохраняется и загружается
+	Network network(10, 10, 3);
+	network.AddLayer("fc outputs=32 activation=relu");
+	network.AddLayer("fc outputs=4");
+
+	assert(network.Factorize(4) == 1); // выходной слой ранга 4 не становится меньше
+	assert(network.GetLayer(0)->GetTrainableParams() == 4 * (300 + 32) + 32);
+
+	Tensor inputs3(4, 10, 10, 3);
+	Tensor targets(4, 1, 1, 4);
+
+	for (int i = 0; i < 4 * 300; i++)
+		inputs3.Data()[i] = sin(i * 0.21);
+
+	for (int i = 0; i < 4 * 4; i++)
+		targets.Data()[i] = cos(i * 0.5);
+
+	double loss = network.TrainOnBatch(inputs3, targets, Optimizer::SGD(0.01), LossFunction::MSE());
+
+	for (int i = 0; i < 20; i++)
+		network.TrainOnBatch(inputs3, targets, Optimizer::SGD(0.01), LossFunction::MSE());
+
+	assert(network.TrainOnBatch(inputs3, targets, Optimizer::SGD(0.01), LossFunction::MSE()) < loss);
+
+	Tensor trained = network.GetOutput(inputs3);
+	network.Save("low_rank_network_test.txt", false);
+
+	Network loaded(10, 10, 3);
+	loaded.Load("low_rank_network_test.txt", false);
+	remove("low_rank_network_test.txt");
+
+	Tensor &output = loaded.GetOutput(inputs3);
+
+	for (int i = 0; i < 4 * 4; i++)
+		assert(fabs(output.Data()[i] - trained.Data()[i]) < Tolerance(1e-10));
+
+	cout << "OK" << endl;
+}
+
+// численная проверка градиентов слоя низкого ранга в сети
+void LowRankFullyConnectedGradientCheckingTest() {
+	default_random_engine generator;
+	normal_distribution<double> distribution(0.0, 1.0);
+
+	Tensor inputs(3, 4, 4, 3);
+	Tensor outputs(3, 1, 1, 10);
+
+	for (int i = 0; i < 3 * inputs.Total(); i++)
+		inputs.Data()[i] = distribution(generator);
+
+	for (int i = 0; i < 3 * outputs.Total(); i++)
+		outputs.Data()[i] = distribution(generator);
+
+	Network network(4, 4, 3);
+
+	network.AddLayer("lowrankfc outputs=17 rank=4 activation=tanh");
+	network.AddLayer("fullconnected outputs=10 activation=sigmoid");
+
+	network.GradientChecking(inputs, outputs, LossFunction::MSE());
+	network.GradientChecking(inputs, outputs, LossFunction::Logcosh());
+}
+
 void MaxPoolingLayerTest() {
 	cout << "Max pooling tests: ";
 
@@ -142,8 +688,8 @@ void MaxPoolingLayerTest() {
 	Volume& deltas2 = layer.GetDeltas()[0];
 
 	assert(deltas2(0, 0, 0) == 0);
-	assert(deltas2(0, 0, 1) == 1.2);
-	assert(deltas2(0, 0, 2) == 1.9);
+	assert(fabs(deltas2(0, 0, 1) - 1.2) < Tolerance(1e-15));
+	assert(fabs(deltas2(0, 0, 2) - 1.9) < Tolerance(1e-15));
 	assert(deltas2(0, 0, 3) == 0);
 
 	assert(deltas2(0, 1, 0) == 0);
@@ -154,9 +700,9 @@ void MaxPoolingLayerTest() {
 	assert(deltas2(0, 2, 0) == 0);
 	assert(deltas2(0, 2, 1) == 0);
 	assert(deltas2(0, 2, 2) == 0);
-	assert(deltas2(0, 2, 3) == 0.3);
+	assert(fabs(deltas2(0, 2, 3) - 0.3) < Tolerance(1e-15));
 
-	assert(deltas2(0, 3, 0) == 0.9);
+	assert(fabs(deltas2(0, 3, 0) - 0.9) < Tolerance(1e-15));
 	assert(deltas2(0, 3, 1) == 0);
 	assert(deltas2(0, 3, 2) == 0);
 	assert(deltas2(0, 3, 3) == 0);
@@ -204,10 +750,10 @@ void AveragePoolingLayerTest() {
 	assert(output.Height() == 2);
 	assert(output.Deep() == 1);
 
-	assert(output(0, 0, 0) == 5.5);
-	assert(output(0, 0, 1) == 6.25);
-	assert(output(0, 1, 0) == 3.5);
-	assert(output(0, 1, 1) == 5.75);
+	assert(fabs(output(0, 0, 0) - 5.5) < Tolerance(1e-15));
+	assert(fabs(output(0, 0, 1) - 6.25) < Tolerance(1e-15));
+	assert(fabs(output(0, 1, 0) - 3.5) < Tolerance(1e-15));
+	assert(fabs(output(0, 1, 1) - 5.75) < Tolerance(1e-15));
 
 	Volume deltas(2, 2, 1);
 
@@ -221,25 +767,25 @@ void AveragePoolingLayerTest() {
 
 	Volume& deltas2 = layer.GetDeltas()[0];
 
-	assert(deltas2(0, 0, 0) == 1.2 / 4);
-	assert(deltas2(0, 0, 1) == 1.2 / 4);
-	assert(deltas2(0, 0, 2) == 1.9 / 4);
-	assert(deltas2(0, 0, 3) == 1.9 / 4);
+	assert(fabs(deltas2(0, 0, 0) - 1.2 / 4) < Tolerance(1e-15));
+	assert(fabs(deltas2(0, 0, 1) - 1.2 / 4) < Tolerance(1e-15));
+	assert(fabs(deltas2(0, 0, 2) - 1.9 / 4) < Tolerance(1e-15));
+	assert(fabs(deltas2(0, 0, 3) - 1.9 / 4) < Tolerance(1e-15));
 
-	assert(deltas2(0, 1, 0) == 1.2 / 4);
-	assert(deltas2(0, 1, 1) == 1.2 / 4);
-	assert(deltas2(0, 1, 2) == 1.9 / 4);
-	assert(deltas2(0, 1, 3) == 1.9 / 4);
+	assert(fabs(deltas2(0, 1, 0) - 1.2 / 4) < Tolerance(1e-15));
+	assert(fabs(deltas2(0, 1, 1) - 1.2 / 4) < Tolerance(1e-15));
+	assert(fabs(deltas2(0, 1, 2) - 1.9 / 4) < Tolerance(1e-15));
+	assert(fabs(deltas2(0, 1, 3) - 1.9 / 4) < Tolerance(1e-15));
 
-	assert(deltas2(0, 2, 0) == 0.9 / 4);
-	assert(deltas2(0, 2, 1) == 0.9 / 4);
-	assert(deltas2(0, 2, 2) == 0.3 / 4);
-	assert(deltas2(0, 2, 3) == 0.3 / 4);
+	assert(fabs(deltas2(0, 2, 0) - 0.9 / 4) < Tolerance(1e-15));
+	assert(fabs(deltas2(0, 2, 1) - 0.9 / 4) < Tolerance(1e-15));
+	assert(fabs(deltas2(0, 2, 2) - 0.3 / 4) < Tolerance(1e-15));
+	assert(fabs(deltas2(0, 2, 3) - 0.3 / 4) < Tolerance(1e-15));
 
-	assert(deltas2(0, 3, 0) == 0.9 / 4);
-	assert(deltas2(0, 3, 1) == 0.9 / 4);
-	assert(deltas2(0, 3, 2) == 0.3 / 4);
-	assert(deltas2(0, 3, 3) == 0.3 / 4);
+	assert(fabs(deltas2(0, 3, 0) - 0.9 / 4) < Tolerance(1e-15));
+	assert(fabs(deltas2(0, 3, 1) - 0.9 / 4) < Tolerance(1e-15));
+	assert(fabs(deltas2(0, 3, 2) - 0.3 / 4) < Tolerance(1e-15));
+	assert(fabs(deltas2(0, 3, 3) - 0.3 / 4) < Tolerance(1e-15));
 
 	cout << "OK" << endl;
 }
@@ -252,7 +798,7 @@ void ConvLayerTest() {
 	size.width = 5;
 	size.deep = 3;
 
-	ConvLayer layer(size, 2, 3, 1, 2);
+	ConvLayer layer(size, 2, 3, 1, 2, 1);
 	layer.SetBatchSize(1);
 	Volume input(5, 5, 3);
 
@@ -309,7 +855,7 @@ void ConvLayerTest() {
 	size.width = 4;
 	size.deep = 1;
 
-	ConvLayer layer2(size, 1, 3, 0, 1);
+	ConvLayer layer2(size, 1, 3, 0, 1, 1);
 	layer2.SetBatchSize(1);
 	layer2.SetBias(0, 0);
 
@@ -355,430 +901,1855 @@ void ConvLayerTest() {
 
 	Volume deltas2 = layer2.GetDeltas()[0];
 
-	assert(fabs(deltas2(0, 0, 0) - 2) < 1e-14);
-	assert(fabs(deltas2(0, 0, 1) - 9) < 1e-14);
-	assert(fabs(deltas2(0, 0, 2) - 6) < 1e-14);
-	assert(fabs(deltas2(0, 0, 3) - 1) < 1e-14);
+	assert(fabs(deltas2(0, 0, 0) - 2) < Tolerance(1e-14));
+	assert(fabs(deltas2(0, 0, 1) - 9) < Tolerance(1e-14));
+	assert(fabs(deltas2(0, 0, 2) - 6) < Tolerance(1e-14));
+	assert(fabs(deltas2(0, 0, 3) - 1) < Tolerance(1e-14));
 
-	assert(fabs(deltas2(0, 1, 0) - 6) < 1e-14);
-	assert(fabs(deltas2(0, 1, 1) - 29) < 1e-14);
-	assert(fabs(deltas2(0, 1, 2) - 30) < 1e-14);
-	assert(fabs(deltas2(0, 1, 3) - 7) < 1e-14);
+	assert(fabs(deltas2(0, 1, 0) - 6) < Tolerance(1e-14));
+	assert(fabs(deltas2(0, 1, 1) - 29) < Tolerance(1e-14));
+	assert(fabs(deltas2(0, 1, 2) - 30) < Tolerance(1e-14));
+	assert(fabs(deltas2(0, 1, 3) - 7) < Tolerance(1e-14));
 
-	assert(fabs(deltas2(0, 2, 0) - 10) < 1e-14);
-	assert(fabs(deltas2(0, 2, 1) - 29) < 1e-14);
-	assert(fabs(deltas2(0, 2, 2) - 33) < 1e-14);
-	assert(fabs(deltas2(0, 2, 3) - 13) < 1e-14);
+	assert(fabs(deltas2(0, 2, 0) - 10) < Tolerance(1e-14));
+	assert(fabs(deltas2(0, 2, 1) - 29) < Tolerance(1e-14));
+	assert(fabs(deltas2(0, 2, 2) - 33) < Tolerance(1e-14));
+	assert(fabs(deltas2(0, 2, 3) - 13) < Tolerance(1e-14));
 
-	assert(fabs(deltas2(0, 3, 0) - 12) < 1e-14);
-	assert(fabs(deltas2(0, 3, 1) - 24) < 1e-14);
-	assert(fabs(deltas2(0, 3, 2) - 16) < 1e-14);
-	assert(fabs(deltas2(0, 3, 3) - 4) < 1e-14);
+	assert(fabs(deltas2(0, 3, 0) - 12) < Tolerance(1e-14));
+	assert(fabs(deltas2(0, 3, 1) - 24) < Tolerance(1e-14));
+	assert(fabs(deltas2(0, 3, 2) - 16) < Tolerance(1e-14));
+	assert(fabs(deltas2(0, 3, 3) - 4) < Tolerance(1e-14));
 
 	cout << "OK" << endl;
 }
 
-void ConvTransposedLayerTest() {
-	cout << "Conv transposed tests: ";
+void ConvAlgorithmsTest() {
+	cout << "Conv algorithms tests: ";
 
-	VolumeSize size;
-	size.deep = 3;
-	size.height = 5;
-	size.width = 5;
+	default_random_engine generator;
+	normal_distribution<double> distribution(0.0, 1.0);
 
-	ConvTransposedLayer layer(size, 1, 3, 0, 1);
-	layer.SetBatchSize(1);
+	// размеры подобраны так, чтобы GEMM проходил несколько блоков по строкам и общей размерности и неполные полосы микроядра
+	vector<vector<int>> configs = { { 7, 5, 3, 1, 1, 1 }, { 13, 30, 11, 3, 1, 1 }, { 9, 4, 6, 3, 0, 2 }, { 10, 3, 5, 4, 2, 3 }, { 6, 8, 9, 1, 0, 1 } };
 
-	Volume input(size);
-	
-	layer.SetWeight(0, 0, 0, 0, 0);
-	layer.SetWeight(0, 0, 0, 1, 1);
-	layer.SetWeight(0, 0, 0, 2, 0);
+	for (size_t index = 0; index < configs.size(); index++) {
+		VolumeSize size;
+		size.width = configs[index][0];
+		size.height = configs[index][0] - 1;
+		size.deep = configs[index][1];
 
-	layer.SetWeight(0, 0, 1, 0, 0);
-	layer.SetWeight(0, 0, 1, 1, 0);
-	layer.SetWeight(0, 0, 1, 2, 2);
+		int fc = configs[index][2];
+		int fs = configs[index][3];
+		int P = configs[index][4];
+		int S = configs[index][5];
 
-	layer.SetWeight(0, 0, 2, 0, 0);
-	layer.SetWeight(0, 0, 2, 1, 1);
-	layer.SetWeight(0, 0, 2, 2, 0);
+		ConvLayer direct(size, fc, fs, P, S, 1);
+		ConvLayer gemm(size, fc, fs, P, S, 1);
+		ConvWithoutStrideLayer gemmWithoutStride(size, fc, fs, P, 1);
 
+		direct.SetAlgorithm(ConvAlgorithm::Direct);
 
-	layer.SetWeight(0, 1, 0, 0, 2);
-	layer.SetWeight(0, 1, 0, 1, 1);
-	layer.SetWeight(0, 1, 0, 2, 0);
+		for (int i = 0; i < direct.GetTrainableParams(); i++) {
+			gemm.SetParam(i, direct.GetParam(i));
+			gemmWithoutStride.SetParam(i, direct.GetParam(i));
+		}
 
-	layer.SetWeight(0, 1, 1, 0, 0);
-	layer.SetWeight(0, 1, 1, 1, 0);
-	layer.SetWeight(0, 1, 1, 2, 0);
+		Tensor inputs(3, size);
+		Tensor deltas(3, direct.GetOutputSize());
 
-	layer.SetWeight(0, 1, 2, 0, 0);
-	layer.SetWeight(0, 1, 2, 1, 3);
-	layer.SetWeight(0, 1, 2, 2, 0);
+		for (int i = 0; i < 3 * inputs.Total(); i++)
+			inputs.Data()[i] = distribution(generator);
 
+		for (int i = 0; i < 3 * deltas.Total(); i++)
+			deltas.Data()[i] = distribution(generator);
 
-	layer.SetWeight(0, 2, 0, 0, 1);
-	layer.SetWeight(0, 2, 0, 1, 0);
-	layer.SetWeight(0, 2, 0, 2, 0);
+		vector<NetworkLayer*> layers = { &direct, &gemm };
 
-	layer.SetWeight(0, 2, 1, 0, 1);
-	layer.SetWeight(0, 2, 1, 1, 0);
-	layer.SetWeight(0, 2, 1, 2, 0);
+		if (S == 1)
+			layers.push_back(&gemmWithoutStride);
 
-	layer.SetWeight(0, 2, 2, 0, 0);
-	layer.SetWeight(0, 2, 2, 1, 0);
-	layer.SetWeight(0, 2, 2, 2, 2);
-	
-	layer.SetBias(0, 0);
+		for (size_t i = 0; i < layers.size(); i++) {
+			layers[i]->SetBatchSize(3);
+			layers[i]->Forward(inputs);
+			layers[i]->Backward(deltas, inputs, true);
+		}
 
-	input(0, 0, 0) = 1;
-	input(0, 0, 1) = 0;
-	input(0, 0, 2) = 1;
-	input(0, 0, 3) = 0;
-	input(0, 0, 4) = 2;
+		for (size_t i = 1; i < layers.size(); i++) {
+			for (int j = 0; j < 3 * deltas.Total(); j++)
+				assert(fabs(layers[i]->GetOutput().Data()[j] - direct.GetOutput().Data()[j]) < Tolerance(1e-10));
 
-	input(0, 1, 0) = 1;
-	input(0, 1, 1) = 1;
-	input(0, 1, 2) = 3;
-	input(0, 1, 3) = 2;
-	input(0, 1, 4) = 1;
+			for (int j = 0; j < 3 * inputs.Total(); j++)
+				assert(fabs(layers[i]->GetDeltas().Data()[j] - direct.GetDeltas().Data()[j]) < Tolerance(1e-10));
 
-	input(0, 2, 0) = 1;
-	input(0, 2, 1) = 1;
-	input(0, 2, 2) = 0;
-	input(0, 2, 3) = 1;
-	input(0, 2, 4) = 1;
+			for (int j = 0; j < direct.GetTrainableParams(); j++)
+				assert(fabs(layers[i]->GetGradient(j) - direct.GetGradient(j)) < Tolerance(1e-10));
+		}
 
-	input(0, 3, 0) = 2;
-	input(0, 3, 1) = 3;
-	input(0, 3, 2) = 2;
+		// упакованные фильтры обновляются после шага оптимизатора и после установки веса
+		for (int step = 0; step < 2; step++) {
+			for (size_t i = 0; i < layers.size(); i++) {
+				if (step == 0)
+					layers[i]->UpdateWeights(Optimizer::SGD(0.5), true);
+				else
+					layers[i]->SetParam(0, 0.25);
+
+				layers[i]->Forward(inputs);
+				layers[i]->Backward(deltas, inputs, true);
+			}
+
+			for (size_t i = 1; i < layers.size(); i++) {
+				for (int j = 0; j < 3 * deltas.Total(); j++)
+					assert(fabs(layers[i]->GetOutput().Data()[j] - direct.GetOutput().Data()[j]) < Tolerance(1e-10));
+
+				for (int j = 0; j < 3 * inputs.Total(); j++)
+					assert(fabs(layers[i]->GetDeltas().Data()[j] - direct.GetDeltas().Data()[j]) < Tolerance(1e-10));
+			}
+		}
+	}
+
+	cout << "OK" << endl;
+}
+
+void WinogradTest() {
+	cout << "Winograd tests: ";
+
+	default_random_engine generator;
+	normal_distribution<double> distribution(0.0, 1.0);
+
+	// размеры не кратны выходным тайлам, а количество каналов - полосам микроядра
+	vector<vector<int>> configs = { { 7, 5, 3, 1 }, { 13, 2, 11, 0 }, { 10, 9, 4, 2 }, { 5, 1, 1, 1 } };
+	vector<ConvAlgorithm> algorithms = { ConvAlgorithm::Winograd2, ConvAlgorithm::Winograd4 };
+
+	for (size_t index = 0; index < configs.size(); index++) {
+		VolumeSize size;
+		size.width = configs[index][0];
+		size.height = configs[index][0] + 1;
+		size.deep = configs[index][1];
+
+		int fc = configs[index][2];
+		int P = configs[index][3];
+
+		ConvWithoutStrideLayer direct(size, fc, 3, P, 1);
+		direct.SetAlgorithm(ConvAlgorithm::Direct);
+		direct.SetBatchSize(2);
+
+		Tensor inputs(2, size);
+		Tensor deltas(2, direct.GetOutputSize());
+
+		for (int i = 0; i < 2 * inputs.Total(); i++)
+			inputs.Data()[i] = distribution(generator);
+
+		for (int i = 0; i < 2 * deltas.Total(); i++)
+			deltas.Data()[i] = distribution(generator);
+
+		direct.Forward(inputs);
+		direct.Backward(deltas, inputs, true);
+
+		for (size_t k = 0; k < algorithms.size(); k++) {
+			ConvWithoutStrideLayer winograd(size, fc, 3, P, 1);
+			winograd.SetAlgorithm(algorithms[k]);
+			winograd.SetBatchSize(2);
+
+			// фильтры, преобразованные до изменения параметров, должны быть пересчитаны
+			winograd.Forward(inputs);
+
+			for (int i = 0; i < direct.GetTrainableParams(); i++)
+				winograd.SetParam(i, direct.GetParam(i));
+
+			winograd.Forward(inputs);
+			winograd.Backward(deltas, inputs, true);
+
+			for (int j = 0; j < 2 * deltas.Total(); j++)
+				assert(fabs(winograd.GetOutput().Data()[j] - direct.GetOutput().Data()[j]) < Tolerance(1e-8));
+
+			for (int j = 0; j < 2 * inputs.Total(); j++)
+				assert(fabs(winograd.GetDeltas().Data()[j] - direct.GetDeltas().Data()[j]) < Tolerance(1e-8));
+
+			for (int j = 0; j < direct.GetTrainableParams(); j++)
+				assert(fabs(winograd.GetGradient(j) - direct.GetGradient(j)) < Tolerance(1e-8));
+		}
+	}
+
+	// после обновления весов преобразованные фильтры должны соответствовать новым весам
+	VolumeSize size;
+	size.width = 6;
+	size.height = 6;
+	size.deep = 2;
+
+	ConvWithoutStrideLayer direct(size, 3, 3, 1, 1);
+	ConvWithoutStrideLayer winograd(size, 3, 3, 1, 1);
+
+	direct.SetAlgorithm(ConvAlgorithm::Direct);
+	winograd.SetAlgorithm(ConvAlgorithm::Winograd4);
+
+	for (int i = 0; i < direct.GetTrainableParams(); i++)
+		winograd.SetParam(i, direct.GetParam(i));
+
+	Tensor inputs(1, size);
+	Tensor deltas(1, direct.GetOutputSize());
+
+	for (int i = 0; i < inputs.Total(); i++)
+		inputs.Data()[i] = distribution(generator);
+
+	for (int i = 0; i < deltas.Total(); i++)
+		deltas.Data()[i] = distribution(generator);
+
+	Optimizer optimizer = Optimizer::SGD(0.1);
+	vector<ConvWithoutStrideLayer*> layers = { &direct, &winograd };
+
+	for (size_t i = 0; i < layers.size(); i++) {
+		layers[i]->SetBatchSize(1);
+		layers[i]->Forward(inputs);
+		layers[i]->Backward(deltas, inputs, true);
+		layers[i]->UpdateWeights(optimizer, true);
+		layers[i]->Forward(inputs);
+	}
+
+	for (int j = 0; j < deltas.Total(); j++)
+		assert(fabs(winograd.GetOutput().Data()[j] - direct.GetOutput().Data()[j]) < Tolerance(1e-8));
+
+	cout << "OK" << endl;
+}
+
+void ConvKernelTest() {
+	cout << "Conv kernel tests: ";
+
+	default_random_engine generator;
+	normal_distribution<double> distribution(0.0, 1.0);
+
+	// все специализации, неполные блоки каналов, дополнение больше фильтра и входы без внутренней области
+	vector<vector<int>> configs = { { 9, 3, 5, 1, 0, 1 }, { 8, 4, 9, 1, 0, 2 }, { 11, 2, 3, 3, 1, 1 }, { 9, 3, 17, 3, 1, 2 }, { 6, 3, 2, 3, 4, 1 }, { 12, 5, 3, 5, 2, 1 }, { 13, 2, 4, 5, 0, 2 }, { 10, 2, 3, 7, 3, 1 }, { 10, 3, 2, 7, 3, 2 }, { 5, 2, 3, 7, 1, 1 } };
+
+	for (size_t index = 0; index < configs.size(); index++) {
+		VolumeSize size;
+		size.width = configs[index][0];
+		size.height = configs[index][0] + 2;
+		size.deep = configs[index][1];
+
+		int fc = configs[index][2];
+		int fs = configs[index][3];
+		int P = configs[index][4];
+		int S = configs[index][5];
+
+		ConvLayer direct(size, fc, fs, P, S, 1);
+		ConvLayer specialized(size, fc, fs, P, S, 1);
+		ConvWithoutStrideLayer specializedWithoutStride(size, fc, fs, P, 1);
+
+		direct.SetAlgorithm(ConvAlgorithm::Direct);
+		specialized.SetAlgorithm(ConvAlgorithm::Specialized);
+		specializedWithoutStride.SetAlgorithm(ConvAlgorithm::Specialized);
+
+		for (int i = 0; i < direct.GetTrainableParams(); i++) {
+			specialized.SetParam(i, direct.GetParam(i));
+			specializedWithoutStride.SetParam(i, direct.GetParam(i));
+		}
+
+		vector<NetworkLayer*> layers = { &direct, &specialized };
+
+		if (S == 1)
+			layers.push_back(&specializedWithoutStride);
+
+		Tensor inputs(2, size);
+		Tensor deltas(2, direct.GetOutputSize());
+
+		for (int i = 0; i < 2 * inputs.Total(); i++)
+			inputs.Data()[i] = distribution(generator);
+
+		for (int i = 0; i < 2 * deltas.Total(); i++)
+			deltas.Data()[i] = distribution(generator);
+
+		for (size_t i = 0; i < layers.size(); i++) {
+			layers[i]->SetBatchSize(2);
+			layers[i]->Forward(inputs);
+			layers[i]->Backward(deltas, inputs, true);
+		}
+
+		for (size_t i = 1; i < layers.size(); i++) {
+			for (int j = 0; j < 2 * deltas.Total(); j++)
+				assert(fabs(layers[i]->GetOutput().Data()[j] - direct.GetOutput().Data()[j]) < Tolerance(1e-10));
+
+			for (int j = 0; j < 2 * inputs.Total(); j++)
+				assert(fabs(layers[i]->GetDeltas().Data()[j] - direct.GetDeltas().Data()[j]) < Tolerance(1e-10));
+
+			for (int j = 0; j < direct.GetTrainableParams(); j++)
+				assert(fabs(layers[i]->GetGradient(j) - direct.GetGradient(j)) < Tolerance(1e-10));
+		}
+	}
+
+	VolumeSize size;
+	size.width = 16;
+	size.height = 16;
+	size.deep = 3;
+
+	// ядро выбирается для неглубоких входов, для глубоких остаётся GEMM, без специализации выбрать ядро нельзя
+	ConvLayer shallow(size, 16, 3, 1, 2, 1);
+	shallow.ChooseAlgorithm();
+	assert(shallow.GetAlgorithm() == ConvAlgorithm::Specialized);
+
+	ConvWithoutStrideLayer unsupported(size, 4, 4, 0, 1);
+	unsupported.ChooseAlgorithm();
+	assert(unsupported.GetAlgorithm() == ConvAlgorithm::Gemm);
+
+	bool thrown = false;
+
+	try {
+		unsupported.SetAlgorithm(ConvAlgorithm::Specialized);
+	}
+	catch (const runtime_error &) {
+		thrown = true;
+	}
+
+	assert(thrown);
+
+	size.deep = 64;
+
+	ConvWithoutStrideLayer deep(size, 64, 3, 1, 1);
+	deep.ChooseAlgorithm();
+	assert(deep.GetAlgorithm() == ConvAlgorithm::Gemm);
+
+	cout << "OK" << endl;
+}
+
+void PointwiseConvTest() {
+	cout << "Pointwise conv tests: ";
+
+	default_random_engine generator;
+	normal_distribution<double> distribution(0.0, 1.0);
+
+	// без дополнения и шага вход используется напрямую, иначе положения собираются с шагом, в том числе из дополнения
+	vector<vector<int>> configs = { { 9, 3, 5, 0, 1 }, { 8, 16, 9, 0, 2 }, { 11, 2, 3, 1, 1 }, { 7, 5, 4, 1, 2 }, { 10, 4, 6, 0, 3 } };
+
+	for (size_t index = 0; index < configs.size(); index++) {
+		VolumeSize size;
+		size.width = configs[index][0];
+		size.height = configs[index][0] + 1;
+		size.deep = configs[index][1];
+
+		int fc = configs[index][2];
+		int P = configs[index][3];
+		int S = configs[index][4];
+
+		ConvLayer direct(size, fc, 1, P, S, 1);
+		ConvLayer pointwise(size, fc, 1, P, S, 1);
+		ConvWithoutStrideLayer pointwiseWithoutStride(size, fc, 1, P, 1);
+
+		direct.SetAlgorithm(ConvAlgorithm::Direct);
+		pointwise.ChooseAlgorithm();
+		pointwiseWithoutStride.ChooseAlgorithm();
+
+		assert(pointwise.GetAlgorithm() == ConvAlgorithm::Pointwise);
+		assert(pointwiseWithoutStride.GetAlgorithm() == ConvAlgorithm::Pointwise);
+
+		for (int i = 0; i < direct.GetTrainableParams(); i++) {
+			pointwise.SetParam(i, direct.GetParam(i));
+			pointwiseWithoutStride.SetParam(i, direct.GetParam(i));
+		}
+
+		vector<NetworkLayer*> layers = { &direct, &pointwise };
+
+		if (S == 1)
+			layers.push_back(&pointwiseWithoutStride);
+
+		Tensor inputs(3, size);
+		Tensor deltas(3, direct.GetOutputSize());
+
+		for (int i = 0; i < 3 * inputs.Total(); i++)
+			inputs.Data()[i] = distribution(generator);
+
+		for (int i = 0; i < 3 * deltas.Total(); i++)
+			deltas.Data()[i] = distribution(generator);
+
+		for (size_t i = 0; i < layers.size(); i++) {
+			layers[i]->SetBatchSize(3);
+			layers[i]->Forward(inputs);
+			layers[i]->Backward(deltas, inputs, true);
+		}
+
+		for (size_t i = 1; i < layers.size(); i++) {
+			for (int j = 0; j < 3 * deltas.Total(); j++)
+				assert(fabs(layers[i]->GetOutput().Data()[j] - direct.GetOutput().Data()[j]) < Tolerance(1e-10));
+
+			for (int j = 0; j < 3 * inputs.Total(); j++)
+				assert(fabs(layers[i]->GetDeltas().Data()[j] - direct.GetDeltas().Data()[j]) < Tolerance(1e-10));
+
+			for (int j = 0; j < direct.GetTrainableParams(); j++)
+				assert(fabs(layers[i]->GetGradient(j) - direct.GetGradient(j)) < Tolerance(1e-10));
+		}
+	}
+
+	VolumeSize size;
+	size.width = 8;
+	size.height = 8;
+	size.deep = 4;
+
+	// алгоритм доступен только для фильтров 1x1
+	ConvWithoutStrideLayer conv(size, 4, 3, 1, 1);
+	bool thrown = false;
+
+	try {
+		conv.SetAlgorithm(ConvAlgorithm::Pointwise);
+	}
+	catch (const runtime_error &) {
+		thrown = true;
+	}
+
+	assert(thrown);
+
+	cout << "OK" << endl;
+}
+
+void GroupConvTest() {
+	cout << "Group conv tests: ";
+
+	default_random_engine generator;
+	normal_distribution<double> distribution(0.0, 1.0);
+
+	// поканальные свёртки (в том числе с множителем глубины) и групповые, сравнение с полной свёрткой с нулевыми весами между группами
+	vector<vector<int>> configs = { { 9, 6, 6, 3, 1, 1, 6 }, { 8, 4, 8, 3, 1, 2, 4 }, { 11, 5, 5, 5, 2, 3, 5 }, { 10, 6, 4, 3, 1, 1, 2 }, { 9, 8, 12, 3, 0, 2, 4 } };
+
+	for (size_t index = 0; index < configs.size(); index++) {
+		VolumeSize size;
+		size.width = configs[index][0];
+		size.height = configs[index][0] + 1;
+		size.deep = configs[index][1];
+
+		int fc = configs[index][2];
+		int fs = configs[index][3];
+		int P = configs[index][4];
+		int S = configs[index][5];
+		int groups = configs[index][6];
+
+		int inputs = size.deep / groups;
+		int outputs = fc / groups;
+		int params = fs * fs * inputs + 1;
+
+		GroupConvLayer group(size, fc, fs, P, S, groups);
+		ConvLayer dense(size, fc, fs, P, S, 1);
+		dense.SetAlgorithm(ConvAlgorithm::Direct);
+
+		for (int i = 0; i < dense.GetTrainableParams(); i++)
+			dense.SetParam(i, 0);
+
+		for (int f = 0; f < fc; f++) {
+			for (int k = 0; k < fs; k++)
+				for (int l = 0; l < fs; l++)
+					for (int c = 0; c < inputs; c++)
+						dense.SetWeight(f, f / outputs * inputs + c, k, l, group.GetParam(f * params + (k * fs + l) * inputs + c));
+
+			dense.SetBias(f, group.GetParam(f * params + params - 1));
+		}
+
+		Tensor inputsTensor(2, size);
+		Tensor deltas(2, dense.GetOutputSize());
+
+		for (int i = 0; i < 2 * inputsTensor.Total(); i++)
+			inputsTensor.Data()[i] = distribution(generator);
+
+		for (int i = 0; i < 2 * deltas.Total(); i++)
+			deltas.Data()[i] = distribution(generator);
+
+		group.SetBatchSize(2);
+		dense.SetBatchSize(2);
+
+		group.Forward(inputsTensor);
+		dense.Forward(inputsTensor);
+		group.Backward(deltas, inputsTensor, true);
+		dense.Backward(deltas, inputsTensor, true);
+
+		for (int j = 0; j < 2 * deltas.Total(); j++)
+			assert(fabs(group.GetOutput().Data()[j] - dense.GetOutput().Data()[j]) < Tolerance(1e-10));
+
+		for (int j = 0; j < 2 * inputsTensor.Total(); j++)
+			assert(fabs(group.GetDeltas().Data()[j] - dense.GetDeltas().Data()[j]) < Tolerance(1e-10));
+
+		for (int f = 0; f < fc; f++) {
+			for (int k = 0; k < fs; k++)
+				for (int l = 0; l < fs; l++)
+					for (int c = 0; c < inputs; c++)
+						assert(fabs(group.GetGradient(f * params + (k * fs + l) * inputs + c) - dense.GetGradient(f * (fs * fs * size.deep + 1) + (k * fs + l) * size.deep + f / outputs * inputs + c)) < Tolerance(1e-10));
+
+			assert(fabs(group.GetGradient(f * params + params - 1) - dense.GetGradient(f * (fs * fs * size.deep + 1) + fs * fs * size.deep)) < Tolerance(1e-10));
+		}
+
+		// сохранение и загрузка восстанавливают слой того же типа с теми же весами
+		ofstream fout("group_conv_test.txt");
+		group.Save(fout);
+		fout.close();
+
+		string type;
+		VolumeSize loadedSize;
+		ifstream fin("group_conv_test.txt");
+		fin >> type >> loadedSize;
+
+		assert(type == (inputs == 1 ? "depthwiseconv" : "groupconv"));
+
+		NetworkLayer *loaded = LoadLayer(loadedSize, type, fin);
+		fin.close();
+		remove("group_conv_test.txt");
+
+		assert(loaded->GetTrainableParams() == group.GetTrainableParams());
+
+		for (int i = 0; i < group.GetTrainableParams(); i++)
+			assert(fabs(loaded->GetParam(i) - group.GetParam(i)) < Tolerance(1e-12));
+
+		delete loaded;
+	}
+
+	VolumeSize size;
+	size.width = 8;
+	size.height = 8;
+	size.deep = 6;
+
+	NetworkLayer *depthwise = CreateLayer(size, "depthwiseconv fs=3 P=same multiplier=2");
+	NetworkLayer *grouped = CreateLayer(size, "conv fc=9 fs=3 S=2 groups=3");
+
+	assert(depthwise->GetOutputSize().deep == 12 && depthwise->GetTrainableParams() == 12 * (9 + 1));
+	assert(grouped->GetOutputSize().width == 3 && grouped->GetTrainableParams() == 9 * (9 * 2 + 1));
+
+	delete depthwise;
+	delete grouped;
+
+	// количество каналов должно делиться на количество групп
+	bool thrown = false;
+
+	try {
+		GroupConvLayer invalid(size, 8, 3, 1, 1, 4);
+	}
+	catch (const runtime_error &) {
+		thrown = true;
+	}
+
+	assert(thrown);
+
+	cout << "OK" << endl;
+}
+
+void FFTConvTest() {
+	cout << "FFT conv tests: ";
+
+	default_random_engine generator;
+	normal_distribution<double> distribution(0.0, 1.0);
+
+	// большие входы разбиваются на несколько блоков, дополнение может превышать размер фильтра
+	vector<vector<int>> configs = { { 7, 5, 3, 5, 2, 1 }, { 30, 4, 6, 7, 0, 1 }, { 13, 3, 5, 5, 1, 2 }, { 11, 3, 2, 3, 3, 1 }, { 70, 2, 3, 5, 2, 1 }, { 12, 2, 4, 5, 4, 3 } };
+
+	for (size_t index = 0; index < configs.size(); index++) {
+		VolumeSize size;
+		size.width = configs[index][0];
+		size.height = configs[index][0] + 1;
+		size.deep = configs[index][1];
+
+		int fc = configs[index][2];
+		int fs = configs[index][3];
+		int P = configs[index][4];
+		int S = configs[index][5];
+
+		ConvLayer direct(size, fc, fs, P, S, 1);
+		ConvLayer fft(size, fc, fs, P, S, 1);
+		ConvWithoutStrideLayer fftWithoutStride(size, fc, fs, P, 1);
+
+		direct.SetAlgorithm(ConvAlgorithm::Direct);
+		fft.SetAlgorithm(ConvAlgorithm::FFT);
+		fftWithoutStride.SetAlgorithm(ConvAlgorithm::FFT);
+
+		vector<NetworkLayer*> layers = { &direct, &fft };
+
+		if (S == 1)
+			layers.push_back(&fftWithoutStride);
+
+		Tensor inputs(2, size);
+		Tensor deltas(2, direct.GetOutputSize());
+
+		for (int i = 0; i < 2 * inputs.Total(); i++)
+			inputs.Data()[i] = distribution(generator);
+
+		for (int i = 0; i < 2 * deltas.Total(); i++)
+			deltas.Data()[i] = distribution(generator);
+
+		for (size_t i = 0; i < layers.size(); i++) {
+			layers[i]->SetBatchSize(2);
+			layers[i]->Forward(inputs); // спектры начальных весов должны быть пересчитаны после SetParam
+
+			for (int j = 0; j < direct.GetTrainableParams() && i > 0; j++)
+				layers[i]->SetParam(j, direct.GetParam(j));
+
+			layers[i]->Forward(inputs);
+			layers[i]->Backward(deltas, inputs, true);
+		}
+
+		for (size_t i = 1; i < layers.size(); i++) {
+			for (int j = 0; j < 2 * deltas.Total(); j++)
+				assert(fabs(layers[i]->GetOutput().Data()[j] - direct.GetOutput().Data()[j]) < Tolerance(1e-10));
+
+			for (int j = 0; j < 2 * inputs.Total(); j++)
+				assert(fabs(layers[i]->GetDeltas().Data()[j] - direct.GetDeltas().Data()[j]) < Tolerance(1e-10));
+
+			for (int j = 0; j < direct.GetTrainableParams(); j++)
+				assert(fabs(layers[i]->GetGradient(j) - direct.GetGradient(j)) < Tolerance(1e-9));
+		}
+	}
+
+	// FFT выбирается только для больших фильтров при большом количестве каналов
+	VolumeSize size;
+	size.width = 28;
+	size.height = 28;
+	size.deep = 1;
+
+	ConvWithoutStrideLayer small(size, 16, 5, 2, 1);
+	small.ChooseAlgorithm();
+	assert(small.GetAlgorithm() != ConvAlgorithm::FFT);
+
+	size.width = 64;
+	size.height = 64;
+	size.deep = 32;
+
+	ConvWithoutStrideLayer large(size, 32, 9, 4, 1);
+	large.ChooseAlgorithm();
+	assert(large.GetAlgorithm() == ConvAlgorithm::FFT);
+
+	cout << "OK" << endl;
+}
+
+void DilatedConvTest() {
+	cout << "Dilated conv tests: ";
+
+	default_random_engine generator;
+	normal_distribution<double> distribution(0.0, 1.0);
+
+	// эталон - обычная свёртка с фильтром D * (fs - 1) + 1, в котором между ядрами стоят нули
+	vector<vector<int>> configs = { { 9, 3, 4, 3, 2, 1, 2 }, { 13, 5, 6, 3, 1, 2, 3 }, { 12, 2, 3, 2, 0, 1, 4 }, { 20, 4, 5, 3, 3, 1, 2 }, { 11, 3, 2, 3, 4, 3, 2 }, { 9, 3, 4, 1, 0, 1, 2 }, { 10, 3, 5, 1, 1, 2, 3 } }; // фильтры 1x1 разрежение не меняет
+
+	for (size_t index = 0; index < configs.size(); index++) {
+		VolumeSize size;
+		size.width = configs[index][0];
+		size.height = configs[index][0] - 2;
+		size.deep = configs[index][1];
+
+		int fc = configs[index][2];
+		int fs = configs[index][3];
+		int P = configs[index][4];
+		int S = configs[index][5];
+		int D = configs[index][6];
+		int fe = D * (fs - 1) + 1;
+		int params = fs * fs * size.deep + 1;
+		int denseParams = fe * fe * size.deep + 1;
+
+		ConvLayer dense(size, fc, fe, P, S, 1);
+		ConvLayer direct(size, fc, fs, P, S, D);
+		ConvLayer gemm(size, fc, fs, P, S, D);
+		ConvLayer fft(size, fc, fs, P, S, D);
+		ConvWithoutStrideLayer gemmWithoutStride(size, fc, fs, P, D);
+		ConvWithoutStrideLayer fftWithoutStride(size, fc, fs, P, D);
+
+		dense.SetAlgorithm(ConvAlgorithm::Direct);
+		direct.SetAlgorithm(ConvAlgorithm::Direct);
+		fft.SetAlgorithm(ConvAlgorithm::FFT);
+		fftWithoutStride.SetAlgorithm(ConvAlgorithm::FFT);
+
+		assert(direct.GetOutputSize().width == dense.GetOutputSize().width && direct.GetOutputSize().height == dense.GetOutputSize().height);
+
+		vector<NetworkLayer*> layers = { &direct, &gemm, &fft };
+
+		if (S == 1) {
+			layers.push_back(&gemmWithoutStride);
+			layers.push_back(&fftWithoutStride);
+		}
+
+		for (int i = 0; i < dense.GetTrainableParams(); i++)
+			dense.SetParam(i, 0);
+
+		for (int f = 0; f < fc; f++) {
+			for (int i = 0; i < params; i++) {
+				real weight = distribution(generator);
+				int k = i / size.deep / fs;
+				int l = i / size.deep % fs;
+				int c = i % size.deep;
+
+				dense.SetParam(f * denseParams + (i == params - 1 ? denseParams - 1 : (D * k * fe + D * l) * size.deep + c), weight);
+
+				for (size_t j = 0; j < layers.size(); j++)
+					layers[j]->SetParam(f * params + i, weight);
+			}
+		}
+
+		Tensor inputs(2, size);
+		Tensor deltas(2, dense.GetOutputSize());
+
+		for (int i = 0; i < 2 * inputs.Total(); i++)
+			inputs.Data()[i] = distribution(generator);
+
+		for (int i = 0; i < 2 * deltas.Total(); i++)
+			deltas.Data()[i] = distribution(generator);
+
+		dense.SetBatchSize(2);
+		dense.Forward(inputs);
+		dense.Backward(deltas, inputs, true);
+
+		for (size_t i = 0; i < layers.size(); i++) {
+			layers[i]->SetBatchSize(2);
+			layers[i]->Forward(inputs);
+			layers[i]->Backward(deltas, inputs, true);
+
+			for (int j = 0; j < 2 * deltas.Total(); j++)
+				assert(fabs(layers[i]->GetOutput().Data()[j] - dense.GetOutput().Data()[j]) < Tolerance(1e-10));
+
+			for (int j = 0; j < 2 * inputs.Total(); j++)
+				assert(fabs(layers[i]->GetDeltas().Data()[j] - dense.GetDeltas().Data()[j]) < Tolerance(1e-10));
+
+			for (int f = 0; f < fc; f++) {
+				for (int j = 0; j < params - 1; j++) {
+					int k = j / size.deep / fs;
+					int l = j / size.deep % fs;
+					int c = j % size.deep;
+
+					assert(fabs(layers[i]->GetGradient(f * params + j) - dense.GetGradient(f * denseParams + (D * k * fe + D * l) * size.deep + c)) < Tolerance(1e-9));
+				}
+
+				assert(fabs(layers[i]->GetGradient(f * params + params - 1) - dense.GetGradient(f * denseParams + denseParams - 1)) < Tolerance(1e-9));
+			}
+		}
+
+		// сохранение и загрузка восстанавливают разрежение и веса
+		ofstream fout("dilated_conv_test.txt");
+		gemm.Save(fout);
+		fout.close();
+
+		string type;
+		VolumeSize loadedSize;
+		ifstream fin("dilated_conv_test.txt");
+		fin >> type >> loadedSize;
+
+		assert(type == "dilatedconv");
+
+		NetworkLayer *loaded = LoadLayer(loadedSize, type, fin);
+		fin.close();
+		remove("dilated_conv_test.txt");
+
+		loaded->SetBatchSize(2);
+		loaded->Forward(inputs);
+
+		for (int j = 0; j < 2 * deltas.Total(); j++)
+			assert(fabs(loaded->GetOutput().Data()[j] - dense.GetOutput().Data()[j]) < Tolerance(1e-10));
+
+		delete loaded;
+	}
+
+	// same сохраняет размер при разрежении, блочное расположение считает так же, как канальное
+	vector<string> configs2 = { "conv fc=6 fs=3 P=same dilation=2", "relu", "conv fc=5 fs=3 P=same D=3 S=2", "relu", "fullconnected outputs=3 activation=none" };
+	Network channels(11, 11, 3);
+	Network blocked(11, 11, 3);
+
+	for (size_t i = 0; i < configs2.size(); i++) {
+		channels.AddLayer(configs2[i]);
+		blocked.AddLayer(configs2[i] + (configs2[i].find("conv") == 0 ? " layout=blocked" : ""));
+
+		for (int j = 0; j < channels.GetLayer(i)->GetTrainableParams(); j++)
+			blocked.GetLayer(i)->SetParam(j, channels.GetLayer(i)->GetParam(j));
+	}
+
+	assert(channels.GetLayer(0)->GetOutputSize().width == 11 && channels.GetLayer(2)->GetOutputSize().width == 6);
+
+	Tensor inputs(2, 11, 11, 3);
+	Tensor outputs(2, 1, 1, 3);
+
+	for (int i = 0; i < 2 * inputs.Total(); i++)
+		inputs.Data()[i] = distribution(generator);
+
+	for (int i = 0; i < 2 * outputs.Total(); i++)
+		outputs.Data()[i] = distribution(generator);
+
+	for (int iteration = 0; iteration < 2; iteration++) {
+		Tensor output1 = channels.GetOutput(inputs);
+		Tensor output2 = blocked.GetOutput(inputs);
+
+		for (int i = 0; i < 2 * output1.Total(); i++)
+			assert(fabs(output1.Data()[i] - output2.Data()[i]) < Tolerance(1e-10));
+
+		channels.TrainOnBatch(inputs, outputs, Optimizer::SGD(0.01), LossFunction::MSE());
+		blocked.TrainOnBatch(inputs, outputs, Optimizer::SGD(0.01), LossFunction::MSE());
+	}
+
+	// свёртка 1x1 с разрежением выбирает поточечный алгоритм без специализированного ядра, в том числе при автоподборе
+	Network pointwise(7, 6, 3);
+	pointwise.AddLayer("conv fs=1 fc=4 D=2");
+	pointwise.AddLayer("conv fs=1 fc=3 D=3 S=2");
+	pointwise.AddLayer("fullconnected outputs=3 activation=none");
+
+	Tensor pointwiseInputs(2, 7, 6, 3);
+
+	for (int i = 0; i < 2 * pointwiseInputs.Total(); i++)
+		pointwiseInputs.Data()[i] = distribution(generator);
+
+	pointwise.GetOutput(pointwiseInputs);
+	pointwise.TrainOnBatch(pointwiseInputs, outputs, Optimizer::SGD(0.01), LossFunction::MSE());
+	assert(pointwise.Autotune(2, true, "dilated_pointwise_autotune.txt") == 2);
+	remove("dilated_pointwise_autotune.txt");
+
+	// для разреженных фильтров нет специализированных ядер и свёртки Винограда
+	VolumeSize size;
+	size.width = 10;
+	size.height = 10;
+	size.deep = 2;
+
+	ConvWithoutStrideLayer conv(size, 4, 3, 2, 2);
+	vector<ConvAlgorithm> unsupported = { ConvAlgorithm::Specialized, ConvAlgorithm::Winograd2, ConvAlgorithm::Winograd4 };
+
+	conv.ChooseAlgorithm();
+	assert(conv.GetAlgorithm() != ConvAlgorithm::Specialized);
+
+	for (size_t i = 0; i < unsupported.size(); i++) {
+		bool thrown = false;
+
+		try {
+			conv.SetAlgorithm(unsupported[i]);
+		}
+		catch (const runtime_error &) {
+			thrown = true;
+		}
+
+		assert(thrown);
+	}
+
+	cout << "OK" << endl;
+}
+
+void ConvTransposedLayerTest() {
+	cout << "Conv transposed tests: ";
+
+	VolumeSize size;
+	size.deep = 3;
+	size.height = 5;
+	size.width = 5;
+
+	ConvTransposedLayer layer(size, 1, 3, 0, 1);
+	layer.SetBatchSize(1);
+
+	Volume input(size);
+	
+	layer.SetWeight(0, 0, 0, 0, 0);
+	layer.SetWeight(0, 0, 0, 1, 1);
+	layer.SetWeight(0, 0, 0, 2, 0);
+
+	layer.SetWeight(0, 0, 1, 0, 0);
+	layer.SetWeight(0, 0, 1, 1, 0);
+	layer.SetWeight(0, 0, 1, 2, 2);
+
+	layer.SetWeight(0, 0, 2, 0, 0);
+	layer.SetWeight(0, 0, 2, 1, 1);
+	layer.SetWeight(0, 0, 2, 2, 0);
+
+
+	layer.SetWeight(0, 1, 0, 0, 2);
+	layer.SetWeight(0, 1, 0, 1, 1);
+	layer.SetWeight(0, 1, 0, 2, 0);
+
+	layer.SetWeight(0, 1, 1, 0, 0);
+	layer.SetWeight(0, 1, 1, 1, 0);
+	layer.SetWeight(0, 1, 1, 2, 0);
+
+	layer.SetWeight(0, 1, 2, 0, 0);
+	layer.SetWeight(0, 1, 2, 1, 3);
+	layer.SetWeight(0, 1, 2, 2, 0);
+
+
+	layer.SetWeight(0, 2, 0, 0, 1);
+	layer.SetWeight(0, 2, 0, 1, 0);
+	layer.SetWeight(0, 2, 0, 2, 0);
+
+	layer.SetWeight(0, 2, 1, 0, 1);
+	layer.SetWeight(0, 2, 1, 1, 0);
+	layer.SetWeight(0, 2, 1, 2, 0);
+
+	layer.SetWeight(0, 2, 2, 0, 0);
+	layer.SetWeight(0, 2, 2, 1, 0);
+	layer.SetWeight(0, 2, 2, 2, 2);
+	
+	layer.SetBias(0, 0);
+
+	input(0, 0, 0) = 1;
+	input(0, 0, 1) = 0;
+	input(0, 0, 2) = 1;
+	input(0, 0, 3) = 0;
+	input(0, 0, 4) = 2;
+
+	input(0, 1, 0) = 1;
+	input(0, 1, 1) = 1;
+	input(0, 1, 2) = 3;
+	input(0, 1, 3) = 2;
+	input(0, 1, 4) = 1;
+
+	input(0, 2, 0) = 1;
+	input(0, 2, 1) = 1;
+	input(0, 2, 2) = 0;
+	input(0, 2, 3) = 1;
+	input(0, 2, 4) = 1;
+
+	input(0, 3, 0) = 2;
+	input(0, 3, 1) = 3;
+	input(0, 3, 2) = 2;
 	input(0, 3, 3) = 1;
 	input(0, 3, 4) = 3;
 
-	input(0, 4, 0) = 0;
-	input(0, 4, 1) = 2;
-	input(0, 4, 2) = 0;
-	input(0, 4, 3) = 1;
-	input(0, 4, 4) = 0;
+	input(0, 4, 0) = 0;
+	input(0, 4, 1) = 2;
+	input(0, 4, 2) = 0;
+	input(0, 4, 3) = 1;
+	input(0, 4, 4) = 0;
+
+
+	input(1, 0, 0) = 1;
+	input(1, 0, 1) = 0;
+	input(1, 0, 2) = 0;
+	input(1, 0, 3) = 1;
+	input(1, 0, 4) = 0;
+
+	input(1, 1, 0) = 2;
+	input(1, 1, 1) = 0;
+	input(1, 1, 2) = 1;
+	input(1, 1, 3) = 2;
+	input(1, 1, 4) = 0;
+
+	input(1, 2, 0) = 3;
+	input(1, 2, 1) = 1;
+	input(1, 2, 2) = 1;
+	input(1, 2, 3) = 3;
+	input(1, 2, 4) = 0;
+
+	input(1, 3, 0) = 0;
+	input(1, 3, 1) = 3;
+	input(1, 3, 2) = 0;
+	input(1, 3, 3) = 3;
+	input(1, 3, 4) = 2;
+
+	input(1, 4, 0) = 1;
+	input(1, 4, 1) = 0;
+	input(1, 4, 2) = 3;
+	input(1, 4, 3) = 2;
+	input(1, 4, 4) = 1;
+
+
+	input(2, 0, 0) = 2;
+	input(2, 0, 1) = 0;
+	input(2, 0, 2) = 1;
+	input(2, 0, 3) = 2;
+	input(2, 0, 4) = 1;
+
+	input(2, 1, 0) = 3;
+	input(2, 1, 1) = 3;
+	input(2, 1, 2) = 1;
+	input(2, 1, 3) = 3;
+	input(2, 1, 4) = 2;
+
+	input(2, 2, 0) = 2;
+	input(2, 2, 1) = 1;
+	input(2, 2, 2) = 1;
+	input(2, 2, 3) = 1;
+	input(2, 2, 4) = 0;
+
+	input(2, 3, 0) = 3;
+	input(2, 3, 1) = 1;
+	input(2, 3, 2) = 3;
+	input(2, 3, 3) = 2;
+	input(2, 3, 4) = 0;
+
+	input(2, 4, 0) = 1;
+	input(2, 4, 1) = 1;
+	input(2, 4, 2) = 2;
+	input(2, 4, 3) = 1;
+	input(2, 4, 4) = 1;
+
+	layer.Forward({input});
+	Volume output = layer.GetOutput()[0];
+
+	assert(output.Width() == 7);
+	assert(output.Height() == 7);
+	assert(output.Deep() == 1);
+
+	assert(output(0, 0, 0) == 4);
+	assert(output(0, 0, 1) == 2);
+	assert(output(0, 0, 2) == 1);
+	assert(output(0, 0, 3) == 5);
+	assert(output(0, 0, 4) == 2);
+	assert(output(0, 0, 5) == 2);
+	assert(output(0, 0, 6) == 0);
+
+	assert(output(0, 1, 0) == 9);
+	assert(output(0, 1, 1) == 6);
+	assert(output(0, 1, 2) == 7);
+	assert(output(0, 1, 3) == 13);
+	assert(output(0, 1, 4) == 9);
+	assert(output(0, 1, 5) == 1);
+	assert(output(0, 1, 6) == 4);
+
+	assert(output(0, 2, 0) == 11);
+	assert(output(0, 2, 1) == 14);
+	assert(output(0, 2, 2) == 12);
+	assert(output(0, 2, 3) == 14);
+	assert(output(0, 2, 4) == 17);
+	assert(output(0, 2, 5) == 11);
+	assert(output(0, 2, 6) == 4);
+
+	assert(output(0, 3, 0) == 5);
+	assert(output(0, 3, 1) == 17);
+	assert(output(0, 3, 2) == 19);
+	assert(output(0, 3, 3) == 25);
+	assert(output(0, 3, 4) == 18);
+	assert(output(0, 3, 5) == 14);
+	assert(output(0, 3, 6) == 6);
+
+	assert(output(0, 4, 0) == 6);
+	assert(output(0, 4, 1) == 13);
+	assert(output(0, 4, 2) == 25);
+	assert(output(0, 4, 3) == 21);
+	assert(output(0, 4, 4) == 22);
+	assert(output(0, 4, 5) == 6);
+	assert(output(0, 4, 6) == 6);
+
+	assert(output(0, 5, 0) == 1);
+	assert(output(0, 5, 1) == 3);
+	assert(output(0, 5, 2) == 20);
+	assert(output(0, 5, 3) == 9);
+	assert(output(0, 5, 4) == 17);
+	assert(output(0, 5, 5) == 15);
+	assert(output(0, 5, 6) == 0);
+
+	assert(output(0, 6, 0) == 0);
+	assert(output(0, 6, 1) == 3);
+	assert(output(0, 6, 2) == 4);
+	assert(output(0, 6, 3) == 11);
+	assert(output(0, 6, 4) == 11);
+	assert(output(0, 6, 5) == 5);
+	assert(output(0, 6, 6) == 2);
+
+	cout << "OK" << endl;
+}
+
+void ConvTransposedStrideTest() {
+	cout << "Conv transposed stride tests: ";
+
+	default_random_engine generator;
+	normal_distribution<double> distribution(0.0, 1.0);
+
+	// fs, P, S
+	vector<vector<int>> configs = {
+		{ 3, 1, 2 },
+		{ 4, 1, 2 },
+		{ 2, 0, 2 },
+		{ 5, 2, 3 },
+		{ 3, 0, 1 },
+		{ 1, 0, 2 }
+	};
+
+	for (size_t t = 0; t < configs.size(); t++) {
+		int fs = configs[t][0];
+		int P = configs[t][1];
+		int S = configs[t][2];
+
+		VolumeSize size;
+		size.width = 5;
+		size.height = 4;
+		size.deep = 3;
+
+		ConvTransposedLayer layer(size, 4, fs, P, S);
+		VolumeSize outputSize = layer.GetOutputSize();
+
+		for (int i = 0; i < layer.GetTrainableParams(); i++)
+			layer.SetParam(i, distribution(generator));
+
+		Tensor inputs(2, size);
+		Tensor deltas(2, outputSize);
+
+		for (int i = 0; i < 2 * inputs.Total(); i++)
+			inputs.Data()[i] = distribution(generator);
+
+		for (int i = 0; i < 2 * deltas.Total(); i++)
+			deltas.Data()[i] = distribution(generator);
+
+		layer.SetBatchSize(2);
+		layer.Forward(inputs);
+		layer.Backward(deltas, inputs, true);
+
+		int params = fs * fs * size.deep + 1;
+
+		// эталон: каждое значение входа разносится по окну выхода (y * S + k - P, x * S + l - P)
+		Tensor outputs(2, outputSize);
+		vector<double> gradients(4 * params, 0);
+
+		for (int n = 0; n < 2; n++) {
+			for (int f = 0; f < 4; f++)
+				for (int i = 0; i < outputSize.height; i++)
+					for (int j = 0; j < outputSize.width; j++)
+						outputs[n](f, i, j) = layer.GetParam(f * params + params - 1);
+
+			for (int f = 0; f < 4; f++) {
+				for (int i = 0; i < outputSize.height; i++)
+					for (int j = 0; j < outputSize.width; j++)
+						gradients[f * params + params - 1] += deltas[n](f, i, j);
+
+				for (int y = 0; y < size.height; y++) {
+					for (int x = 0; x < size.width; x++) {
+						for (int k = 0; k < fs; k++) {
+							for (int l = 0; l < fs; l++) {
+								int i = y * S + k - P;
+								int j = x * S + l - P;
+
+								if (i < 0 || i >= outputSize.height || j < 0 || j >= outputSize.width)
+									continue;
+
+								for (int c = 0; c < size.deep; c++) {
+									int index = f * params + (k * fs + l) * size.deep + c;
+
+									outputs[n](f, i, j) += layer.GetParam(index) * inputs[n](c, y, x);
+									gradients[index] += deltas[n](f, i, j) * inputs[n](c, y, x);
+								}
+							}
+						}
+					}
+				}
+			}
+
+			for (int y = 0; y < size.height; y++) {
+				for (int x = 0; x < size.width; x++) {
+					for (int c = 0; c < size.deep; c++) {
+						double dx = 0;
+
+						for (int k = 0; k < fs; k++) {
+							for (int l = 0; l < fs; l++) {
+								int i = y * S + k - P;
+								int j = x * S + l - P;
+
+								if (i < 0 || i >= outputSize.height || j < 0 || j >= outputSize.width)
+									continue;
+
+								for (int f = 0; f < 4; f++)
+									dx += deltas[n](f, i, j) * layer.GetParam(f * params + (k * fs + l) * size.deep + c);
+							}
+						}
+
+						assert(fabs(layer.GetDeltas()[n](c, y, x) - dx) < Tolerance(1e-10));
+					}
+				}
+			}
+		}
+
+		for (int i = 0; i < 2 * outputs.Total(); i++)
+			assert(fabs(layer.GetOutput().Data()[i] - outputs.Data()[i]) < Tolerance(1e-10));
+
+		for (int i = 0; i < layer.GetTrainableParams(); i++)
+			assert(fabs(layer.GetGradient(i) - gradients[i]) < Tolerance(1e-10));
+	}
+
+	cout << "OK" << endl;
+}
+
+void UpscaleLayerTest() {
+	cout << "Upscale tests: ";
+
+	VolumeSize size;
+	size.deep = 1;
+	size.height = 2;
+	size.width = 2;
+
+	UpscaleLayer layer(size, 2);
+	layer.SetBatchSize(1);
+
+	Volume input(size);
+
+	input(0, 0, 0) = 1;
+	input(0, 0, 1) = 2;
+	input(0, 1, 0) = 3;
+	input(0, 1, 1) = 4;
+
+	layer.Forward({input});
+	Volume output = layer.GetOutput()[0];
+
+	assert(output.Width() == 4);
+	assert(output.Height() == 4);
+	assert(output.Deep() == 1);
+
+	assert(output(0, 0, 0) == 1);
+	assert(output(0, 0, 1) == 1);
+	assert(output(0, 1, 0) == 1);
+	assert(output(0, 1, 1) == 1);
+
+	assert(output(0, 0, 2) == 2);
+	assert(output(0, 0, 3) == 2);
+	assert(output(0, 1, 2) == 2);
+	assert(output(0, 1, 3) == 2);
+
+	assert(output(0, 2, 0) == 3);
+	assert(output(0, 2, 1) == 3);
+	assert(output(0, 3, 0) == 3);
+	assert(output(0, 3, 1) == 3);
+
+	assert(output(0, 2, 2) == 4);
+	assert(output(0, 2, 3) == 4);
+	assert(output(0, 3, 2) == 4);
+	assert(output(0, 3, 3) == 4);
+
+	Volume deltas(output.GetSize());
+
+	deltas(0, 0, 0) = 1;
+	deltas(0, 0, 1) = 2;
+	deltas(0, 1, 0) = 0;
+	deltas(0, 1, 1) = -1;
+
+	deltas(0, 0, 2) = -1;
+	deltas(0, 0, 3) = 2;
+	deltas(0, 1, 2) = 2;
+	deltas(0, 1, 3) = 0;
+
+	deltas(0, 2, 0) = 0;
+	deltas(0, 2, 1) = 0;
+	deltas(0, 3, 0) = 0;
+	deltas(0, 3, 1) = 0;
+
+	deltas(0, 2, 2) = -1;
+	deltas(0, 2, 3) = -2;
+	deltas(0, 3, 2) = -3;
+	deltas(0, 3, 3) = -4;
+
+	layer.Backward({deltas}, {input}, true);
+	Volume& dX = layer.GetDeltas()[0];
+
+	assert(dX.Width() == 2);
+	assert(dX.Height() == 2);
+	assert(dX.Deep() == 1);
+
+	assert(dX(0, 0, 0) == 2);
+	assert(dX(0, 0, 1) == 3);
+	assert(dX(0, 1, 0) == 0);
+	assert(dX(0, 1, 1) == -10);
+
+	cout << "OK" << endl;
+}
+
+void UpscaleBilinearLayerTest() {
+	cout << "Upscale bilinear tests: ";
+
+	VolumeSize size;
+	size.deep = 1;
+	size.height = 2;
+	size.width = 2;
+
+	UpscaleBilinearLayer layer(size, 2);
+	layer.SetBatchSize(1);
+
+	Volume input(size);
+
+	input(0, 0, 0) = 1;
+	input(0, 0, 1) = 2;
+	input(0, 1, 0) = 3;
+	input(0, 1, 1) = 4;
+
+	layer.Forward({input});
+	Volume output = layer.GetOutput()[0];
+
+	assert(output.Width() == 4);
+	assert(output.Height() == 4);
+	assert(output.Deep() == 1);
+
+	assert(output(0, 0, 0) == 1);
+	assert(fabs(output(0, 0, 1) - 1.5) < Tolerance(1e-15));
+	assert(output(0, 1, 0) == 2);
+	assert(fabs(output(0, 1, 1) - 2.5) < Tolerance(1e-15));
 
+	assert(output(0, 0, 2) == 2);
+	assert(fabs(output(0, 0, 3) - 2.5) < Tolerance(1e-15));
+	assert(output(0, 1, 2) == 3);
+	assert(fabs(output(0, 1, 3) - 3.5) < Tolerance(1e-15));
 
-	input(1, 0, 0) = 1;
-	input(1, 0, 1) = 0;
-	input(1, 0, 2) = 0;
-	input(1, 0, 3) = 1;
-	input(1, 0, 4) = 0;
+	assert(output(0, 2, 0) == 3);
+	assert(fabs(output(0, 2, 1) - 3.5) < Tolerance(1e-15));
+	assert(output(0, 3, 0) == 4);
+	assert(fabs(output(0, 3, 1) - 4.5) < Tolerance(1e-15));
 
-	input(1, 1, 0) = 2;
-	input(1, 1, 1) = 0;
-	input(1, 1, 2) = 1;
-	input(1, 1, 3) = 2;
-	input(1, 1, 4) = 0;
+	assert(output(0, 2, 2) == 4);
+	assert(fabs(output(0, 2, 3) - 4.5) < Tolerance(1e-15));
+	assert(output(0, 3, 2) == 5);
+	assert(fabs(output(0, 3, 3) - 5.5) < Tolerance(1e-15));
 
-	input(1, 2, 0) = 3;
-	input(1, 2, 1) = 1;
-	input(1, 2, 2) = 1;
-	input(1, 2, 3) = 3;
-	input(1, 2, 4) = 0;
+	Volume deltas(output.GetSize());
 
-	input(1, 3, 0) = 0;
-	input(1, 3, 1) = 3;
-	input(1, 3, 2) = 0;
-	input(1, 3, 3) = 3;
-	input(1, 3, 4) = 2;
+	deltas(0, 0, 0) = 1;
+	deltas(0, 0, 1) = 2;
+	deltas(0, 1, 0) = 0;
+	deltas(0, 1, 1) = -1;
 
-	input(1, 4, 0) = 1;
-	input(1, 4, 1) = 0;
-	input(1, 4, 2) = 3;
-	input(1, 4, 3) = 2;
-	input(1, 4, 4) = 1;
+	deltas(0, 0, 2) = -1;
+	deltas(0, 0, 3) = 2;
+	deltas(0, 1, 2) = 2;
+	deltas(0, 1, 3) = 0;
 
+	deltas(0, 2, 0) = 0;
+	deltas(0, 2, 1) = 0;
+	deltas(0, 3, 0) = 0;
+	deltas(0, 3, 1) = 0;
 
-	input(2, 0, 0) = 2;
-	input(2, 0, 1) = 0;
-	input(2, 0, 2) = 1;
-	input(2, 0, 3) = 2;
-	input(2, 0, 4) = 1;
+	deltas(0, 2, 2) = -1;
+	deltas(0, 2, 3) = -2;
+	deltas(0, 3, 2) = -3;
+	deltas(0, 3, 3) = -4;
 
-	input(2, 1, 0) = 3;
-	input(2, 1, 1) = 3;
-	input(2, 1, 2) = 1;
-	input(2, 1, 3) = 3;
-	input(2, 1, 4) = 2;
+	layer.Backward({deltas}, {input}, true);
+	Volume& dX = layer.GetDeltas()[0];
 
-	input(2, 2, 0) = 2;
-	input(2, 2, 1) = 1;
-	input(2, 2, 2) = 1;
-	input(2, 2, 3) = 1;
-	input(2, 2, 4) = 0;
+	assert(dX.Width() == 2);
+	assert(dX.Height() == 2);
+	assert(dX.Deep() == 1);
 
-	input(2, 3, 0) = 3;
-	input(2, 3, 1) = 1;
-	input(2, 3, 2) = 3;
-	input(2, 3, 3) = 2;
-	input(2, 3, 4) = 0;
+	assert(fabs(dX(0, 0, 0) - -0.25) < Tolerance(1e-15));
+	assert(fabs(dX(0, 0, 1) - 8.25) < Tolerance(1e-15));
+	assert(fabs(dX(0, 1, 0) - 3.75) < Tolerance(1e-15));
+	assert(fabs(dX(0, 1, 1) - -16.75) < Tolerance(1e-15));
 
-	input(2, 4, 0) = 1;
-	input(2, 4, 1) = 1;
-	input(2, 4, 2) = 2;
-	input(2, 4, 3) = 1;
-	input(2, 4, 4) = 1;
+	cout << "OK" << endl;
+}
 
-	layer.Forward({input});
-	Volume output = layer.GetOutput()[0];
+void DropoutTest() {
+	cout << "Dropout tests: ";
+	Volume input(1, 1, 10);
 
-	assert(output.Width() == 7);
-	assert(output.Height() == 7);
-	assert(output.Deep() == 1);
+	for (int i = 0; i < 10; i++)
+		input[i] = 1;
 
-	assert(output(0, 0, 0) == 4);
-	assert(output(0, 0, 1) == 2);
-	assert(output(0, 0, 2) == 1);
-	assert(output(0, 0, 3) == 5);
-	assert(output(0, 0, 4) == 2);
-	assert(output(0, 0, 5) == 2);
-	assert(output(0, 0, 6) == 0);
+	VolumeSize size;
+	size.height = 1;
+	size.width = 1;
+	size.deep = 10;
 
-	assert(output(0, 1, 0) == 9);
-	assert(output(0, 1, 1) == 6);
-	assert(output(0, 1, 2) == 7);
-	assert(output(0, 1, 3) == 13);
-	assert(output(0, 1, 4) == 9);
-	assert(output(0, 1, 5) == 1);
-	assert(output(0, 1, 6) == 4);
+	DropoutLayer layer(size, 0.2);
+	layer.SetBatchSize(1);
 
-	assert(output(0, 2, 0) == 11);
-	assert(output(0, 2, 1) == 14);
-	assert(output(0, 2, 2) == 12);
-	assert(output(0, 2, 3) == 14);
-	assert(output(0, 2, 4) == 17);
-	assert(output(0, 2, 5) == 11);
-	assert(output(0, 2, 6) == 4);
+	Tensor inputs(1, size);
+	inputs[0] = input;
 
-	assert(output(0, 3, 0) == 5);
-	assert(output(0, 3, 1) == 17);
-	assert(output(0, 3, 2) == 19);
-	assert(output(0, 3, 3) == 25);
-	assert(output(0, 3, 4) == 18);
-	assert(output(0, 3, 5) == 14);
-	assert(output(0, 3, 6) == 6);
+	for (int i = 0; i < 10; i++)
+		layer.Forward(inputs);
 
-	assert(output(0, 4, 0) == 6);
-	assert(output(0, 4, 1) == 13);
-	assert(output(0, 4, 2) == 25);
-	assert(output(0, 4, 3) == 21);
-	assert(output(0, 4, 4) == 22);
-	assert(output(0, 4, 5) == 6);
-	assert(output(0, 4, 6) == 6);
+	layer.ForwardOutput(inputs);
+	Volume& output = layer.GetOutput()[0];
 
-	assert(output(0, 5, 0) == 1);
-	assert(output(0, 5, 1) == 3);
-	assert(output(0, 5, 2) == 20);
-	assert(output(0, 5, 3) == 9);
-	assert(output(0, 5, 4) == 17);
-	assert(output(0, 5, 5) == 15);
-	assert(output(0, 5, 6) == 0);
+	double sum = 0;
+	for (int j = 0; j < 10; j++)
+		sum += output[j];
 
-	assert(output(0, 6, 0) == 0);
-	assert(output(0, 6, 1) == 3);
-	assert(output(0, 6, 2) == 4);
-	assert(output(0, 6, 3) == 11);
-	assert(output(0, 6, 4) == 11);
-	assert(output(0, 6, 5) == 5);
-	assert(output(0, 6, 6) == 2);
+	assert(fabs(sum - 10) < Tolerance(1e-14));
+	cout << "OK" << endl;
+}
+
+void TensorTest() {
+	cout << "Tensor tests: ";
+
+	Volume volume1(2, 2, 3);
+	Volume volume2(2, 2, 3);
+
+	for (int i = 0; i < 12; i++) {
+		volume1[i] = i;
+		volume2[i] = -i;
+	}
+
+	Tensor tensor({ volume1, volume2 });
+
+	assert(tensor.size() == 2);
+	assert(tensor.Total() == 12);
+	assert(tensor[0].IsView() && tensor[1].IsView());
+	assert(tensor[1].Data() == tensor.Data() + 12);
+
+	for (int i = 0; i < 12; i++) {
+		assert(tensor.Data()[i] == i);
+		assert(tensor.Data()[12 + i] == -i);
+	}
+
+	tensor[1](2, 1, 0) = 100;
+	assert(tensor.Data()[12 + 1 * 2 * 3 + 0 * 3 + 2] == 100);
+
+	Volume copy = tensor[1];
+	copy[0] = 5;
+
+	assert(!copy.IsView());
+	assert(tensor[1][0] == 0);
+
+	Tensor tensorCopy = tensor;
+	tensorCopy[0][0] = 7;
+
+	assert(tensorCopy[0].Data() == tensorCopy.Data());
+	assert(tensor[0][0] == 0);
+
+	real *data = tensorCopy.Data();
+	tensorCopy.Resize(1, tensorCopy.GetSize());
+
+	assert(tensorCopy.size() == 1);
+	assert(tensorCopy.Capacity() == 2);
+	assert(tensorCopy.Data() == data);
+
+	tensorCopy.Resize(2, tensorCopy.GetSize());
+
+	assert(tensorCopy.Data() == data);
+	assert(tensorCopy[1][0] == 0);
+
+	tensorCopy.Resize(3, tensorCopy.GetSize());
+
+	assert(tensorCopy.size() == 3);
+	assert(tensorCopy.Capacity() == 3);
+
+	cout << "OK" << endl;
+}
+
+void AlignedAllocatorTest() {
+	cout << "Aligned allocator tests: ";
+
+	Volume volume(3, 5, 7);
+	Tensor tensor(4, volume.GetSize());
+
+	assert((uintptr_t) volume.Data() % MEMORY_ALIGNMENT == 0);
+	assert((uintptr_t) tensor.Data() % MEMORY_ALIGNMENT == 0);
+
+	MemoryConfig::SetHugePages(true);
+	Tensor large(1, HUGE_PAGE_THRESHOLD / sizeof(real), 1, 1);
+	MemoryConfig::SetHugePages(false);
+
+	assert((uintptr_t) large.Data() % HUGE_PAGE_SIZE == 0);
+	assert(large[0][large.Total() - 1] == 0);
+
+	cout << "OK" << endl;
+}
+
+void AliasLayersTest() {
+	cout << "Alias layers tests: ";
+
+	VolumeSize size;
+	size.width = 4;
+	size.height = 3;
+	size.deep = 2;
+
+	VolumeSize newSize;
+	newSize.width = 1;
+	newSize.height = 1;
+	newSize.deep = 24;
+
+	Tensor inputs(2, size);
+	Tensor douts(2, newSize);
+
+	for (int i = 0; i < 2 * inputs.Total(); i++) {
+		inputs.Data()[i] = i;
+		douts.Data()[i] = -i;
+	}
+
+	ReshapeLayer reshape(size, newSize);
+	reshape.SetBatchSize(2);
+	reshape.Forward(inputs);
+	reshape.Backward(douts, inputs, true);
+
+	assert(reshape.AliasesInput());
+	assert(reshape.GetOutput().Data() == inputs.Data());
+	assert(reshape.GetOutput().GetSize() == newSize);
+	assert(reshape.GetOutput()[1](5, 0, 0) == 29);
+	assert(reshape.GetDeltas().Data() == douts.Data());
+	assert(reshape.GetDeltas()[1](1, 2, 3) == -47);
+
+	IdentityLayer identity(size);
+	identity.SetBatchSize(2);
+	identity.Forward(inputs);
+
+	assert(identity.GetOutput().Data() == inputs.Data());
+	assert(identity.GetOutput().size() == 2);
+
+	DropoutLayer dropout(size, 0.5);
+	dropout.SetBatchSize(2);
+	dropout.ForwardOutput(inputs);
+
+	assert(dropout.GetOutput().IsAlias());
+	assert(dropout.GetOutput().Data() == inputs.Data());
+
+	dropout.Forward(inputs);
+
+	assert(!dropout.GetOutput().IsAlias());
+	assert(dropout.GetOutput().Data() != inputs.Data());
+	assert(inputs.Data()[1] == 1);
+
+	Tensor copy = reshape.GetOutput();
+	copy[0][0] = 100;
+
+	assert(!copy.IsAlias());
+	assert(inputs.Data()[0] == 0);
+
+	cout << "OK" << endl;
+}
+
+void BlockedLayoutTest() {
+	cout << "Blocked layout tests: ";
+
+	default_random_engine generator;
+	normal_distribution<double> distribution(0.0, 1.0);
+
+	Volume volume(5, 4, 11);
+	Volume blocked(5, 4, 11);
+	Volume restored(5, 4, 11);
+
+	for (int i = 0; i < volume.Total(); i++)
+		volume[i] = distribution(generator);
+
+	ChannelsToBlocked(volume.Data(), blocked.Data(), volume.GetSize());
+	BlockedToChannels(blocked.Data(), restored.Data(), volume.GetSize());
+
+	for (int d = 0; d < 11; d++)
+		for (int i = 0; i < 4; i++)
+			for (int j = 0; j < 5; j++)
+				assert(blocked[BlockedIndex(volume.GetSize(), d, i, j)] == volume(d, i, j));
+
+	for (int i = 0; i < volume.Total(); i++)
+		assert(restored[i] == volume[i]);
+
+	vector<string> configs = { "conv filters=12 filter_size=3 P=1", "relu", "conv filters=10 filter_size=3 P=1 S=2", "relu", "fullconnected outputs=3 activation=none" };
+	Network channels(9, 9, 5);
+	Network blockedNetwork(9, 9, 5);
+
+	for (size_t i = 0; i < configs.size(); i++) {
+		channels.AddLayer(configs[i]);
+		blockedNetwork.AddLayer(configs[i] + (configs[i].find("conv") == 0 ? " layout=blocked" : ""));
+
+		for (int j = 0; j < channels.GetLayer(i)->GetTrainableParams(); j++)
+			blockedNetwork.GetLayer(i)->SetParam(j, channels.GetLayer(i)->GetParam(j));
+	}
+
+	Tensor inputs(2, 9, 9, 5);
+	Tensor outputs(2, 1, 1, 3);
+
+	for (int i = 0; i < 2 * inputs.Total(); i++)
+		inputs.Data()[i] = distribution(generator);
+
+	for (int i = 0; i < 2 * outputs.Total(); i++)
+		outputs.Data()[i] = distribution(generator);
+
+	for (int iteration = 0; iteration < 3; iteration++) {
+		Tensor output1 = channels.GetOutput(inputs);
+		Tensor output2 = blockedNetwork.GetOutput(inputs);
+
+		for (int i = 0; i < 2 * output1.Total(); i++)
+			assert(fabs(output1.Data()[i] - output2.Data()[i]) < Tolerance(1e-10));
+
+		channels.TrainOnBatch(inputs, outputs, Optimizer::SGD(0.01), LossFunction::MSE());
+		blockedNetwork.TrainOnBatch(inputs, outputs, Optimizer::SGD(0.01), LossFunction::MSE());
+	}
+
+	for (int i = 0; i < channels.LayersCount(); i++)
+		for (int j = 0; j < channels.GetLayer(i)->GetTrainableParams(); j++)
+			assert(fabs(channels.GetLayer(i)->GetParam(j) - blockedNetwork.GetLayer(i)->GetParam(j)) < Tolerance(1e-10));
+
+	// расположение и явно выбранный алгоритм свёрток сохраняются вместе с моделью
+	Network algorithms(9, 9, 5);
+	algorithms.AddLayer("conv filters=4 filter_size=3 P=1 algorithm=direct");
+	algorithms.AddLayer("conv filters=4 filter_size=3 S=2 algorithm=direct");
+
+	blockedNetwork.Save("blocked_network_test.txt", false);
+	algorithms.Save("algorithms_network_test.txt", false);
+
+	Network loaded(9, 9, 5);
+	Network loadedAlgorithms(9, 9, 5);
+	loaded.Load("blocked_network_test.txt", false);
+	loadedAlgorithms.Load("algorithms_network_test.txt", false);
+	remove("blocked_network_test.txt");
+	remove("algorithms_network_test.txt");
+
+	for (int i = 0; i < blockedNetwork.LayersCount(); i++)
+		assert(loaded.GetLayer(i)->GetLayout() == blockedNetwork.GetLayer(i)->GetLayout());
+
+	assert(loaded.GetLayer(0)->GetLayout() == Layout::Blocked && loaded.GetLayer(2)->GetLayout() == Layout::Blocked);
+	assert(dynamic_cast<ConvWithoutStrideLayer*>(loadedAlgorithms.GetLayer(0))->GetAlgorithm() == ConvAlgorithm::Direct);
+	assert(dynamic_cast<ConvLayer*>(loadedAlgorithms.GetLayer(1))->GetAlgorithm() == ConvAlgorithm::Direct);
+
+	Tensor expected = blockedNetwork.GetOutput(inputs);
+	Tensor &output = loaded.GetOutput(inputs);
+
+	for (int i = 0; i < 2 * output.Total(); i++)
+		assert(fabs(output.Data()[i] - expected.Data()[i]) < Tolerance(1e-10));
+
+	cout << "OK" << endl;
+}
+
+void TrainingAllocationsTest() {
+	cout << "Training allocations tests: ";
+
+	Network network(12, 12, 3);
+
+	network.AddLayer("conv filters=8 filter_size=3 P=1");
+	network.AddLayer("relu");
+	network.AddBlock({ { "conv filters=4 filter_size=3 P=1", "batchnormalization2D" }, { "identity" } }, "stack");
+	network.AddLayer("conv filters=6 filter_size=3 P=1 S=2 layout=blocked");
+	network.AddLayer("convtransposed filters=4 filter_size=2 S=2");
+	network.AddLayer("maxpool");
+	network.AddLayer("dropout p=0.2");
+	network.AddLayer("fullconnected outputs=10 activation=none");
+	network.AddLayer("batchnormalization");
+	network.AddLayer("softmax");
+
+	Tensor inputs(4, 12, 12, 3);
+	Tensor outputs(4, 1, 1, 10);
+	Tensor halfInputs(2, 12, 12, 3);
+	Tensor halfOutputs(2, 1, 1, 10);
+
+	for (int i = 0; i < 4 * inputs.Total(); i++)
+		inputs.Data()[i] = sin(i);
+
+	for (size_t i = 0; i < outputs.size(); i++)
+		outputs[i][i] = 1;
+
+	for (size_t i = 0; i < halfInputs.size(); i++) {
+		halfInputs[i] = inputs[i];
+		halfOutputs[i] = outputs[i];
+	}
+
+	Optimizer optimizer = Optimizer::Adam();
+	LossFunction E = LossFunction::CrossEntropy();
 
-	cout << "OK" << endl;
-}
+	network.TrainOnBatch(inputs, outputs, optimizer, E);
+	network.GetOutput(inputs[0]);
 
-void UpscaleLayerTest() {
-	cout << "Upscale tests: ";
+	size_t allocations = MemoryConfig::Allocations();
+	size_t heap = heapAllocations;
 
-	VolumeSize size;
-	size.deep = 1;
-	size.height = 2;
-	size.width = 2;
+	for (int i = 0; i < 3; i++)
+		network.TrainOnBatch(inputs, outputs, optimizer, E);
 
-	UpscaleLayer layer(size, 2);
-	layer.SetBatchSize(1);
+	assert(MemoryConfig::Allocations() == allocations);
+	assert(heapAllocations == heap);
 
-	Volume input(size);
+	// смена размера батча в пределах уже выделенной памяти тоже не выделяет память
+	for (int i = 0; i < 3; i++) {
+		network.TrainOnBatch(halfInputs, halfOutputs, optimizer, E);
+		network.GetOutput(inputs[0]);
+		network.TrainOnBatch(inputs, outputs, optimizer, E);
+	}
 
-	input(0, 0, 0) = 1;
-	input(0, 0, 1) = 2;
-	input(0, 1, 0) = 3;
-	input(0, 1, 1) = 4;
+	assert(MemoryConfig::Allocations() == allocations);
+	assert(heapAllocations == heap);
+	assert(network.GetLayer(0)->GetBatchSize() == 4);
+	cout << "OK" << endl;
+}
 
-	layer.Forward({input});
-	Volume output = layer.GetOutput()[0];
+void InferencePlanTest() {
+	cout << "Inference plan tests: ";
 
-	assert(output.Width() == 4);
-	assert(output.Height() == 4);
-	assert(output.Deep() == 1);
+	Network network(12, 12, 3);
 
-	assert(output(0, 0, 0) == 1);
-	assert(output(0, 0, 1) == 1);
-	assert(output(0, 1, 0) == 1);
-	assert(output(0, 1, 1) == 1);
+	network.AddLayer("conv filters=8 filter_size=3 P=1");
+	network.AddLayer("relu");
+	network.AddBlock({ { "conv filters=8 filter_size=3 P=1", "tanh" }, { "identity" } }, "sum");
+	network.AddBlock({ { "conv filters=4 filter_size=3 P=1", "batchnormalization2D" }, { "identity" } }, "stack");
+	network.AddLayer("conv filters=6 filter_size=3 P=1 S=2 layout=blocked");
+	network.AddLayer("convtransposed filters=4 filter_size=2 S=2");
+	network.AddLayer("maxpool");
+	network.AddLayer("dropout p=0.2");
+	network.AddLayer("fullconnected outputs=10 activation=sigmoid");
+	network.AddLayer("batchnormalization");
+	network.AddLayer("softmax");
 
-	assert(output(0, 0, 2) == 2);
-	assert(output(0, 0, 3) == 2);
-	assert(output(0, 1, 2) == 2);
-	assert(output(0, 1, 3) == 2);
+	Tensor inputs(4, 12, 12, 3);
+	Tensor outputs(4, 1, 1, 10);
 
-	assert(output(0, 2, 0) == 3);
-	assert(output(0, 2, 1) == 3);
-	assert(output(0, 3, 0) == 3);
-	assert(output(0, 3, 1) == 3);
+	for (int i = 0; i < 4 * inputs.Total(); i++)
+		inputs.Data()[i] = sin(i);
 
-	assert(output(0, 2, 2) == 4);
-	assert(output(0, 2, 3) == 4);
-	assert(output(0, 3, 2) == 4);
-	assert(output(0, 3, 3) == 4);
+	for (size_t i = 0; i < outputs.size(); i++)
+		outputs[i][i] = 1;
 
-	Volume deltas(output.GetSize());
+	network.TrainOnBatch(inputs, outputs, Optimizer::SGD(0.01), LossFunction::CrossEntropy());
 
-	deltas(0, 0, 0) = 1;
-	deltas(0, 0, 1) = 2;
-	deltas(0, 1, 0) = 0;
-	deltas(0, 1, 1) = -1;
+	Tensor expected = network.GetOutput(inputs);
+	size_t unplanned = 0;
 
-	deltas(0, 0, 2) = -1;
-	deltas(0, 0, 3) = 2;
-	deltas(0, 1, 2) = 2;
-	deltas(0, 1, 3) = 0;
+	for (int i = 0; i < network.LayersCount(); i++) {
+		VolumeSize size = network.GetLayer(i)->GetOutputSize();
+		unplanned += size.width * size.height * size.deep * inputs.size();
+	}
 
-	deltas(0, 2, 0) = 0;
-	deltas(0, 2, 1) = 0;
-	deltas(0, 3, 0) = 0;
-	deltas(0, 3, 1) = 0;
+	network.PlanInference(4);
 
-	deltas(0, 2, 2) = -1;
-	deltas(0, 2, 3) = -2;
-	deltas(0, 3, 2) = -3;
-	deltas(0, 3, 3) = -4;
+	// выходы слоёв делят несколько общих буферов, а градиенты по входу не выделяются
+	assert(network.GetInferenceMemory() < unplanned);
+	assert(network.GetLayer(0)->GetDeltas().Capacity() == 0);
 
-	layer.Backward({deltas}, {input}, true);
-	Volume& dX = layer.GetDeltas()[0];
+	Volume &single = network.GetOutput(inputs[1]);
 
-	assert(dX.Width() == 2);
-	assert(dX.Height() == 2);
-	assert(dX.Deep() == 1);
+	for (int j = 0; j < single.Total(); j++)
+		assert(single[j] == expected[1][j]);
 
-	assert(dX(0, 0, 0) == 2);
-	assert(dX(0, 0, 1) == 3);
-	assert(dX(0, 1, 0) == 0);
-	assert(dX(0, 1, 1) == -10);
+	size_t allocations = MemoryConfig::Allocations();
+	Tensor &output = network.GetOutput(inputs);
 
-	cout << "OK" << endl;
-}
+	for (size_t i = 0; i < output.size(); i++)
+		for (int j = 0; j < output.Total(); j++)
+			assert(output[i][j] == expected[i][j]);
 
-void UpscaleBilinearLayerTest() {
-	cout << "Upscale bilinear tests: ";
+	// повторный вывод по плану (в том числе с меньшим батчем) не выделяет память
+	network.GetOutput(inputs[0]);
+	network.GetOutput(inputs);
 
-	VolumeSize size;
-	size.deep = 1;
-	size.height = 2;
-	size.width = 2;
+	assert(MemoryConfig::Allocations() == allocations);
+	cout << "OK" << endl;
+}
 
-	UpscaleBilinearLayer layer(size, 2);
-	layer.SetBatchSize(1);
+void OptimizeForInferenceTest() {
+	cout << "Optimize for inference tests: ";
 
-	Volume input(size);
+	Network network(10, 10, 3);
 
-	input(0, 0, 0) = 1;
-	input(0, 0, 1) = 2;
-	input(0, 1, 0) = 3;
-	input(0, 1, 1) = 4;
+	network.AddLayer("conv filters=8 filter_size=3");
+	network.AddLayer("relu");
+	network.AddLayer("batchnormalization2D");
+	network.AddLayer("conv filters=12 filter_size=3 P=1 layout=blocked");
+	network.AddLayer("batchnormalization2D");
+	network.AddLayer("leakyrelu alpha=0.2");
+	network.AddLayer("maxpool");
+	network.AddLayer("dropout p=0.3");
+	network.AddLayer("conv filters=8 filter_size=3 P=1 S=2");
+	network.AddLayer("relu");
+	network.AddLayer("fullconnected outputs=16");
+	network.AddLayer("batchnormalization");
+	network.AddLayer("relu");
+	network.AddLayer("dropout p=0.2");
+	network.AddLayer("fullconnected outputs=10 activation=sigmoid");
+	network.AddLayer("batchnormalization");
+	network.AddLayer("softmax");
 
-	layer.Forward({input});
-	Volume output = layer.GetOutput()[0];
+	Tensor inputs(4, 10, 10, 3);
+	Tensor outputs(4, 1, 1, 10);
 
-	assert(output.Width() == 4);
-	assert(output.Height() == 4);
-	assert(output.Deep() == 1);
+	for (int i = 0; i < 4 * inputs.Total(); i++)
+		inputs.Data()[i] = sin(i * 0.7);
 
-	assert(output(0, 0, 0) == 1);
-	assert(output(0, 0, 1) == 1.5);
-	assert(output(0, 1, 0) == 2);
-	assert(output(0, 1, 1) == 2.5);
+	for (size_t i = 0; i < outputs.size(); i++)
+		outputs[i][i * 2] = 1;
 
-	assert(output(0, 0, 2) == 2);
-	assert(output(0, 0, 3) == 2.5);
-	assert(output(0, 1, 2) == 3);
-	assert(output(0, 1, 3) == 3.5);
+	// несколько шагов обучения, чтобы статистика нормализаций и параметры сдвигов стали нетривиальными
+	for (int i = 0; i < 5; i++)
+		network.TrainOnBatch(inputs, outputs, Optimizer::Adam(0.01), LossFunction::CrossEntropy());
 
-	assert(output(0, 2, 0) == 3);
-	assert(output(0, 2, 1) == 3.5);
-	assert(output(0, 3, 0) == 4);
-	assert(output(0, 3, 1) == 4.5);
+	Tensor expected = network.GetOutput(inputs);
 
-	assert(output(0, 2, 2) == 4);
-	assert(output(0, 2, 3) == 4.5);
-	assert(output(0, 3, 2) == 5);
-	assert(output(0, 3, 3) == 5.5);
+	network.OptimizeForInference();
 
-	Volume deltas(output.GetSize());
+	// conv + relu + bn, conv + bn + leaky relu, maxpool, conv + relu, fc + bn + relu, fc + bn, softmax
+	assert(network.LayersCount() == 7);
 
-	deltas(0, 0, 0) = 1;
-	deltas(0, 0, 1) = 2;
-	deltas(0, 1, 0) = 0;
-	deltas(0, 1, 1) = -1;
+	Tensor &output = network.GetOutput(inputs);
 
-	deltas(0, 0, 2) = -1;
-	deltas(0, 0, 3) = 2;
-	deltas(0, 1, 2) = 2;
-	deltas(0, 1, 3) = 0;
+	for (size_t i = 0; i < output.size(); i++)
+		for (int j = 0; j < output.Total(); j++)
+			assert(fabs(output[i][j] - expected[i][j]) < Tolerance(1e-10));
 
-	deltas(0, 2, 0) = 0;
-	deltas(0, 2, 1) = 0;
-	deltas(0, 3, 0) = 0;
-	deltas(0, 3, 1) = 0;
+	network.PlanInference(4);
+	Tensor &planned = network.GetOutput(inputs);
 
-	deltas(0, 2, 2) = -1;
-	deltas(0, 2, 3) = -2;
-	deltas(0, 3, 2) = -3;
-	deltas(0, 3, 3) = -4;
+	for (size_t i = 0; i < planned.size(); i++)
+		for (int j = 0; j < planned.Total(); j++)
+			assert(fabs(planned[i][j] - expected[i][j]) < Tolerance(1e-10));
 
-	layer.Backward({deltas}, {input}, true);
-	Volume& dX = layer.GetDeltas()[0];
+	bool trained = true;
+	bool saved = true;
 
-	assert(dX.Width() == 2);
-	assert(dX.Height() == 2);
-	assert(dX.Deep() == 1);
+	try {
+		network.TrainOnBatch(inputs, outputs, Optimizer::SGD(0.01), LossFunction::CrossEntropy());
+	}
+	catch (std::runtime_error &e) {
+		trained = false;
+	}
 
-	assert(dX(0, 0, 0) == -0.25);
-	assert(dX(0, 0, 1) == 8.25);
-	assert(dX(0, 1, 0) == 3.75);
-	assert(dX(0, 1, 1) == -16.75);
+	try {
+		network.Save("optimized_network_test.txt", false);
+	}
+	catch (std::runtime_error &e) {
+		saved = false;
+	}
 
+	assert(!trained && !saved);
 	cout << "OK" << endl;
 }
 
-void DropoutTest() {
-	cout << "Dropout tests: ";
-	Volume input(1, 1, 10);
+void AutotuneTest() {
+	cout << "Autotune tests: ";
 
-	for (int i = 0; i < 10; i++)
-		input[i] = 1;
+	string path = "autotune_test.txt";
+	vector<string> configs = { "conv fc=8 fs=3 P=1", "relu", "conv fc=8 fs=1", "conv fc=6 fs=5 P=2 S=2", "conv fc=4 fs=3 layout=blocked", "fullconnected outputs=3" };
+	vector<int> convs = { 0, 2, 3 };
 
-	VolumeSize size;
-	size.height = 1;
-	size.width = 1;
-	size.deep = 10;
+	Network network(12, 12, 3);
+	Network same(12, 12, 3);
 
-	DropoutLayer layer(size, 0.2);
-	layer.SetBatchSize(1);
+	for (size_t i = 0; i < configs.size(); i++) {
+		network.AddLayer(configs[i]);
+		same.AddLayer(configs[i]);
+	}
 
-	for (int i = 0; i < 10; i++)
-		layer.Forward({input});
+	Tensor inputs(4, 12, 12, 3);
 
-	layer.ForwardOutput({input});
-	Volume& output = layer.GetOutput()[0];
+	for (int i = 0; i < 4 * inputs.Total(); i++)
+		inputs.Data()[i] = sin(i * 0.3);
 
-	double sum = 0;
-	for (int j = 0; j < 10; j++)
-		sum += output[j];
+	Tensor expected = network.GetOutput(inputs);
+	vector<real> params;
+
+	for (int i = 0; i < network.LayersCount(); i++)
+		for (int j = 0; j < network.GetLayer(i)->GetTrainableParams(); j++)
+			params.push_back(network.GetLayer(i)->GetParam(j));
+
+	remove(path.c_str());
+
+	// замеряются все свёртки, кроме блочной, веса не меняются, а выход совпадает с точностью до алгоритма
+	assert(network.Autotune(4, true, path) == 3);
+
+	for (int i = 0, index = 0; i < network.LayersCount(); i++)
+		for (int j = 0; j < network.GetLayer(i)->GetTrainableParams(); j++)
+			assert(network.GetLayer(i)->GetParam(j) == params[index++]);
+
+	Tensor &output = network.GetOutput(inputs);
+
+	for (int i = 0; i < 4 * output.Total(); i++)
+		assert(fabs(output.Data()[i] - expected.Data()[i]) < Tolerance(1e-10));
+
+	// такая же сеть берёт алгоритмы из кэша без замеров, другой батч замеряется заново
+	assert(same.Autotune(4, true, path) == 0);
+
+	for (size_t i = 0; i < convs.size(); i++) {
+		ConvAlgorithm algorithm1 = convs[i] == 3 ? ((ConvLayer *) network.GetLayer(3))->GetAlgorithm() : ((ConvWithoutStrideLayer *) network.GetLayer(convs[i]))->GetAlgorithm();
+		ConvAlgorithm algorithm2 = convs[i] == 3 ? ((ConvLayer *) same.GetLayer(3))->GetAlgorithm() : ((ConvWithoutStrideLayer *) same.GetLayer(convs[i]))->GetAlgorithm();
+		assert(algorithm1 == algorithm2);
+	}
+
+	assert(same.Autotune(2, true, path) == 3);
+	assert(same.Autotune(2, false, path) == 3);
+	assert(network.Autotune(2, false, path) == 0);
+
+	AutotuneCache cache(path);
+	assert(cache.Size() == 9);
+	remove(path.c_str());
+
+	// после настройки сеть обучается так же, как без неё
+	Network reference(12, 12, 3);
+
+	for (size_t i = 0; i < configs.size(); i++)
+		reference.AddLayer(configs[i]);
+
+	for (int i = 0, index = 0; i < reference.LayersCount(); i++)
+		for (int j = 0; j < reference.GetLayer(i)->GetTrainableParams(); j++)
+			reference.GetLayer(i)->SetParam(j, params[index++]);
+
+	Tensor outputs(4, 1, 1, 3);
+
+	for (int i = 0; i < 4 * outputs.Total(); i++)
+		outputs.Data()[i] = cos(i);
+
+	for (int i = 0; i < 3; i++) {
+		network.TrainOnBatch(inputs, outputs, Optimizer::SGD(0.001), LossFunction::MSE());
+		reference.TrainOnBatch(inputs, outputs, Optimizer::SGD(0.001), LossFunction::MSE());
+	}
+
+	for (int i = 0; i < network.LayersCount(); i++)
+		for (int j = 0; j < network.GetLayer(i)->GetTrainableParams(); j++)
+			assert(fabs(network.GetLayer(i)->GetParam(j) - reference.GetLayer(i)->GetParam(j)) < Tolerance(1e-10));
 
-	assert(fabs(sum - 10) < 1e-14);
 	cout << "OK" << endl;
 }
 
@@ -815,6 +2786,14 @@ void GradientCheckingTest() {
 
 	Network network(inputSize.width, inputSize.height, inputSize.deep);
 	
+#ifdef USE_FLOAT
+	// в одинарной точности шаг конечных разностей, различимый на фоне округлений, перескакивает изломы relu и max pooling, поэтому свёрточная часть без них
+	network.AddLayer("conv filters=4 filter_size=3 P=1 S=2");
+	network.AddLayer("convtransposed filters=3 filter_size=2 S=2");
+	network.AddLayer("conv filters=5 filter_size=3 P=1 S=2");
+	network.AddLayer("convtransposed filters=2 filter_size=3 P=1");
+	network.AddLayer("conv filters=3 filter_size=3 S=2");
+#else
 	network.AddLayer("conv filters=16 filter_size=3 P=1");
 	network.AddLayer("relu");
 	network.AddLayer("maxpool");
@@ -824,6 +2803,7 @@ void GradientCheckingTest() {
 	network.AddLayer("maxpool");
 	network.AddLayer("convtransposed filters=8 filter_size=3 P=1");
 	network.AddLayer("maxpool");
+#endif
 	network.AddLayer("fullconnected outputs=40 activation=none");
 	network.AddLayer("batchnormalization");
 	network.AddLayer("relu");
@@ -840,14 +2820,276 @@ void GradientCheckingTest() {
 	network.GradientChecking(inputs, outputs, LossFunction::Logcosh());
 }
 
+void GradientReductionTest() {
+	cout << "Gradient reduction tests: ";
+
+	int threads = omp_get_max_threads();
+
+	// участки частей покрывают каждую строку выхода каждого примера ровно один раз
+	vector<int> counts = { 1, 3, 8 };
+	vector<int> batches = { 1, 2, 5, 16 };
+	vector<int> heights = { 1, 3, 7 };
+
+	for (size_t t = 0; t < counts.size(); t++) {
+		omp_set_num_threads(counts[t]);
+
+		for (size_t b = 0; b < batches.size(); b++) {
+			for (size_t h = 0; h < heights.size(); h++) {
+				GradientTiles tiles = GetGradientTiles(batches[b], heights[h]);
+				vector<int> covered(batches[b] * heights[h], 0);
+
+				assert(tiles.parts >= 1 && tiles.parts <= counts[t]);
+
+				for (int part = 0; part < tiles.parts; part++) {
+					for (int unit = part * tiles.units / tiles.parts; unit < (part + 1) * tiles.units / tiles.parts; unit++) {
+						int n = unit / tiles.bands;
+						int begin = unit % tiles.bands * tiles.bandRows;
+
+						for (int i = begin; i < min(heights[h], begin + tiles.bandRows); i++)
+							covered[n * heights[h] + i]++;
+					}
+				}
+
+				for (size_t i = 0; i < covered.size(); i++)
+					assert(covered[i] == 1);
+			}
+		}
+	}
+
+	// частичные суммы складываются в первую
+	AlignedVector partials(5 * 3);
+
+	for (int part = 0; part < 5; part++)
+		for (int i = 0; i < 3; i++)
+			partials[part * 3 + i] = part * 10 + i;
+
+	ReduceGradientPartials(partials.data(), 5, 3);
+
+	for (int i = 0; i < 3; i++)
+		assert(partials[i] == 100 + 5 * i);
+
+	// при малом батче примеры режутся на полосы, градиенты совпадают с прямым вычислением и повторяются бит в бит
+	omp_set_num_threads(6);
+
+	default_random_engine generator;
+	normal_distribution<double> distribution(0.0, 1.0);
+
+	VolumeSize size;
+	size.width = 9;
+	size.height = 10;
+	size.deep = 3;
+
+	ConvLayer direct(size, 4, 3, 1, 2, 1);
+	ConvLayer gemm(size, 4, 3, 1, 2, 1);
+	GroupConvLayer depthwise(size, 6, 3, 1, 2, 3);
+	GroupConvLayer depthwiseReference(size, 6, 3, 1, 2, 3);
+
+	direct.SetAlgorithm(ConvAlgorithm::Direct);
+
+	for (int i = 0; i < direct.GetTrainableParams(); i++)
+		gemm.SetParam(i, direct.GetParam(i));
+
+	for (int i = 0; i < depthwise.GetTrainableParams(); i++)
+		depthwiseReference.SetParam(i, depthwise.GetParam(i));
+
+	Tensor inputs(2, size);
+	Tensor deltas(2, direct.GetOutputSize());
+	Tensor depthwiseDeltas(2, depthwise.GetOutputSize());
+
+	for (int i = 0; i < 2 * inputs.Total(); i++)
+		inputs.Data()[i] = distribution(generator);
+
+	for (int i = 0; i < 2 * deltas.Total(); i++)
+		deltas.Data()[i] = distribution(generator);
+
+	for (int i = 0; i < 2 * depthwiseDeltas.Total(); i++)
+		depthwiseDeltas.Data()[i] = distribution(generator);
+
+	vector<ConvLayer*> layers = { &direct, &gemm };
+
+	for (size_t i = 0; i < layers.size(); i++) {
+		layers[i]->SetBatchSize(2);
+		layers[i]->Forward(inputs);
+		layers[i]->Backward(deltas, inputs, false);
+	}
+
+	for (int j = 0; j < direct.GetTrainableParams(); j++)
+		assert(fabs(gemm.GetGradient(j) - direct.GetGradient(j)) < Tolerance(1e-10));
+
+	// на одном потоке частичная сумма одна, так что совпадение с ней проверяет и порядок редукции
+	omp_set_num_threads(1);
+	depthwiseReference.SetBatchSize(2);
+	depthwiseReference.Forward(inputs);
+	depthwiseReference.Backward(depthwiseDeltas, inputs, false);
+
+	omp_set_num_threads(6);
+	depthwise.SetBatchSize(2);
+	depthwise.Forward(inputs);
+
+	for (int run = 0; run < 2; run++) {
+		vector<real> gradients;
+
+		for (int j = 0; j < depthwise.GetTrainableParams(); j++)
+			depthwise.ZeroGradient(j);
+
+		depthwise.Backward(depthwiseDeltas, inputs, false);
+
+		for (int j = 0; j < depthwise.GetTrainableParams(); j++) {
+			assert(fabs(depthwise.GetGradient(j) - depthwiseReference.GetGradient(j)) < Tolerance(1e-10));
+			gradients.push_back(depthwise.GetGradient(j));
+		}
+
+		depthwise.Backward(depthwiseDeltas, inputs, false);
+
+		for (int j = 0; j < depthwise.GetTrainableParams(); j++)
+			assert(depthwise.GetGradient(j) == 2 * gradients[j]);
+	}
+
+	omp_set_num_threads(threads);
+
+	cout << "OK" << endl;
+}
+
+void QuantizationTest() {
+	cout << "Quantization tests: ";
+
+	// int8 умножение совпадает с целочисленным умножением квантованных весов, восстановленные веса отличаются не больше чем на полшага
+	int M = 7;
+	int outputs = 19;
+	int depth = 37;
+
+	vector<real> W(outputs * depth);
+
+	for (int i = 0; i < outputs * depth; i++)
+		W[i] = sin(i * 0.37) * (1 + i % 5);
+
+	Int8Weights weights;
+	QuantizeWeights(W.data(), outputs, depth, weights);
+	assert(weights.paddedDepth == 40);
+
+	vector<uint8_t> A(M * weights.paddedDepth, 0);
+
+	for (int i = 0; i < M; i++)
+		for (int p = 0; p < depth; p++)
+			A[i * weights.paddedDepth + p] = (i * 31 + p * 17) % (QUANTIZED_INPUT_MAX + 1);
+
+	vector<real> ones(weights.packed.size() / weights.paddedDepth, 1);
+	vector<real> zeros(ones.size(), 0);
+	vector<real> C(M * outputs);
+
+	Int8Gemm(M, A.data(), weights.paddedDepth, weights, ones.data(), zeros.data(), Epilogue(), C.data(), outputs);
+
+	for (int n = 0; n < outputs; n++) {
+		const int8_t *panel = weights.packed.data() + n / INT8_GEMM_NR * INT8_GEMM_NR * weights.paddedDepth;
+
+		for (int p = 0; p < depth; p++) {
+			int q = panel[(p / INT8_GEMM_KU * INT8_GEMM_NR + n % INT8_GEMM_NR) * INT8_GEMM_KU + p % INT8_GEMM_KU];
+			assert(fabs(q * weights.scales[n] - W[n * depth + p]) <= weights.scales[n] / 2 + Tolerance(1e-12));
+		}
+
+		for (int i = 0; i < M; i++) {
+			int sum = 0;
+
+			for (int p = 0; p < depth; p++)
+				sum += A[i * weights.paddedDepth + p] * panel[(p / INT8_GEMM_KU * INT8_GEMM_NR + n % INT8_GEMM_NR) * INT8_GEMM_KU + p % INT8_GEMM_KU];
+
+			assert(C[i * outputs + n] == sum);
+		}
+	}
+
+	// квантованная сеть близка к исходной: свёртки с шагом, разрежением и 1x1 со встроенными активациями, полносвязные слои (tanh остаётся вещественным)
+	Network network(12, 12, 3);
+
+	network.AddLayer("conv fc=8 fs=3 P=1 S=2");
+	network.AddLayer("relu");
+	network.AddLayer("conv fc=8 fs=3 P=2 D=2");
+	network.AddLayer("leakyrelu alpha=0.1");
+	network.AddLayer("conv fc=6 fs=1");
+	network.AddLayer("fullconnected outputs=20 activation=relu");
+	network.AddLayer("fullconnected outputs=12 activation=tanh");
+	network.AddLayer("fullconnected outputs=5");
+
+	Tensor inputs(6, 12, 12, 3);
+
+	for (int i = 0; i < 6 * inputs.Total(); i++)
+		inputs.Data()[i] = sin(i * 0.3) + 0.5 * cos(i * 0.07);
+
+	vector<Volume> calibration;
+
+	for (size_t i = 0; i < inputs.size(); i++)
+		calibration.push_back(inputs[i]);
+
+	network.OptimizeForInference();
+	Tensor expected = network.GetOutput(inputs);
+
+	assert(network.Quantize(calibration, 4) == 5);
+
+	real range = 0;
+	real error = 0;
+
+	network.PlanInference(6);
+	Tensor &output = network.GetOutput(inputs);
+
+	for (int i = 0; i < 6 * output.Total(); i++) {
+		range = max(range, (real) fabs(expected.Data()[i]));
+		error = max(error, (real) fabs(output.Data()[i] - expected.Data()[i]));
+	}
+
+	assert(range > 0 && error < 0.1 * range); // 7-битные входы пяти слоёв
+
+	bool trained = true;
+	bool saved = true;
+
+	try {
+		network.TrainOnBatch(inputs, expected, Optimizer::SGD(0.01), LossFunction::MSE());
+	}
+	catch (std::runtime_error &e) {
+		trained = false;
+	}
+
+	try {
+		network.Save("quantized_network_test.txt", false);
+	}
+	catch (std::runtime_error &e) {
+		saved = false;
+	}
+
+	assert(!trained && !saved);
+	cout << "OK" << endl;
+}
+
 int main() {
+	TensorTest();
+	AlignedAllocatorTest();
 	ConvLayerTest();
+	ConvAlgorithmsTest();
+	WinogradTest();
+	FFTConvTest();
+	DilatedConvTest();
+	ConvKernelTest();
+	PointwiseConvTest();
+	GroupConvTest();
 	ConvTransposedLayerTest();
+	ConvTransposedStrideTest();
 	UpscaleLayerTest();
 	UpscaleBilinearLayerTest();
 	MaxPoolingLayerTest();
 	AveragePoolingLayerTest();
 	FullyConnectedLayerTest();
+	FullyConnectedGemmTest();
+	FullyConnectedActivationTest();
+	SparseFullyConnectedTest();
+	SparseFullyConnectedGradientCheckingTest();
+	LowRankFullyConnectedTest();
+	LowRankFullyConnectedGradientCheckingTest();
 	DropoutTest();
+	AliasLayersTest();
+	BlockedLayoutTest();
+	GradientReductionTest();
+	TrainingAllocationsTest();
+	InferencePlanTest();
+	OptimizeForInferenceTest();
+	AutotuneTest();
+	QuantizationTest();
 	GradientCheckingTest();
 }
\ No newline at end of file